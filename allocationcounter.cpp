@@ -0,0 +1,200 @@
+/**
+ * @file allocationcounter.cpp
+ * @brief 实现堆分配计数：glibc 下替换 malloc 族函数并转发到 __libc_* 实现，其他平台替换全局 operator new/delete。
+ * @mainfunctions
+ *   - AllocationCounter::count
+ *   - AllocationCounter::scope
+ *   - AllocationCounter::watchThread
+ *   - AllocationCounter::threadCount
+ * @mainclasses
+ *   - 无
+ */
+
+#include "allocationcounter.h"
+
+#include "frametrace.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+    std::atomic<uint64_t> g_allocationCount{ 0 };
+
+    // 按线程名计数的槽位：名称只在被关注线程启动前写入，之后只读
+    const char* g_watchedNames[AllocationCounter::kMaxWatchedThreads] = {};
+    std::atomic<uint64_t> g_watchedCounts[AllocationCounter::kMaxWatchedThreads] = {};
+    std::atomic<int> g_watchedThreads{ 0 };
+
+    /**
+     * @brief 计一次分配；当前线程名与某个登记的名称一致时同时计入该槽位。
+     *
+     * 线程名读自 FrameTrace 的 thread_local 指针，比较用 strcmp，都不分配内存，不会在钩子中递归。
+     */
+    inline void countAllocation() {
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+        const int watched = g_watchedThreads.load(std::memory_order_acquire);
+        if (watched == 0) {
+            return;
+        }
+        const char* name = FrameTrace::threadName();
+        if (!name) {
+            return;
+        }
+        for (int i = 0; i < watched; ++i) {
+            if (std::strcmp(name, g_watchedNames[i]) == 0) {
+                g_watchedCounts[i].fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 把线程名写入下一个空槽位，再以 release 发布槽位数。
+ * @param name 线程名。
+ * @return 槽位编号，已满时返回 -1。
+ */
+int AllocationCounter::watchThread(const char* name) {
+    const int slot = g_watchedThreads.load(std::memory_order_relaxed);
+    if (slot >= kMaxWatchedThreads) {
+        return -1;
+    }
+    g_watchedNames[slot] = name;
+    g_watchedThreads.store(slot + 1, std::memory_order_release);
+    return slot;
+}
+
+/**
+ * @brief 返回槽位的累计分配次数。
+ * @param slot 槽位编号。
+ * @return 次数。
+ */
+uint64_t AllocationCounter::threadCount(int slot) {
+    if (slot < 0 || slot >= g_watchedThreads.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    return g_watchedCounts[slot].load(std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+
+// glibc 导出了真正的实现入口，可执行程序中定义同名的 malloc 族函数即可覆盖共享库中的全部调用，
+// 无需 dlsym（dlsym 本身会分配，初始化顺序难以保证）。operator new 最终也走 malloc，不再单独替换以免重复计数。
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* ptr);
+
+    void* malloc(size_t size) {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size) {
+        countAllocation();
+        return __libc_realloc(ptr, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size) {
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+            return 22; // EINVAL
+        }
+        countAllocation();
+        void* p = __libc_memalign(alignment, size);
+        if (!p) {
+            return 12; // ENOMEM
+        }
+        *result = p;
+        return 0;
+    }
+
+    void free(void* ptr) {
+        __libc_free(ptr);
+    }
+}
+
+/**
+ * @brief 返回累计分配次数。
+ * @return 次数。
+ */
+uint64_t AllocationCounter::count() {
+    return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 返回计数范围。
+ * @return "malloc"。
+ */
+const char* AllocationCounter::scope() {
+    return "malloc";
+}
+
+#else
+
+// 非 glibc 平台没有可转发的实现入口，只替换 operator new/delete。FFmpeg 的 av_malloc 不在统计内，
+// 转换输出缓冲是否复用请看播放器统计中的 framePoolHits / framePoolMisses。
+void* operator new(std::size_t size) {
+    countAllocation();
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+/**
+ * @brief 返回累计分配次数。
+ * @return 次数。
+ */
+uint64_t AllocationCounter::count() {
+    return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 返回计数范围。
+ * @return "operator-new"。
+ */
+const char* AllocationCounter::scope() {
+    return "operator-new";
+}
+
+#endif
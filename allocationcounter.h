@@ -0,0 +1,60 @@
+/**
+ * @file allocationcounter.h
+ * @brief 定义基准测试使用的堆分配计数器：glibc 下在 malloc 层计数（覆盖 FFmpeg 的 av_malloc 与 Qt 的分配），
+ *        其他平台退化为只统计 C++ operator new。
+ * @mainfunctions
+ *   - AllocationCounter::count
+ *   - AllocationCounter::scope
+ *   - AllocationCounter::watchThread
+ *   - AllocationCounter::threadCount
+ * @mainclasses
+ *   - AllocationCounter
+ */
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+/**
+ * @brief AllocationCounter 读取进程累计的堆分配次数。
+ *
+ * 计数钩子在 allocationcounter.cpp 中以替换全局分配函数的方式实现，只能链接进可执行程序，不进入播放核心库。
+ * 释放不计数；realloc 每次调用计一次。
+ *
+ * 另可按 FrameTrace::setThreadName 设置的线程名分别计数（如 "audio decode"、"audio output"），
+ * 用于检查某条线程在稳态下是否仍有分配。被关注的线程名须在对应线程启动前登记。
+ */
+class AllocationCounter {
+public:
+    /**
+     * @brief 进程启动以来的累计分配次数，任意线程可调用。
+     * @return 次数。
+     */
+    static uint64_t count();
+
+    /**
+     * @brief 计数覆盖的范围。
+     * @return "malloc" 表示覆盖 malloc/calloc/realloc/posix_memalign 等全部 C 堆分配；
+     *         "operator-new" 表示只覆盖 C++ 分配，FFmpeg 与 C 库内部的分配不在统计内。
+     */
+    static const char* scope();
+
+    /**
+     * @brief 登记一个需要单独计数的线程名，须在任何被关注线程启动前调用，最多 kMaxWatchedThreads 个。
+     * @param name 线程名（字符串字面量），与 FrameTrace::setThreadName 的参数按内容比较。
+     * @return 槽位编号，供 threadCount 查询；已满时返回 -1。
+     */
+    static int watchThread(const char* name);
+
+    /**
+     * @brief 名称与某槽位一致的所有线程累计的分配次数，任意线程可调用。
+     * @param slot watchThread 返回的槽位编号。
+     * @return 次数，槽位无效时为 0。
+     */
+    static uint64_t threadCount(int slot);
+
+    static constexpr int kMaxWatchedThreads = 4;
+};
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,138 @@
+/**
+ * @file audiointerleaver.cpp
+ * @brief 实现平面 PCM 到打包 PCM 的交错（立体声 SSE2 特化）。
+ * @mainfunctions
+ *   - AudioInterleaver::supports
+ *   - AudioInterleaver::interleave
+ * @mainclasses
+ *   - AudioInterleaver
+ */
+
+#include "audiointerleaver.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LSP_PCM_SSE2 1
+#include <emmintrin.h>
+#else
+#define LSP_PCM_SSE2 0
+#endif
+
+namespace {
+    /**
+     * @brief 任意通道数的标量交错。
+     * @param planes 源平面。
+     * @param channels 通道数。
+     * @param samples 每通道样本数。
+     * @param dst 目标缓冲。
+     */
+    template <typename Sample>
+    void interleaveScalar(const uint8_t* const* planes, int channels, int samples, Sample* dst) {
+        for (int ch = 0; ch < channels; ++ch) {
+            const Sample* src = reinterpret_cast<const Sample*>(planes[ch]);
+            Sample* out = dst + ch;
+            for (int i = 0; i < samples; ++i) {
+                out[static_cast<size_t>(i) * channels] = src[i];
+            }
+        }
+    }
+
+    /**
+     * @brief 立体声浮点交错：unpacklo/hi 把 L0..L3 与 R0..R3 合成 L0R0..L3R3。
+     * @param left 左声道。
+     * @param right 右声道。
+     * @param samples 样本数。
+     * @param dst 目标缓冲。
+     */
+    void interleaveStereoFloat(const float* left, const float* right, int samples, float* dst) {
+        int i = 0;
+#if LSP_PCM_SSE2
+        for (; i + 4 <= samples; i += 4) {
+            const __m128 l = _mm_loadu_ps(left + i);
+            const __m128 r = _mm_loadu_ps(right + i);
+            _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(l, r));
+        }
+#endif
+        for (; i < samples; ++i) {
+            dst[2 * i] = left[i];
+            dst[2 * i + 1] = right[i];
+        }
+    }
+
+    /**
+     * @brief 立体声 16 位交错，每次处理 8 个样本。
+     * @param left 左声道。
+     * @param right 右声道。
+     * @param samples 样本数。
+     * @param dst 目标缓冲。
+     */
+    void interleaveStereoS16(const int16_t* left, const int16_t* right, int samples, int16_t* dst) {
+        int i = 0;
+#if LSP_PCM_SSE2
+        for (; i + 8 <= samples; i += 8) {
+            const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+            const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i), _mm_unpacklo_epi16(l, r));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 8), _mm_unpackhi_epi16(l, r));
+        }
+#endif
+        for (; i < samples; ++i) {
+            dst[2 * i] = left[i];
+            dst[2 * i + 1] = right[i];
+        }
+    }
+}
+
+/**
+ * @brief 目标格式与源格式的打包形式一致时可直通。
+ * @param source 源格式。
+ * @param target 目标格式。
+ * @return true 表示支持。
+ */
+bool AudioInterleaver::supports(AVSampleFormat source, AVSampleFormat target) {
+    switch (target) {
+    case AV_SAMPLE_FMT_FLT:
+        return source == AV_SAMPLE_FMT_FLT || source == AV_SAMPLE_FMT_FLTP;
+    case AV_SAMPLE_FMT_S16:
+        return source == AV_SAMPLE_FMT_S16 || source == AV_SAMPLE_FMT_S16P;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 打包格式整体拷贝，单声道平面格式等同打包格式，其余按样本宽度交错。
+ * @param planes 源平面。
+ * @param source 源格式。
+ * @param channels 通道数。
+ * @param samples 样本数。
+ * @param dst 目标缓冲。
+ */
+void AudioInterleaver::interleave(const uint8_t* const* planes, AVSampleFormat source, int channels, int samples, uint8_t* dst) {
+    const int bytesPerSample = av_get_bytes_per_sample(source);
+    if (!av_sample_fmt_is_planar(source) || channels == 1) {
+        std::memcpy(dst, planes[0], static_cast<size_t>(samples) * channels * bytesPerSample);
+        return;
+    }
+
+    if (source == AV_SAMPLE_FMT_FLTP) {
+        if (channels == 2) {
+            interleaveStereoFloat(reinterpret_cast<const float*>(planes[0]), reinterpret_cast<const float*>(planes[1]),
+                samples, reinterpret_cast<float*>(dst));
+        }
+        else {
+            interleaveScalar(planes, channels, samples, reinterpret_cast<float*>(dst));
+        }
+    }
+    else if (source == AV_SAMPLE_FMT_S16P) {
+        if (channels == 2) {
+            interleaveStereoS16(reinterpret_cast<const int16_t*>(planes[0]), reinterpret_cast<const int16_t*>(planes[1]),
+                samples, reinterpret_cast<int16_t*>(dst));
+        }
+        else {
+            interleaveScalar(planes, channels, samples, reinterpret_cast<int16_t*>(dst));
+        }
+    }
+}
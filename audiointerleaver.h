@@ -0,0 +1,49 @@
+/**
+ * @file audiointerleaver.h
+ * @brief 定义解码帧与输出格式一致时绕过重采样器的 PCM 交错/拷贝路径。
+ * @mainfunctions
+ *   - supports
+ *   - interleave
+ * @mainclasses
+ *   - AudioInterleaver
+ */
+
+#ifndef AUDIOINTERLEAVER_H
+#define AUDIOINTERLEAVER_H
+
+#include <cstdint>
+
+extern "C"
+{
+#include <libavutil/samplefmt.h>
+}
+
+/**
+ * @brief AudioInterleaver 处理采样率与通道数已与设备一致的帧：
+ *        交错格式直接拷贝，平面格式（FLTP/S16P）交错成设备需要的打包格式。
+ *
+ * 立体声是监控摄像头最常见的布局，使用 SSE2 解包指令一次处理 4 个浮点或 8 个 16 位样本；
+ * 其余通道数走标量循环。
+ */
+class AudioInterleaver {
+public:
+    /**
+     * @brief 判断能否不经重采样把 source 格式的样本写成 target 格式。
+     * @param source 解码帧的样本格式。
+     * @param target 输出设备的样本格式（打包格式）。
+     * @return true 表示支持。
+     */
+    static bool supports(AVSampleFormat source, AVSampleFormat target);
+
+    /**
+     * @brief 交错或拷贝样本。
+     * @param planes 源数据平面（打包格式只使用 planes[0]）。
+     * @param source 源样本格式，需满足 supports()。
+     * @param channels 通道数。
+     * @param samples 每通道样本数。
+     * @param dst 目标缓冲，至少 samples * channels * 样本字节数。
+     */
+    static void interleave(const uint8_t* const* planes, AVSampleFormat source, int channels, int samples, uint8_t* dst);
+};
+
+#endif // AUDIOINTERLEAVER_H
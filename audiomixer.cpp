@@ -0,0 +1,496 @@
+/**
+ * @file audiomixer.cpp
+ * @brief 实现共享音频输出：设备格式协商、输出线程管理、各路环形缓冲的混合与空输出消费。
+ * @mainfunctions
+ *   - AudioMixer::shared
+ *   - AudioMixer::queryDeviceFormat
+ *   - AudioMixer::attach
+ *   - AudioMixer::mix
+ *   - AudioMixer::drainNullSources
+ * @mainclasses
+ *   - AudioMixDevice
+ */
+
+#include "audiomixer.h"
+
+#include "audioringdevice.h"
+#include "frametrace.h"
+#include "mediaclock.h"
+
+#include <QAudioOutput>
+#include <QIODevice>
+#include <QMetaObject>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+    constexpr int kMixSampleRate = 48000;       // 第一路接入前声卡的初始采样率，AAC 摄像头最常见
+    constexpr int kMixChannels = 2;
+    constexpr int kNullSinkPeriodMs = 10;       // 空输出的消费周期，与常见声卡周期相当
+    constexpr size_t kMaxSources = 64;          // 预留的注册表容量，超出时照常增长
+
+    /**
+     * @brief 将设备格式映射为 FFmpeg 打包样本格式。
+     * @param format 协商后的设备格式。
+     * @return 对应格式，无法处理时为 AV_SAMPLE_FMT_NONE。
+     */
+    AVSampleFormat sampleFormatFor(const QAudioFormat& format) {
+        if (!format.isValid() || format.byteOrder() != QAudioFormat::LittleEndian) {
+            return AV_SAMPLE_FMT_NONE;
+        }
+        if (format.sampleType() == QAudioFormat::Float && format.sampleSize() == 32) {
+            return AV_SAMPLE_FMT_FLT;
+        }
+        if (format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 16) {
+            return AV_SAMPLE_FMT_S16;
+        }
+        if (format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 32) {
+            return AV_SAMPLE_FMT_S32;
+        }
+        if (format.sampleType() == QAudioFormat::UnSignedInt && format.sampleSize() == 8) {
+            return AV_SAMPLE_FMT_U8;
+        }
+        return AV_SAMPLE_FMT_NONE;
+    }
+
+    /**
+     * @brief 有符号整型样本饱和相加。
+     * @param dst 累加目标。
+     * @param src 加数。
+     * @param count 样本数。
+     */
+    template <typename Sample, typename Wide>
+    void addSaturated(Sample* dst, const Sample* src, size_t count) {
+        constexpr Wide lo = std::numeric_limits<Sample>::min();
+        constexpr Wide hi = std::numeric_limits<Sample>::max();
+        for (size_t i = 0; i < count; ++i) {
+            const Wide sum = static_cast<Wide>(dst[i]) + static_cast<Wide>(src[i]);
+            dst[i] = static_cast<Sample>(std::min(hi, std::max(lo, sum)));
+        }
+    }
+
+    /**
+     * @brief 按样本格式把 src 叠加到 dst：浮点直接相加（由设备钳位），整型饱和相加，U8 以 128 为零点。
+     * @param dst 累加目标。
+     * @param src 加数。
+     * @param bytes 字节数。
+     * @param format 打包样本格式。
+     */
+    void mixInto(char* dst, const char* src, size_t bytes, AVSampleFormat format) {
+        switch (format) {
+        case AV_SAMPLE_FMT_FLT: {
+            float* out = reinterpret_cast<float*>(dst);
+            const float* in = reinterpret_cast<const float*>(src);
+            for (size_t i = 0; i < bytes / sizeof(float); ++i) {
+                out[i] += in[i];
+            }
+            break;
+        }
+        case AV_SAMPLE_FMT_S16:
+            addSaturated<int16_t, int32_t>(reinterpret_cast<int16_t*>(dst), reinterpret_cast<const int16_t*>(src),
+                bytes / sizeof(int16_t));
+            break;
+        case AV_SAMPLE_FMT_S32:
+            addSaturated<int32_t, int64_t>(reinterpret_cast<int32_t*>(dst), reinterpret_cast<const int32_t*>(src),
+                bytes / sizeof(int32_t));
+            break;
+        case AV_SAMPLE_FMT_U8: {
+            uint8_t* out = reinterpret_cast<uint8_t*>(dst);
+            const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+            for (size_t i = 0; i < bytes; ++i) {
+                out[i] = static_cast<uint8_t>(std::min(255, std::max(0, out[i] + in[i] - 128)));
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief AudioMixDevice 交给 QAudioOutput::start(QIODevice*) 以拉模式播放，读取时由 AudioMixer 混合各路。
+ */
+class AudioMixDevice : public QIODevice {
+public:
+    /**
+     * @brief 以无缓冲只读方式打开。
+     * @param mixer 混合器。
+     * @param parent Qt 父对象。
+     */
+    AudioMixDevice(AudioMixer* mixer, QObject* parent)
+        : QIODevice(parent),
+        m_mixer(mixer) {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    /**
+     * @brief 顺序设备。
+     * @return true。
+     */
+    bool isSequential() const override {
+        return true;
+    }
+
+protected:
+    /**
+     * @brief 由 QAudioOutput 在输出线程调用。
+     * @param data 目标缓冲。
+     * @param maxlen 请求字节数。
+     * @return 写入的字节数。
+     */
+    qint64 readData(char* data, qint64 maxlen) override {
+        return m_mixer->mix(data, maxlen);
+    }
+
+    /**
+     * @brief 只读设备。
+     * @return -1。
+     */
+    qint64 writeData(const char*, qint64) override {
+        return -1;
+    }
+
+private:
+    AudioMixer* m_mixer;
+};
+
+/**
+ * @brief 每种模式保存一个弱引用，最后一个持有者释放后下次调用重新创建。
+ * @param nullSink 是否为空输出。
+ * @return 共享实例。
+ */
+std::shared_ptr<AudioMixer> AudioMixer::shared(bool nullSink) {
+    static std::mutex mutex;
+    static std::weak_ptr<AudioMixer> instances[2];
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<AudioMixer>& slot = instances[nullSink ? 1 : 0];
+    std::shared_ptr<AudioMixer> mixer = slot.lock();
+    if (!mixer) {
+        mixer.reset(new AudioMixer(nullSink));
+        slot = mixer;
+    }
+    return mixer;
+}
+
+/**
+ * @brief 设备查询可能耗时数十毫秒，只在创建声卡实例（或关闭复用的连接）时执行。
+ * @param sampleRate 期望采样率。
+ * @param channels 期望通道数。
+ * @return 协商结果。
+ */
+AudioMixer::OutputFormat AudioMixer::queryDeviceFormat(int sampleRate, int channels) {
+    QAudioFormat format;
+    format.setCodec("audio/pcm");
+    format.setChannelCount(channels);
+    format.setSampleRate(sampleRate);
+    format.setSampleSize(32);
+    format.setSampleType(QAudioFormat::Float);
+    format.setByteOrder(QAudioFormat::LittleEndian);
+
+    const QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+    if (!device.isFormatSupported(format)) {
+        format.setSampleSize(16);
+        format.setSampleType(QAudioFormat::SignedInt);
+        if (!device.isFormatSupported(format)) {
+            format = device.nearestFormat(format);
+        }
+    }
+    return OutputFormat{ device, format, sampleFormatFor(format) };
+}
+
+/**
+ * @brief 按初始格式协商（声卡模式）、预分配暂存区，再把上下文对象移到新线程并在该线程创建输出。
+ * @param nullSink 是否为空输出。
+ */
+AudioMixer::AudioMixer(bool nullSink)
+    : m_nullSink(nullSink) {
+    if (!m_nullSink) {
+        m_format = queryDeviceFormat(kMixSampleRate, kMixChannels);
+        m_requestedSampleRate = kMixSampleRate;
+        m_requestedChannels = kMixChannels;
+        if (m_format.sampleFormat != AV_SAMPLE_FMT_NONE) {
+            m_bytesPerFrame = m_format.format.channelCount() * av_get_bytes_per_sample(m_format.sampleFormat);
+            m_bytesPerSecond = m_format.format.sampleRate() * m_bytesPerFrame;
+        }
+    }
+    m_sources.reserve(kMaxSources);
+    // 声卡单次拉取不超过设备缓冲（200 ms），预留 1 秒
+    m_scratch.resize(static_cast<size_t>(std::max(m_bytesPerSecond, 0)));
+
+    m_context = new QObject();
+    if (m_nullSink) {
+        m_nullTimer = new QTimer(m_context);
+        m_nullTimer->setInterval(kNullSinkPeriodMs);
+        m_nullTimer->setTimerType(Qt::PreciseTimer);
+        QObject::connect(m_nullTimer, &QTimer::timeout, m_context, [this]() { drainNullSources(); });
+    }
+    else {
+        m_device = new AudioMixDevice(this, m_context);
+    }
+
+    m_thread = new QThread();
+    m_thread->setObjectName(QStringLiteral("LSP audio output"));
+    m_context->moveToThread(m_thread);
+    m_thread->start();
+    QMetaObject::invokeMethod(m_context, [this]() {
+        FrameTrace::setThreadName("audio output");
+        startOutput();
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief 输出在其所属线程销毁后再结束线程，线程退出后删除上下文及其子对象。
+ *        最后一个引用不得在输出线程中释放。
+ */
+AudioMixer::~AudioMixer() {
+    QMetaObject::invokeMethod(m_context, [this]() { stopOutput(); }, Qt::BlockingQueuedConnection);
+    m_thread->quit();
+    m_thread->wait();
+    delete m_context;
+    delete m_thread;
+}
+
+/**
+ * @brief 返回模式。
+ * @return true 表示空输出。
+ */
+bool AudioMixer::isNullSink() const {
+    return m_nullSink;
+}
+
+/**
+ * @brief 返回输出格式的副本，格式可能被 attach 更新。
+ * @return 输出格式。
+ */
+AudioMixer::OutputFormat AudioMixer::outputFormat() const {
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    return m_format;
+}
+
+/**
+ * @brief 设备查询不持锁进行，查询后重新确认仍无其他接入者再替换格式；
+ *        相同请求不重复查询，设备不支持请求格式时沿用最接近的结果。
+ * @param ring 环形缓冲。
+ * @param sampleRate 源采样率。
+ * @param channels 源通道数。
+ * @return 当前输出格式。
+ */
+AudioMixer::OutputFormat AudioMixer::attach(AudioRingDevice* ring, int sampleRate, int channels) {
+    {
+        std::lock_guard<std::mutex> lock(m_sourcesMutex);
+        if (std::find(m_attached.begin(), m_attached.end(), ring) == m_attached.end()) {
+            m_attached.push_back(ring);
+        }
+        if (m_nullSink || sampleRate <= 0 || channels <= 0 || hasOtherAttached(ring) ||
+            (sampleRate == m_requestedSampleRate && channels == m_requestedChannels)) {
+            return m_format;
+        }
+    }
+
+    const OutputFormat negotiated = queryDeviceFormat(sampleRate, channels);
+
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    if (negotiated.sampleFormat == AV_SAMPLE_FMT_NONE || hasOtherAttached(ring)) {
+        return m_format;
+    }
+    m_requestedSampleRate = sampleRate;
+    m_requestedChannels = channels;
+    if (negotiated.format == m_format.format && negotiated.sampleFormat == m_format.sampleFormat) {
+        return m_format;
+    }
+
+    // 旧格式写入的 ring 不能再被读取，由调用方按新格式配置后重新注册
+    m_sources.erase(std::remove_if(m_sources.begin(), m_sources.end(),
+        [ring](const Source& source) { return source.ring == ring; }), m_sources.end());
+    m_format = negotiated;
+    m_bytesPerFrame = m_format.format.channelCount() * av_get_bytes_per_sample(m_format.sampleFormat);
+    m_bytesPerSecond = m_format.format.sampleRate() * m_bytesPerFrame;
+    if (m_scratch.size() < static_cast<size_t>(m_bytesPerSecond)) {
+        m_scratch.resize(static_cast<size_t>(m_bytesPerSecond));
+    }
+    ++m_pendingRestarts;
+    QMetaObject::invokeMethod(m_context, [this]() { restartOutput(); }, Qt::QueuedConnection);
+    return m_format;
+}
+
+/**
+ * @brief 持锁同时移除接入记录与注册。
+ * @param ring 环形缓冲。
+ */
+void AudioMixer::detach(AudioRingDevice* ring) {
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    m_attached.erase(std::remove(m_attached.begin(), m_attached.end(), ring), m_attached.end());
+    m_sources.erase(std::remove_if(m_sources.begin(), m_sources.end(),
+        [ring](const Source& source) { return source.ring == ring; }), m_sources.end());
+}
+
+/**
+ * @brief 在接入表中查找 ring 以外的项。
+ * @param ring 排除的环形缓冲。
+ * @return true 表示有其他接入者。
+ */
+bool AudioMixer::hasOtherAttached(const AudioRingDevice* ring) const {
+    return std::any_of(m_attached.begin(), m_attached.end(), [ring](const AudioRingDevice* other) { return other != ring; });
+}
+
+/**
+ * @brief 注册或更新一路；空输出从此刻重新计量，暂存区按该路一秒的数据量增长。
+ * @param ring 环形缓冲。
+ * @param bytesPerSecond 每秒字节数。
+ * @param bytesPerFrame 每帧字节数。
+ */
+void AudioMixer::addSource(AudioRingDevice* ring, int bytesPerSecond, int bytesPerFrame) {
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    auto it = std::find_if(m_sources.begin(), m_sources.end(), [ring](const Source& source) { return source.ring == ring; });
+    if (it == m_sources.end()) {
+        m_sources.push_back(Source());
+        it = m_sources.end() - 1;
+    }
+    it->ring = ring;
+    it->bytesPerSecond = bytesPerSecond;
+    it->bytesPerFrame = bytesPerFrame > 0 ? bytesPerFrame : 1;
+    it->startUs = MediaClock::nowUs();
+    it->consumedBytes = 0;
+    if (m_nullSink && m_scratch.size() < static_cast<size_t>(bytesPerSecond)) {
+        m_scratch.resize(static_cast<size_t>(bytesPerSecond));
+    }
+}
+
+/**
+ * @brief 持锁移除，输出线程此刻不在读取任何一路。
+ * @param ring 环形缓冲。
+ */
+void AudioMixer::removeSource(AudioRingDevice* ring) {
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    m_sources.erase(std::remove_if(m_sources.begin(), m_sources.end(),
+        [ring](const Source& source) { return source.ring == ring; }), m_sources.end());
+}
+
+/**
+ * @brief 返回声卡缓冲中未播放的字节数。
+ * @return 字节数。
+ */
+int AudioMixer::bufferedBytes() const {
+    return m_bufferedBytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 声卡模式创建 QAudioOutput（缓冲 200 ms）并以拉模式启动；空输出模式启动定时器。
+ */
+void AudioMixer::startOutput() {
+    if (m_nullSink) {
+        m_nullTimer->start();
+        return;
+    }
+    OutputFormat format;
+    int bytesPerSecond = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_sourcesMutex);
+        format = m_format;
+        bytesPerSecond = m_bytesPerSecond;
+    }
+    if (format.sampleFormat == AV_SAMPLE_FMT_NONE) {
+        return;
+    }
+    m_output = new QAudioOutput(format.device, format.format, m_context);
+    m_output->setBufferSize(bytesPerSecond / 5);
+    m_output->start(m_device);
+}
+
+/**
+ * @brief 停止并销毁输出。
+ */
+void AudioMixer::stopOutput() {
+    if (m_nullTimer) {
+        m_nullTimer->stop();
+    }
+    if (m_output) {
+        m_output->stop();
+        delete m_output;
+        m_output = nullptr;
+    }
+}
+
+/**
+ * @brief 销毁旧格式的 QAudioOutput 并按当前格式新建，之后 mix 恢复读取各路。
+ */
+void AudioMixer::restartOutput() {
+    if (m_output) {
+        m_output->stop();
+        delete m_output;
+        m_output = nullptr;
+    }
+    m_bufferedBytes.store(0, std::memory_order_relaxed);
+    startOutput();
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    --m_pendingRestarts;
+}
+
+/**
+ * @brief 先记录设备缓冲水位（各路的读取回调据此修正时钟），第一路直接读入目标缓冲，其余经暂存区叠加。
+ *        各路的 AudioRingDevice 读空时自行以静音补齐并统计欠载。
+ * @param data 目标缓冲。
+ * @param maxlen 请求字节数。
+ * @return 写入的字节数。
+ */
+qint64 AudioMixer::mix(char* data, qint64 maxlen) {
+    if (m_output) {
+        m_bufferedBytes.store(std::max(0, m_output->bufferSize() - m_output->bytesFree()), std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    size_t wanted = static_cast<size_t>(maxlen > 0 ? maxlen : 0);
+    if (m_pendingRestarts > 0) {
+        // 设备仍按旧格式拉取，各路的新格式数据等重新打开后再送出
+        std::memset(data, 0, wanted);
+        return static_cast<qint64>(wanted);
+    }
+    wanted = std::min(wanted, m_scratch.size()) / m_bytesPerFrame * m_bytesPerFrame;
+    if (wanted == 0) {
+        return 0;
+    }
+    if (m_sources.empty()) {
+        std::memset(data, m_format.sampleFormat == AV_SAMPLE_FMT_U8 ? 0x80 : 0, wanted);
+        return static_cast<qint64>(wanted);
+    }
+
+    m_sources.front().ring->read(data, static_cast<qint64>(wanted));
+    for (size_t i = 1; i < m_sources.size(); ++i) {
+        m_sources[i].ring->read(m_scratch.data(), static_cast<qint64>(wanted));
+        mixInto(data, m_scratch.data(), wanted, m_format.sampleFormat);
+    }
+    return static_cast<qint64>(wanted);
+}
+
+/**
+ * @brief 各路按自注册以来的实时时长计算应消费的字节数并补足差额；
+ *        事件循环停顿超过 1 秒时从当前时刻重新计量，避免一次读出大量数据。
+ */
+void AudioMixer::drainNullSources() {
+    const int64_t now = MediaClock::nowUs();
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    for (Source& source : m_sources) {
+        if (source.bytesPerSecond <= 0) {
+            continue;
+        }
+        const uint64_t dueFrames = static_cast<uint64_t>(static_cast<double>(now - source.startUs) * 1e-6 *
+            source.bytesPerSecond / source.bytesPerFrame);
+        const uint64_t dueBytes = dueFrames * static_cast<uint64_t>(source.bytesPerFrame);
+        if (dueBytes <= source.consumedBytes) {
+            continue;
+        }
+        const uint64_t pending = dueBytes - source.consumedBytes;
+        if (pending > static_cast<uint64_t>(source.bytesPerSecond)) {
+            source.startUs = now;
+            source.consumedBytes = 0;
+            continue;
+        }
+        source.ring->read(m_scratch.data(), static_cast<qint64>(pending));
+        source.consumedBytes += pending;
+    }
+}
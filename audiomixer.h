@@ -0,0 +1,210 @@
+/**
+ * @file audiomixer.h
+ * @brief 定义进程内共享的音频输出：一个输出线程、一个 QAudioOutput，把所有未静音播放器的
+ *        PCM 环形缓冲混合后送往声卡；空输出模式下由同一线程按实时速率消费各路缓冲。
+ * @mainfunctions
+ *   - AudioMixer::shared
+ *   - AudioMixer::queryDeviceFormat
+ *   - AudioMixer::attach
+ *   - AudioMixer::detach
+ *   - AudioMixer::addSource
+ *   - AudioMixer::removeSource
+ *   - AudioMixer::bufferedBytes
+ * @mainclasses
+ *   - AudioMixer
+ */
+
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <QAudioDeviceInfo>
+#include <QAudioFormat>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+extern "C"
+{
+#include <libavutil/samplefmt.h>
+}
+
+class AudioRingDevice;
+class QAudioOutput;
+class QIODevice;
+class QObject;
+class QThread;
+class QTimer;
+
+/**
+ * @brief AudioMixer 让多路播放器共用一个音频输出线程与一个声卡输出，静音与音量都在各路的
+ *        软件路径中完成，画面墙上增加一路流不再增加 QAudioOutput 与输出线程。
+ *
+ * 声卡模式下创建时先按 48 kHz 立体声打开设备；第一路接入（attach）时若没有其他播放器接入，按该路的采样率与
+ * 通道数重新协商（优先 32 位浮点），格式变化时在输出线程重新打开 QAudioOutput，使 44.1 kHz、单声道等源也能走直通。
+ * 已有其他播放器接入（包括静音的）时沿用当前格式，各路按该格式写入自己的 AudioRingDevice；设备拉取时逐路读取并按样本类型饱和相加。空输出模式不打开声卡，每 10 ms
+ * 按各路自身格式与实时时长读出应播放的数据，行为与声卡拉取相同，供无声卡环境运行完整的音频路径。
+ * 两种模式各有一个进程级实例，由最后一个持有者释放时停止线程。
+ *
+ * 注册表由互斥量保护：输出线程每次拉取持锁遍历，addSource/removeSource 只在连接、静音切换与停止时调用，
+ * removeSource 返回后输出线程不会再访问该缓冲，调用方随后可以安全地重置或销毁它。
+ */
+class AudioMixer {
+public:
+    /**
+     * @brief 协商得到的声卡与格式。
+     */
+    struct OutputFormat {
+        QAudioDeviceInfo device;
+        QAudioFormat format;
+        AVSampleFormat sampleFormat = AV_SAMPLE_FMT_NONE;   // 与 format 对应的打包样本格式
+    };
+
+    /**
+     * @brief 获取进程级实例，不存在时创建并启动输出线程（声卡模式同时协商设备格式）。
+     * @param nullSink true 取空输出实例，false 取声卡实例。
+     * @return 共享实例。
+     */
+    static std::shared_ptr<AudioMixer> shared(bool nullSink);
+
+    /**
+     * @brief 查询默认声卡对给定采样率/通道数的格式：优先 32 位浮点，其次 16 位整型，最后取最接近的格式。
+     * @param sampleRate 期望采样率。
+     * @param channels 期望通道数。
+     * @return 协商结果，样本格式为 AV_SAMPLE_FMT_NONE 表示无法使用。
+     */
+    static OutputFormat queryDeviceFormat(int sampleRate, int channels);
+
+    ~AudioMixer();
+
+    AudioMixer(const AudioMixer&) = delete;
+    AudioMixer& operator=(const AudioMixer&) = delete;
+
+    /**
+     * @brief 是否为空输出实例。
+     * @return true 表示空输出。
+     */
+    bool isNullSink() const;
+
+    /**
+     * @brief 声卡实例的输出格式，各路必须按此格式写入；空输出实例返回无效格式。
+     * @return 输出格式。
+     */
+    OutputFormat outputFormat() const;
+
+    /**
+     * @brief 播放器打开流时接入并取得写入格式，任意线程可调用，不等待输出线程。
+     *        声卡实例在没有其他播放器接入时按请求重新协商，格式变化则从注册表移除 ring 并排队重新打开设备；
+     *        空输出实例只记录接入，返回无效格式。
+     * @param ring 该播放器的环形缓冲。
+     * @param sampleRate 源采样率。
+     * @param channels 源通道数。
+     * @return 当前输出格式，调用方随后按此格式配置 ring 再 addSource。
+     */
+    OutputFormat attach(AudioRingDevice* ring, int sampleRate, int channels);
+
+    /**
+     * @brief 播放器断开时注销并解除接入，返回后输出线程不再访问 ring，任意线程可调用。
+     * @param ring 环形缓冲。
+     */
+    void detach(AudioRingDevice* ring);
+
+    /**
+     * @brief 开始读取一路环形缓冲，已注册时只更新格式，任意线程可调用。
+     * @param ring 环形缓冲，需已按写入格式 configure。
+     * @param bytesPerSecond 每秒字节数（空输出按此速率消费）。
+     * @param bytesPerFrame 每个采样帧的字节数。
+     */
+    void addSource(AudioRingDevice* ring, int bytesPerSecond, int bytesPerFrame);
+
+    /**
+     * @brief 停止读取一路环形缓冲，返回后输出线程不再访问它，任意线程可调用。
+     * @param ring 环形缓冲。
+     */
+    void removeSource(AudioRingDevice* ring);
+
+    /**
+     * @brief 声卡缓冲中已取走但尚未播放的字节数，供各路修正音频时钟；空输出恒为 0。
+     * @return 字节数。
+     */
+    int bufferedBytes() const;
+
+private:
+    friend class AudioMixDevice;
+
+    /**
+     * @brief 一路已注册的环形缓冲。
+     */
+    struct Source {
+        AudioRingDevice* ring = nullptr;
+        int bytesPerSecond = 0;
+        int bytesPerFrame = 1;
+        int64_t startUs = 0;            // 空输出：计量起点
+        uint64_t consumedBytes = 0;     // 空输出：自起点以来已读出的字节数
+    };
+
+    /**
+     * @brief 创建输出线程及其上下文对象，声卡模式同时协商格式。
+     * @param nullSink 是否为空输出。
+     */
+    explicit AudioMixer(bool nullSink);
+
+    /**
+     * @brief 在输出线程创建并启动 QAudioOutput 或空输出定时器。
+     */
+    void startOutput();
+
+    /**
+     * @brief 在输出线程停止并销毁 QAudioOutput 与定时器。
+     */
+    void stopOutput();
+
+    /**
+     * @brief 在输出线程按最新格式重新打开 QAudioOutput，完成后恢复混合。
+     */
+    void restartOutput();
+
+    /**
+     * @brief 除 ring 外是否还有播放器接入，调用方持有 m_sourcesMutex。
+     * @param ring 排除的环形缓冲。
+     * @return true 表示有其他接入者。
+     */
+    bool hasOtherAttached(const AudioRingDevice* ring) const;
+
+    /**
+     * @brief 声卡拉取：逐路读取并相加，无注册源时输出静音。
+     * @param data 目标缓冲。
+     * @param maxlen 请求字节数。
+     * @return 写入的字节数（按整帧对齐）。
+     */
+    qint64 mix(char* data, qint64 maxlen);
+
+    /**
+     * @brief 空输出定时回调：各路按自启动以来的实时时长读出应播放的数据。
+     */
+    void drainNullSources();
+
+    const bool m_nullSink;
+
+    QThread* m_thread = nullptr;
+    QObject* m_context = nullptr;           // 驻留在输出线程，是下列对象的父对象
+    QIODevice* m_device = nullptr;          // 声卡拉取的数据源，读取时混合各路
+    QAudioOutput* m_output = nullptr;       // 仅输出线程访问
+    QTimer* m_nullTimer = nullptr;          // 仅输出线程访问
+
+    mutable std::mutex m_sourcesMutex;      // 保护下面各项
+    OutputFormat m_format;
+    int m_requestedSampleRate = 0;          // 得到 m_format 的协商请求，相同请求不再查询设备
+    int m_requestedChannels = 0;
+    int m_bytesPerFrame = 1;
+    int m_bytesPerSecond = 0;
+    int m_pendingRestarts = 0;              // 已排队但输出线程尚未执行的重新打开次数，非 0 时只输出静音
+    std::vector<AudioRingDevice*> m_attached;   // 已接入的播放器（含静音未注册的），决定能否重新协商
+    std::vector<Source> m_sources;
+    std::vector<char> m_scratch;            // 逐路读取的暂存区，注册时按需增长，输出线程内不分配
+    std::atomic<int> m_bufferedBytes{ 0 };
+};
+
+#endif // AUDIOMIXER_H
@@ -0,0 +1,253 @@
+/**
+ * @file audioprocessor.cpp
+ * @brief 实现电平统计与增益内核（SSE2 与标量回退）。
+ * @mainfunctions
+ *   - AudioProcessor::measure
+ *   - AudioProcessor::applyGain
+ * @mainclasses
+ *   - AudioLevels
+ *   - AudioProcessor
+ */
+
+#include "audioprocessor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LSP_LEVELS_SSE2 1
+#include <emmintrin.h>
+#else
+#define LSP_LEVELS_SSE2 0
+#endif
+
+namespace {
+    constexpr double kSilenceDb = -100.0;   // 电平下限，静音时上报该值
+    constexpr float kS16Scale = 1.0f / 32768.0f;
+
+    /**
+     * @brief 线性幅度转换为 dBFS。
+     * @param amplitude 线性幅度。
+     * @return dBFS，不低于下限。
+     */
+    double toDb(double amplitude) {
+        if (!(amplitude > 0.0)) {
+            return kSilenceDb;
+        }
+        return std::max(kSilenceDb, 20.0 * std::log10(amplitude));
+    }
+
+    /**
+     * @brief 浮点样本的峰值与平方和；平方和按 4 路浮点累加，一帧只有数千个样本，精度足够。
+     * @param src 样本。
+     * @param count 样本数。
+     * @param levels 累计结果。
+     */
+    void measureFloat(const float* src, size_t count, AudioLevels& levels) {
+        size_t i = 0;
+        float peak = levels.peak;
+        double sum = 0.0;
+#if LSP_LEVELS_SSE2
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 peakVec = _mm_setzero_ps();
+        __m128 sumVec = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            const __m128 v = _mm_loadu_ps(src + i);
+            peakVec = _mm_max_ps(peakVec, _mm_and_ps(v, absMask));
+            sumVec = _mm_add_ps(sumVec, _mm_mul_ps(v, v));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, peakVec);
+        peak = std::max({ peak, lanes[0], lanes[1], lanes[2], lanes[3] });
+        _mm_store_ps(lanes, sumVec);
+        sum = static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#endif
+        for (; i < count; ++i) {
+            peak = std::max(peak, std::abs(src[i]));
+            sum += static_cast<double>(src[i]) * src[i];
+        }
+        levels.peak = peak;
+        levels.sumSquares += sum;
+        levels.samples += count;
+    }
+
+    /**
+     * @brief 16 位样本的峰值与平方和。pmaddwd 每两个样本的平方和最大为 2^31，
+     *        按无符号 32 位扩展到 64 位累加，不会溢出。
+     * @param src 样本。
+     * @param count 样本数。
+     * @param levels 累计结果。
+     */
+    void measureS16(const int16_t* src, size_t count, AudioLevels& levels) {
+        size_t i = 0;
+        int maxValue = 0;
+        int minValue = 0;
+        uint64_t sum = 0;
+#if LSP_LEVELS_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        __m128i maxVec = zero;
+        __m128i minVec = zero;
+        __m128i sumVec = zero;
+        for (; i + 8 <= count; i += 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            maxVec = _mm_max_epi16(maxVec, v);
+            minVec = _mm_min_epi16(minVec, v);
+            const __m128i squares = _mm_madd_epi16(v, v);
+            sumVec = _mm_add_epi64(sumVec, _mm_unpacklo_epi32(squares, zero));
+            sumVec = _mm_add_epi64(sumVec, _mm_unpackhi_epi32(squares, zero));
+        }
+        alignas(16) int16_t words[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(words), maxVec);
+        maxValue = *std::max_element(words, words + 8);
+        _mm_store_si128(reinterpret_cast<__m128i*>(words), minVec);
+        minValue = *std::min_element(words, words + 8);
+        alignas(16) uint64_t sums[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(sums), sumVec);
+        sum = sums[0] + sums[1];
+#endif
+        for (; i < count; ++i) {
+            maxValue = std::max<int>(maxValue, src[i]);
+            minValue = std::min<int>(minValue, src[i]);
+            sum += static_cast<uint64_t>(static_cast<int>(src[i]) * src[i]);
+        }
+        levels.peak = std::max(levels.peak, static_cast<float>(std::max(maxValue, -minValue)) * kS16Scale);
+        levels.sumSquares += static_cast<double>(sum) * (static_cast<double>(kS16Scale) * kS16Scale);
+        levels.samples += count;
+    }
+
+    /**
+     * @brief 浮点增益，不做截断（由设备处理超出 [-1, 1] 的样本）。
+     * @param data 样本。
+     * @param count 样本数。
+     * @param gain 增益。
+     */
+    void gainFloat(float* data, size_t count, float gain) {
+        size_t i = 0;
+#if LSP_LEVELS_SSE2
+        const __m128 g = _mm_set1_ps(gain);
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), g));
+        }
+#endif
+        for (; i < count; ++i) {
+            data[i] *= gain;
+        }
+    }
+
+    /**
+     * @brief 16 位增益：符号扩展到 32 位后转浮点相乘，再以 packssdw 饱和打包回 16 位。
+     * @param data 样本。
+     * @param count 样本数。
+     * @param gain 增益。
+     */
+    void gainS16(int16_t* data, size_t count, float gain) {
+        size_t i = 0;
+#if LSP_LEVELS_SSE2
+        const __m128 g = _mm_set1_ps(gain);
+        for (; i + 8 <= count; i += 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            const __m128i scaledLo = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(lo), g));
+            const __m128i scaledHi = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(hi), g));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_packs_epi32(scaledLo, scaledHi));
+        }
+#endif
+        for (; i < count; ++i) {
+            const long scaled = std::lrint(static_cast<float>(data[i]) * gain);
+            data[i] = static_cast<int16_t>(std::min(32767L, std::max(-32768L, scaled)));
+        }
+    }
+}
+
+/**
+ * @brief 清零。
+ */
+void AudioLevels::reset() {
+    peak = 0.0f;
+    sumSquares = 0.0;
+    samples = 0;
+}
+
+/**
+ * @brief 峰值换算为 dBFS。
+ * @return dBFS。
+ */
+double AudioLevels::peakDb() const {
+    return toDb(peak);
+}
+
+/**
+ * @brief 平方和换算为 RMS 后转 dBFS。
+ * @return dBFS。
+ */
+double AudioLevels::rmsDb() const {
+    if (samples == 0) {
+        return kSilenceDb;
+    }
+    return toDb(std::sqrt(sumSquares / static_cast<double>(samples)));
+}
+
+/**
+ * @brief 覆盖解码器最常见的输出格式。
+ * @param format 样本格式。
+ * @return true 表示支持。
+ */
+bool AudioProcessor::canMeasure(AVSampleFormat format) {
+    switch (format) {
+    case AV_SAMPLE_FMT_FLT:
+    case AV_SAMPLE_FMT_FLTP:
+    case AV_SAMPLE_FMT_S16:
+    case AV_SAMPLE_FMT_S16P:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 电平不区分通道，打包格式整体处理，平面格式逐个平面处理。
+ * @param planes 数据平面。
+ * @param format 样本格式。
+ * @param channels 通道数。
+ * @param samples 每通道样本数。
+ * @param levels 累计结果。
+ */
+void AudioProcessor::measure(const uint8_t* const* planes, AVSampleFormat format, int channels, int samples, AudioLevels& levels) {
+    if (channels <= 0 || samples <= 0) {
+        return;
+    }
+    const bool planar = av_sample_fmt_is_planar(format) != 0;
+    const int planeCount = planar ? channels : 1;
+    const size_t perPlane = static_cast<size_t>(samples) * (planar ? 1 : channels);
+    for (int p = 0; p < planeCount; ++p) {
+        if (format == AV_SAMPLE_FMT_FLT || format == AV_SAMPLE_FMT_FLTP) {
+            measureFloat(reinterpret_cast<const float*>(planes[p]), perPlane, levels);
+        }
+        else if (format == AV_SAMPLE_FMT_S16 || format == AV_SAMPLE_FMT_S16P) {
+            measureS16(reinterpret_cast<const int16_t*>(planes[p]), perPlane, levels);
+        }
+    }
+}
+
+/**
+ * @brief 按输出格式分派增益内核。
+ * @param data 样本数据。
+ * @param format 样本格式。
+ * @param count 样本数。
+ * @param gain 增益。
+ * @return 是否已施加。
+ */
+bool AudioProcessor::applyGain(uint8_t* data, AVSampleFormat format, size_t count, float gain) {
+    switch (format) {
+    case AV_SAMPLE_FMT_FLT:
+        gainFloat(reinterpret_cast<float*>(data), count, gain);
+        return true;
+    case AV_SAMPLE_FMT_S16:
+        gainS16(reinterpret_cast<int16_t*>(data), count, gain);
+        return true;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,321 @@
+/**
+ * @file audioringdevice.cpp
+ * @brief 实现拉模式音频设备的写入、读取、静音补齐与时间锚点换算。
+ * @mainfunctions
+ *   - AudioRingDevice::push
+ *   - AudioRingDevice::enforceQueueLimit
+ *   - AudioRingDevice::reserve
+ *   - AudioRingDevice::readData
+ *   - AudioRingDevice::ptsAtReadPosition
+ * @mainclasses
+ *   - AudioRingDevice
+ */
+
+#include "audioringdevice.h"
+
+#include "probes.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    constexpr double kAnchorToleranceSec = 0.001; // 写入时间与外推值偏差超过 1 ms 才记录新锚点
+}
+
+/**
+ * @brief 以无缓冲只读方式打开，避免 QIODevice 内部预读打乱读位置与播放位置的对应关系。
+ * @param capacityBytes 环形缓冲容量。
+ * @param parent Qt 父对象。
+ */
+AudioRingDevice::AudioRingDevice(size_t capacityBytes, QObject* parent)
+    : QIODevice(parent),
+    m_ring(capacityBytes) {
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+/**
+ * @brief 清空数据、锚点与读写双方的私有状态。
+ * @param bytesPerSecond 每秒字节数。
+ * @param bytesPerFrame 每帧字节数。
+ */
+void AudioRingDevice::configure(int bytesPerSecond, int bytesPerFrame) {
+    m_bytesPerSecond = bytesPerSecond;
+    m_bytesPerFrame = bytesPerFrame > 0 ? bytesPerFrame : 1;
+    m_ring.reset();
+    m_anchorHead.store(0, std::memory_order_relaxed);
+    m_anchorTail.store(0, std::memory_order_relaxed);
+    m_hasAnchor = false;
+    m_anchorFloor = 0;
+    m_appliedDiscard = 0;
+    m_hasPushed = false;
+    m_discardUntil.store(0, std::memory_order_relaxed);
+    m_primed = false;
+    m_starved = false;
+}
+
+/**
+ * @brief 拷贝写入，用于可写区域在缓冲区尾部被截断的情况。
+ * @param data PCM 数据。
+ * @param bytes 字节数。
+ * @param pts 首样本时间。
+ * @param rate 播放速率。
+ * @return 实际写入字节数。
+ */
+size_t AudioRingDevice::push(const char* data, size_t bytes, double pts, double rate) {
+    enforceQueueLimit(bytes);
+    recordAnchor(pts, rate);
+    const size_t written = m_ring.write(data, bytes);
+    if (written < bytes) {
+        m_overflowBytes.fetch_add(bytes - written, std::memory_order_relaxed);
+    }
+    return written;
+}
+
+/**
+ * @brief 可写区域按整帧截断，保证原地写入的数据不会拆开一个采样帧。
+ * @param data 输出参数。
+ * @return 字节数。
+ */
+size_t AudioRingDevice::reserve(char** data) {
+    const size_t span = m_ring.writableSpan(data);
+    return span / m_bytesPerFrame * m_bytesPerFrame;
+}
+
+/**
+ * @brief 先记录锚点（使用发布前的写位置）再发布数据。
+ * @param bytes 字节数。
+ * @param pts 首样本时间。
+ * @param rate 播放速率。
+ */
+void AudioRingDevice::commit(size_t bytes, double pts, double rate) {
+    recordAnchor(pts, rate);
+    m_ring.commitWrite(bytes);
+    enforceQueueLimit(0);
+}
+
+/**
+ * @brief 保留上限 3/4 减去即将写入的部分，读位置由生产者推进；锚点按写位置记录，丢弃后读取端照常换算。
+ * @param incomingBytes 即将写入的字节数。
+ */
+void AudioRingDevice::enforceQueueLimit(size_t incomingBytes) {
+    const size_t limit = maxQueuedBytes();
+    if (limit == 0 || m_ring.size() + incomingBytes <= limit) {
+        return;
+    }
+    const size_t keep = limit * 3 / 4;
+    const size_t keepBytes = (keep > incomingBytes ? keep - incomingBytes : 0) / m_bytesPerFrame * m_bytesPerFrame;
+    const size_t trimmed = m_ring.discardOldest(keepBytes);
+    m_trimmedFrames.fetch_add(trimmed / m_bytesPerFrame, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 上限按每秒字节数换算。
+ * @return 字节数。
+ */
+size_t AudioRingDevice::maxQueuedBytes() const {
+    const int maxQueuedMs = m_maxQueuedMs.load(std::memory_order_relaxed);
+    if (maxQueuedMs <= 0 || m_bytesPerSecond <= 0) {
+        return 0;
+    }
+    return static_cast<size_t>(static_cast<int64_t>(m_bytesPerSecond) * maxQueuedMs / 1000);
+}
+
+/**
+ * @brief 时间与上一锚点外推一致时不再记录锚点，锚点队列写满时跳过（读取端继续外推）。
+ * @param pts 首样本时间。
+ * @param rate 播放速率。
+ */
+void AudioRingDevice::recordAnchor(double pts, double rate) {
+    const uint64_t position = m_ring.writePosition();
+    if (std::isfinite(pts) && m_bytesPerSecond > 0) {
+        bool needAnchor = !m_hasPushed || rate != m_lastPushed.rate;
+        if (!needAnchor) {
+            const double expected = m_lastPushed.pts +
+                static_cast<double>(position - m_lastPushed.position) / m_bytesPerSecond * m_lastPushed.rate;
+            needAnchor = std::abs(pts - expected) > kAnchorToleranceSec;
+        }
+
+        const uint32_t head = m_anchorHead.load(std::memory_order_relaxed);
+        if (needAnchor && head - m_anchorTail.load(std::memory_order_acquire) < kMaxAnchors) {
+            m_anchors[head % kMaxAnchors] = Anchor{ position, pts, rate };
+            m_anchorHead.store(head + 1, std::memory_order_release);
+            m_lastPushed = Anchor{ position, pts, rate };
+            m_hasPushed = true;
+        }
+    }
+}
+
+/**
+ * @brief 记录当前写位置，读取端下次读取时跳到该位置。
+ */
+void AudioRingDevice::discardQueued() {
+    m_discardUntil.store(m_ring.writePosition(), std::memory_order_release);
+}
+
+/**
+ * @brief 保存回调。
+ * @param callback 回调函数。
+ */
+void AudioRingDevice::setPositionCallback(PositionCallback callback) {
+    m_positionCallback = std::move(callback);
+}
+
+/**
+ * @brief 返回排队字节数。
+ * @return 字节数。
+ */
+size_t AudioRingDevice::queuedBytes() const {
+    return m_ring.size();
+}
+
+/**
+ * @brief 返回欠载次数。
+ * @return 次数。
+ */
+quint64 AudioRingDevice::underrunCount() const {
+    return m_underruns.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 返回溢出字节数。
+ * @return 字节数。
+ */
+quint64 AudioRingDevice::overflowBytes() const {
+    return m_overflowBytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 清零计数。
+ */
+void AudioRingDevice::resetCounters() {
+    m_underruns.store(0, std::memory_order_relaxed);
+    m_overflowBytes.store(0, std::memory_order_relaxed);
+    m_trimmedFrames.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 保存上限，下一次写入或读取时生效。
+ * @param maxQueuedMs 上限（毫秒）。
+ */
+void AudioRingDevice::setMaxQueuedMs(int maxQueuedMs) {
+    m_maxQueuedMs.store(maxQueuedMs > 0 ? maxQueuedMs : 0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 返回裁剪帧数。
+ * @return 帧数。
+ */
+quint64 AudioRingDevice::trimmedFrames() const {
+    return m_trimmedFrames.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 顺序设备。
+ * @return true。
+ */
+bool AudioRingDevice::isSequential() const {
+    return true;
+}
+
+/**
+ * @brief 先处理丢弃请求与时长上限并上报读位置，再按整帧读取；开始出数据之后的不足才计为欠载，
+ *        连续欠载只计一次。
+ * @param data 目标缓冲。
+ * @param maxlen 请求字节数。
+ * @return 按整帧对齐后的字节数。
+ */
+qint64 AudioRingDevice::readData(char* data, qint64 maxlen) {
+    const size_t wanted = static_cast<size_t>(maxlen > 0 ? maxlen : 0) / m_bytesPerFrame * m_bytesPerFrame;
+    if (wanted == 0) {
+        return 0;
+    }
+
+    uint64_t readPos = m_ring.readPosition();
+    const uint64_t discardUntil = m_discardUntil.load(std::memory_order_acquire);
+    if (discardUntil != m_appliedDiscard) {
+        // 缓冲已空时同样要作废当前锚点
+        m_appliedDiscard = discardUntil;
+        if (discardUntil > readPos) {
+            m_ring.discard(static_cast<size_t>(discardUntil - readPos));
+            readPos = m_ring.readPosition();
+        }
+        // 丢弃的数据（例如上一连接的音频）的时间不能外推到之后的数据上
+        m_hasAnchor = false;
+        m_anchorFloor = discardUntil;
+    }
+
+    // 写入端已在每次写入时裁剪；上限刚被调低时由读取端补做一次，丢弃最旧的整帧数据
+    const size_t limit = maxQueuedBytes();
+    if (limit > 0) {
+        const size_t queued = m_ring.size();
+        if (queued > limit) {
+            const size_t keepBytes = limit * 3 / 4 / m_bytesPerFrame * m_bytesPerFrame;
+            const size_t trimmed = m_ring.discard((queued - keepBytes) / m_bytesPerFrame * m_bytesPerFrame);
+            m_trimmedFrames.fetch_add(trimmed / m_bytesPerFrame, std::memory_order_relaxed);
+            readPos = m_ring.readPosition();
+        }
+    }
+
+    if (m_positionCallback) {
+        m_positionCallback(ptsAtReadPosition(readPos), m_ring.size());
+    }
+
+    const size_t got = m_ring.read(data, wanted);
+    if (got < wanted) {
+        // 补静音（有符号 PCM 与浮点的零值均为静音）
+        std::memset(data + got, 0, wanted - got);
+        if (m_primed && !m_starved) {
+            [[maybe_unused]] const quint64 underruns = m_underruns.fetch_add(1, std::memory_order_relaxed) + 1;
+            LSP_PROBE3(audio_underrun, underruns, wanted - got, wanted);
+        }
+        m_starved = true;
+    }
+    else {
+        m_starved = false;
+    }
+    if (got > 0) {
+        m_primed = true;
+    }
+    return static_cast<qint64>(wanted);
+}
+
+/**
+ * @brief 只读设备。
+ * @param data 未使用。
+ * @param len 未使用。
+ * @return -1。
+ */
+qint64 AudioRingDevice::writeData(const char* data, qint64 len) {
+    Q_UNUSED(data);
+    Q_UNUSED(len);
+    return -1;
+}
+
+/**
+ * @brief 锚点按写位置递增排列，逐个取出直到遇到尚未播放到的锚点。
+ * @param readPos 读位置。
+ * @return 媒体时间。
+ */
+double AudioRingDevice::ptsAtReadPosition(uint64_t readPos) {
+    uint32_t tail = m_anchorTail.load(std::memory_order_relaxed);
+    const uint32_t head = m_anchorHead.load(std::memory_order_acquire);
+    while (tail != head) {
+        const Anchor& anchor = m_anchors[tail % kMaxAnchors];
+        if (anchor.position > readPos) {
+            break;
+        }
+        if (anchor.position >= m_anchorFloor) {
+            m_currentAnchor = anchor;
+            m_hasAnchor = true;
+        }
+        ++tail;
+    }
+    m_anchorTail.store(tail, std::memory_order_release);
+
+    if (!m_hasAnchor || m_bytesPerSecond <= 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return m_currentAnchor.pts +
+        static_cast<double>(readPos - m_currentAnchor.position) / m_bytesPerSecond * m_currentAnchor.rate;
+}
@@ -0,0 +1,218 @@
+/**
+ * @file audioringdevice.h
+ * @brief 定义以 PCM 环形缓冲为数据源的拉模式音频设备。
+ * @mainfunctions
+ *   - configure
+ *   - push
+ *   - reserve
+ *   - commit
+ *   - discardQueued
+ *   - setMaxQueuedMs
+ *   - setPositionCallback
+ *   - readData
+ * @mainclasses
+ *   - AudioRingDevice
+ */
+
+#ifndef AUDIORINGDEVICE_H
+#define AUDIORINGDEVICE_H
+
+#include <QIODevice>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include "pcmringbuffer.h"
+
+/**
+ * @brief AudioRingDevice 交给 QAudioOutput::start(QIODevice*) 以拉模式播放。
+ *
+ * 音频解码线程通过 reserve()/commit() 原地写入环形缓冲（区域被尾部截断时退回 push() 拷贝），
+ * 设备在需要数据时调用 readData() 读取，
+ * 中间不经过 UI 定时器，也没有逐块 QByteArray 拷贝。缓冲读空时以静音补齐，设备保持运行并记录一次欠载。
+ * 每段写入可附带首样本时间，构成独立的无锁时间锚点队列，读取时据此换算当前读位置对应的媒体时间。
+ */
+class AudioRingDevice : public QIODevice {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 读取前回调，参数为当前读位置的媒体时间（未知时为 NaN）与环形缓冲中排队的字节数。
+     */
+    using PositionCallback = std::function<void(double pts, size_t queuedBytes)>;
+
+    /**
+     * @brief 构造函数，分配环形缓冲并以只读方式打开设备。
+     * @param capacityBytes 环形缓冲容量。
+     * @param parent Qt 父对象。
+     */
+    explicit AudioRingDevice(size_t capacityBytes, QObject* parent = nullptr);
+
+    /**
+     * @brief 设置 PCM 格式并清空缓冲，调用时生产者与 QAudioOutput 都不得访问设备。
+     * @param bytesPerSecond 每秒字节数。
+     * @param bytesPerFrame 每个采样帧（全部通道）的字节数。
+     */
+    void configure(int bytesPerSecond, int bytesPerFrame);
+
+    /**
+     * @brief 写入一段 PCM（仅生产者线程调用），不阻塞；写入后排队超出时长上限时先丢弃最旧的数据，
+     *        仍写不下的部分丢弃并计入溢出。
+     * @param data 交错 PCM 数据。
+     * @param bytes 字节数。
+     * @param pts 首样本的媒体时间（秒），NaN 表示沿用上一锚点外推。
+     * @param rate 每秒播放对应的媒体时长。
+     * @return 实际写入的字节数。
+     */
+    size_t push(const char* data, size_t bytes, double pts, double rate);
+
+    /**
+     * @brief 获取可直接写入的连续区域（仅生产者线程调用），重采样器可原地输出，省去中间拷贝。
+     * @param data 输出参数，区域起始地址。
+     * @return 区域字节数（按整帧向下取整）。
+     */
+    size_t reserve(char** data);
+
+    /**
+     * @brief 发布已写入 reserve 区域的数据（仅生产者线程调用），超出时长上限时随即丢弃最旧的数据。
+     * @param bytes 字节数，不得超过 reserve 返回值。
+     * @param pts 首样本的媒体时间（秒），NaN 表示沿用上一锚点外推。
+     * @param rate 每秒播放对应的媒体时长。
+     */
+    void commit(size_t bytes, double pts, double rate);
+
+    /**
+     * @brief 请求丢弃当前已写入的全部数据，在下一次读取时生效，任意线程可调用。
+     */
+    void discardQueued();
+
+    /**
+     * @brief 设置排队 PCM 的时长上限，任意线程可调用。写入端在每次写入时检查，读取端在每次读取时检查，
+     *        超出时丢弃最旧的数据，一次裁剪到上限的 3/4，避免每次写入或读取都产生一处不连续。
+     *        设备停滞（不再读取）时由写入端裁剪，排队的始终是最新的音频。
+     * @param maxQueuedMs 上限（毫秒），0 表示不限制（仅受缓冲容量约束）。
+     */
+    void setMaxQueuedMs(int maxQueuedMs);
+
+    /**
+     * @brief 查询因超出时长上限而裁剪掉的采样帧数。
+     * @return 累计帧数（每帧含全部通道）。
+     */
+    quint64 trimmedFrames() const;
+
+    /**
+     * @brief 设置读取前回调，需在 QAudioOutput 开始拉取之前设置。
+     * @param callback 回调函数。
+     */
+    void setPositionCallback(PositionCallback callback);
+
+    /**
+     * @brief 查询环形缓冲中排队的字节数。
+     * @return 字节数。
+     */
+    size_t queuedBytes() const;
+
+    /**
+     * @brief 查询欠载次数（缓冲读空、需要以静音补齐的次数）。
+     * @return 累计次数。
+     */
+    quint64 underrunCount() const;
+
+    /**
+     * @brief 查询因缓冲写满而丢弃的字节数。
+     * @return 累计字节数。
+     */
+    quint64 overflowBytes() const;
+
+    /**
+     * @brief 清零欠载、溢出与裁剪计数。
+     */
+    void resetCounters();
+
+    /**
+     * @brief 顺序设备，不支持定位。
+     * @return true。
+     */
+    bool isSequential() const override;
+
+protected:
+    /**
+     * @brief 由 QAudioOutput 在其所属线程调用，从环形缓冲读取，不足部分填充静音。
+     * @param data 目标缓冲。
+     * @param maxlen 请求字节数。
+     * @return 按整帧对齐后的请求字节数（不足部分为静音），保持设备处于活动状态。
+     */
+    qint64 readData(char* data, qint64 maxlen) override;
+
+    /**
+     * @brief 只读设备，拒绝写入。
+     * @return -1。
+     */
+    qint64 writeData(const char* data, qint64 len) override;
+
+private:
+    /**
+     * @brief 时间锚点：写位置 position 处样本的媒体时间。
+     */
+    struct Anchor {
+        uint64_t position = 0;
+        double pts = 0.0;
+        double rate = 1.0;
+    };
+
+    static constexpr uint32_t kMaxAnchors = 128;
+
+    /**
+     * @brief 消费者侧：取出所有不晚于读位置的锚点并换算读位置的媒体时间。
+     * @param readPos 读位置。
+     * @return 媒体时间，无锚点时为 NaN。
+     */
+    double ptsAtReadPosition(uint64_t readPos);
+
+    /**
+     * @brief 生产者侧：时间与外推值不一致时在当前写位置记录锚点。
+     * @param pts 首样本时间。
+     * @param rate 播放速率。
+     */
+    void recordAnchor(double pts, double rate);
+
+    /**
+     * @brief 生产者侧：排队数据加上即将写入的数据超出时长上限时，丢弃最旧的整帧数据并计入裁剪帧数。
+     * @param incomingBytes 即将写入的字节数，写入之后检查时为 0。
+     */
+    void enforceQueueLimit(size_t incomingBytes);
+
+    /**
+     * @brief 按当前格式把时长上限换算为字节数。
+     * @return 字节数，0 表示不限制。
+     */
+    size_t maxQueuedBytes() const;
+
+    PcmRingBuffer m_ring;
+    int m_bytesPerSecond = 0;
+    int m_bytesPerFrame = 1;
+    PositionCallback m_positionCallback;
+
+    // 锚点队列同样为单生产者/单消费者
+    std::array<Anchor, kMaxAnchors> m_anchors;
+    std::atomic<uint32_t> m_anchorHead{ 0 };    // 生产者写入
+    std::atomic<uint32_t> m_anchorTail{ 0 };    // 消费者读取
+    Anchor m_currentAnchor;                     // 消费者独占
+    bool m_hasAnchor = false;                   // 消费者独占
+    uint64_t m_anchorFloor = 0;                 // 消费者独占：早于该位置的锚点属于已丢弃数据
+    uint64_t m_appliedDiscard = 0;              // 消费者独占：最近一次已执行的丢弃请求
+    Anchor m_lastPushed;                        // 生产者独占，用于判断是否需要新锚点
+    bool m_hasPushed = false;                   // 生产者独占
+
+    std::atomic<uint64_t> m_discardUntil{ 0 };  // 读位置需要跳过到的写位置
+    bool m_primed = false;                      // 消费者独占：是否已读到过数据
+    bool m_starved = false;                     // 消费者独占：上一次读取是否欠载
+    std::atomic<quint64> m_underruns{ 0 };
+    std::atomic<quint64> m_overflowBytes{ 0 };
+    std::atomic<int> m_maxQueuedMs{ 0 };
+    std::atomic<quint64> m_trimmedFrames{ 0 };
+};
+
+#endif // AUDIORINGDEVICE_H
@@ -0,0 +1,675 @@
+/**
+ * @file benchmain.cpp
+ * @brief 基准测试入口：生成确定的合成流，以文件实时回放或环回 TCP 方式驱动多路播放器，
+ *        热身后测量呈现帧率、各阶段耗时分位数、CPU、内存分配次数与峰值内存，输出一个 JSON 结果对象。
+ * @mainfunctions
+ *   - main
+ * @mainclasses
+ *   - 无
+ */
+
+#include "allocationcounter.h"
+#include "converterbench.h"
+#include "driftsimulation.h"
+#include "framemailbox.h"
+#include "frametrace.h"
+#include "interleaverbench.h"
+#include "livestreamplayer.h"
+#include "syntheticstream.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+    constexpr int kFrameDrainIntervalMs = 16;   // 与无界面入口相同的取帧周期
+    constexpr int kServerStartupMs = 200;       // 环回服务端进入监听后再启动播放器
+    constexpr int kFirstLoopbackPort = 18554;   // 第 i 路使用 kFirstLoopbackPort + i
+    constexpr int kGenerationMarginSec = 5;     // 合成流比测量窗口多出的时长，覆盖连接与缓冲
+    constexpr double kDriftSimulationSkewsPpm[] = { -200.0, -100.0, 0.0, 100.0, 200.0 }; // 漂移仿真覆盖的时钟偏差
+
+    /**
+     * @brief 与 headlessmain.cpp 相同的三种运行模式。
+     */
+    enum class BenchMode {
+        DecodeOnly,
+        Convert,
+        Full
+    };
+
+    /**
+     * @brief 测量窗口起点的快照。
+     */
+    struct Baseline {
+        double cpuSec = 0.0;
+        uint64_t allocations = 0;
+        uint64_t audioDecodeAllocations = 0;
+        uint64_t audioOutputAllocations = 0;
+        std::vector<PlayerStats> players;    // 各路窗口起点的统计，用于计算帧数与缓冲池计数的增量
+        int reconnects = 0;
+        int stalls = 0;
+        double stallMs = 0.0;
+    };
+
+    /**
+     * @brief 测量窗口内的延迟采样，统计事件驱动累加。
+     */
+    struct LatencyAccumulator {
+        double sumMs = 0.0;
+        double maxMs = 0.0;
+        qint64 samples = 0;
+    };
+
+    /**
+     * @brief 进程累计的用户态与内核态 CPU 时间。
+     * @return 秒。
+     */
+    double processCpuSeconds() {
+#ifdef Q_OS_WIN
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+            return 0.0;
+        }
+        const auto toSeconds = [](const FILETIME& time) {
+            return static_cast<double>((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+        };
+        return toSeconds(kernel) + toSeconds(user);
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+            + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+    }
+
+    /**
+     * @brief 进程峰值常驻内存。
+     * @return KiB。
+     */
+    qint64 peakResidentMemoryKb() {
+#ifdef Q_OS_WIN
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return -1;
+        }
+        return static_cast<qint64>(counters.PeakWorkingSetSize / 1024);
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MACOS
+        return static_cast<qint64>(usage.ru_maxrss / 1024); // macOS 以字节为单位
+#else
+        return static_cast<qint64>(usage.ru_maxrss);
+#endif
+#endif
+    }
+
+    /**
+     * @brief 解析模式名称。
+     * @param text 命令行取值。
+     * @param mode 输出参数。
+     * @return 名称有效时返回 true。
+     */
+    bool parseMode(const QString& text, BenchMode* mode) {
+        if (text == QStringLiteral("decode")) {
+            *mode = BenchMode::DecodeOnly;
+        }
+        else if (text == QStringLiteral("convert")) {
+            *mode = BenchMode::Convert;
+        }
+        else if (text == QStringLiteral("full")) {
+            *mode = BenchMode::Full;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 解析分辨率档位。
+     * @param text 720p / 1080p / 4k。
+     * @param config 输出参数，写入宽高。
+     * @return 名称有效时返回 true。
+     */
+    bool parseResolution(const QString& text, SyntheticStream::Config* config) {
+        if (text == QStringLiteral("720p")) {
+            config->width = 1280;
+            config->height = 720;
+        }
+        else if (text == QStringLiteral("1080p")) {
+            config->width = 1920;
+            config->height = 1080;
+        }
+        else if (text == QStringLiteral("4k")) {
+            config->width = 3840;
+            config->height = 2160;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 解析逗号分隔的线程数列表。
+     * @param text 例如 "1,2,4,8"。
+     * @param counts 输出参数。
+     * @return 每一项都是正整数时返回 true。
+     */
+    bool parseThreadCounts(const QString& text, std::vector<int>* counts) {
+        counts->clear();
+        for (const QString& item : text.split(QLatin1Char(','))) {
+            bool ok = false;
+            const int count = item.trimmed().toInt(&ok);
+            if (!ok || count <= 0) {
+                return false;
+            }
+            counts->push_back(count);
+        }
+        return !counts->empty();
+    }
+
+    /**
+     * @brief 对每个时钟偏差运行一次 24 小时漂移仿真。
+     * @param passed 输出参数，全部偏差下水位有界且估计收敛时为 true。
+     * @return 结果对象。
+     */
+    QJsonObject runDriftSimulation(bool* passed) {
+        *passed = true;
+        QJsonArray runs;
+        uint32_t seed = 1;
+        for (double skewPpm : kDriftSimulationSkewsPpm) {
+            DriftSimulation::Config config;
+            config.skewPpm = skewPpm;
+            config.seed = seed++;
+            const DriftSimulation::Result result = DriftSimulation::run(config);
+            *passed = *passed && result.bounded && result.converged;
+
+            QJsonObject run;
+            run.insert(QStringLiteral("skewPpm"), skewPpm);
+            run.insert(QStringLiteral("durationSec"), config.durationSec);
+            run.insert(QStringLiteral("jitterMs"), config.jitterMs);
+            run.insert(QStringLiteral("targetMs"), config.targetMs);
+            run.insert(QStringLiteral("minBufferMs"), result.minBufferMs);
+            run.insert(QStringLiteral("settledMinMs"), result.settledMinMs);
+            run.insert(QStringLiteral("settledMaxMs"), result.settledMaxMs);
+            run.insert(QStringLiteral("finalDriftPpm"), result.finalDriftPpm);
+            run.insert(QStringLiteral("maxDriftErrorPpm"), result.maxDriftErrorPpm);
+            run.insert(QStringLiteral("maxWindowMeanErrorPpm"), result.maxWindowMeanErrorPpm);
+            run.insert(QStringLiteral("bounded"), result.bounded);
+            run.insert(QStringLiteral("converged"), result.converged);
+            runs.append(run);
+        }
+        QJsonObject object;
+        object.insert(QStringLiteral("driftSimulation"), runs);
+        object.insert(QStringLiteral("passed"), *passed);
+        return object;
+    }
+
+    /**
+     * @brief 输出结果：指定文件时写入文件，否则写到标准输出。
+     * @param result 结果对象。
+     * @param path 文件路径，为空时写到标准输出。
+     */
+    void writeResult(const QJsonObject& result, const QString& path) {
+        const QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Indented);
+        if (!path.isEmpty()) {
+            QFile file(path);
+            if (file.open(QIODevice::WriteOnly)) {
+                file.write(json);
+            }
+            else {
+                std::fprintf(stderr, "Cannot write %s\n", qPrintable(path));
+            }
+        }
+        else {
+            std::fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+            std::fflush(stdout);
+        }
+    }
+
+    /**
+     * @brief 阶段名称，作为结果中的键。
+     * @param stage 阶段。
+     * @return 名称。
+     */
+    QString stageName(LiveStreamPlayer::PipelineStage stage) {
+        switch (stage) {
+        case LiveStreamPlayer::PipelineStage::VideoQueueWait:
+            return QStringLiteral("videoQueueWait");
+        case LiveStreamPlayer::PipelineStage::VideoDecode:
+            return QStringLiteral("videoDecode");
+        case LiveStreamPlayer::PipelineStage::VideoConvert:
+            return QStringLiteral("videoConvert");
+        default:
+            return QStringLiteral("packetToPresent");
+        }
+    }
+
+    /**
+     * @brief 直方图汇总转为 JSON。
+     * @param summary 汇总结果。
+     * @return JSON 对象。
+     */
+    QJsonObject summaryToJson(const LatencyHistogram::Summary& summary) {
+        QJsonObject object;
+        object.insert(QStringLiteral("count"), static_cast<double>(summary.count));
+        object.insert(QStringLiteral("meanUs"), summary.meanUs);
+        object.insert(QStringLiteral("p50Us"), summary.p50Us);
+        object.insert(QStringLiteral("p90Us"), summary.p90Us);
+        object.insert(QStringLiteral("p99Us"), summary.p99Us);
+        object.insert(QStringLiteral("maxUs"), summary.maxUs);
+        return object;
+    }
+}
+
+/**
+ * @brief 解析命令行，生成（或复用）合成流，启动各路播放器；热身结束时清零统计，测量窗口结束时输出结果并退出。
+ * @param argc 命令行参数数量。
+ * @param argv 命令行参数数组。
+ * @return 0 表示正常结束，1 表示参数错误，2 表示生成合成流失败，3 表示转换微基准的误差超出容限，4 表示漂移仿真未通过，
+ *         5 表示开启 --check-audio-allocs 时音频输出线程在测量窗口内发生了堆分配，6 表示音频交错与参考实现不一致。
+ */
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("LiveStreamPullPlayerBench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("拉流播放器基准测试：以合成流驱动播放器并输出 JSON 结果。"));
+    parser.addHelpOption();
+    const QCommandLineOption codecOption(QStringLiteral("codec"),
+        QStringLiteral("视频编码：h264 或 hevc。"), QStringLiteral("codec"), QStringLiteral("h264"));
+    const QCommandLineOption resolutionOption(QStringLiteral("resolution"),
+        QStringLiteral("分辨率：720p、1080p 或 4k。"), QStringLiteral("name"), QStringLiteral("1080p"));
+    const QCommandLineOption fpsOption(QStringLiteral("fps"),
+        QStringLiteral("帧率。"), QStringLiteral("fps"), QStringLiteral("30"));
+    const QCommandLineOption gopOption(QStringLiteral("gop"),
+        QStringLiteral("关键帧间隔（帧）。"), QStringLiteral("frames"), QStringLiteral("60"));
+    const QCommandLineOption bitrateOption(QStringLiteral("bitrate"),
+        QStringLiteral("视频码率（kbps），0 表示按分辨率取默认值。"), QStringLiteral("kbps"), QStringLiteral("0"));
+    const QCommandLineOption noAudioOption(QStringLiteral("no-audio"),
+        QStringLiteral("不生成音频轨。"));
+    const QCommandLineOption durationOption(QStringLiteral("duration"),
+        QStringLiteral("测量时长（秒）。"), QStringLiteral("seconds"), QStringLiteral("20"));
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"),
+        QStringLiteral("热身时长（秒），期间的样本不计入结果。"), QStringLiteral("seconds"), QStringLiteral("2"));
+    const QCommandLineOption transportOption(QStringLiteral("transport"),
+        QStringLiteral("file：按时间戳实时读取本地文件；tcp：经环回 TCP 匀速发送。"), QStringLiteral("name"), QStringLiteral("file"));
+    const QCommandLineOption streamsOption(QStringLiteral("streams"),
+        QStringLiteral("并发播放器数量。"), QStringLiteral("count"), QStringLiteral("1"));
+    const QCommandLineOption modeOption(QStringLiteral("mode"),
+        QStringLiteral("decode、convert 或 full，含义同无界面入口。"), QStringLiteral("mode"), QStringLiteral("full"));
+    const QCommandLineOption workDirOption(QStringLiteral("work-dir"),
+        QStringLiteral("合成流的存放目录，同参数的文件已存在时直接复用。"), QStringLiteral("dir"), QStringLiteral("."));
+    const QCommandLineOption impairOption(QStringLiteral("impair"),
+        QStringLiteral("网络损伤脚本，语法同无界面程序。"), QStringLiteral("profile"));
+    const QCommandLineOption traceOption(QStringLiteral("trace"),
+        QStringLiteral("在测量窗口内记录逐帧追踪并导出为 Chrome Trace JSON。"), QStringLiteral("file"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+        QStringLiteral("结果写入的文件，默认写到标准输出。"), QStringLiteral("file"));
+    const QCommandLineOption driftSimulationOption(QStringLiteral("drift-simulation"),
+        QStringLiteral("只运行音频漂移控制的 24 小时确定性仿真（±200 ppm 时钟偏差加网络抖动），不通过时退出码为 4。"));
+    const QCommandLineOption converterOption(QStringLiteral("converter"),
+        QStringLiteral("只测转换阶段：simd 或 sws，报告与 swscale 的最大误差与吞吐。"), QStringLiteral("path"));
+    const QCommandLineOption convertThreadsOption(QStringLiteral("convert-threads"),
+        QStringLiteral("只测转换阶段：逗号分隔的线程数列表，如 1,2,4,8，逐个报告 MPix/s。"), QStringLiteral("list"), QStringLiteral("1"));
+    const QCommandLineOption convertFramesOption(QStringLiteral("convert-frames"),
+        QStringLiteral("转换测量时每个线程数的转换次数。"), QStringLiteral("frames"), QStringLiteral("300"));
+    const QCommandLineOption checkAudioAllocsOption(QStringLiteral("check-audio-allocs"),
+        QStringLiteral("测量窗口内音频输出线程发生任何堆分配时退出码为 5；配合 --duration 600 做 10 分钟检查。"));
+    const QCommandLineOption interleaverCheckOption(QStringLiteral("interleaver-check"),
+        QStringLiteral("只检查音频直通交错与标量参考实现逐位一致并测吞吐，不一致时退出码为 6。"));
+    parser.addOptions({ codecOption, resolutionOption, fpsOption, gopOption, bitrateOption, noAudioOption,
+        durationOption, warmupOption, transportOption, streamsOption, modeOption, workDirOption, impairOption, traceOption, outputOption,
+        converterOption, convertThreadsOption, convertFramesOption, driftSimulationOption, checkAudioAllocsOption,
+        interleaverCheckOption });
+    parser.process(app);
+
+    if (parser.isSet(driftSimulationOption)) {
+        bool passed = false;
+        writeResult(runDriftSimulation(&passed), parser.value(outputOption));
+        return passed ? 0 : 4;
+    }
+
+    if (parser.isSet(interleaverCheckOption)) {
+        bool matched = false;
+        writeResult(InterleaverBench::run(&matched), parser.value(outputOption));
+        return matched ? 0 : 6;
+    }
+
+    SyntheticStream::Config config;
+    const QString codecName = parser.value(codecOption);
+    if (codecName == QStringLiteral("hevc")) {
+        config.codec = SyntheticStream::VideoCodec::Hevc;
+    }
+    else if (codecName != QStringLiteral("h264")) {
+        std::fprintf(stderr, "Unknown codec: %s\n", qPrintable(codecName));
+        return 1;
+    }
+    const QString resolutionName = parser.value(resolutionOption);
+    if (!parseResolution(resolutionName, &config)) {
+        std::fprintf(stderr, "Unknown resolution: %s\n", qPrintable(resolutionName));
+        return 1;
+    }
+
+    if (parser.isSet(converterOption) || parser.isSet(convertThreadsOption)) {
+        // 转换微基准：不生成合成流、不启动播放器，只以内存中的 YUV 帧驱动 VideoConverter
+        ConverterBench::Config benchConfig;
+        benchConfig.width = config.width;
+        benchConfig.height = config.height;
+        const QString converterName = parser.isSet(converterOption) ? parser.value(converterOption) : QStringLiteral("simd");
+        if (converterName == QStringLiteral("sws")) {
+            benchConfig.path = ConverterBench::Path::Sws;
+        }
+        else if (converterName != QStringLiteral("simd")) {
+            std::fprintf(stderr, "Unknown converter: %s\n", qPrintable(converterName));
+            return 1;
+        }
+        bool framesOk = false;
+        benchConfig.frames = parser.value(convertFramesOption).toInt(&framesOk);
+        if (!parseThreadCounts(parser.value(convertThreadsOption), &benchConfig.threadCounts) || !framesOk || benchConfig.frames <= 0) {
+            std::fprintf(stderr, "Invalid --convert-threads or --convert-frames.\n");
+            return 1;
+        }
+        bool withinTolerance = false;
+        QJsonObject result = ConverterBench::run(benchConfig, &withinTolerance);
+        result.insert(QStringLiteral("resolution"), resolutionName);
+        writeResult(result, parser.value(outputOption));
+        return withinTolerance ? 0 : 3;
+    }
+
+    BenchMode mode = BenchMode::Full;
+    if (!parseMode(parser.value(modeOption), &mode)) {
+        std::fprintf(stderr, "Unknown mode: %s\n", qPrintable(parser.value(modeOption)));
+        return 1;
+    }
+    const QString transport = parser.value(transportOption);
+    const bool useTcp = transport == QStringLiteral("tcp");
+    if (!useTcp && transport != QStringLiteral("file")) {
+        std::fprintf(stderr, "Unknown transport: %s\n", qPrintable(transport));
+        return 1;
+    }
+    bool ok[6] = {};
+    config.fps = parser.value(fpsOption).toInt(&ok[0]);
+    config.gopSize = parser.value(gopOption).toInt(&ok[1]);
+    config.bitrateKbps = parser.value(bitrateOption).toInt(&ok[2]);
+    const int durationSec = parser.value(durationOption).toInt(&ok[3]);
+    const int warmupSec = parser.value(warmupOption).toInt(&ok[4]);
+    const int streamCount = parser.value(streamsOption).toInt(&ok[5]);
+    if (!ok[0] || !ok[1] || !ok[2] || !ok[3] || !ok[4] || !ok[5] || config.fps <= 0 || config.gopSize <= 0
+        || config.bitrateKbps < 0 || durationSec <= 0 || warmupSec < 0 || streamCount <= 0) {
+        std::fprintf(stderr, "Invalid numeric option.\n");
+        return 1;
+    }
+    std::shared_ptr<const ImpairmentProfile> impairment;
+    if (parser.isSet(impairOption)) {
+        auto profile = std::make_shared<ImpairmentProfile>();
+        QString error;
+        if (!ImpairmentProfile::parse(parser.value(impairOption), profile.get(), &error)) {
+            std::fprintf(stderr, "Invalid impairment profile: %s\n", qPrintable(error));
+            return 1;
+        }
+        impairment = std::move(profile);
+    }
+    config.withAudio = !parser.isSet(noAudioOption);
+    config.durationSec = warmupSec + durationSec + kGenerationMarginSec;
+    if (config.bitrateKbps == 0) {
+        config.bitrateKbps = SyntheticStream::defaultBitrateKbps(config.width, config.height);
+    }
+
+    const QString streamPath = QStringLiteral("%1/bench_%2_%3_%4fps_g%5_%6k%7_%8s.ts")
+        .arg(parser.value(workDirOption), codecName, resolutionName)
+        .arg(config.fps).arg(config.gopSize).arg(config.bitrateKbps)
+        .arg(config.withAudio ? QStringLiteral("_aac") : QString())
+        .arg(config.durationSec);
+    if (!QFile::exists(streamPath)) {
+        QString error;
+        if (!SyntheticStream::generate(config, streamPath, &error)) {
+            std::fprintf(stderr, "Failed to generate %s: %s\n", qPrintable(streamPath), qPrintable(error));
+            return 2;
+        }
+    }
+
+    std::vector<std::unique_ptr<LoopbackStreamServer>> servers;
+    std::vector<std::unique_ptr<LiveStreamPlayer>> players;
+    std::vector<std::shared_ptr<FrameMailbox>> mailboxes;
+    LatencyAccumulator latency;
+    bool measuring = false;
+    // 线程名在播放器线程启动前登记，名称与 FrameTrace::setThreadName 的参数一致
+    const int audioDecodeSlot = AllocationCounter::watchThread("audio decode");
+    const int audioOutputSlot = AllocationCounter::watchThread("audio output");
+    QStringList urls;
+    for (int i = 0; i < streamCount; ++i) {
+        if (useTcp) {
+            auto server = std::make_unique<LoopbackStreamServer>();
+            server->start(streamPath, kFirstLoopbackPort + i, config.durationSec);
+            urls.append(server->url());
+            servers.push_back(std::move(server));
+        }
+        else {
+            urls.append(streamPath);
+        }
+
+        auto player = std::make_unique<LiveStreamPlayer>();
+        player->setNullAudioSink(true);
+        player->setMuted(mode != BenchMode::Full);
+        player->setVideoConversionEnabled(mode != BenchMode::DecodeOnly);
+        // 本地文件按时间戳节流，否则解复用会以磁盘速度读完，无法代表直播到达节奏
+        player->setRealtimeInput(!useTcp);
+        player->setNetworkImpairment(impairment);
+        if (mode != BenchMode::DecodeOnly) {
+            auto mailbox = std::make_shared<FrameMailbox>();
+            player->setFrameMailbox(mailbox);
+            mailboxes.push_back(std::move(mailbox));
+        }
+        QObject::connect(player.get(), &LiveStreamPlayer::statsUpdated, &app,
+            [&latency, &measuring](const PlayerStats& stats) {
+                if (measuring) {
+                    latency.sumMs += stats.latencyMs;
+                    latency.maxMs = std::max(latency.maxMs, stats.latencyMs);
+                    ++latency.samples;
+                }
+            });
+        QObject::connect(player.get(), &LiveStreamPlayer::errorOccurred, &app, [i](const QString& message) {
+            std::fprintf(stderr, "stream %d: %s\n", i, qPrintable(message));
+        });
+        players.push_back(std::move(player));
+    }
+
+    QTimer drainTimer;
+    drainTimer.setInterval(kFrameDrainIntervalMs);
+    QObject::connect(&drainTimer, &QTimer::timeout, &app, [&mailboxes]() {
+        QImage frame;
+        for (const auto& mailbox : mailboxes) {
+            mailbox->take(frame);
+        }
+    });
+    if (!mailboxes.empty()) {
+        drainTimer.start();
+    }
+
+    Baseline baseline;
+    QElapsedTimer window;
+    const int startDelayMs = useTcp ? kServerStartupMs : 0;
+    QTimer::singleShot(startDelayMs, &app, [&players, &urls]() {
+        for (int i = 0; i < urls.size(); ++i) {
+            players[static_cast<size_t>(i)]->start(urls.at(i));
+        }
+    });
+
+    QTimer::singleShot(startDelayMs + warmupSec * 1000, &app, [&]() {
+        for (const auto& player : players) {
+            player->resetStageLatency();
+        }
+        baseline.cpuSec = processCpuSeconds();
+        baseline.allocations = AllocationCounter::count();
+        baseline.audioDecodeAllocations = AllocationCounter::threadCount(audioDecodeSlot);
+        baseline.audioOutputAllocations = AllocationCounter::threadCount(audioOutputSlot);
+        baseline.players.clear();
+        baseline.reconnects = 0;
+        baseline.stalls = 0;
+        baseline.stallMs = 0.0;
+        for (const auto& player : players) {
+            const PlayerStats stats = player->latestStats();
+            baseline.players.push_back(stats);
+            baseline.reconnects += stats.reconnectCount;
+            baseline.stalls += stats.stallCount;
+            baseline.stallMs += stats.stallTotalMs;
+        }
+        latency = LatencyAccumulator();
+        measuring = true;
+        if (parser.isSet(traceOption)) {
+            FrameTrace::clear();
+            FrameTrace::setEnabled(true);
+        }
+        window.start();
+    });
+
+    QTimer::singleShot(startDelayMs + (warmupSec + durationSec) * 1000, &app, [&]() {
+        const double elapsedSec = static_cast<double>(window.elapsed()) / 1000.0;
+        const double cpuSec = processCpuSeconds() - baseline.cpuSec;
+        const uint64_t allocations = AllocationCounter::count() - baseline.allocations;
+        const uint64_t audioDecodeAllocations = AllocationCounter::threadCount(audioDecodeSlot) - baseline.audioDecodeAllocations;
+        const uint64_t audioOutputAllocations = AllocationCounter::threadCount(audioOutputSlot) - baseline.audioOutputAllocations;
+        measuring = false;
+        FrameTrace::setEnabled(false);
+        // 重连与卡顿取测量窗口内的增量；首帧耗时在预热期内产生，取各路的均值与最大值
+        int reconnects = -baseline.reconnects;
+        int stalls = -baseline.stalls;
+        double stallMs = -baseline.stallMs;
+        double ttffSumMs = 0.0;
+        double ttffMaxMs = 0.0;
+        int ttffStreams = 0;
+        std::vector<PlayerStats> finalStats;
+        for (const auto& player : players) {
+            finalStats.push_back(player->latestStats());
+        }
+        for (const auto& stats : finalStats) {
+            reconnects += stats.reconnectCount;
+            stalls += stats.stallCount;
+            stallMs += stats.stallTotalMs;
+            if (stats.timeToFirstFrameMs >= 0.0) {
+                ttffSumMs += stats.timeToFirstFrameMs;
+                ttffMaxMs = std::max(ttffMaxMs, stats.timeToFirstFrameMs);
+                ++ttffStreams;
+            }
+        }
+
+        // 转换输出缓冲池的命中与新分配次数，取测量窗口内的增量
+        qint64 poolHits = 0;
+        qint64 poolMisses = 0;
+        for (size_t i = 0; i < finalStats.size(); ++i) {
+            poolHits += finalStats[i].framePoolHits - baseline.players[i].framePoolHits;
+            poolMisses += finalStats[i].framePoolMisses - baseline.players[i].framePoolMisses;
+        }
+
+        QJsonArray fpsPerStream;
+        double fpsTotal = 0.0;
+        for (size_t i = 0; i < finalStats.size(); ++i) {
+            const double fps = elapsedSec > 0.0
+                ? static_cast<double>(finalStats[i].presentedVideoFrames - baseline.players[i].presentedVideoFrames) / elapsedSec : 0.0;
+            fpsPerStream.append(fps);
+            fpsTotal += fps;
+        }
+
+        QJsonObject stages;
+        for (int s = 0; s < static_cast<int>(LiveStreamPlayer::PipelineStage::Count); ++s) {
+            const auto stage = static_cast<LiveStreamPlayer::PipelineStage>(s);
+            LatencyHistogram merged;
+            for (const auto& player : players) {
+                merged.merge(player->stageLatency(stage));
+            }
+            stages.insert(stageName(stage), summaryToJson(merged.summarize()));
+        }
+
+        QJsonObject configJson;
+        configJson.insert(QStringLiteral("codec"), codecName);
+        configJson.insert(QStringLiteral("resolution"), resolutionName);
+        configJson.insert(QStringLiteral("fps"), config.fps);
+        configJson.insert(QStringLiteral("gop"), config.gopSize);
+        configJson.insert(QStringLiteral("bitrateKbps"), config.bitrateKbps);
+        configJson.insert(QStringLiteral("audio"), config.withAudio);
+        configJson.insert(QStringLiteral("transport"), transport);
+        configJson.insert(QStringLiteral("streams"), streamCount);
+        configJson.insert(QStringLiteral("mode"), parser.value(modeOption));
+        configJson.insert(QStringLiteral("durationSec"), durationSec);
+        configJson.insert(QStringLiteral("warmupSec"), warmupSec);
+        if (parser.isSet(impairOption)) {
+            configJson.insert(QStringLiteral("impair"), parser.value(impairOption));
+        }
+
+        QJsonObject result;
+        result.insert(QStringLiteral("config"), configJson);
+        result.insert(QStringLiteral("measuredSec"), elapsedSec);
+        result.insert(QStringLiteral("fpsPerStream"), fpsPerStream);
+        result.insert(QStringLiteral("fpsTotal"), fpsTotal);
+        result.insert(QStringLiteral("cpuPercent"), elapsedSec > 0.0 ? cpuSec / elapsedSec * 100.0 : 0.0);
+        result.insert(QStringLiteral("cpuPercentPerStream"), elapsedSec > 0.0 ? cpuSec / elapsedSec * 100.0 / streamCount : 0.0);
+        result.insert(QStringLiteral("allocationsPerSec"), elapsedSec > 0.0 ? static_cast<double>(allocations) / elapsedSec : 0.0);
+        result.insert(QStringLiteral("allocationsPerFrame"), fpsTotal > 0.0 ? static_cast<double>(allocations) / (fpsTotal * elapsedSec) : 0.0);
+        result.insert(QStringLiteral("allocationScope"), QString::fromLatin1(AllocationCounter::scope()));
+        result.insert(QStringLiteral("audioDecodeAllocations"), static_cast<double>(audioDecodeAllocations));
+        result.insert(QStringLiteral("audioDecodeAllocationsPerSec"),
+            elapsedSec > 0.0 ? static_cast<double>(audioDecodeAllocations) / elapsedSec : 0.0);
+        result.insert(QStringLiteral("audioOutputAllocations"), static_cast<double>(audioOutputAllocations));
+        result.insert(QStringLiteral("framePoolHits"), static_cast<double>(poolHits));
+        result.insert(QStringLiteral("framePoolMisses"), static_cast<double>(poolMisses));
+        result.insert(QStringLiteral("framePoolHitRate"),
+            poolHits + poolMisses > 0 ? static_cast<double>(poolHits) / static_cast<double>(poolHits + poolMisses) : 0.0);
+        result.insert(QStringLiteral("peakRssKb"), static_cast<double>(peakResidentMemoryKb()));
+        result.insert(QStringLiteral("reconnects"), reconnects);
+        result.insert(QStringLiteral("stalls"), stalls);
+        result.insert(QStringLiteral("stallTotalMs"), std::max(stallMs, 0.0));
+        result.insert(QStringLiteral("ttffMeanMs"), ttffStreams > 0 ? ttffSumMs / ttffStreams : -1.0);
+        result.insert(QStringLiteral("ttffMaxMs"), ttffStreams > 0 ? ttffMaxMs : -1.0);
+        result.insert(QStringLiteral("latencyMeanMs"), latency.samples > 0 ? latency.sumMs / static_cast<double>(latency.samples) : 0.0);
+        result.insert(QStringLiteral("latencyMaxMs"), latency.maxMs);
+        result.insert(QStringLiteral("stages"), stages);
+
+        writeResult(result, parser.value(outputOption));
+
+        if (parser.isSet(traceOption)) {
+            QString error;
+            if (!FrameTrace::exportChromeTrace(parser.value(traceOption), &error)) {
+                std::fprintf(stderr, "Cannot write trace: %s\n", qPrintable(error));
+            }
+        }
+
+        int exitCode = 0;
+        if (parser.isSet(checkAudioAllocsOption) && config.withAudio && audioOutputAllocations > 0) {
+            std::fprintf(stderr, "Audio output thread allocated %llu times in the measurement window\n",
+                static_cast<unsigned long long>(audioOutputAllocations));
+            exitCode = 5;
+        }
+
+        for (const auto& player : players) {
+            player->stop();
+        }
+        app.exit(exitCode);
+    });
+
+    const int result = app.exec();
+    players.clear();
+    servers.clear();
+    return result;
+}
@@ -0,0 +1,396 @@
+/**
+ * @file converterbench.cpp
+ * @brief 实现视频转换微基准：生成确定的 YUV 帧，比较专用路径与 swscale 的误差并测量各线程数下的吞吐。
+ * @mainfunctions
+ *   - ConverterBench::run
+ * @mainclasses
+ *   - 无
+ */
+
+#include "converterbench.h"
+
+#include "videoconverter.h"
+#include "workerpool.h"
+
+#include <QJsonArray>
+#include <QString>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+    constexpr int kFrameVariants = 4;       // 吞吐测量轮换的帧数，避免同一帧一直驻留缓存
+    constexpr int kWarmupConversions = 8;   // 每个线程数正式计时前的转换次数（建立上下文与缓冲池）
+
+    // 精度基准的 swscale 标志：色度取最近样本（与专用内核一致），逐像素全精度取整。
+    // 播放器回退路径用 SWS_BILINEAR，NV12 会插值色度，YUV420P 走无缩放查表快速路径，都不适合作 ±1 的基准
+    constexpr int kAccurateSwsFlags = SWS_POINT | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT;
+
+    /**
+     * @brief 输入帧的像素格式与色彩属性。
+     */
+    struct FrameFormat {
+        AVPixelFormat format;
+        AVColorSpace colorspace;
+        AVColorRange range;
+    };
+
+    // 吞吐使用最常见的 YUV420P BT.709 有限范围帧
+    constexpr FrameFormat kThroughputFormat = { AV_PIX_FMT_YUV420P, AVCOL_SPC_BT709, AVCOL_RANGE_MPEG };
+
+    // 精度比较覆盖专用路径支持的全部组合
+    constexpr FrameFormat kAccuracyFormats[] = {
+        { AV_PIX_FMT_YUV420P, AVCOL_SPC_SMPTE170M, AVCOL_RANGE_MPEG },
+        { AV_PIX_FMT_YUV420P, AVCOL_SPC_SMPTE170M, AVCOL_RANGE_JPEG },
+        { AV_PIX_FMT_YUV420P, AVCOL_SPC_BT709, AVCOL_RANGE_MPEG },
+        { AV_PIX_FMT_YUV420P, AVCOL_SPC_BT709, AVCOL_RANGE_JPEG },
+        { AV_PIX_FMT_NV12, AVCOL_SPC_SMPTE170M, AVCOL_RANGE_MPEG },
+        { AV_PIX_FMT_NV12, AVCOL_SPC_SMPTE170M, AVCOL_RANGE_JPEG },
+        { AV_PIX_FMT_NV12, AVCOL_SPC_BT709, AVCOL_RANGE_MPEG },
+        { AV_PIX_FMT_NV12, AVCOL_SPC_BT709, AVCOL_RANGE_JPEG },
+    };
+
+    /**
+     * @brief AVFrame 的独占持有者。
+     */
+    struct FrameDeleter {
+        void operator()(AVFrame* frame) const {
+            av_frame_free(&frame);
+        }
+    };
+    using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
+
+    /**
+     * @brief 生成内容确定的 8 位 4:2:0 帧：斜向渐变叠加线性同余噪声，样本覆盖 0~255 全部取值
+     *        （包括有限范围之外的值，用于检查两条路径的钳位是否一致）。
+     * @param width 宽度（偶数）。
+     * @param height 高度（偶数）。
+     * @param testCase 像素格式与色彩属性。
+     * @param seed 噪声种子，不同种子得到不同的帧。
+     * @param legalRange 为 true 且为有限范围时，样本限制在合法区间（亮度 16~235，色度 16~240）。
+     * @return 帧，分配失败返回空指针。
+     */
+    FramePtr makeFrame(int width, int height, const FrameFormat& testCase, uint32_t seed, bool legalRange = false) {
+        FramePtr frame(av_frame_alloc());
+        if (!frame) {
+            return nullptr;
+        }
+        frame->width = width;
+        frame->height = height;
+        frame->format = testCase.format;
+        frame->colorspace = testCase.colorspace;
+        frame->color_range = testCase.range;
+        if (av_frame_get_buffer(frame.get(), 0) < 0) {
+            return nullptr;
+        }
+
+        uint32_t state = seed * 2654435761u + 1u;
+        const auto noise = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<int>(state >> 24) - 128;
+        };
+        const bool clampToLegal = legalRange && testCase.range == AVCOL_RANGE_MPEG;
+        const int low = clampToLegal ? 16 : 0;
+        const int lumaHigh = clampToLegal ? 235 : 255;
+        const int chromaHigh = clampToLegal ? 240 : 255;
+        const auto sample = [low](int value, int high) {
+            return static_cast<uint8_t>(std::min(high, std::max(low, value)));
+        };
+
+        for (int y = 0; y < height; ++y) {
+            uint8_t* row = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+            for (int x = 0; x < width; ++x) {
+                row[x] = sample(((x + y) * 255) / (width + height) + noise() / 2, lumaHigh);
+            }
+        }
+        const bool semiPlanar = testCase.format == AV_PIX_FMT_NV12;
+        for (int y = 0; y < height / 2; ++y) {
+            uint8_t* uRow = frame->data[1] + static_cast<ptrdiff_t>(y) * frame->linesize[1];
+            uint8_t* vRow = semiPlanar ? nullptr : frame->data[2] + static_cast<ptrdiff_t>(y) * frame->linesize[2];
+            for (int x = 0; x < width / 2; ++x) {
+                const uint8_t u = sample((x * 255) / (width / 2) + noise(), chromaHigh);
+                const uint8_t v = sample((y * 255) / (height / 2) + noise(), chromaHigh);
+                if (semiPlanar) {
+                    uRow[x * 2] = u;
+                    uRow[x * 2 + 1] = v;
+                }
+                else {
+                    uRow[x] = u;
+                    vRow[x] = v;
+                }
+            }
+        }
+        return frame;
+    }
+
+    /**
+     * @brief 以 kAccurateSwsFlags 单独构建 swscale 上下文转换整帧，作为专用内核的精度基准。
+     * @param frame 输入帧。
+     * @return BGRA 图像，失败返回空图像。
+     */
+    QImage convertAccurateSws(const AVFrame* frame) {
+        SwsContext* ctx = sws_getContext(frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+            frame->width, frame->height, AV_PIX_FMT_BGRA, kAccurateSwsFlags, nullptr, nullptr, nullptr);
+        if (!ctx) {
+            return QImage();
+        }
+        sws_setColorspaceDetails(ctx, sws_getCoefficients(frame->colorspace), frame->color_range == AVCOL_RANGE_JPEG ? 1 : 0,
+            sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+
+        QImage image(frame->width, frame->height, QImage::Format_ARGB32);
+        uint8_t* destData[4] = { image.bits(), nullptr, nullptr, nullptr };
+        int destLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+        sws_scale(ctx, frame->data, frame->linesize, 0, frame->height, destData, destLinesize);
+        sws_freeContext(ctx);
+        return image;
+    }
+
+    /**
+     * @brief 两幅 BGRA 图像 B/G/R 通道的最大绝对差。
+     * @param a 图像 A。
+     * @param b 图像 B，尺寸与 A 相同。
+     * @return 最大差值，尺寸不符或任一为空时返回 256。
+     */
+    int maxChannelError(const QImage& a, const QImage& b) {
+        if (a.isNull() || b.isNull() || a.width() != b.width() || a.height() != b.height()) {
+            return 256;
+        }
+        int maxError = 0;
+        for (int y = 0; y < a.height(); ++y) {
+            const uint8_t* rowA = a.constScanLine(y);
+            const uint8_t* rowB = b.constScanLine(y);
+            for (int x = 0; x < a.width() * 4; x += 4) {
+                for (int c = 0; c < 3; ++c) {
+                    maxError = std::max(maxError, std::abs(rowA[x + c] - rowB[x + c]));
+                }
+            }
+        }
+        return maxError;
+    }
+
+    /**
+     * @brief 两幅 BGRA 图像是否逐字节相同（只比较每行的像素部分，不含行尾填充）。
+     * @param a 图像 A。
+     * @param b 图像 B。
+     * @return 尺寸相同且内容一致时返回 true，任一为空时返回 false。
+     */
+    bool identicalPixels(const QImage& a, const QImage& b) {
+        if (a.isNull() || b.isNull() || a.width() != b.width() || a.height() != b.height()) {
+            return false;
+        }
+        const size_t rowBytes = static_cast<size_t>(a.width()) * 4;
+        for (int y = 0; y < a.height(); ++y) {
+            if (std::memcmp(a.constScanLine(y), b.constScanLine(y), rowBytes) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 与双精度浮点参考值（色度按最近样本复制）的最大绝对差。
+     * @param frame 输入帧。
+     * @param image 转换结果。
+     * @return 最大差值，尺寸不符或为空时返回 256。
+     */
+    int maxReferenceError(const AVFrame* frame, const QImage& image) {
+        if (image.isNull() || image.width() != frame->width || image.height() != frame->height) {
+            return 256;
+        }
+        const bool bt709 = frame->colorspace == AVCOL_SPC_BT709;
+        const bool fullRange = frame->color_range == AVCOL_RANGE_JPEG;
+        const bool semiPlanar = frame->format == AV_PIX_FMT_NV12;
+        const double kr = bt709 ? 0.2126 : 0.299;
+        const double kb = bt709 ? 0.0722 : 0.114;
+        const double kg = 1.0 - kr - kb;
+        const double yScale = fullRange ? 1.0 : 255.0 / 219.0;
+        const double cScale = fullRange ? 1.0 : 255.0 / 224.0;
+        const int yOffset = fullRange ? 0 : 16;
+
+        int maxError = 0;
+        for (int y = 0; y < frame->height; ++y) {
+            const uint8_t* yRow = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+            const uint8_t* uRow = frame->data[1] + static_cast<ptrdiff_t>(y / 2) * frame->linesize[1];
+            const uint8_t* vRow = semiPlanar ? nullptr : frame->data[2] + static_cast<ptrdiff_t>(y / 2) * frame->linesize[2];
+            const uint8_t* out = image.constScanLine(y);
+            for (int x = 0; x < frame->width; ++x) {
+                const int c = x / 2;
+                const double luma = (yRow[x] - yOffset) * yScale;
+                const double u = ((semiPlanar ? uRow[c * 2] : uRow[c]) - 128) * cScale;
+                const double v = ((semiPlanar ? uRow[c * 2 + 1] : vRow[c]) - 128) * cScale;
+                const double r = luma + 2.0 * (1.0 - kr) * v;
+                const double b = luma + 2.0 * (1.0 - kb) * u;
+                const double g = (luma - kr * r - kb * b) / kg;
+                const double expected[3] = { b, g, r };
+                for (int i = 0; i < 3; ++i) {
+                    const int rounded = static_cast<int>(std::lround(std::min(255.0, std::max(0.0, expected[i]))));
+                    maxError = std::max(maxError, std::abs(out[x * 4 + i] - rounded));
+                }
+            }
+        }
+        return maxError;
+    }
+
+    /**
+     * @brief 像素格式名称。
+     * @param format 像素格式。
+     * @return 名称。
+     */
+    QString formatName(AVPixelFormat format) {
+        return format == AV_PIX_FMT_NV12 ? QStringLiteral("nv12") : QStringLiteral("yuv420p");
+    }
+}
+
+/**
+ * @brief 先做 8 组精度比较（与精确 swscale 及双精度参考值），再检查各线程数下条带输出与单条带逐位一致（专用路径与 swscale 都检查），
+ *        最后对每个线程数测量吞吐。
+ * @param config 运行参数。
+ * @param withinTolerance 输出参数。
+ * @return 结果对象。
+ */
+QJsonObject ConverterBench::run(const Config& config, bool* withinTolerance) {
+    const int width = config.width & ~1;
+    const int height = config.height & ~1;
+    const bool simd = config.path == Path::Simd;
+    bool passed = true;
+
+    QJsonArray accuracy;
+    int worstErrorVsSws = 0;
+    for (const FrameFormat& testCase : kAccuracyFormats) {
+        // 超出有限范围的样本在 swscale 精确路径上会回绕（如 U=255 时蓝色输出 0），与 swscale 比较只用合法样本；
+        // 钳位行为改由覆盖 0~255 的帧与双精度参考值比较来检查
+        const FramePtr frame = makeFrame(width, height, testCase, 1);
+        const FramePtr legalFrame = makeFrame(width, height, testCase, 1, true);
+        if (!frame || !legalFrame) {
+            passed = false;
+            continue;
+        }
+        VideoConverter fallback;
+        fallback.setDirectYuvEnabled(false);
+        fallback.setMaxSlices(1);
+        VideoConverter tested;
+        tested.setDirectYuvEnabled(simd);
+        tested.setMaxSlices(1);
+        const QImage expected = convertAccurateSws(legalFrame.get());
+        const QImage actualLegal = tested.convert(legalFrame.get(), QSize(), VideoConverter::ScalingQuality::Bilinear);
+        const int errorVsSws = maxChannelError(actualLegal, expected);
+        const QImage fallbackImage = fallback.convert(frame.get(), QSize(), VideoConverter::ScalingQuality::Bilinear);
+        const QImage actual = tested.convert(frame.get(), QSize(), VideoConverter::ScalingQuality::Bilinear);
+        const int errorVsReference = maxReferenceError(frame.get(), actual);
+
+        // 只对专用路径设门槛；sws 路径即播放器回退，NV12 色度插值与最近样本基准相差较大，只报告
+        worstErrorVsSws = std::max(worstErrorVsSws, errorVsSws);
+        if (simd) {
+            passed = passed && errorVsSws <= config.toleranceLsb && errorVsReference <= config.toleranceLsb;
+        }
+
+        QJsonObject entry;
+        entry.insert(QStringLiteral("format"), formatName(testCase.format));
+        entry.insert(QStringLiteral("matrix"), testCase.colorspace == AVCOL_SPC_BT709 ? QStringLiteral("bt709") : QStringLiteral("bt601"));
+        entry.insert(QStringLiteral("range"), testCase.range == AVCOL_RANGE_JPEG ? QStringLiteral("full") : QStringLiteral("limited"));
+        entry.insert(QStringLiteral("maxLsbErrorVsSws"), errorVsSws);
+        entry.insert(QStringLiteral("maxLsbErrorVsReference"), errorVsReference);
+        entry.insert(QStringLiteral("maxLsbErrorVsFallback"), maxChannelError(actual, fallbackImage));
+        entry.insert(QStringLiteral("swsMaxLsbErrorVsReference"), maxReferenceError(frame.get(), fallbackImage));
+        accuracy.append(entry);
+    }
+
+    // 轮换几帧内容不同的输入
+    std::vector<FramePtr> frames;
+    for (int i = 0; i < kFrameVariants; ++i) {
+        FramePtr frame = makeFrame(width, height, kThroughputFormat, static_cast<uint32_t>(i + 2));
+        if (frame) {
+            frames.push_back(std::move(frame));
+        }
+    }
+
+    // 条带并行不得改变结果：同一帧分别以 N 条带与单条带转换后逐字节比较，两条路径都检查
+    QJsonArray sliceMismatches;
+    if (!frames.empty()) {
+        for (int threads : config.threadCounts) {
+            if (threads <= 1) {
+                continue;
+            }
+            for (const bool directYuv : { true, false }) {
+                VideoConverter single;
+                single.setDirectYuvEnabled(directYuv);
+                single.setMaxSlices(1);
+                VideoConverter sliced;
+                sliced.setDirectYuvEnabled(directYuv);
+                sliced.setMaxSlices(threads);
+                const QImage expected = single.convert(frames.front().get(), QSize(), VideoConverter::ScalingQuality::Bilinear);
+                const QImage actual = sliced.convert(frames.front().get(), QSize(), VideoConverter::ScalingQuality::Bilinear);
+                if (!identicalPixels(expected, actual)) {
+                    QJsonObject mismatch;
+                    mismatch.insert(QStringLiteral("threads"), threads);
+                    mismatch.insert(QStringLiteral("converter"), directYuv ? QStringLiteral("simd") : QStringLiteral("sws"));
+                    sliceMismatches.append(mismatch);
+                    passed = false;
+                }
+            }
+        }
+    }
+
+    QJsonArray throughput;
+    double singleThreadMpix = 0.0;
+    for (int threads : config.threadCounts) {
+        if (frames.empty() || threads <= 0) {
+            break;
+        }
+        VideoConverter converter;
+        converter.setDirectYuvEnabled(simd);
+        converter.setMaxSlices(threads);
+        for (int i = 0; i < kWarmupConversions; ++i) {
+            converter.convert(frames[static_cast<size_t>(i) % frames.size()].get(), QSize(), VideoConverter::ScalingQuality::Bilinear);
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < config.frames; ++i) {
+            // 结果立即释放，缓冲回到池中，与解码线程逐帧交出图像的节奏一致
+            converter.convert(frames[static_cast<size_t>(i) % frames.size()].get(), QSize(), VideoConverter::ScalingQuality::Bilinear);
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        const double mpixPerSec = seconds > 0.0
+            ? static_cast<double>(width) * height * config.frames / seconds / 1e6 : 0.0;
+        if (threads == 1) {
+            singleThreadMpix = mpixPerSec;
+        }
+
+        QJsonObject entry;
+        entry.insert(QStringLiteral("threads"), threads);
+        entry.insert(QStringLiteral("mpixPerSec"), mpixPerSec);
+        entry.insert(QStringLiteral("msPerFrame"), config.frames > 0 ? seconds * 1000.0 / config.frames : 0.0);
+        entry.insert(QStringLiteral("speedupVsOneThread"), singleThreadMpix > 0.0 ? mpixPerSec / singleThreadMpix : 0.0);
+        throughput.append(entry);
+    }
+
+    QJsonObject result;
+    result.insert(QStringLiteral("converter"), simd ? QStringLiteral("simd") : QStringLiteral("sws"));
+    result.insert(QStringLiteral("width"), width);
+    result.insert(QStringLiteral("height"), height);
+    result.insert(QStringLiteral("frames"), config.frames);
+    result.insert(QStringLiteral("poolThreads"), WorkerPool::instance().threadCount());
+    result.insert(QStringLiteral("toleranceLsb"), config.toleranceLsb);
+    result.insert(QStringLiteral("maxLsbErrorVsSws"), worstErrorVsSws);
+    result.insert(QStringLiteral("slicesIdentical"), sliceMismatches.isEmpty());
+    result.insert(QStringLiteral("sliceMismatches"), sliceMismatches);
+    result.insert(QStringLiteral("withinTolerance"), passed);
+    result.insert(QStringLiteral("accuracy"), accuracy);
+    result.insert(QStringLiteral("throughput"), throughput);
+    if (withinTolerance) {
+        *withinTolerance = passed;
+    }
+    return result;
+}
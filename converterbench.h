@@ -0,0 +1,60 @@
+/**
+ * @file converterbench.h
+ * @brief 定义视频转换微基准：以确定的内存 YUV 帧驱动 VideoConverter，测量各线程数下的吞吐，
+ *        比较 SIMD 专用路径与 swscale 回退路径的逐像素误差，并检查条带并行输出与单条带逐位一致。
+ * @mainfunctions
+ *   - ConverterBench::run
+ * @mainclasses
+ *   - ConverterBench
+ */
+
+#ifndef CONVERTERBENCH_H
+#define CONVERTERBENCH_H
+
+#include <QJsonObject>
+
+#include <vector>
+
+/**
+ * @brief ConverterBench 不经过解码与播放器，只测量转换阶段本身。
+ *
+ * 精度部分覆盖 YUV420P/NV12 × BT.601/709 × 有限/全范围共 8 组，取 B/G/R 三通道的最大绝对误差：
+ * 合法范围样本的帧与精确 swscale（SWS_POINT | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT，色度取最近样本）比较，
+ * 覆盖 0~255 的帧与双精度浮点参考值比较；另报告与播放器 swscale 回退路径（SWS_BILINEAR）的差值，仅供参考。
+ * 条带部分对每个大于 1 的线程数，把同一帧分别按该条带数与单条带转换，专用路径与 swscale 各比较一次，要求逐字节相同。
+ * 吞吐部分对每个线程数（即单帧条带数上限，含调用线程）重复转换同一组帧，报告 MPix/s。条带数同时受
+ * VideoConverter 每条带至少 256K 像素的限制（1080p 最多 7 条），超过共享线程池线程数加一后也不再增加并行度。
+ */
+class ConverterBench {
+public:
+    /**
+     * @brief 被测的转换路径。
+     */
+    enum class Path {
+        Simd,   // 无缩放 4:2:0 走 YuvToBgra 专用内核
+        Sws     // 统一走 swscale
+    };
+
+    /**
+     * @brief 运行参数。
+     */
+    struct Config {
+        int width = 1920;
+        int height = 1080;
+        Path path = Path::Simd;
+        std::vector<int> threadCounts{ 1 };
+        int frames = 300;           // 每个线程数测量的转换次数
+        int toleranceLsb = 1;       // 专用路径与精确 swscale、双精度参考值的最大允许误差
+    };
+
+    /**
+     * @brief 执行精度比较、条带一致性检查与吞吐测量。
+     * @param config 运行参数。
+     * @param withinTolerance 输出参数，专用路径各组与精确 swscale、双精度参考值的误差都不超过 toleranceLsb
+     *        （sws 路径不设此门槛）且条带输出逐位一致时为 true，可为 nullptr。
+     * @return 结果对象，字段见 README。
+     */
+    static QJsonObject run(const Config& config, bool* withinTolerance);
+};
+
+#endif // CONVERTERBENCH_H
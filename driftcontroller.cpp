@@ -0,0 +1,84 @@
+/**
+ * @file driftcontroller.cpp
+ * @brief 实现音频缓冲水位的平滑与 PI 漂移控制。
+ * @mainfunctions
+ *   - DriftController::update
+ *   - DriftController::reset
+ * @mainclasses
+ *   - DriftController
+ */
+
+#include "driftcontroller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr double kSmoothingSec = 2.0;         // 水位指数平滑的时间常数
+    constexpr double kProportionalPpmPerMs = 20.0; // 每毫秒水位误差对应的比例修正
+    constexpr double kIntegralPpmPerMsSec = 0.1;   // 每毫秒误差每秒累积的积分修正
+    constexpr double kMaxDriftPpm = 1000.0;       // 积分项上限，防止断流期间积分饱和
+    constexpr double kMaxCorrectionPpm = 2000.0;  // 总修正上限，0.2% 以内的变速不可察觉
+    constexpr double kMaxElapsedSec = 1.0;        // 更新间隔过长（线程被阻塞）时按此截断
+}
+
+/**
+ * @brief 清零全部状态。
+ */
+void DriftController::reset() {
+    m_primed = false;
+    m_smoothedMs = 0.0;
+    m_integralPpm = 0.0;
+    m_correctionPpm = 0.0;
+}
+
+/**
+ * @brief 闭环约 50 秒时间常数、接近临界阻尼：足以跟随数百 ppm 的漂移，又不会追逐网络抖动。
+ * @param bufferMs 水位测量。
+ * @param targetMs 目标水位。
+ * @param elapsedSec 时间间隔。
+ * @return 速率修正（ppm）。
+ */
+double DriftController::update(double bufferMs, double targetMs, double elapsedSec) {
+    if (!std::isfinite(bufferMs) || !(elapsedSec > 0.0)) {
+        return m_correctionPpm;
+    }
+    elapsedSec = std::min(elapsedSec, kMaxElapsedSec);
+
+    if (!m_primed) {
+        m_smoothedMs = bufferMs;
+        m_primed = true;
+    }
+    else {
+        m_smoothedMs += (bufferMs - m_smoothedMs) * elapsedSec / (kSmoothingSec + elapsedSec);
+    }
+
+    const double errorMs = m_smoothedMs - targetMs;
+    m_integralPpm = std::clamp(m_integralPpm + errorMs * kIntegralPpmPerMsSec * elapsedSec, -kMaxDriftPpm, kMaxDriftPpm);
+    m_correctionPpm = std::clamp(m_integralPpm + errorMs * kProportionalPpmPerMs, -kMaxCorrectionPpm, kMaxCorrectionPpm);
+    return m_correctionPpm;
+}
+
+/**
+ * @brief 返回积分项。
+ * @return ppm。
+ */
+double DriftController::driftPpm() const {
+    return m_integralPpm;
+}
+
+/**
+ * @brief 返回最近的修正量。
+ * @return ppm。
+ */
+double DriftController::correctionPpm() const {
+    return m_correctionPpm;
+}
+
+/**
+ * @brief 返回平滑水位。
+ * @return 毫秒。
+ */
+double DriftController::smoothedBufferMs() const {
+    return m_smoothedMs;
+}
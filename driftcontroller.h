@@ -0,0 +1,65 @@
+/**
+ * @file driftcontroller.h
+ * @brief 定义音频时钟漂移控制器，根据输出缓冲水位估计发送端与声卡的时钟偏差。
+ * @mainfunctions
+ *   - update
+ *   - reset
+ *   - driftPpm
+ *   - correctionPpm
+ * @mainclasses
+ *   - DriftController
+ */
+
+#ifndef DRIFTCONTROLLER_H
+#define DRIFTCONTROLLER_H
+
+/**
+ * @brief DriftController 是作用在音频缓冲水位上的 PI 控制器。
+ *
+ * 摄像机的采样时钟与本地声卡不同源，长时间播放时待写队列与设备缓冲会缓慢增长或耗尽。
+ * 水位高于目标说明输入比消费快，需要以略高于 1 的速率播放（输出更少样本），反之亦然。
+ * 积分项收敛到两端时钟的实际偏差，即 driftPpm；比例项负责把水位拉回目标。
+ * 水位测量在 UI 定时器粒度上抖动较大，先做指数平滑再进入控制器。
+ */
+class DriftController {
+public:
+    /**
+     * @brief 清除平滑水位与积分项，用于重连或跳转之后。
+     */
+    void reset();
+
+    /**
+     * @brief 输入一次水位测量并更新修正量。
+     * @param bufferMs 当前音频缓冲水位（待写队列 + 设备缓冲，毫秒）。
+     * @param targetMs 期望保持的水位（毫秒）。
+     * @param elapsedSec 距上次更新经过的时间（秒）。
+     * @return 本次给出的速率修正（ppm），正值表示加快播放。
+     */
+    double update(double bufferMs, double targetMs, double elapsedSec);
+
+    /**
+     * @brief 查询估计的时钟漂移。
+     * @return 输入时钟相对声卡的偏差（ppm），正值表示输入更快。
+     */
+    double driftPpm() const;
+
+    /**
+     * @brief 查询最近一次给出的速率修正。
+     * @return 修正量（ppm）。
+     */
+    double correctionPpm() const;
+
+    /**
+     * @brief 查询平滑后的水位。
+     * @return 毫秒，尚无测量时为 0。
+     */
+    double smoothedBufferMs() const;
+
+private:
+    bool m_primed = false;
+    double m_smoothedMs = 0.0;
+    double m_integralPpm = 0.0;
+    double m_correctionPpm = 0.0;
+};
+
+#endif // DRIFTCONTROLLER_H
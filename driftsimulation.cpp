@@ -0,0 +1,116 @@
+/**
+ * @file driftsimulation.cpp
+ * @brief 实现音频时钟漂移的确定性仿真。
+ * @mainfunctions
+ *   - DriftSimulation::run
+ * @mainclasses
+ *   - 无
+ */
+
+#include "driftsimulation.h"
+
+#include "driftcontroller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr double kFrameMs = 1024.0 * 1000.0 / 48000.0; // 一帧 AAC 的时长
+    constexpr double kSinkPeriodMs = 10.0;                  // 声卡每次取数据的时长
+    constexpr int kTicksPerUpdate = 10;                     // 每 10 个声卡周期（100 ms）更新一次控制器
+    constexpr int kUpdatesPerWindow = 6000;                 // 漂移估计按 10 分钟窗口取均值
+
+    /**
+     * @brief xorshift32 伪随机数，输出 [0, 1) 内的均匀分布，跨平台可复现。
+     */
+    class Random {
+    public:
+        explicit Random(uint32_t seed) : m_state(seed ? seed : 0x9E3779B9u) {}
+
+        double next() {
+            m_state ^= m_state << 13;
+            m_state ^= m_state >> 17;
+            m_state ^= m_state << 5;
+            return static_cast<double>(m_state) / 4294967296.0;
+        }
+
+    private:
+        uint32_t m_state;
+    };
+}
+
+/**
+ * @brief 以 10 ms 声卡周期推进：先写入已到达的帧，再消费一个周期；每 10 个周期测量一次水位并更新控制器。
+ * @param config 仿真参数。
+ * @return 仿真结果。
+ */
+DriftSimulation::Result DriftSimulation::run(const Config& config) {
+    Result result;
+    DriftController controller;
+    Random random(config.seed);
+
+    const double senderScale = 1.0 / (1.0 + config.skewPpm * 1e-6); // 发送端一帧对应的声卡时长比例
+    double bufferMs = config.targetMs;   // 以预缓冲到目标水位的状态开始播放
+    double correctionPpm = 0.0;
+    int64_t frameIndex = 0;
+    double lastArrivalMs = 0.0;
+    double nextArrivalMs = random.next() * config.jitterMs;
+
+    result.minBufferMs = bufferMs;
+    result.settledMinMs = std::numeric_limits<double>::max();
+    result.settledMaxMs = std::numeric_limits<double>::lowest();
+    bool underrun = false;
+    double windowSumPpm = 0.0;
+    int windowUpdates = 0;
+
+    const int64_t ticks = static_cast<int64_t>(config.durationSec * 1000.0 / kSinkPeriodMs);
+    for (int64_t tick = 1; tick <= ticks; ++tick) {
+        const double nowMs = static_cast<double>(tick) * kSinkPeriodMs;
+
+        // 已到达的帧按当前修正量拉伸后入缓冲（修正为正时输出更少样本）
+        while (nextArrivalMs <= nowMs) {
+            bufferMs += kFrameMs / (1.0 + correctionPpm * 1e-6);
+            lastArrivalMs = nextArrivalMs;
+            ++frameIndex;
+            const double sentMs = static_cast<double>(frameIndex) * kFrameMs * senderScale;
+            nextArrivalMs = std::max(lastArrivalMs, sentMs + random.next() * config.jitterMs);
+        }
+
+        if (tick % kTicksPerUpdate == 0) {
+            correctionPpm = controller.update(bufferMs, config.targetMs, kTicksPerUpdate * kSinkPeriodMs / 1000.0);
+            ++result.updates;
+            const double seconds = nowMs / 1000.0;
+            if (seconds >= config.convergeSec) {
+                result.maxDriftErrorPpm = std::max(result.maxDriftErrorPpm, std::abs(controller.driftPpm() - config.skewPpm));
+                windowSumPpm += controller.driftPpm();
+                if (++windowUpdates == kUpdatesPerWindow) {
+                    result.maxWindowMeanErrorPpm = std::max(result.maxWindowMeanErrorPpm,
+                        std::abs(windowSumPpm / kUpdatesPerWindow - config.skewPpm));
+                    windowSumPpm = 0.0;
+                    windowUpdates = 0;
+                }
+            }
+        }
+
+        // 声卡消费一个周期，数据不足时播放静音，缓冲停在 0
+        bufferMs -= kSinkPeriodMs;
+        result.minBufferMs = std::min(result.minBufferMs, bufferMs);
+        if (bufferMs <= 0.0) {
+            underrun = true;
+            bufferMs = 0.0;
+        }
+        if (nowMs / 1000.0 >= config.settleSec) {
+            result.settledMinMs = std::min(result.settledMinMs, bufferMs);
+            result.settledMaxMs = std::max(result.settledMaxMs, bufferMs);
+        }
+    }
+
+    result.finalDriftPpm = controller.driftPpm();
+    result.bounded = !underrun &&
+        result.settledMinMs >= config.targetMs - config.maxDepthErrorMs &&
+        result.settledMaxMs <= config.targetMs + config.maxDepthErrorMs;
+    result.converged = result.maxDriftErrorPpm <= config.maxDriftErrorPpm &&
+        result.maxWindowMeanErrorPpm <= config.maxWindowErrorPpm;
+    return result;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file driftsimulation.h
+ * @brief 定义音频时钟漂移的确定性仿真：以带时钟偏差与到达抖动的音频输入驱动 DriftController，
+ *        检查长时间运行下缓冲水位有界、漂移估计收敛。
+ * @mainfunctions
+ *   - DriftSimulation::run
+ * @mainclasses
+ *   - DriftSimulation
+ */
+
+#ifndef DRIFTSIMULATION_H
+#define DRIFTSIMULATION_H
+
+#include <cstdint>
+
+/**
+ * @brief DriftSimulation 按音频解码线程的方式闭环驱动 DriftController，不依赖真实声卡与网络。
+ *
+ * 发送端按自身时钟每 1024 样本（48 kHz）产生一帧，相对声卡快 skewPpm；每帧在网络上延迟
+ * [0, jitterMs] 内的伪随机时长，按序到达（TCP 语义，不会超车）。到达的帧按当前修正量拉伸后写入缓冲，
+ * 声卡以 10 ms 周期从缓冲取数据。每 100 ms 在随机相位上测量一次水位交给控制器，
+ * 与 LiveStreamPlayer::audioDecodeLoop 的更新间隔和目标水位一致。
+ * 伪随机数由固定种子的 xorshift 生成，结果在任何平台上逐位可复现。
+ */
+class DriftSimulation {
+public:
+    /**
+     * @brief 仿真参数。
+     */
+    struct Config {
+        double skewPpm = 0.0;           // 发送端时钟相对声卡的偏差，正值表示发送端更快
+        double durationSec = 86400.0;   // 仿真时长，默认 24 小时
+        double jitterMs = 80.0;         // 每帧网络延迟的上限
+        double targetMs = 240.0;        // 控制器保持的目标水位
+        double settleSec = 600.0;       // 之后开始检查水位范围
+        double convergeSec = 3600.0;    // 之后开始检查漂移估计
+        double maxDepthErrorMs = 100.0; // 稳定后水位偏离目标的允许范围
+        double maxDriftErrorPpm = 25.0; // 收敛后漂移估计逐次更新的允许误差（含网络抖动引起的波动）
+        double maxWindowErrorPpm = 10.0; // 收敛后 10 分钟窗口均值的允许误差
+        uint32_t seed = 1;
+    };
+
+    /**
+     * @brief 仿真结果，水位均为实际缓冲（非测量值）。
+     */
+    struct Result {
+        double minBufferMs = 0.0;       // 全程最低水位，不大于 0 表示发生欠载
+        double settledMinMs = 0.0;      // settleSec 之后的最低水位
+        double settledMaxMs = 0.0;      // settleSec 之后的最高水位
+        double finalDriftPpm = 0.0;     // 结束时的漂移估计
+        double maxDriftErrorPpm = 0.0;  // convergeSec 之后漂移估计与真实偏差的最大差（逐次更新）
+        double maxWindowMeanErrorPpm = 0.0; // convergeSec 之后各 10 分钟窗口内估计均值与真实偏差的最大差
+        int64_t updates = 0;            // 控制器更新次数
+        bool bounded = false;           // 未欠载且稳定后水位在允许范围内
+        bool converged = false;         // 收敛后逐次与窗口均值误差都在允许范围内
+    };
+
+    /**
+     * @brief 运行一次仿真。
+     * @param config 仿真参数。
+     * @return 仿真结果。
+     */
+    static Result run(const Config& config);
+};
+
+#endif // DRIFTSIMULATION_H
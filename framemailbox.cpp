@@ -0,0 +1,96 @@
+/**
+ * @file framemailbox.cpp
+ * @brief 实现三缓冲最新帧信箱的发布与取帧。
+ * @mainfunctions
+ *   - FrameMailbox::publish
+ *   - FrameMailbox::take
+ * @mainclasses
+ *   - FrameMailbox
+ */
+
+#include "framemailbox.h"
+
+/**
+ * @brief 槽位 0 归生产者、1 为中间、2 归消费者。
+ */
+FrameMailbox::FrameMailbox()
+    : m_middle(1) {
+}
+
+/**
+ * @brief 写入生产者槽位后与中间槽位交换；若换回的槽位仍带新帧标志，说明该帧未被显示即被覆盖。
+ * @param frame 新帧。
+ * @param traceId 追踪编号。
+ */
+void FrameMailbox::publish(QImage frame, quint64 traceId) {
+    m_slots[m_back] = std::move(frame);
+    m_traceIds[m_back] = traceId;
+    const quint8 previous = m_middle.exchange(static_cast<quint8>(m_back | kFreshBit), std::memory_order_acq_rel);
+    m_back = previous & kIndexMask;
+    if (previous & kFreshBit) {
+        m_superseded.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 换回的槽位可能仍持有被覆盖的旧帧，立即释放以便缓冲区尽快回到帧池
+    m_slots[m_back] = QImage();
+
+    if (!m_repaintPending.exchange(true, std::memory_order_acq_rel)) {
+        std::lock_guard<std::mutex> lock(m_notifierMutex);
+        if (m_notifier) {
+            m_notifier();
+        }
+    }
+}
+
+/**
+ * @brief 先清除重绘标志再交换，保证在交换之后发布的帧一定会触发新的重绘请求。
+ * @param frame 输出参数。
+ * @param traceId 可选输出参数。
+ * @return true 表示取到了新帧。
+ */
+bool FrameMailbox::take(QImage& frame, quint64* traceId) {
+    m_repaintPending.store(false, std::memory_order_release);
+    if (!(m_middle.load(std::memory_order_acquire) & kFreshBit)) {
+        return false;
+    }
+
+    const quint8 previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = previous & kIndexMask;
+    frame = std::move(m_slots[m_front]);
+    m_slots[m_front] = QImage();
+    if (traceId) {
+        *traceId = m_traceIds[m_front];
+    }
+    return true;
+}
+
+/**
+ * @brief 由消费者线程调用，取走并丢弃待取帧。
+ */
+void FrameMailbox::clear() {
+    QImage discarded;
+    take(discarded);
+}
+
+/**
+ * @brief 持锁替换通知回调，与 publish 中的调用互斥。
+ * @param notifier 回调。
+ */
+void FrameMailbox::setNotifier(std::function<void()> notifier) {
+    std::lock_guard<std::mutex> lock(m_notifierMutex);
+    m_notifier = std::move(notifier);
+}
+
+/**
+ * @brief 返回覆盖计数。
+ * @return 覆盖帧数。
+ */
+quint64 FrameMailbox::supersededCount() const {
+    return m_superseded.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 清零覆盖计数。
+ */
+void FrameMailbox::resetSupersededCount() {
+    m_superseded.store(0, std::memory_order_relaxed);
+}
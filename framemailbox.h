@@ -0,0 +1,94 @@
+/**
+ * @file framemailbox.h
+ * @brief 定义视频管线与显示控件之间的最新帧信箱（三缓冲）。
+ * @mainfunctions
+ *   - publish
+ *   - take
+ *   - setNotifier
+ *   - supersededCount
+ * @mainclasses
+ *   - FrameMailbox
+ */
+
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+#include <QImage>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+/**
+ * @brief FrameMailbox 只保留最新一帧：生产者直接覆盖未被取走的帧，消费者绘制时取走最新帧。
+ *
+ * 三个槽位分别归生产者（写入中）、中间（待取）与消费者（显示中）所有，交接只交换一个原子索引，
+ * 双方都不会阻塞。UI 线程卡顿时内存占用恒定为三帧，不会在事件队列中堆积。
+ * 发布新帧后最多只有一个未处理的重绘请求，消费者取帧时才允许发出下一个请求。
+ */
+class FrameMailbox {
+public:
+    /**
+     * @brief 构造函数，初始时三个槽位均为空。
+     */
+    FrameMailbox();
+
+    FrameMailbox(const FrameMailbox&) = delete;
+    FrameMailbox& operator=(const FrameMailbox&) = delete;
+
+    /**
+     * @brief 发布一帧（仅由单一生产者线程调用），覆盖尚未取走的旧帧。
+     * @param frame 新帧。
+     * @param traceId 帧的追踪编号，0 表示不追踪。
+     */
+    void publish(QImage frame, quint64 traceId = 0);
+
+    /**
+     * @brief 取走最新帧（仅由单一消费者线程调用）。
+     * @param frame 输出参数，有新帧时写入。
+     * @param traceId 可选输出参数，有新帧时写入其追踪编号。
+     * @return true 表示自上次调用后有新帧。
+     */
+    bool take(QImage& frame, quint64* traceId = nullptr);
+
+    /**
+     * @brief 丢弃待取的帧，用于停止播放后清屏。
+     */
+    void clear();
+
+    /**
+     * @brief 设置有新帧时的通知回调（通常向 UI 线程投递一次重绘），回调在生产者线程的 publish 内执行。
+     *        本函数可在任意线程调用（显示控件在 UI 线程设置），由内部互斥量保护。
+     * @param notifier 回调，传空表示取消通知。
+     */
+    void setNotifier(std::function<void()> notifier);
+
+    /**
+     * @brief 查询在显示前即被新帧覆盖的帧数。
+     * @return 累计覆盖数。
+     */
+    quint64 supersededCount() const;
+
+    /**
+     * @brief 重置覆盖计数。
+     */
+    void resetSupersededCount();
+
+private:
+    static constexpr quint8 kIndexMask = 0x3;
+    static constexpr quint8 kFreshBit = 0x4;    // 中间槽位中有尚未取走的新帧
+
+    QImage m_slots[3];
+    quint64 m_traceIds[3] = {};                 // 与槽位一一对应，随槽位交接
+    std::atomic<quint8> m_middle;               // 中间槽位索引 | kFreshBit
+    quint8 m_back = 0;                          // 生产者独占
+    quint8 m_front = 2;                         // 消费者独占
+    std::atomic_bool m_repaintPending{ false };
+    std::atomic<quint64> m_superseded{ 0 };
+
+    // 通知回调只在每次重绘请求时调用一次，用互斥锁保证控件析构时能安全撤销
+    std::mutex m_notifierMutex;
+    std::function<void()> m_notifier;
+};
+
+#endif // FRAMEMAILBOX_H
@@ -0,0 +1,226 @@
+/**
+ * @file framepool.cpp
+ * @brief 实现视频输出帧缓冲池与解码帧零拷贝包装。
+ * @mainfunctions
+ *   - FramePool::acquire
+ *   - FramePool::wrapFrame
+ *   - FramePool::releaseBuffer
+ * @mainclasses
+ *   - FramePool
+ */
+
+#include "framepool.h"
+
+#include <algorithm>
+
+extern "C"
+{
+#include <libavutil/mem.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace {
+    constexpr int kLineAlignment = 64; // 行对齐，便于 SIMD 写入并避免跨缓存行
+}
+
+/**
+ * @brief 单块池化缓冲区，借出期间持有池状态以保证归还时仍然有效。
+ */
+struct FramePool::Buffer {
+    uint8_t* data = nullptr;
+    size_t capacity = 0;
+    std::shared_ptr<State> owner;
+};
+
+/**
+ * @brief 池的共享状态，由 FramePool 与借出的缓冲区共同持有。
+ */
+struct FramePool::State {
+    std::mutex mutex;
+    std::vector<Buffer*> freeList;
+    size_t bufferBytes = 0; // 当前几何尺寸对应的缓冲区大小
+    int totalBuffers = 0;   // 已分配（空闲 + 借出）的池化缓冲区数量
+    int maxBuffers = 0;
+    bool closed = false;
+    std::atomic<quint64> allocations{ 0 };
+    std::atomic<quint64> hits{ 0 };
+
+    ~State() {
+        for (Buffer* buffer : freeList) {
+            destroy(buffer);
+        }
+    }
+
+    static void destroy(Buffer* buffer) {
+        av_free(buffer->data);
+        delete buffer;
+    }
+};
+
+/**
+ * @brief 构造函数，记录池容量。
+ * @param maxBuffers 最大缓冲区数量。
+ */
+FramePool::FramePool(int maxBuffers)
+    : m_state(std::make_shared<State>()) {
+    m_state->maxBuffers = std::max(1, maxBuffers);
+}
+
+/**
+ * @brief 析构函数，标记池关闭并释放空闲缓冲区。
+ */
+FramePool::~FramePool() {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->closed = true;
+    for (Buffer* buffer : m_state->freeList) {
+        State::destroy(buffer);
+        --m_state->totalBuffers;
+    }
+    m_state->freeList.clear();
+}
+
+/**
+ * @brief 借出与请求尺寸匹配的缓冲区，尺寸变化时淘汰旧缓冲区。
+ * @param width 图像宽度。
+ * @param height 图像高度。
+ * @return 池化 QImage 或退化分配的 QImage。
+ */
+QImage FramePool::acquire(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return QImage();
+    }
+
+    const int bytesPerLine = (width * 4 + kLineAlignment - 1) / kLineAlignment * kLineAlignment;
+    const size_t bytes = static_cast<size_t>(bytesPerLine) * static_cast<size_t>(height);
+
+    Buffer* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (bytes != m_state->bufferBytes) {
+            // 分辨率变化：空闲缓冲区立即释放，借出中的缓冲区归还时释放
+            for (Buffer* stale : m_state->freeList) {
+                State::destroy(stale);
+                --m_state->totalBuffers;
+            }
+            m_state->freeList.clear();
+            m_state->bufferBytes = bytes;
+        }
+
+        if (!m_state->freeList.empty()) {
+            buffer = m_state->freeList.back();
+            m_state->freeList.pop_back();
+            m_state->hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (m_state->totalBuffers < m_state->maxBuffers) {
+            uint8_t* data = static_cast<uint8_t*>(av_malloc(bytes));
+            if (data) {
+                buffer = new Buffer;
+                buffer->data = data;
+                buffer->capacity = bytes;
+                ++m_state->totalBuffers;
+                m_state->allocations.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    if (!buffer) {
+        // 池已耗尽（例如 UI 线程积压），退化为普通分配，保证不阻塞解码线程
+        m_state->allocations.fetch_add(1, std::memory_order_relaxed);
+        return QImage(width, height, QImage::Format_ARGB32);
+    }
+
+    buffer->owner = m_state;
+    return QImage(buffer->data, width, height, bytesPerLine, QImage::Format_ARGB32,
+        &FramePool::releaseBuffer, buffer);
+}
+
+/**
+ * @brief 释放空闲缓冲区，借出的缓冲区不受影响。
+ */
+void FramePool::clear() {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    for (Buffer* buffer : m_state->freeList) {
+        State::destroy(buffer);
+        --m_state->totalBuffers;
+    }
+    m_state->freeList.clear();
+    m_state->bufferBytes = 0;
+}
+
+/**
+ * @brief 返回累计分配次数。
+ * @return 分配次数。
+ */
+quint64 FramePool::allocationCount() const {
+    return m_state->allocations.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 返回累计命中次数。
+ * @return 命中次数。
+ */
+quint64 FramePool::hitCount() const {
+    return m_state->hits.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 仅 BGRA/BGR0 且行跨度为正的帧可直接映射为 QImage 的 32 位格式。
+ * @param frame 解码帧。
+ * @return true 表示可零拷贝包装。
+ */
+bool FramePool::canWrap(const AVFrame* frame) {
+    if (!frame || !frame->data[0] || !frame->buf[0] || frame->linesize[0] <= 0) {
+        return false;
+    }
+    return frame->format == AV_PIX_FMT_BGRA || frame->format == AV_PIX_FMT_BGR0;
+}
+
+/**
+ * @brief 引用解码帧并包装为 QImage，引用在 QImage 释放时归还给解码器缓冲池。
+ * @param frame 解码帧。
+ * @return 包装后的 QImage。
+ */
+QImage FramePool::wrapFrame(const AVFrame* frame) {
+    if (!canWrap(frame)) {
+        return QImage();
+    }
+
+    AVFrame* ref = av_frame_clone(frame);
+    if (!ref) {
+        return QImage();
+    }
+
+    const QImage::Format format = ref->format == AV_PIX_FMT_BGRA ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+    return QImage(ref->data[0], ref->width, ref->height, ref->linesize[0], format,
+        &FramePool::releaseFrame, ref);
+}
+
+/**
+ * @brief 归还池化缓冲区；池已关闭或尺寸已变化时直接释放。
+ * @param info 指向 Buffer。
+ */
+void FramePool::releaseBuffer(void* info) {
+    auto* buffer = static_cast<Buffer*>(info);
+    std::shared_ptr<State> state = std::move(buffer->owner);
+    if (!state) {
+        State::destroy(buffer);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->closed || buffer->capacity != state->bufferBytes) {
+        State::destroy(buffer);
+        --state->totalBuffers;
+        return;
+    }
+    state->freeList.push_back(buffer);
+}
+
+/**
+ * @brief 释放包装的 AVFrame 引用。
+ * @param info 指向 AVFrame。
+ */
+void FramePool::releaseFrame(void* info) {
+    AVFrame* frame = static_cast<AVFrame*>(info);
+    av_frame_free(&frame);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file framepool.h
+ * @brief 定义视频输出帧缓冲池，复用 QImage 像素内存以避免逐帧分配。
+ * @mainfunctions
+ *   - acquire
+ *   - wrapFrame
+ *   - canWrap
+ *   - clear
+ *   - allocationCount
+ *   - hitCount
+ * @mainclasses
+ *   - FramePool
+ */
+
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+/**
+ * @brief FramePool 维护固定数量的对齐缓冲区，并借助 QImage 清理回调在最后一个引用释放时归还。
+ *
+ * 借出的 QImage 可以安全地跨线程传递，也可以比池本身存活更久：池销毁后归还的缓冲区直接释放。
+ */
+class FramePool {
+public:
+    /**
+     * @brief 构造函数。
+     * @param maxBuffers 池中最多同时存在的缓冲区数量，超出时退化为普通 QImage 分配。
+     */
+    explicit FramePool(int maxBuffers = 8);
+
+    /**
+     * @brief 析构函数，释放空闲缓冲区，借出中的缓冲区在归还时释放。
+     */
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * @brief 借出一块可写的 ARGB32 图像缓冲区。
+     * @param width 图像宽度。
+     * @param height 图像高度。
+     * @return 池化的 QImage，池耗尽时返回普通分配的 QImage。
+     */
+    QImage acquire(int width, int height);
+
+    /**
+     * @brief 释放所有空闲缓冲区，例如在切换流时调用。
+     */
+    void clear();
+
+    /**
+     * @brief 查询累计真实分配次数（含池耗尽时的退化分配）。
+     * @return 分配次数，稳态下应保持不变。
+     */
+    quint64 allocationCount() const;
+
+    /**
+     * @brief 查询累计从空闲列表直接复用缓冲区的次数，任意线程可读取。
+     * @return 命中次数；与 allocationCount 之比即池的命中率。
+     */
+    quint64 hitCount() const;
+
+    /**
+     * @brief 判断解码帧是否可以不经转换直接包装为 QImage。
+     * @param frame 解码输出帧。
+     * @return true 表示像素格式与内存布局可直接显示。
+     */
+    static bool canWrap(const AVFrame* frame);
+
+    /**
+     * @brief 以零拷贝方式包装解码帧，帧缓冲（来自解码器 AVBufferPool）在 QImage 释放时归还。
+     * @param frame 解码输出帧，调用方仍保留其所有权。
+     * @return 包装后的 QImage，失败时返回空图像。
+     */
+    static QImage wrapFrame(const AVFrame* frame);
+
+private:
+    struct State;
+    struct Buffer;
+
+    /**
+     * @brief QImage 清理回调，将缓冲区归还到池中。
+     * @param info 指向 Buffer。
+     */
+    static void releaseBuffer(void* info);
+
+    /**
+     * @brief QImage 清理回调，释放包装的 AVFrame 引用。
+     * @param info 指向 AVFrame。
+     */
+    static void releaseFrame(void* info);
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,364 @@
+/**
+ * @file frametrace.cpp
+ * @brief 实现逐帧追踪的线程缓冲管理、无锁记录与 Chrome Trace JSON 导出。
+ * @mainfunctions
+ *   - FrameTrace::setEnabled
+ *   - FrameTrace::setThreadName
+ *   - FrameTrace::record
+ *   - FrameTrace::clear
+ *   - FrameTrace::exportChromeTrace
+ * @mainclasses
+ *   - FrameTrace
+ */
+
+#include "frametrace.h"
+
+#include <QByteArray>
+#include <QFile>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+    constexpr uint64_t kEventsPerThread = 1u << 15;    // 每线程 1 MiB，30fps 单路约可保留数分钟
+    constexpr size_t kMaxPendingRetired = 32;           // 未导出的已退出线程缓冲上限，超出后复用最早退出的
+
+    /**
+     * @brief 一个线程独占的环形缓冲。槽位字段用 relaxed 原子存取，使导出时与写入并发也没有数据竞争。
+     */
+    struct ThreadBuffer {
+        struct Slot {
+            std::atomic<int64_t> timeUs{ 0 };
+            std::atomic<int64_t> durationUs{ 0 };
+            std::atomic<uint64_t> id{ 0 };
+            std::atomic<int64_t> meta{ 0 };     // 打点位置 | (流下标 + 1) << 8
+        };
+
+        std::unique_ptr<Slot[]> entries{ new Slot[kEventsPerThread] };
+        std::atomic<uint64_t> head{ 0 };        // 只由所属线程写入，单调递增
+
+        // 以下字段受注册表互斥锁保护
+        int tid = 0;
+        const char* name = nullptr;
+        uint64_t firstIndex = 0;                // 此前的记录属于上一个线程或已被清除
+        bool retired = false;                   // 所属线程已退出
+        bool drained = false;                   // 退出后的记录已导出或清除，可由新线程复用
+        uint64_t retiredOrder = 0;              // 退出顺序，未导出的缓冲超限时复用最早的
+    };
+
+    /**
+     * @brief 所有线程缓冲的注册表，只在线程首次打点、线程退出、清除与导出时加锁。
+     */
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        int nextTid = 1;
+        uint64_t nextRetiredOrder = 1;
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    /**
+     * @brief 线程局部的缓冲持有者，线程退出时把缓冲标记为可复用。
+     */
+    struct ThreadHolder {
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ~ThreadHolder() {
+            if (buffer) {
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                buffer->retired = true;
+                buffer->drained = false;
+                buffer->retiredOrder = reg.nextRetiredOrder++;
+            }
+        }
+    };
+
+    thread_local ThreadHolder t_holder;
+    thread_local const char* t_threadName = nullptr;
+
+    /**
+     * @brief 为当前线程取得缓冲：复用退出后记录已导出（或已清除）的缓冲，使反复启停播放时内存不增长；
+     *        未导出的已退出缓冲保留其记录，只在数量超过上限时复用最早退出的一个。
+     * @return 缓冲。
+     */
+    ThreadBuffer* acquireBuffer() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        std::shared_ptr<ThreadBuffer> buffer;
+        std::shared_ptr<ThreadBuffer> oldestPending;
+        size_t pendingRetired = 0;
+        for (const auto& candidate : reg.buffers) {
+            if (!candidate->retired) {
+                continue;
+            }
+            if (candidate->drained) {
+                buffer = candidate;
+                break;
+            }
+            ++pendingRetired;
+            if (!oldestPending || candidate->retiredOrder < oldestPending->retiredOrder) {
+                oldestPending = candidate;
+            }
+        }
+        if (!buffer && pendingRetired >= kMaxPendingRetired) {
+            buffer = oldestPending;
+        }
+        if (!buffer) {
+            buffer = std::make_shared<ThreadBuffer>();
+            reg.buffers.push_back(buffer);
+        }
+        buffer->retired = false;
+        buffer->tid = reg.nextTid++;
+        buffer->name = t_threadName;
+        buffer->firstIndex = buffer->head.load(std::memory_order_relaxed);
+        t_holder.buffer = buffer;
+        return buffer.get();
+    }
+
+    /**
+     * @brief 打点位置在导出结果中的名称。
+     * @param point 打点位置。
+     * @return 名称。
+     */
+    const char* pointName(FrameTrace::Point point) {
+        switch (point) {
+        case FrameTrace::Point::PacketRead:
+            return "read";
+        case FrameTrace::Point::QueuePush:
+            return "queue push";
+        case FrameTrace::Point::QueueDrop:
+            return "queue drop";
+        case FrameTrace::Point::QueueSkip:
+            return "queue skip";
+        case FrameTrace::Point::QueuePop:
+            return "queue pop";
+        case FrameTrace::Point::SendPacket:
+            return "send packet";
+        case FrameTrace::Point::ReceiveFrame:
+            return "receive frame";
+        case FrameTrace::Point::Convert:
+            return "convert";
+        case FrameTrace::Point::Publish:
+            return "publish";
+        case FrameTrace::Point::Paint:
+            return "paint";
+        default:
+            return "unknown";
+        }
+    }
+
+    /**
+     * @brief 导出时从各缓冲复制出的记录。
+     */
+    struct Event {
+        int tid;
+        int64_t timeUs;
+        int64_t durationUs;
+        uint64_t id;
+        FrameTrace::Point point;
+        int stream;
+    };
+}
+
+std::atomic_bool FrameTrace::s_enabled{ false };
+std::atomic<uint64_t> FrameTrace::s_nextId{ 1 };
+
+/**
+ * @brief 切换记录开关。
+ * @param enabled 是否开启。
+ */
+void FrameTrace::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 保存线程名；缓冲已存在时同步更新。
+ * @param name 线程名（字符串字面量）。
+ */
+void FrameTrace::setThreadName(const char* name) {
+    t_threadName = name;
+    if (t_holder.buffer) {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        t_holder.buffer->name = name;
+    }
+}
+
+/**
+ * @brief 返回当前线程的名称。
+ * @return 线程名，未设置时为 nullptr。
+ */
+const char* FrameTrace::threadName() {
+    return t_threadName;
+}
+
+/**
+ * @brief 写入当前线程的下一个槽位，最后以 release 发布新的写入位置。
+ * @param point 打点位置。
+ * @param id 追踪编号。
+ * @param stream 流下标。
+ * @param timeUs 时刻。
+ * @param durationUs 持续时长。
+ */
+void FrameTrace::record(Point point, uint64_t id, int stream, int64_t timeUs, int64_t durationUs) {
+    ThreadBuffer* buffer = t_holder.buffer.get();
+    if (!buffer) {
+        buffer = acquireBuffer();
+    }
+    const uint64_t index = buffer->head.load(std::memory_order_relaxed);
+    ThreadBuffer::Slot& slot = buffer->entries[index % kEventsPerThread];
+    slot.timeUs.store(timeUs, std::memory_order_relaxed);
+    slot.durationUs.store(durationUs, std::memory_order_relaxed);
+    slot.id.store(id, std::memory_order_relaxed);
+    slot.meta.store(static_cast<int64_t>(point) | (static_cast<int64_t>(stream + 1) << 8), std::memory_order_relaxed);
+    buffer->head.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief 把每个缓冲的起始位置移到当前写入位置，已退出线程的缓冲随之可以复用。
+ */
+void FrameTrace::clear() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& buffer : reg.buffers) {
+        buffer->firstIndex = buffer->head.load(std::memory_order_acquire);
+        buffer->drained = buffer->retired;
+    }
+}
+
+/**
+ * @brief 复制各缓冲中仍有效的记录，按时间排序后写出切片与元数据，再按编号写出串联各阶段的流向事件。
+ *        快照时已退出的缓冲在复制完成后标记为可复用。
+ * @param path 输出文件路径。
+ * @param error 可选输出参数。
+ * @return 成功返回 true。
+ */
+bool FrameTrace::exportChromeTrace(const QString& path, QString* error) {
+    struct Snapshot {
+        std::shared_ptr<ThreadBuffer> buffer;
+        int tid;
+        const char* name;
+        uint64_t firstIndex;
+        uint64_t retiredOrder;      // 快照时未退出为 0
+    };
+    std::vector<Snapshot> snapshots;
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto& buffer : reg.buffers) {
+            snapshots.push_back(Snapshot{ buffer, buffer->tid, buffer->name, buffer->firstIndex,
+                buffer->retired ? buffer->retiredOrder : 0 });
+        }
+    }
+
+    std::vector<Event> events;
+    for (const Snapshot& snapshot : snapshots) {
+        ThreadBuffer& buffer = *snapshot.buffer;
+        const uint64_t head = buffer.head.load(std::memory_order_acquire);
+        uint64_t begin = head > kEventsPerThread ? head - kEventsPerThread : 0;
+        begin = std::max(begin, snapshot.firstIndex);
+        const size_t copiedFrom = events.size();
+        for (uint64_t index = begin; index < head; ++index) {
+            const ThreadBuffer::Slot& slot = buffer.entries[index % kEventsPerThread];
+            const int64_t meta = slot.meta.load(std::memory_order_relaxed);
+            events.push_back(Event{ snapshot.tid, slot.timeUs.load(std::memory_order_relaxed),
+                slot.durationUs.load(std::memory_order_relaxed), slot.id.load(std::memory_order_relaxed),
+                static_cast<Point>(meta & 0xFF), static_cast<int>(meta >> 8) - 1 });
+        }
+        // 复制期间写入方可能已绕回覆盖最旧的槽位，按复制后的写入位置丢弃这部分；
+        // 写入方发布 headAfter 之前已在改写下标 headAfter 的槽位，它与 headAfter + 1 - N 共用同一槽位
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t headAfter = buffer.head.load(std::memory_order_relaxed);
+        if (headAfter + 1 > kEventsPerThread && headAfter + 1 - kEventsPerThread > begin) {
+            const uint64_t overwritten = std::min(headAfter + 1 - kEventsPerThread, head) - begin;
+            events.erase(events.begin() + static_cast<std::ptrdiff_t>(copiedFrom),
+                events.begin() + static_cast<std::ptrdiff_t>(copiedFrom + overwritten));
+        }
+    }
+    {
+        // 退出顺序不变说明期间未被复用，复制的正是这批记录
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        for (const Snapshot& snapshot : snapshots) {
+            if (snapshot.retiredOrder != 0 && snapshot.buffer->retired && snapshot.buffer->retiredOrder == snapshot.retiredOrder) {
+                snapshot.buffer->drained = true;
+            }
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.timeUs < b.timeUs;
+    });
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    QByteArray out;
+    out.reserve(static_cast<int>(std::min<size_t>(events.size() * 200 + 4096, 256u << 20)));
+    char line[512];
+    bool first = true;
+    const auto append = [&out, &first, &line](int length) {
+        if (!first) {
+            out.append(",\n", 2);
+        }
+        first = false;
+        out.append(line, length);
+    };
+
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    append(std::snprintf(line, sizeof(line),
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"LiveStreamPullPlayer\"}}"));
+    for (const Snapshot& snapshot : snapshots) {
+        append(std::snprintf(line, sizeof(line),
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            snapshot.tid, snapshot.name ? snapshot.name : "thread"));
+    }
+    // 瞬时打点也写成零时长切片，使流向事件能绑定到它们
+    for (const Event& event : events) {
+        append(std::snprintf(line, sizeof(line),
+            "{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"id\":%llu,\"stream\":%d}}",
+            pointName(event.point), static_cast<long long>(event.timeUs), static_cast<long long>(event.durationUs),
+            event.tid, static_cast<unsigned long long>(event.id), event.stream));
+    }
+
+    // 按编号分组（组内保持时间顺序），首个为 s、中间为 t、最后为 f
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.id < b.id;
+    });
+    for (size_t i = 0; i < events.size();) {
+        size_t end = i + 1;
+        while (end < events.size() && events[end].id == events[i].id) {
+            ++end;
+        }
+        if (end - i > 1) {
+            for (size_t j = i; j < end; ++j) {
+                const char* phase = j == i ? "s" : (j + 1 == end ? "f" : "t");
+                append(std::snprintf(line, sizeof(line),
+                    "{\"name\":\"frame\",\"cat\":\"frame\",\"ph\":\"%s\",\"id\":%llu,\"ts\":%lld,\"pid\":1,\"tid\":%d,\"bp\":\"e\"}",
+                    phase, static_cast<unsigned long long>(events[j].id), static_cast<long long>(events[j].timeUs),
+                    events[j].tid));
+            }
+        }
+        i = end;
+    }
+    out.append("\n]}\n");
+
+    if (file.write(out) != out.size()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
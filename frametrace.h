@@ -0,0 +1,219 @@
+/**
+ * @file frametrace.h
+ * @brief 定义逐帧追踪：为每个数据包分配追踪编号，在读包、入队/出队、送包/取帧、转换、发布与绘制处打点，
+ *        记录写入各线程独占的无锁环形缓冲，按需导出为 Chrome / Perfetto 可加载的 JSON。
+ * @mainfunctions
+ *   - FrameTrace::setEnabled
+ *   - FrameTrace::newId
+ *   - FrameTrace::instant
+ *   - FrameTrace::span
+ *   - FrameTrace::exportChromeTrace
+ * @mainclasses
+ *   - FrameTrace
+ *   - PtsTagMap
+ */
+
+#ifndef FRAMETRACE_H
+#define FRAMETRACE_H
+
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/time.h>
+}
+
+/**
+ * @brief FrameTrace 是进程级的逐帧追踪记录器。
+ *
+ * 关闭时每个打点只有一次 relaxed 原子读与一次分支，不分配、不加锁；开启后每个线程在首次打点时
+ * 获得一个固定容量的环形缓冲，只有该线程写入，写满后覆盖最旧的记录。追踪编号在读包时分配，
+ * 经 AVPacket::opaque 随包穿过队列，解码后按时间戳对应到帧，再随帧经信箱到达绘制，
+ * 因此同一编号串起一帧在各线程上的全部阶段，导出时以流向箭头相连。
+ */
+class FrameTrace {
+public:
+    /**
+     * @brief 打点位置。
+     */
+    enum class Point : uint8_t {
+        PacketRead,     // av_read_frame 返回
+        QueuePush,      // 进入包队列
+        QueueDrop,      // 队列满时被丢弃
+        QueueSkip,      // 延迟追赶时被跳过（跳到最新关键帧或丢弃早于关键帧的音频）
+        QueuePop,       // 解码线程取出
+        SendPacket,     // avcodec_send_packet（持续）
+        ReceiveFrame,   // avcodec_receive_frame 取得一帧（持续）
+        Convert,        // 像素格式转换与缩放（持续）
+        Publish,        // 帧到达呈现时刻，交给信箱
+        Paint,          // 显示控件绘制该帧
+        Count
+    };
+
+    /**
+     * @brief 开启或关闭记录，关闭后已记录的内容保留，仍可导出。
+     * @param enabled 是否开启。
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * @brief 查询是否正在记录。
+     * @return 开启时返回 true。
+     */
+    static bool enabled() {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 为新读到的包分配追踪编号。
+     * @return 编号，未开启时为 0（表示不追踪）。
+     */
+    static uint64_t newId() {
+        return enabled() ? s_nextId.fetch_add(1, std::memory_order_relaxed) : 0;
+    }
+
+    /**
+     * @brief 设置当前线程在导出结果中的名称，线程启动时调用；只保存指针，需传入字符串字面量。
+     * @param name 线程名。
+     */
+    static void setThreadName(const char* name);
+
+    /**
+     * @brief 查询当前线程通过 setThreadName 设置的名称，不分配内存，可在内存分配钩子中调用。
+     * @return 线程名，未设置时为 nullptr。
+     */
+    static const char* threadName();
+
+    /**
+     * @brief 记录一个瞬时打点，时刻取调用时刻。
+     * @param point 打点位置。
+     * @param id 追踪编号，0 表示不追踪、不记录。
+     * @param stream 流下标，未知时为 -1。
+     */
+    static void instant(Point point, uint64_t id, int stream = -1) {
+        if (id != 0 && enabled()) {
+            record(point, id, stream, av_gettime_relative(), 0);
+        }
+    }
+
+    /**
+     * @brief 记录一个持续阶段，结束时刻取调用时刻。
+     * @param point 打点位置。
+     * @param id 追踪编号，0 表示不追踪、不记录。
+     * @param startUs 阶段开始时刻（av_gettime_relative 时钟，微秒）。
+     * @param stream 流下标，未知时为 -1。
+     */
+    static void span(Point point, uint64_t id, int64_t startUs, int stream = -1) {
+        if (id != 0 && enabled()) {
+            const int64_t nowUs = av_gettime_relative();
+            record(point, id, stream, startUs, nowUs - startUs);
+        }
+    }
+
+    /**
+     * @brief 把追踪编号写入包，随包的引用一起复制。
+     * @param packet 包。
+     * @param id 追踪编号。
+     */
+    static void tagPacket(AVPacket& packet, uint64_t id) {
+        packet.opaque = reinterpret_cast<void*>(static_cast<uintptr_t>(id));
+    }
+
+    /**
+     * @brief 读取包上的追踪编号。
+     * @param packet 包。
+     * @return 编号，未标记时为 0。
+     */
+    static uint64_t packetId(const AVPacket& packet) {
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(packet.opaque));
+    }
+
+    /**
+     * @brief 丢弃所有线程已记录的内容。
+     */
+    static void clear();
+
+    /**
+     * @brief 导出为 Chrome Trace Event JSON（chrome://tracing 与 ui.perfetto.dev 均可打开）。
+     * @param path 输出文件路径。
+     * @param error 可选输出参数，失败原因。
+     * @return 成功返回 true。
+     */
+    static bool exportChromeTrace(const QString& path, QString* error = nullptr);
+
+private:
+    /**
+     * @brief 写入当前线程的环形缓冲。
+     * @param point 打点位置。
+     * @param id 追踪编号。
+     * @param stream 流下标。
+     * @param timeUs 时刻。
+     * @param durationUs 持续时长，瞬时打点为 0。
+     */
+    static void record(Point point, uint64_t id, int stream, int64_t timeUs, int64_t durationUs);
+
+    static std::atomic_bool s_enabled;
+    static std::atomic<uint64_t> s_nextId;
+};
+
+/**
+ * @brief PtsTagMap 在解码线程内把送入解码器的包携带的值（追踪编号、入队时间等）对应到解出的帧。
+ *
+ * 解码器会重排帧序且 FFmpeg 5 不保证传递包的 opaque，因此按 pts 记住最近送入的若干个包，
+ * 取帧时按帧的 pts 查回；容量覆盖常见的重排深度，查不到时返回值初始化的 Value（0 表示无）。
+ */
+template <typename Value>
+class PtsTagMap {
+public:
+    /**
+     * @brief 记住一个已送入解码器的包。
+     * @param pts 包的 pts。
+     * @param value 携带的值，为 0 时不记录。
+     */
+    void remember(int64_t pts, Value value) {
+        if (value == Value() || pts == AV_NOPTS_VALUE) {
+            return;
+        }
+        m_entries[m_next] = Entry{ pts, value };
+        m_next = (m_next + 1) % kCapacity;
+    }
+
+    /**
+     * @brief 查找并移除与帧 pts 对应的值。
+     * @param pts 帧的 pts。
+     * @return 携带的值，未找到时为 0。
+     */
+    Value take(int64_t pts) {
+        if (pts == AV_NOPTS_VALUE) {
+            return Value();
+        }
+        for (Entry& entry : m_entries) {
+            if (entry.value != Value() && entry.pts == pts) {
+                const Value value = entry.value;
+                entry.value = Value();
+                return value;
+            }
+        }
+        return Value();
+    }
+
+private:
+    static constexpr int kCapacity = 32;
+
+    struct Entry {
+        int64_t pts = AV_NOPTS_VALUE;
+        Value value = Value();
+    };
+
+    Entry m_entries[kCapacity];
+    int m_next = 0;
+};
+
+// 包追踪编号到帧的对应
+using FrameTraceIds = PtsTagMap<uint64_t>;
+
+#endif // FRAMETRACE_H
@@ -0,0 +1,284 @@
+/**
+ * @file headlessmain.cpp
+ * @brief 无界面入口：以空音视频输出驱动 LiveStreamPlayer，逐行输出 JSON 统计，用于长时间运行与吞吐测试。
+ * @mainfunctions
+ *   - main
+ * @mainclasses
+ *   - 无
+ */
+
+#include "framemailbox.h"
+#include "frametrace.h"
+#include "livestreamplayer.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace {
+    constexpr int kFrameDrainIntervalMs = 16; // 空视频输出的取帧周期（约 60 Hz，与显示刷新相当）
+
+    /**
+     * @brief 运行模式，逐级增加被测的处理阶段。
+     */
+    enum class HeadlessMode {
+        DecodeOnly, // 只解码：视频不转换，音频不重采样、不输出
+        Convert,    // 解码并将视频转换为 QImage，音频不输出
+        Full        // 另外将音频写入环形缓冲，由空音频输出按实时速率消费
+    };
+
+    /**
+     * @brief 解析模式名称。
+     * @param text 命令行取值。
+     * @param mode 输出参数。
+     * @return 名称有效时返回 true。
+     */
+    bool parseMode(const QString& text, HeadlessMode* mode) {
+        if (text == QStringLiteral("decode")) {
+            *mode = HeadlessMode::DecodeOnly;
+        }
+        else if (text == QStringLiteral("convert")) {
+            *mode = HeadlessMode::Convert;
+        }
+        else if (text == QStringLiteral("full")) {
+            *mode = HeadlessMode::Full;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 模式名称，写入每行输出便于区分不同运行的结果。
+     * @param mode 模式。
+     * @return 名称。
+     */
+    QString modeName(HeadlessMode mode) {
+        switch (mode) {
+        case HeadlessMode::DecodeOnly:
+            return QStringLiteral("decode");
+        case HeadlessMode::Convert:
+            return QStringLiteral("convert");
+        default:
+            return QStringLiteral("full");
+        }
+    }
+
+    /**
+     * @brief 读取进程常驻内存（/proc/self/status 中的 VmRSS）。
+     * @return KiB，不支持的平台返回 -1。
+     */
+    qint64 residentMemoryKb() {
+        QFile file(QStringLiteral("/proc/self/status"));
+        if (!file.open(QIODevice::ReadOnly)) {
+            return -1;
+        }
+        const QByteArray status = file.readAll();
+        const int begin = status.indexOf("VmRSS:");
+        if (begin < 0) {
+            return -1;
+        }
+        const int end = status.indexOf('\n', begin);
+        bool ok = false;
+        const qint64 value = status.mid(begin + 6, end < 0 ? -1 : end - begin - 6).trimmed().split(' ').value(0).toLongLong(&ok);
+        return ok ? value : -1;
+    }
+
+    /**
+     * @brief 以单行紧凑 JSON 写到标准输出并立即刷新，便于管道另一端实时处理。
+     * @param object JSON 对象。
+     */
+    void writeJsonLine(const QJsonObject& object) {
+        const QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+        std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+    }
+}
+
+/**
+ * @brief 解析命令行，为每个地址创建一个播放器，按模式配置空输出后运行指定时长。
+ * @param argc 命令行参数数量。
+ * @param argv 命令行参数数组。
+ * @return 0 表示正常结束，1 表示参数错误。
+ */
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("LiveStreamPullPlayerHeadless"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("无界面拉流播放器：以空音视频输出运行，逐行输出 JSON 统计。"));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("urls"),
+        QStringLiteral("一个或多个流地址，每个地址对应一个播放器实例。"), QStringLiteral("<url>..."));
+    const QCommandLineOption durationOption(QStringList{ QStringLiteral("d"), QStringLiteral("duration") },
+        QStringLiteral("运行时长（秒），0 表示一直运行。"), QStringLiteral("seconds"), QStringLiteral("60"));
+    const QCommandLineOption modeOption(QStringList{ QStringLiteral("m"), QStringLiteral("mode") },
+        QStringLiteral("decode：只解码；convert：另外转换视频帧；full：另外以实时速率输出音频。"),
+        QStringLiteral("mode"), QStringLiteral("full"));
+    const QCommandLineOption latencyOption(QStringLiteral("max-latency-ms"),
+        QStringLiteral("延迟上限（毫秒），0 表示关闭。"), QStringLiteral("ms"), QStringLiteral("0"));
+    const QCommandLineOption captureOption(QStringLiteral("capture-dir"),
+        QStringLiteral("将每路收到的数据包写入该目录下的 stream<序号>.lspcap，供之后回放。"), QStringLiteral("dir"));
+    const QCommandLineOption replaySpeedOption(QStringLiteral("replay-speed"),
+        QStringLiteral("回放 .lspcap 文件的速度：1 为原始节奏，0 为最快。"), QStringLiteral("speed"), QStringLiteral("1"));
+    parser.addOption(durationOption);
+    parser.addOption(modeOption);
+    parser.addOption(latencyOption);
+    const QCommandLineOption impairOption(QStringLiteral("impair"),
+        QStringLiteral("网络损伤脚本，例如 \"latency=80,jitter=30,bandwidth=6000;@20:disconnect,outage=3000\"。"),
+        QStringLiteral("profile"));
+    parser.addOption(captureOption);
+    parser.addOption(replaySpeedOption);
+    const QCommandLineOption traceOption(QStringLiteral("trace"),
+        QStringLiteral("记录逐帧追踪，退出时导出为 Chrome Trace JSON。"), QStringLiteral("file"));
+    const QCommandLineOption audioSinkOption(QStringLiteral("audio-sink"),
+        QStringLiteral("null：空音频输出（默认）；device：打开默认声卡，重连时包含真实的设备格式协商。"),
+        QStringLiteral("sink"), QStringLiteral("null"));
+    const QCommandLineOption noAudioReuseOption(QStringLiteral("no-audio-reuse"),
+        QStringLiteral("每次连接都重新协商设备格式并阻塞等待重建音频输出（旧行为），用于对比 audioSetupMs。"));
+    parser.addOption(impairOption);
+    parser.addOption(traceOption);
+    parser.addOption(audioSinkOption);
+    parser.addOption(noAudioReuseOption);
+    parser.process(app);
+
+    const QStringList urls = parser.positionalArguments();
+    if (urls.isEmpty()) {
+        std::fprintf(stderr, "At least one stream URL is required.\n");
+        return 1;
+    }
+    HeadlessMode mode = HeadlessMode::Full;
+    if (!parseMode(parser.value(modeOption), &mode)) {
+        std::fprintf(stderr, "Unknown mode: %s\n", qPrintable(parser.value(modeOption)));
+        return 1;
+    }
+    const QString audioSink = parser.value(audioSinkOption);
+    if (audioSink != QStringLiteral("null") && audioSink != QStringLiteral("device")) {
+        std::fprintf(stderr, "Unknown audio sink: %s\n", qPrintable(audioSink));
+        return 1;
+    }
+    bool durationOk = false;
+    const int durationSec = parser.value(durationOption).toInt(&durationOk);
+    bool latencyOk = false;
+    const int maxLatencyMs = parser.value(latencyOption).toInt(&latencyOk);
+    bool speedOk = false;
+    const double replaySpeed = parser.value(replaySpeedOption).toDouble(&speedOk);
+    if (!durationOk || durationSec < 0 || !latencyOk || maxLatencyMs < 0 || !speedOk || replaySpeed < 0.0) {
+        std::fprintf(stderr, "Invalid duration, latency or replay speed value.\n");
+        return 1;
+    }
+
+    std::shared_ptr<const ImpairmentProfile> impairment;
+    if (parser.isSet(impairOption)) {
+        auto profile = std::make_shared<ImpairmentProfile>();
+        QString error;
+        if (!ImpairmentProfile::parse(parser.value(impairOption), profile.get(), &error)) {
+            std::fprintf(stderr, "Invalid impairment profile: %s\n", qPrintable(error));
+            return 1;
+        }
+        impairment = std::move(profile);
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    std::vector<std::unique_ptr<LiveStreamPlayer>> players;
+    std::vector<std::shared_ptr<FrameMailbox>> mailboxes;
+    for (int i = 0; i < urls.size(); ++i) {
+        auto player = std::make_unique<LiveStreamPlayer>();
+        player->setNullAudioSink(audioSink == QStringLiteral("null"));
+        player->setAudioOutputReuse(!parser.isSet(noAudioReuseOption));
+        player->setMuted(mode != HeadlessMode::Full);
+        player->setVideoConversionEnabled(mode != HeadlessMode::DecodeOnly);
+        player->setMaxLatencyMs(maxLatencyMs);
+        player->setReplaySpeed(replaySpeed);
+        player->setNetworkImpairment(impairment);
+        if (parser.isSet(captureOption)) {
+            player->setCaptureFile(QStringLiteral("%1/stream%2.lspcap").arg(parser.value(captureOption)).arg(i));
+        }
+        if (mode != HeadlessMode::DecodeOnly) {
+            // 空视频输出：转换后的帧投递到信箱，由定时器取走，与界面模式的缓冲池周转方式一致
+            auto mailbox = std::make_shared<FrameMailbox>();
+            player->setFrameMailbox(mailbox);
+            mailboxes.push_back(std::move(mailbox));
+        }
+
+        const auto makeLine = [&elapsed, i, mode](const QString& type) {
+            QJsonObject line;
+            line.insert(QStringLiteral("type"), type);
+            line.insert(QStringLiteral("timeSec"), static_cast<double>(elapsed.elapsed()) / 1000.0);
+            line.insert(QStringLiteral("stream"), i);
+            line.insert(QStringLiteral("mode"), modeName(mode));
+            return line;
+        };
+        QObject::connect(player.get(), &LiveStreamPlayer::statsUpdated, &app, [makeLine](const PlayerStats& stats) {
+            QJsonObject line = makeLine(QStringLiteral("stats"));
+            const qint64 rssKb = residentMemoryKb();
+            if (rssKb >= 0) {
+                line.insert(QStringLiteral("rssKb"), static_cast<double>(rssKb));
+            }
+            line.insert(QStringLiteral("stats"), stats.toJson());
+            writeJsonLine(line);
+        });
+        QObject::connect(player.get(), &LiveStreamPlayer::statusChanged, &app, [makeLine](const QString& status) {
+            QJsonObject line = makeLine(QStringLiteral("status"));
+            line.insert(QStringLiteral("message"), status);
+            writeJsonLine(line);
+        });
+        QObject::connect(player.get(), &LiveStreamPlayer::errorOccurred, &app, [makeLine](const QString& message) {
+            QJsonObject line = makeLine(QStringLiteral("error"));
+            line.insert(QStringLiteral("message"), message);
+            writeJsonLine(line);
+        });
+        players.push_back(std::move(player));
+    }
+
+    QTimer drainTimer;
+    drainTimer.setInterval(kFrameDrainIntervalMs);
+    QObject::connect(&drainTimer, &QTimer::timeout, &app, [&mailboxes]() {
+        QImage frame;
+        for (const auto& mailbox : mailboxes) {
+            mailbox->take(frame);
+        }
+    });
+    if (!mailboxes.empty()) {
+        drainTimer.start();
+    }
+
+    if (durationSec > 0) {
+        QTimer::singleShot(durationSec * 1000, &app, [&players, &app]() {
+            for (const auto& player : players) {
+                player->stop();
+            }
+            app.quit();
+        });
+    }
+
+    FrameTrace::setEnabled(parser.isSet(traceOption));
+    for (int i = 0; i < urls.size(); ++i) {
+        players[static_cast<size_t>(i)]->start(urls.at(i));
+    }
+
+    const int result = app.exec();
+    // 析构时等待各播放器的异步停止完成
+    players.clear();
+    if (parser.isSet(traceOption)) {
+        FrameTrace::setEnabled(false);
+        QString error;
+        if (!FrameTrace::exportChromeTrace(parser.value(traceOption), &error)) {
+            std::fprintf(stderr, "Cannot write trace: %s\n", qPrintable(error));
+        }
+    }
+    return result;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file interleaverbench.cpp
+ * @brief 实现音频交错的一致性检查与吞吐测量。
+ * @mainfunctions
+ *   - InterleaverBench::run
+ * @mainclasses
+ *   - 无
+ */
+
+#include "interleaverbench.h"
+
+#include "audiointerleaver.h"
+
+#include <QJsonArray>
+#include <QString>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+namespace {
+    constexpr int kMaxChannels = 8;
+    constexpr int kThroughputSamples = 1024;    // 一帧 AAC
+    constexpr int kThroughputIterations = 20000;
+
+    // 覆盖 SIMD 整块（浮点 4 个、16 位 8 个）前后的余数
+    constexpr int kSampleCounts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 1023, 1024, 1031 };
+    constexpr AVSampleFormat kFormats[] = { AV_SAMPLE_FMT_FLT, AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_S16P };
+
+    /**
+     * @brief 以线性同余序列填充字节，每个通道、每个样本的内容都不同。
+     * @param data 目标。
+     * @param bytes 字节数。
+     * @param seed 种子。
+     */
+    void fillPattern(uint8_t* data, size_t bytes, uint32_t seed) {
+        uint32_t state = seed * 2654435761u + 1;
+        for (size_t i = 0; i < bytes; ++i) {
+            state = state * 1664525u + 1013904223u;
+            data[i] = static_cast<uint8_t>(state >> 24);
+        }
+    }
+
+    /**
+     * @brief 参考实现：逐样本按字节拷贝到交错位置，不依赖样本类型，也就不受浮点 NaN 比较影响。
+     * @param planes 源平面（打包格式只使用 planes[0]）。
+     * @param format 源格式。
+     * @param channels 通道数。
+     * @param samples 每通道样本数。
+     * @param dst 目标缓冲。
+     */
+    void interleaveReference(const uint8_t* const* planes, AVSampleFormat format, int channels, int samples, uint8_t* dst) {
+        const size_t bytesPerSample = static_cast<size_t>(av_get_bytes_per_sample(format));
+        const bool planar = av_sample_fmt_is_planar(format) != 0;
+        for (int i = 0; i < samples; ++i) {
+            for (int ch = 0; ch < channels; ++ch) {
+                const uint8_t* src = planar
+                    ? planes[ch] + static_cast<size_t>(i) * bytesPerSample
+                    : planes[0] + (static_cast<size_t>(i) * channels + ch) * bytesPerSample;
+                std::memcpy(dst + (static_cast<size_t>(i) * channels + ch) * bytesPerSample, src, bytesPerSample);
+            }
+        }
+    }
+
+    /**
+     * @brief 检查一个组合：源平面与目标都从偏移一个样本的位置开始，目标前后各留一个样本的哨兵。
+     * @param format 源格式。
+     * @param channels 通道数。
+     * @param samples 样本数。
+     * @param seed 数据种子。
+     * @return 与参考实现逐字节一致且哨兵未被改写时为 true。
+     */
+    bool checkCase(AVSampleFormat format, int channels, int samples, uint32_t seed) {
+        const size_t bytesPerSample = static_cast<size_t>(av_get_bytes_per_sample(format));
+        const bool planar = av_sample_fmt_is_planar(format) != 0;
+        const size_t planeSamples = planar ? static_cast<size_t>(samples) : static_cast<size_t>(samples) * channels;
+        const int planeCount = planar ? channels : 1;
+
+        std::vector<std::vector<uint8_t>> storage(static_cast<size_t>(planeCount));
+        const uint8_t* planes[kMaxChannels] = {};
+        for (int p = 0; p < planeCount; ++p) {
+            storage[p].resize((planeSamples + 1) * bytesPerSample);
+            fillPattern(storage[p].data(), storage[p].size(), seed + static_cast<uint32_t>(p));
+            planes[p] = storage[p].data() + bytesPerSample;
+        }
+
+        const size_t outBytes = static_cast<size_t>(samples) * channels * bytesPerSample;
+        std::vector<uint8_t> actual(outBytes + 2 * bytesPerSample, 0xA5);
+        std::vector<uint8_t> expected(actual.size(), 0xA5);
+        AudioInterleaver::interleave(planes, format, channels, samples, actual.data() + bytesPerSample);
+        interleaveReference(planes, format, channels, samples, expected.data() + bytesPerSample);
+        return actual == expected;
+    }
+
+    /**
+     * @brief 测量立体声平面格式交错的吞吐。
+     * @param format FLTP 或 S16P。
+     * @param reference true 测参考实现，false 测 AudioInterleaver。
+     * @return 每秒处理的样本数（百万，按每通道计）。
+     */
+    double measureThroughput(AVSampleFormat format, bool reference) {
+        const size_t bytesPerSample = static_cast<size_t>(av_get_bytes_per_sample(format));
+        std::vector<uint8_t> left(kThroughputSamples * bytesPerSample);
+        std::vector<uint8_t> right(kThroughputSamples * bytesPerSample);
+        fillPattern(left.data(), left.size(), 1);
+        fillPattern(right.data(), right.size(), 2);
+        const uint8_t* planes[2] = { left.data(), right.data() };
+        std::vector<uint8_t> out(2 * kThroughputSamples * bytesPerSample);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kThroughputIterations; ++i) {
+            if (reference) {
+                interleaveReference(planes, format, 2, kThroughputSamples, out.data());
+            }
+            else {
+                AudioInterleaver::interleave(planes, format, 2, kThroughputSamples, out.data());
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // 防止整个循环被优化掉
+        volatile uint8_t sink = out[out.size() / 2];
+        (void)sink;
+        return seconds > 0.0 ? static_cast<double>(kThroughputSamples) * kThroughputIterations / seconds / 1e6 : 0.0;
+    }
+}
+
+/**
+ * @brief 逐组合检查，记录不一致的组合，再测量立体声吞吐。
+ * @param matched 输出参数。
+ * @return 结果对象。
+ */
+QJsonObject InterleaverBench::run(bool* matched) {
+    int cases = 0;
+    QJsonArray mismatches;
+    uint32_t seed = 1;
+    for (AVSampleFormat format : kFormats) {
+        for (int channels = 1; channels <= kMaxChannels; ++channels) {
+            for (int samples : kSampleCounts) {
+                ++cases;
+                if (!checkCase(format, channels, samples, seed++)) {
+                    QJsonObject mismatch;
+                    mismatch.insert(QStringLiteral("format"), QString::fromLatin1(av_get_sample_fmt_name(format)));
+                    mismatch.insert(QStringLiteral("channels"), channels);
+                    mismatch.insert(QStringLiteral("samples"), samples);
+                    mismatches.append(mismatch);
+                }
+            }
+        }
+    }
+
+    QJsonArray throughput;
+    for (AVSampleFormat format : { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16P }) {
+        QJsonObject entry;
+        entry.insert(QStringLiteral("format"), QString::fromLatin1(av_get_sample_fmt_name(format)));
+        entry.insert(QStringLiteral("channels"), 2);
+        entry.insert(QStringLiteral("msamplesPerSec"), measureThroughput(format, false));
+        entry.insert(QStringLiteral("referenceMsamplesPerSec"), measureThroughput(format, true));
+        throughput.append(entry);
+    }
+
+    const bool allMatched = mismatches.isEmpty();
+    if (matched) {
+        *matched = allMatched;
+    }
+    QJsonObject object;
+    object.insert(QStringLiteral("cases"), cases);
+    object.insert(QStringLiteral("mismatches"), mismatches);
+    object.insert(QStringLiteral("matched"), allMatched);
+    object.insert(QStringLiteral("throughput"), throughput);
+    return object;
+}
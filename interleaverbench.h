@@ -0,0 +1,33 @@
+/**
+ * @file interleaverbench.h
+ * @brief 定义音频交错的一致性检查：以确定的平面 PCM 驱动 AudioInterleaver，逐样本与标量参考实现比较，
+ *        并测量立体声交错相对标量参考的吞吐。
+ * @mainfunctions
+ *   - InterleaverBench::run
+ * @mainclasses
+ *   - InterleaverBench
+ */
+
+#ifndef INTERLEAVERBENCH_H
+#define INTERLEAVERBENCH_H
+
+#include <QJsonObject>
+
+/**
+ * @brief InterleaverBench 检查直通路径的交错结果与逐样本赋值的参考实现逐位一致。
+ *
+ * 覆盖 FLT/FLTP/S16/S16P × 1~8 通道 × 含 SIMD 整块前后余数的多种样本数，源平面与目标缓冲都额外
+ * 偏移一个样本，确保非对齐地址同样被检查。吞吐部分对立体声 FLTP/S16P 的 1024 样本帧重复交错，
+ * 报告 AudioInterleaver 与标量参考各自的每秒样本数。
+ */
+class InterleaverBench {
+public:
+    /**
+     * @brief 执行一致性检查与吞吐测量。
+     * @param matched 输出参数，所有组合都与参考实现一致时为 true，可为 nullptr。
+     * @return 结果对象，字段见 README。
+     */
+    static QJsonObject run(bool* matched);
+};
+
+#endif // INTERLEAVERBENCH_H
@@ -0,0 +1,187 @@
+/**
+ * @file latencyhistogram.cpp
+ * @brief 实现延迟直方图的分桶、合并与分位数计算。
+ * @mainfunctions
+ *   - LatencyHistogram::record
+ *   - LatencyHistogram::merge
+ *   - LatencyHistogram::summarize
+ *   - LatencyHistogram::summarizeSince
+ *   - LatencyHistogram::assign
+ * @mainclasses
+ *   - LatencyHistogram
+ */
+
+#include "latencyhistogram.h"
+
+#include <algorithm>
+
+/**
+ * @brief 超出范围的样本归入最后一个桶，最大值仍精确记录。
+ * @param valueUs 耗时（微秒）。
+ */
+void LatencyHistogram::record(int64_t valueUs) {
+    const uint64_t value = valueUs > 0 ? static_cast<uint64_t>(valueUs) : 0;
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t previous = m_max.load(std::memory_order_relaxed);
+    while (value > previous && !m_max.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 逐桶累加。
+ * @param other 来源直方图。
+ */
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < kBucketCount; ++i) {
+        const uint64_t count = other.m_buckets[i].load(std::memory_order_relaxed);
+        if (count > 0) {
+            m_buckets[i].fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+    m_count.fetch_add(other.m_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    const uint64_t otherMax = other.m_max.load(std::memory_order_relaxed);
+    uint64_t previous = m_max.load(std::memory_order_relaxed);
+    while (otherMax > previous && !m_max.compare_exchange_weak(previous, otherMax, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 读取各桶计数后汇总全部样本。
+ * @return 汇总结果。
+ */
+LatencyHistogram::Summary LatencyHistogram::summarize() const {
+    uint64_t counts[kBucketCount];
+    for (int i = 0; i < kBucketCount; ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return summarizeCounts(counts, m_sum.load(std::memory_order_relaxed),
+        static_cast<double>(m_max.load(std::memory_order_relaxed)));
+}
+
+/**
+ * @brief 逐桶相减；最大值无法从差值精确得出，取最高非空桶的代表值与全局最大值中较小者。
+ * @param baseline 基线。
+ * @return 汇总结果。
+ */
+LatencyHistogram::Summary LatencyHistogram::summarizeSince(const LatencyHistogram& baseline) const {
+    const bool baselineValid = baseline.m_count.load(std::memory_order_relaxed) <= m_count.load(std::memory_order_relaxed);
+    uint64_t counts[kBucketCount];
+    int highest = -1;
+    for (int i = 0; i < kBucketCount; ++i) {
+        const uint64_t current = m_buckets[i].load(std::memory_order_relaxed);
+        const uint64_t previous = baselineValid ? baseline.m_buckets[i].load(std::memory_order_relaxed) : 0;
+        counts[i] = current > previous ? current - previous : 0;
+        if (counts[i] > 0) {
+            highest = i;
+        }
+    }
+    if (highest < 0) {
+        return Summary();
+    }
+    const uint64_t sum = m_sum.load(std::memory_order_relaxed);
+    const uint64_t baselineSum = baselineValid ? baseline.m_sum.load(std::memory_order_relaxed) : 0;
+    return summarizeCounts(counts, sum > baselineSum ? sum - baselineSum : 0,
+        std::min(static_cast<double>(m_max.load(std::memory_order_relaxed)), bucketValue(highest)));
+}
+
+/**
+ * @brief 逐字段复制。
+ * @param other 来源直方图。
+ */
+void LatencyHistogram::assign(const LatencyHistogram& other) {
+    for (int i = 0; i < kBucketCount; ++i) {
+        m_buckets[i].store(other.m_buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    m_count.store(other.m_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_sum.store(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_max.store(other.m_max.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+/**
+ * @brief 按累计计数查找分位数所在的桶；分位数不超过最大值。
+ * @param counts 各桶计数。
+ * @param sum 样本总和。
+ * @param maxUs 最大值。
+ * @return 汇总结果。
+ */
+LatencyHistogram::Summary LatencyHistogram::summarizeCounts(const uint64_t* counts, uint64_t sum, double maxUs) {
+    uint64_t total = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        total += counts[i];
+    }
+
+    Summary summary;
+    if (total == 0) {
+        return summary;
+    }
+    summary.count = total;
+    summary.maxUs = maxUs;
+    summary.meanUs = static_cast<double>(sum) / static_cast<double>(total);
+
+    const auto percentile = [&](double fraction) {
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * static_cast<double>(total) + 0.5));
+        uint64_t seen = 0;
+        for (int i = 0; i < kBucketCount; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(bucketValue(i), summary.maxUs);
+            }
+        }
+        return summary.maxUs;
+    };
+    summary.p50Us = percentile(0.50);
+    summary.p90Us = percentile(0.90);
+    summary.p99Us = percentile(0.99);
+    return summary;
+}
+
+/**
+ * @brief 清零。与并发记录同时调用时可能残留少量样本，仅用于统计窗口切换。
+ */
+void LatencyHistogram::reset() {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 值 v ≥ 16 时取最高位指数 e，子桶为紧随最高位之后的 3 位。
+ * @param value 样本值。
+ * @return 桶下标。
+ */
+int LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(kLinearBuckets)) {
+        return static_cast<int>(value);
+    }
+    int exponent = 63;
+    while (!(value >> exponent)) {
+        --exponent;
+    }
+    if (exponent >= kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    const int subBucket = static_cast<int>((value >> (exponent - kSubBucketBits)) & ((1 << kSubBucketBits) - 1));
+    return kLinearBuckets + (exponent - 4) * (1 << kSubBucketBits) + subBucket;
+}
+
+/**
+ * @brief 线性区直接返回下标，对数区返回子桶区间的中点。
+ * @param index 桶下标。
+ * @return 微秒。
+ */
+double LatencyHistogram::bucketValue(int index) {
+    if (index < kLinearBuckets) {
+        return static_cast<double>(index);
+    }
+    const int exponent = 4 + (index - kLinearBuckets) / (1 << kSubBucketBits);
+    const int subBucket = (index - kLinearBuckets) % (1 << kSubBucketBits);
+    const double width = static_cast<double>(uint64_t(1) << (exponent - kSubBucketBits));
+    const double lower = static_cast<double>(uint64_t(1) << exponent) + subBucket * width;
+    return lower + width / 2.0;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file latencyhistogram.h
+ * @brief 定义无锁的对数分桶延迟直方图，用于统计各处理阶段的耗时分位数。
+ * @mainfunctions
+ *   - record
+ *   - merge
+ *   - summarize
+ *   - summarizeSince
+ *   - assign
+ *   - reset
+ * @mainclasses
+ *   - LatencyHistogram
+ */
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief LatencyHistogram 以微秒为单位累计耗时样本。
+ *
+ * 小于 16 µs 的值逐一分桶，其余按 2 的幂分段、每段再等分 8 个子桶，相对误差不超过 12.5%，
+ * 覆盖到数小时。记录只做一次数组下标计算与几次 relaxed 原子加法，可在解码循环中每帧调用；
+ * 汇总时读取的是近似快照，与并发记录之间不需要同步。
+ */
+class LatencyHistogram {
+public:
+    /**
+     * @brief 汇总结果，时间单位均为微秒。
+     */
+    struct Summary {
+        uint64_t count = 0;
+        double meanUs = 0.0;
+        double p50Us = 0.0;
+        double p90Us = 0.0;
+        double p99Us = 0.0;
+        double maxUs = 0.0;
+    };
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /**
+     * @brief 记录一个样本，任意线程可调用。
+     * @param valueUs 耗时（微秒），负值按 0 处理。
+     */
+    void record(int64_t valueUs);
+
+    /**
+     * @brief 将另一个直方图的样本累加进来，用于汇总多路播放器。
+     * @param other 来源直方图。
+     */
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * @brief 计算样本数、均值、分位数与最大值。
+     * @return 汇总结果，没有样本时各值为 0。
+     */
+    Summary summarize() const;
+
+    /**
+     * @brief 只汇总基线之后新增的样本，用于最近一段时间的分位数。
+     * @param baseline 先前以 assign 保存的副本；计数少于基线（期间被 reset）时按空基线处理。
+     * @return 汇总结果，最大值取新增样本所在最高桶的代表值（不超过记录到的最大值）。
+     */
+    Summary summarizeSince(const LatencyHistogram& baseline) const;
+
+    /**
+     * @brief 复制另一个直方图的当前内容（近似快照），用作 summarizeSince 的基线。
+     * @param other 来源直方图。
+     */
+    void assign(const LatencyHistogram& other);
+
+    /**
+     * @brief 清空所有样本。
+     */
+    void reset();
+
+private:
+    static constexpr int kLinearBuckets = 16;
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kMaxExponent = 40;
+    static constexpr int kBucketCount = kLinearBuckets + (kMaxExponent - 4) * (1 << kSubBucketBits);
+
+    /**
+     * @brief 计算样本所在的桶。
+     * @param value 样本值。
+     * @return 桶下标。
+     */
+    static int bucketIndex(uint64_t value);
+
+    /**
+     * @brief 桶的代表值（区间中点）。
+     * @param index 桶下标。
+     * @return 微秒。
+     */
+    static double bucketValue(int index);
+
+    /**
+     * @brief 由各桶计数计算汇总结果。
+     * @param counts 各桶计数。
+     * @param sum 样本总和。
+     * @param maxUs 最大值上限。
+     * @return 汇总结果。
+     */
+    static Summary summarizeCounts(const uint64_t* counts, uint64_t sum, double maxUs);
+
+    std::atomic<uint64_t> m_buckets[kBucketCount] = {};
+    std::atomic<uint64_t> m_count{ 0 };
+    std::atomic<uint64_t> m_sum{ 0 };
+    std::atomic<uint64_t> m_max{ 0 };
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -6,17 +6,27 @@
  *   - LiveStreamPlayer::stop
  *   - LiveStreamPlayer::demuxLoop
  *   - LiveStreamPlayer::videoDecodeLoop
+ *   - LiveStreamPlayer::waitForPresentation
+ *   - LiveStreamPlayer::regulateLatency
+ *   - LiveStreamPlayer::replayUnpaced
  *   - LiveStreamPlayer::audioDecodeLoop
+ *   - LiveStreamPlayer::drainResampler
  *   - LiveStreamPlayer::openStream
  *   - LiveStreamPlayer::setupAudioOutput
+ *   - LiveStreamPlayer::configureAudioRing
+ *   - LiveStreamPlayer::updateAudioClock
  *   - LiveStreamPlayer::updateStats
+ *   - LiveStreamPlayer::requestStatsUpdate
+ *   - LiveStreamPlayer::latestStats
  * @mainclasses
  *   - LiveStreamPlayer
  */
 
 #include "livestreamplayer.h"
 
-#include <QAudioDeviceInfo>
+#include "frametrace.h"
+#include "probes.h"
+
 #include <QMetaObject>
 #include <QThread>
 #include <QTimer>
@@ -24,6 +34,10 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <vector>
 #include <type_traits>
 #include <utility>
@@ -43,6 +57,78 @@ namespace {
     constexpr int kQueueMaxPacketsVideo = 90;
     constexpr int kQueueMaxPacketsAudio = 180;
     constexpr int kMaxReconnectAttempts = 5; // default 最大重试次数
+    constexpr double kMaxFrameDelaySec = 1.0;      // 帧超前主时钟超过该值视为时间戳跳变
+    constexpr double kMinLateToleranceMs = 20.0;   // 迟到容忍度下限，实际取其与帧间隔的较大值
+    constexpr int64_t kPresentationPollUs = 10000; // 等待呈现时的最长单次休眠
+    constexpr double kCatchUpRate = 1.05;          // 小幅超出延迟上限时的追赶速率
+    constexpr double kCatchUpStopRatio = 0.8;      // 缓冲降到上限的该比例以下时恢复正常速率
+    constexpr double kJumpExcessSec = 2.0;         // 超出上限至少该值（且不小于上限本身）时直接跳到最新关键帧
+    constexpr double kTargetAudioBufferMs = 240.0; // 漂移补偿保持的音频水位（设备缓冲 200 ms + 少量待写数据）
+    constexpr int64_t kDriftUpdateIntervalUs = 100000; // 漂移控制器的更新间隔
+    constexpr size_t kAudioRingBytes = 1 << 20;    // PCM 环形缓冲容量（48 kHz 立体声 16 位约 5.4 秒）
+    constexpr int kDefaultMaxAudioQueueMs = 500;   // 默认排队音频上限，正常水位（约 40 ms）远低于此值
+    constexpr double kMaxVolume = 4.0;             // 软件增益上限
+    constexpr int64_t kLevelWindowUs = 100000;     // 电平统计窗口
+    constexpr double kRealtimeResyncSec = 1.0;     // 实时读取时时间戳超前或回退超过该值视为跳变，重新对齐
+    constexpr int64_t kRealtimePollUs = 10000;     // 实时读取等待的最长单次休眠
+    constexpr int64_t kReplayBackpressureUs = 2000; // 非原速回放时等待队列腾出空位的轮询间隔
+    constexpr int64_t kMinStallUs = 250000;        // 卡顿阈值下限，实际取其与 3 个帧间隔的较大值
+    constexpr int64_t kRateWindowUs = 1000000;     // 帧率统计窗口
+    constexpr int64_t kPercentileWindowUs = 5000000; // 分位数基线的刷新间隔
+
+    /**
+     * @brief 迟到容忍度：至少一个帧间隔。
+     * @param frameDurationMs 标称帧间隔（毫秒）。
+     * @return 容忍度（秒）。
+     */
+    double lateToleranceSec(double frameDurationMs) {
+        return std::max(kMinLateToleranceMs, frameDurationMs) / 1000.0;
+    }
+
+    /**
+     * @brief 卡顿阈值：呈现间隔明显超出正常帧间隔才计为卡顿。
+     * @param frameDurationMs 标称帧间隔（毫秒），未知时为 0。
+     * @return 阈值（微秒）。
+     */
+    int64_t stallThresholdUs(double frameDurationMs) {
+        return std::max(kMinStallUs, static_cast<int64_t>(frameDurationMs * 3000.0));
+    }
+
+    /**
+     * @brief 计数增量折算为每秒速率。
+     * @param current 当前计数。
+     * @param previous 窗口起点计数。
+     * @param elapsedUs 窗口时长。
+     * @return 速率，计数回退（期间重新开始）时为 0。
+     */
+    double ratePerSecond(quint64 current, quint64 previous, int64_t elapsedUs) {
+        if (elapsedUs <= 0 || current < previous) {
+            return 0.0;
+        }
+        return static_cast<double>(current - previous) * 1e6 / static_cast<double>(elapsedUs);
+    }
+
+    /**
+     * @brief 直通路径的漂移修正：delta < 0 时丢弃末尾样本，delta > 0 时重复最后一个样本。
+     * @param data 已交错的数据，需预留 delta 个额外采样帧的空间。
+     * @param samples 原样本数。
+     * @param delta 需要增减的样本数。
+     * @param bytesPerFrame 每个采样帧（全部通道）的字节数。
+     * @return 修正后的样本数。
+     */
+    int applySampleSlip(uint8_t* data, int samples, int delta, int bytesPerFrame) {
+        if (samples <= 0 || delta == 0) {
+            return samples;
+        }
+        if (delta < 0) {
+            return samples - std::min(-delta, samples / 2);
+        }
+        const uint8_t* last = data + static_cast<size_t>(samples - 1) * bytesPerFrame;
+        for (int i = 0; i < delta; ++i) {
+            std::memcpy(data + static_cast<size_t>(samples + i) * bytesPerFrame, last, bytesPerFrame);
+        }
+        return samples + delta;
+    }
 }
 
 // Helper to make av_channel_layout_default usable across FFmpeg versions
@@ -114,11 +200,12 @@ LiveStreamPlayer::LiveStreamPlayer(QObject* parent)
     connect(m_statsTimer, &QTimer::timeout, this, &LiveStreamPlayer::updateStats);
     m_statsTimer->start();
 
-    m_audioWriteTimer = new QTimer(this);
-    m_audioWriteTimer->setInterval(20);  // 每 20ms 尝试写入音频
-    m_audioWriteTimer->setTimerType(Qt::TimerType::PreciseTimer);
-    connect(m_audioWriteTimer, &QTimer::timeout, this, &LiveStreamPlayer::processAudioQueue);
-    m_audioWriteTimer->start();
+    // 设备每次拉取数据前回调：用设备缓冲中尚未播放的时长修正读位置时间，得到正在播放的时间
+    m_audioRing = new AudioRingDevice(kAudioRingBytes, this);
+    m_audioRing->setMaxQueuedMs(kDefaultMaxAudioQueueMs);
+    m_audioRing->setPositionCallback([this](double pts, size_t queuedBytes) {
+        updateAudioClock(pts, queuedBytes);
+    });
 }
 
 /**
@@ -127,6 +214,10 @@ LiveStreamPlayer::LiveStreamPlayer(QObject* parent)
 LiveStreamPlayer::~LiveStreamPlayer() {
     stop();
     waitForShutdownCompletion();
+
+    // 先注销，共享输出线程不再读取后环形缓冲才随 this 销毁；最后一个播放器释放时共享输出随之停止
+    teardownAudioOutput();
+    m_audioMixer.reset();
 }
 
 /**
@@ -152,6 +243,48 @@ void LiveStreamPlayer::start(const QString& url) {
     m_authFailure.store(false, std::memory_order_release);  // 重置认证失败标志
     m_running.store(true);
     m_bitrateKbps.store(0.0, std::memory_order_release);
+    m_clock.reset();
+    m_avOffsetMs.store(0.0, std::memory_order_relaxed);
+    m_presentationJitterMs.store(0.0, std::memory_order_relaxed);
+    m_videoLatenessMs.store(0.0, std::memory_order_relaxed);
+    m_lateDroppedFrames.store(0, std::memory_order_relaxed);
+    m_clock.setRate(1.0);
+    m_latestVideoPts.store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+    m_latencyMs.store(0.0, std::memory_order_relaxed);
+    m_latencyJumps.store(0, std::memory_order_relaxed);
+    m_flushAudioDecoder.store(false, std::memory_order_relaxed);
+    m_audioBufferMs.store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+    m_audioDriftPpm.store(0.0, std::memory_order_relaxed);
+    m_audioPeakDb.store(-100.0, std::memory_order_relaxed);
+    m_audioRmsDb.store(-100.0, std::memory_order_relaxed);
+    m_decodedVideoFrames.store(0, std::memory_order_relaxed);
+    m_presentedVideoFrames.store(0, std::memory_order_relaxed);
+    m_inputVideoPackets.store(0, std::memory_order_relaxed);
+    m_startUs.store(MediaClock::nowUs(), std::memory_order_relaxed);
+    m_lastPresentedUs.store(0, std::memory_order_relaxed);
+    m_stallThresholdUs.store(stallThresholdUs(0.0), std::memory_order_relaxed);
+    m_stallCount.store(0, std::memory_order_relaxed);
+    m_stallTotalUs.store(0, std::memory_order_relaxed);
+    m_reconnectCount.store(0, std::memory_order_relaxed);
+    m_timeToFirstFrameMs.store(-1.0, std::memory_order_relaxed);
+    resetStageLatency();
+    m_rateBaseline = RateBaseline();
+    m_rateBaseline.timeUs = MediaClock::nowUs();
+    for (int i = 0; i < 2; ++i) {
+        m_decodeBaseline[i].reset();
+        m_convertBaseline[i].reset();
+    }
+    m_percentileWindowStartUs = m_rateBaseline.timeUs;
+    m_audioRing->resetCounters();
+    {
+        std::lock_guard<std::mutex> lock(m_mailboxMutex);
+        if (m_frameMailbox) {
+            m_frameMailbox->resetSupersededCount();
+        }
+    }
+
+    // 各线程启动前取得共享输出，空输出开关在此生效；旧实例的注册已在停止时注销
+    m_audioMixer = AudioMixer::shared(m_nullAudioSink.load(std::memory_order_acquire));
 
     emit statusChanged(QStringLiteral("Connecting"));
     updateStats();
@@ -216,27 +349,15 @@ void LiveStreamPlayer::stop() {
 
     clearQueues();
     closeStream();
-
-    {
-        std::lock_guard<std::mutex> lock(m_audioPendingMutex);
-        m_audioPendingQueue.clear();
-    }
+    m_audioRing->discardQueued();
 
     m_bitrateKbps.store(0.0, std::memory_order_release);
 
-    updateStats();
+    // 可能运行在异步停止线程上，交由 UI 线程汇总
+    requestStatsUpdate();
 
-    // 在 UI 线程清理音频输出，但避免从异步线程使用 BlockingQueuedConnection 造成死锁
-    if (thread() == QThread::currentThread()) {
-        teardownAudioOutput();
-    }
-    else {
-        // 使用普通队列连接，避免异步线程等待 UI 线程处理
-        QMetaObject::invokeMethod(this, &LiveStreamPlayer::teardownAudioOutput,
-            Qt::QueuedConnection);
-        // 等待一小段时间确保消息处理
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
-    }
+    // 只从共享输出注销，不等待输出线程，可以在 UI 线程或异步停止线程调用
+    teardownAudioOutput();
 
     emit statusChanged(QStringLiteral("Stopped"));
 }
@@ -273,13 +394,59 @@ void LiveStreamPlayer::requestStop() {
  * @param url 当前播放地址。
  */
 void LiveStreamPlayer::demuxLoop(QString url) {
+    FrameTrace::setThreadName("demux");
     int retryCount = 0;
+    bool connectedOnce = false;     // 本次 start() 内是否已连接成功过，之后的成功连接计为重连
     m_authFailure.store(false, std::memory_order_release);  // 重置认证失败标志
+    m_replayFinished.store(false, std::memory_order_release);
+    if (PacketCaptureReader::isCaptureFile(url)) {
+        auto reader = std::make_unique<PacketCaptureReader>();
+        QString error;
+        if (reader->open(url, &error)) {
+            m_replayReader = std::move(reader);
+            m_replaying.store(true, std::memory_order_release);
+        }
+        else {
+            emit errorOccurred(error);
+            emit statusChanged(QStringLiteral("Stopped"));
+            m_running.store(false);
+            m_stopRequested.store(true);
+        }
+    }
+    QString capturePath;
+    std::shared_ptr<const ImpairmentProfile> impairmentProfile;
+    {
+        std::lock_guard<std::mutex> lock(m_inputConfigMutex);
+        capturePath = m_capturePath;
+        impairmentProfile = m_impairmentProfile;
+    }
+    // 损伤会话跨重连共享，脚本时间从本次 start() 起算
+    if (impairmentProfile && !m_replayReader) {
+        m_impairment = std::make_shared<NetworkImpairment>(std::move(impairmentProfile));
+    }
+    if (!capturePath.isEmpty() && m_running.load()) {
+        auto writer = std::make_unique<PacketCaptureWriter>();
+        QString error;
+        if (writer->open(capturePath, &error)) {
+            m_captureWriter = std::move(writer);
+        }
+        else {
+            emit errorOccurred(error);  // 抓取失败不影响播放
+        }
+    }
+
     while (m_running.load()) {
         if (!openStream(url)) {
             if (!m_running.load() || m_stopRequested.load()) {
                 break;
             }
+            // 回放已读完所有段（或文件损坏），重试没有意义
+            if (m_replayFinished.load(std::memory_order_acquire)) {
+                emit statusChanged(QStringLiteral("回放结束"));
+                m_running.store(false);
+                m_stopRequested.store(true);
+                break;
+            }
             // 认证失败不应重试，直接停止
             if (m_authFailure.load(std::memory_order_acquire)) {
                 emit statusChanged(QStringLiteral("认证失败，已停止"));
@@ -301,6 +468,7 @@ void LiveStreamPlayer::demuxLoop(QString url) {
 
             emit statusChanged(QStringLiteral("Retrying connection (%1/%2)").arg(retryCount).arg(std::max(0, maxRetries)));
             const int delay = m_reconnectDelayMs.load(std::memory_order_acquire);
+            LSP_PROBE4(reconnect, retryCount, maxRetries, delay, 0);
             if (delay > 0)
                 std::this_thread::sleep_for(std::chrono::milliseconds(delay));
             continue;
@@ -309,24 +477,128 @@ void LiveStreamPlayer::demuxLoop(QString url) {
         emit statusChanged(QStringLiteral("Playing"));
         // 成功打开后清零失败计数
         retryCount = 0;
+        if (connectedOnce) {
+            m_reconnectCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        connectedOnce = true;
+        if (m_captureWriter) {
+            m_captureWriter->beginSegment(m_formatCtx);
+        }
 
         auto windowStart = std::chrono::steady_clock::now();
         size_t bytesAccumulated = 0;
+        // 非关键帧放行标志：开启仅关键帧模式时立即关闭，关闭该模式后需等到下一个关键帧才重新放行
+        bool passNonKeyframes = !keyframeOnlyActive();
+        // 实时读取：首个带时间戳的包对齐到当前时刻，之后的包等到各自的时刻再入队
+        const bool realtimeInput = m_realtimeInput.load(std::memory_order_relaxed);
+        double paceBaseSec = std::numeric_limits<double>::quiet_NaN();
+        int64_t paceBaseUs = 0;
+        // 回放：按抓取时的到达时刻排期，速度变化时从当前包重新对齐
+        double replaySpeed = std::numeric_limits<double>::quiet_NaN();
+        int64_t replayBaseUs = 0;
+        int64_t replayBaseArrivalUs = 0;
 
         while (m_running.load()) {
             AVPacket packet{};
-            int ret = av_read_frame(m_formatCtx, &packet);
+            int64_t arrivalUs = 0;
+            const int64_t readStartUs = FrameTrace::enabled() ? MediaClock::nowUs() : 0;
+            int ret = m_replayReader ? m_replayReader->read(packet, &arrivalUs) : av_read_frame(m_formatCtx, &packet);
+            if (ret >= 0) {
+                // 追踪编号随包的引用穿过队列，读包耗时含等待网络数据的时间
+                const uint64_t traceId = FrameTrace::newId();
+                if (traceId != 0) {
+                    FrameTrace::tagPacket(packet, traceId);
+                    FrameTrace::span(FrameTrace::Point::PacketRead, traceId, readStartUs, packet.stream_index);
+                }
+                LSP_PROBE5(packet_read, packet.stream_index, packet.pts, packet.dts, packet.size, packet.flags);
+            }
+            if (ret >= 0 && m_replayReader) {
+                const double speed = m_replaySpeed.load(std::memory_order_relaxed);
+                int64_t now = MediaClock::nowUs();
+                if (speed != replaySpeed) {
+                    replaySpeed = speed;
+                    replayBaseUs = now;
+                    replayBaseArrivalUs = arrivalUs;
+                }
+                if (speed > 0.0) {
+                    const int64_t dueUs = replayBaseUs + static_cast<int64_t>(static_cast<double>(arrivalUs - replayBaseArrivalUs) / speed);
+                    while (now < dueUs && m_running.load()) {
+                        std::this_thread::sleep_for(std::chrono::microseconds(std::min(dueUs - now, kRealtimePollUs)));
+                        now = MediaClock::nowUs();
+                    }
+                }
+                if (speed != 1.0) {
+                    // 非原速：解码端不按时钟消费，两个队列都等有空位再入队，
+                    // 避免视频队列丢弃最旧包的溢出策略使回放结果不可重复
+                    const bool isVideo = packet.stream_index == m_videoStreamIndex;
+                    if (isVideo || packet.stream_index == m_audioStreamIndex) {
+                        PacketQueue& queue = isVideo ? m_videoQueue : m_audioQueue;
+                        const size_t capacity = static_cast<size_t>(isVideo ? kQueueMaxPacketsVideo : kQueueMaxPacketsAudio);
+                        while (queue.size() >= capacity && m_running.load()) {
+                            std::this_thread::sleep_for(std::chrono::microseconds(kReplayBackpressureUs));
+                        }
+                    }
+                }
+            }
+            else if (ret >= 0 && realtimeInput &&
+                (packet.stream_index == m_videoStreamIndex || packet.stream_index == m_audioStreamIndex)) {
+                const int64_t timestamp = packet.dts != AV_NOPTS_VALUE ? packet.dts : packet.pts;
+                if (timestamp != AV_NOPTS_VALUE) {
+                    const double seconds = static_cast<double>(timestamp) *
+                        av_q2d(m_formatCtx->streams[packet.stream_index]->time_base);
+                    int64_t now = MediaClock::nowUs();
+                    const double aheadSec = seconds - paceBaseSec - static_cast<double>(now - paceBaseUs) * 1e-6;
+                    if (!std::isfinite(aheadSec) || seconds < paceBaseSec - kRealtimeResyncSec || aheadSec > kRealtimeResyncSec) {
+                        paceBaseSec = seconds;
+                        paceBaseUs = now;
+                    }
+                    else {
+                        const int64_t dueUs = paceBaseUs + static_cast<int64_t>((seconds - paceBaseSec) * 1e6);
+                        while (now < dueUs && m_running.load()) {
+                            std::this_thread::sleep_for(std::chrono::microseconds(std::min(dueUs - now, kRealtimePollUs)));
+                            now = MediaClock::nowUs();
+                        }
+                    }
+                }
+            }
+            if (ret >= 0 && m_captureWriter) {
+                m_captureWriter->write(packet);
+            }
             if (ret >= 0) {
                 bytesAccumulated += static_cast<size_t>(packet.size);
                 bool pushed = false;
+                bool dropped = false;
                 if (packet.stream_index == m_videoStreamIndex) {
-                    pushed = m_videoQueue.push(&packet, m_running);
+                    const bool keyframeOnly = keyframeOnlyActive();
+                    if (packet.flags & AV_PKT_FLAG_KEY) {
+                        passNonKeyframes = !keyframeOnly;
+                    }
+                    else if (keyframeOnly || !passNonKeyframes) {
+                        // 在入队前丢弃非关键帧，节省队列与解码开销；仍走到下面的 1 秒窗口检查
+                        passNonKeyframes = false;
+                        dropped = true;
+                    }
+                    if (!dropped) {
+                        pushed = m_videoQueue.push(&packet, m_running);
+                        if (pushed) {
+                            m_inputVideoPackets.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        const int64_t timestamp = packet.pts != AV_NOPTS_VALUE ? packet.pts : packet.dts;
+                        if (pushed && timestamp != AV_NOPTS_VALUE) {
+                            // 记录已接收的最新视频时间，与主时钟之差即为端到端缓冲的媒体时长
+                            const double seconds = static_cast<double>(timestamp) * av_q2d(m_videoTimeBase);
+                            const double latest = m_latestVideoPts.load(std::memory_order_relaxed);
+                            if (!(seconds <= latest)) {
+                                m_latestVideoPts.store(seconds, std::memory_order_relaxed);
+                            }
+                        }
+                    }
                 }
                 else if (packet.stream_index == m_audioStreamIndex) {
                     pushed = m_audioQueue.push(&packet, m_running);
                 }
 
-                if (!pushed) {
+                if (!pushed && !dropped) {
                     av_packet_unref(&packet);
                     if (!m_running.load()) {
                         break;
@@ -341,6 +613,10 @@ void LiveStreamPlayer::demuxLoop(QString url) {
                 if (!m_running.load()) {
                     break;
                 }
+                if (m_replayReader && m_replayReader->atEnd()) {
+                    m_replayFinished.store(true, std::memory_order_release);
+                    break;
+                }
                 emit statusChanged(QStringLiteral("Connection lost"));
                 break;
             }
@@ -352,7 +628,27 @@ void LiveStreamPlayer::demuxLoop(QString url) {
                 m_bitrateKbps.store(kbps, std::memory_order_relaxed);
                 bytesAccumulated = 0;
                 windowStart = now;
-                updateStats();
+                requestStatsUpdate();
+                if (m_captureWriter) {
+                    const QString captureError = m_captureWriter->errorString();
+                    if (!captureError.isEmpty()) {
+                        // 写盘失败后停止抓取，播放不受影响
+                        emit errorOccurred(captureError);
+                        m_captureWriter.reset();
+                    }
+                }
+            }
+        }
+
+        if (m_replayFinished.load(std::memory_order_acquire)) {
+            // 等解码线程取完已入队的包，使回放的帧数与抓取一致
+            while (m_running.load() && (m_videoQueue.size() > 0 || m_audioQueue.size() > 0)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(kRealtimePollUs));
+            }
+            if (m_running.load()) {
+                emit statusChanged(QStringLiteral("回放结束"));
+                m_running.store(false);
+                m_stopRequested.store(true);
             }
         }
 
@@ -360,8 +656,8 @@ void LiveStreamPlayer::demuxLoop(QString url) {
             break;
         }
 
-        // 若仍处于运行状态且不是用户主动停止，则进行重试计数
-        if (m_running.load() && !m_stopRequested.load()) {
+        // 若仍处于运行状态且不是用户主动停止，则进行重试计数；回放的段边界不是失败，不计数
+        if (m_running.load() && !m_stopRequested.load() && !m_replayReader) {
             retryCount++;
             const int maxRetries = m_maxReconnectAttempts.load(std::memory_order_acquire);
             if (maxRetries >= 0 && retryCount >= maxRetries) {
@@ -385,14 +681,32 @@ void LiveStreamPlayer::demuxLoop(QString url) {
         m_videoQueue.open();
         m_audioQueue.open();
 
-        if (m_running.load()) {
+        if (m_running.load() && !m_replayReader) {
             const int maxRetries = m_maxReconnectAttempts.load(std::memory_order_acquire);
             emit statusChanged(QStringLiteral("Retrying connection (%1/%2)").arg(std::min(retryCount, std::max(0, maxRetries))).arg(std::max(0, maxRetries)));
             const int delay = m_reconnectDelayMs.load(std::memory_order_acquire);
+            LSP_PROBE4(reconnect, retryCount, maxRetries, delay, 1);
             if (delay > 0)
                 std::this_thread::sleep_for(std::chrono::milliseconds(delay));
         }
     }
+
+    // 写完抓取文件；回放包持有映射的引用，读取器可以先于队列中的包释放
+    if (m_captureWriter) {
+        m_captureWriter->close();
+        if (m_captureWriter->droppedPackets() > 0) {
+            emit errorOccurred(QStringLiteral("Capture dropped %1 packets because the disk could not keep up.")
+                .arg(m_captureWriter->droppedPackets()));
+        }
+        const QString captureError = m_captureWriter->errorString();
+        if (!captureError.isEmpty()) {
+            emit errorOccurred(captureError);
+        }
+    }
+    m_captureWriter.reset();
+    m_replayReader.reset();
+    m_replaying.store(false, std::memory_order_release);
+    m_impairment.reset();
 }
 
 /**
@@ -415,6 +729,177 @@ void LiveStreamPlayer::setReconnectDelayMs(int delayMs) {
     m_reconnectDelayMs.store(delayMs, std::memory_order_release);
 }
 
+/**
+ * @brief 切换仅关键帧模式，实际生效点由解复用与解码线程在关键帧边界处理。
+ * @param enabled 是否只解码关键帧。
+ */
+void LiveStreamPlayer::setKeyframeOnly(bool enabled) {
+    m_keyframeOnly.store(enabled, std::memory_order_release);
+}
+
+/**
+ * @brief 返回当前是否处于仅关键帧模式。
+ * @return true 表示只解码关键帧。
+ */
+bool LiveStreamPlayer::isKeyframeOnly() const {
+    return m_keyframeOnly.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief 记录显示区域尺寸，下一帧转换时生效。
+ * @param devicePixelSize 设备像素尺寸。
+ */
+void LiveStreamPlayer::setOutputSize(const QSize& devicePixelSize) {
+    const quint32 width = static_cast<quint32>(qBound(0, devicePixelSize.width(), 0xFFFF));
+    const quint32 height = static_cast<quint32>(qBound(0, devicePixelSize.height(), 0xFFFF));
+    m_outputSize.store((width << 16) | height, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 设置端到端延迟上限，由视频线程在每个包处检查。
+ * @param latencyMs 延迟上限（毫秒），0 表示关闭。
+ */
+void LiveStreamPlayer::setMaxLatencyMs(int latencyMs) {
+    m_maxLatencyMs.store(std::max(0, latencyMs), std::memory_order_release);
+}
+
+/**
+ * @brief 设置排队音频上限，由音频设备在下一次拉取时执行裁剪。
+ * @param queueMs 上限（毫秒）。
+ */
+void LiveStreamPlayer::setMaxAudioQueueMs(int queueMs) {
+    m_audioRing->setMaxQueuedMs(queueMs);
+}
+
+/**
+ * @brief 保存增益，音频线程对下一帧生效。
+ * @param volume 线性增益。
+ */
+void LiveStreamPlayer::setVolume(double volume) {
+    m_audioVolume.store(static_cast<float>(std::min(kMaxVolume, std::max(0.0, volume))), std::memory_order_relaxed);
+}
+
+/**
+ * @brief 在 UI 线程切换静音状态并同步注册/注销共享输出。静音时清空排队音频并重置时钟，
+ *        视频随即以系统时钟继续播放，无需等待音频主时钟超时；取消静音时再清空一次，
+ *        丢弃切换瞬间音频解码线程仍写入的数据，避免恢复后先播放过时的音频。
+ * @param muted 是否静音。
+ */
+void LiveStreamPlayer::setMuted(bool muted) {
+    if (thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this, muted]() { setMuted(muted); }, Qt::QueuedConnection);
+        return;
+    }
+    if (m_audioMuted.exchange(muted, std::memory_order_acq_rel) == muted) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_audioFormatMutex);
+    if (muted) {
+        updateAudioSource();
+        m_audioRing->discardQueued();
+        m_clock.reset();
+        m_audioBufferMs.store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+    }
+    else {
+        m_audioRing->discardQueued();
+        updateAudioSource();
+    }
+}
+
+/**
+ * @brief 保存开关，下一次 start 时据此选择共享输出实例。
+ * @param enabled 是否启用。
+ */
+void LiveStreamPlayer::setNullAudioSink(bool enabled) {
+    m_nullAudioSink.store(enabled, std::memory_order_release);
+}
+
+/**
+ * @brief 保存开关，openStream 协商输出时读取。
+ * @param enabled 是否复用。
+ */
+void LiveStreamPlayer::setAudioOutputReuse(bool enabled) {
+    m_audioOutputReuse.store(enabled, std::memory_order_release);
+}
+
+/**
+ * @brief 保存开关，视频线程对下一帧生效。
+ * @param enabled 是否转换。
+ */
+void LiveStreamPlayer::setVideoConversionEnabled(bool enabled) {
+    m_convertVideo.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 保存开关，解复用线程在下一次连接时读取。
+ * @param enabled 是否启用。
+ */
+void LiveStreamPlayer::setRealtimeInput(bool enabled) {
+    m_realtimeInput.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 保存路径，解复用线程启动时读取。
+ * @param path 文件路径，空字符串表示关闭。
+ */
+void LiveStreamPlayer::setCaptureFile(const QString& path) {
+    std::lock_guard<std::mutex> lock(m_inputConfigMutex);
+    m_capturePath = path;
+}
+
+/**
+ * @brief 保存速度，解复用线程对下一个包生效。
+ * @param speed 速度倍数。
+ */
+void LiveStreamPlayer::setReplaySpeed(double speed) {
+    m_replaySpeed.store(speed >= 0.0 ? speed : 1.0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 保存脚本，解复用线程启动时读取。
+ * @param profile 损伤脚本，空指针表示关闭。
+ */
+void LiveStreamPlayer::setNetworkImpairment(std::shared_ptr<const ImpairmentProfile> profile) {
+    std::lock_guard<std::mutex> lock(m_inputConfigMutex);
+    m_impairmentProfile = std::move(profile);
+}
+
+/**
+ * @brief 返回对应阶段的直方图。
+ * @param stage 阶段。
+ * @return 直方图。
+ */
+const LatencyHistogram& LiveStreamPlayer::stageLatency(PipelineStage stage) const {
+    return m_stageLatency[static_cast<int>(stage)];
+}
+
+/**
+ * @brief 清空全部阶段。
+ */
+void LiveStreamPlayer::resetStageLatency() {
+    for (auto& histogram : m_stageLatency) {
+        histogram.reset();
+    }
+}
+
+/**
+ * @brief 替换帧信箱，视频线程在下一个包开始时使用新信箱。
+ * @param mailbox 信箱。
+ */
+void LiveStreamPlayer::setFrameMailbox(std::shared_ptr<FrameMailbox> mailbox) {
+    std::lock_guard<std::mutex> lock(m_mailboxMutex);
+    m_frameMailbox = std::move(mailbox);
+}
+
+/**
+ * @brief 更新缩放质量，下一帧转换时生效。
+ * @param quality 缩放算法。
+ */
+void LiveStreamPlayer::setScalingQuality(VideoConverter::ScalingQuality quality) {
+    m_scalingQuality.store(static_cast<int>(quality), std::memory_order_relaxed);
+}
+
 
 /**
  * @brief 从视频队列中取包解码并输出帧。
@@ -426,33 +911,79 @@ void LiveStreamPlayer::videoDecodeLoop() {
         return;
     }
 
+    m_catchingUp = false;
+    FrameTrace::setThreadName("video decode");
+    FrameTraceIds traceIds;
+    PtsTagMap<int64_t> enqueueTimes;    // 包入队时间，一个包解出的帧可能属于之前送入的包
+
+    // 已解码、待呈现的帧
+    struct DecodedFrame {
+        QImage image;
+        double pts;
+        uint64_t traceId;
+        int64_t enqueuedUs;     // 对应包的入队时间
+    };
+
     while (m_running.load()) {
         AVPacket packet{};
-        if (!m_videoQueue.pop(packet, m_running)) {
+        int64_t enqueuedUs = 0;
+        if (!m_videoQueue.pop(packet, m_running, &enqueuedUs)) {
             if (!m_running.load()) {
                 break;
             }
             std::this_thread::sleep_for(std::chrono::milliseconds(5));
             continue;
         }
+        m_stageLatency[static_cast<int>(PipelineStage::VideoQueueWait)].record(MediaClock::nowUs() - enqueuedUs);
+        const int streamIndex = packet.stream_index;
+
+        if (regulateLatency()) {
+            // 已跳到最新关键帧，当前包属于被跳过的旧数据
+            av_packet_unref(&packet);
+            continue;
+        }
 
-        QImage frameImage;
+        // 一个包可能解出多帧（例如解码器积压），全部转换后在锁外按 pts 依次呈现
+        std::vector<DecodedFrame> decodedFrames;
+        double frameDurationMs = 0.0;
 
         {
             std::lock_guard<std::mutex> lock(m_contextMutex);
-            if (!m_videoCodecCtx || !m_swsCtx) {
+            if (!m_videoCodecCtx) {
                 av_packet_unref(&packet);
                 continue;
             }
+            frameDurationMs = m_videoFrameDurationMs.load(std::memory_order_relaxed);
+
+            // 进入仅关键帧模式立即跳过非关键帧；退出时等到关键帧再恢复，避免参考帧缺失导致花屏
+            if (keyframeOnlyActive()) {
+                m_videoCodecCtx->skip_frame = AVDISCARD_NONKEY;
+            }
+            else if (packet.flags & AV_PKT_FLAG_KEY) {
+                m_videoCodecCtx->skip_frame = AVDISCARD_DEFAULT;
+            }
 
+            // 解码耗时只计送包与取帧，不含其间的转换
+            const int64_t packetPts = packet.pts;
+            LSP_PROBE3(video_decode_start, streamIndex, packetPts, packet.size);
+            int64_t stageStartUs = MediaClock::nowUs();
             int ret = avcodec_send_packet(m_videoCodecCtx, &packet);
+            const uint64_t packetTraceId = FrameTrace::packetId(packet);
+            if (packetTraceId != 0) {
+                FrameTrace::span(FrameTrace::Point::SendPacket, packetTraceId, stageStartUs, streamIndex);
+                traceIds.remember(packetPts, packetTraceId);
+            }
+            enqueueTimes.remember(packetPts, enqueuedUs);
             av_packet_unref(&packet);
+            int64_t decodeUs = MediaClock::nowUs() - stageStartUs;
             if (ret < 0) {
                 continue;
             }
 
             while (ret >= 0 && m_running.load()) {
+                stageStartUs = MediaClock::nowUs();
                 ret = avcodec_receive_frame(m_videoCodecCtx, frame);
+                decodeUs += MediaClock::nowUs() - stageStartUs;
                 if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
                     break;
                 }
@@ -460,35 +991,256 @@ void LiveStreamPlayer::videoDecodeLoop() {
                     emit errorOccurred(QStringLiteral("Error while decoding video frame."));
                     break;
                 }
+                m_decodedVideoFrames.fetch_add(1, std::memory_order_relaxed);
+                const uint64_t frameTraceId = packetTraceId != 0 ? traceIds.take(frame->pts) : 0;
+                // 没有 pts 的帧（或已被挤出的旧条目）归到本次送入的包
+                int64_t frameEnqueuedUs = enqueueTimes.take(frame->pts);
+                if (frameEnqueuedUs == 0) {
+                    frameEnqueuedUs = enqueuedUs;
+                }
+                FrameTrace::span(FrameTrace::Point::ReceiveFrame, frameTraceId, stageStartUs, streamIndex);
+
+                const double pts = frame->best_effort_timestamp != AV_NOPTS_VALUE
+                    ? static_cast<double>(frame->best_effort_timestamp) * av_q2d(m_videoTimeBase)
+                    : std::numeric_limits<double>::quiet_NaN();
+
+                // 在转换与分配之前判断迟到：已有更新的数据排队时直接丢弃，突发追赶只付出解码开销
+                const double lateSec = m_clock.time(MediaClock::nowUs()) - pts;
+                if (std::isfinite(lateSec)) {
+                    m_videoLatenessMs.store(lateSec * 1000.0, std::memory_order_relaxed);
+                    if (lateSec > lateToleranceSec(frameDurationMs) && m_videoQueue.size() > 0 && !replayUnpaced()) {
+                        m_lateDroppedFrames.fetch_add(1, std::memory_order_relaxed);
+                        av_frame_unref(frame);
+                        continue;
+                    }
+                }
 
-                QImage image(m_videoCodecCtx->width, m_videoCodecCtx->height, QImage::Format_ARGB32);
-                if (image.isNull()) {
-                    continue;
+                const quint32 packedSize = m_outputSize.load(std::memory_order_relaxed);
+                const QSize boundingSize(static_cast<int>(packedSize >> 16), static_cast<int>(packedSize & 0xFFFF));
+                const auto quality = static_cast<VideoConverter::ScalingQuality>(m_scalingQuality.load(std::memory_order_relaxed));
+
+                // 转换时直接缩放到显示尺寸，输出缓冲来自缓冲池；关闭转换时只保留时间戳参与呈现计时
+                const bool convertVideo = m_convertVideo.load(std::memory_order_relaxed);
+                QImage frameImage;
+                if (convertVideo) {
+                    LSP_PROBE4(convert_start, streamIndex, frame->pts, frame->width, frame->height);
+                    stageStartUs = MediaClock::nowUs();
+                    frameImage = m_videoConverter.convert(frame, boundingSize, quality);
+                    const int64_t convertUs = MediaClock::nowUs() - stageStartUs;
+                    m_stageLatency[static_cast<int>(PipelineStage::VideoConvert)].record(convertUs);
+                    FrameTrace::span(FrameTrace::Point::Convert, frameTraceId, stageStartUs, streamIndex);
+                    LSP_PROBE4(convert_end, streamIndex, frame->pts, convertUs, frameImage.sizeInBytes());
+                }
+                av_frame_unref(frame);
+                if (!convertVideo || !frameImage.isNull()) {
+                    decodedFrames.push_back(DecodedFrame{ std::move(frameImage), pts, frameTraceId, frameEnqueuedUs });
                 }
+            }
+            m_stageLatency[static_cast<int>(PipelineStage::VideoDecode)].record(decodeUs);
+            LSP_PROBE4(video_decode_end, streamIndex, packetPts, decodeUs, decodedFrames.size());
+        }
 
-                uint8_t* destData[4] = { image.bits(), nullptr, nullptr, nullptr };
-                int destLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+        std::shared_ptr<FrameMailbox> mailbox;
+        {
+            std::lock_guard<std::mutex> lock(m_mailboxMutex);
+            mailbox = m_frameMailbox;
+        }
 
-                sws_scale(m_swsCtx,
-                    frame->data,
-                    frame->linesize,
-                    0,
-                    m_videoCodecCtx->height,
-                    destData,
-                    destLinesize);
+        for (size_t i = 0; i < decodedFrames.size(); ++i) {
+            auto& decoded = decodedFrames[i];
+            if (!waitForPresentation(decoded.pts, frameDurationMs, i + 1 < decodedFrames.size())) {
+                continue;
+            }
+            m_presentedVideoFrames.fetch_add(1, std::memory_order_relaxed);
+            const int64_t presentedUs = MediaClock::nowUs();
+            m_stageLatency[static_cast<int>(PipelineStage::PacketToPresent)].record(presentedUs - decoded.enqueuedUs);
+            notePresented(presentedUs, frameDurationMs);
+            FrameTrace::instant(FrameTrace::Point::Publish, decoded.traceId, streamIndex);
+            if (mailbox && !decoded.image.isNull()) {
+                // 只覆盖信箱中的最新帧，UI 线程卡顿时不会在事件队列中堆积图像
+                mailbox->publish(std::move(decoded.image), decoded.traceId);
+            }
+        }
+    }
 
-                frameImage = image;  // 直接赋值，利用 QImage 隐式共享避免深拷贝
-                av_frame_unref(frame);
-                break;
+    av_frame_free(&frame);
+}
+
+/**
+ * @brief 首帧记录自 start() 起的耗时；之后的呈现间隔超过阈值时计一次卡顿并累计间隔时长。
+ *        仅关键帧模式下间隔本就很长，不计卡顿。
+ * @param presentedUs 呈现时刻。
+ * @param frameDurationMs 标称帧间隔。
+ */
+void LiveStreamPlayer::notePresented(int64_t presentedUs, double frameDurationMs) {
+    const int64_t thresholdUs = stallThresholdUs(frameDurationMs);
+    m_stallThresholdUs.store(thresholdUs, std::memory_order_relaxed);
+    const int64_t previousUs = m_lastPresentedUs.exchange(presentedUs, std::memory_order_relaxed);
+    if (previousUs == 0) {
+        const int64_t elapsedUs = presentedUs - m_startUs.load(std::memory_order_relaxed);
+        m_timeToFirstFrameMs.store(static_cast<double>(elapsedUs) / 1000.0, std::memory_order_relaxed);
+        return;
+    }
+    const int64_t gapUs = presentedUs - previousUs;
+    if (gapUs > thresholdUs && !keyframeOnlyActive()) {
+        m_stallCount.fetch_add(1, std::memory_order_relaxed);
+        m_stallTotalUs.fetch_add(gapUs, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 按主时钟等待帧的呈现时刻，分小段休眠以便及时响应停止与时钟调整。
+ * @param pts 帧时间（秒），NaN 表示无时间戳，立即呈现。
+ * @param frameDurationMs 标称帧间隔，用于确定迟到容忍度。
+ * @param newerFramePending 同一包是否还解出了更新的帧。
+ * @return true 表示应呈现，false 表示帧已迟到且已有更新的数据，应丢弃。
+ */
+bool LiveStreamPlayer::waitForPresentation(double pts, double frameDurationMs, bool newerFramePending) {
+    if (!std::isfinite(pts)) {
+        return m_running.load();
+    }
+    if (replayUnpaced()) {
+        // 非原速回放：解码完即呈现，时钟跟随视频，只用于延迟与偏差统计
+        m_clock.setVideoTime(pts, MediaClock::nowUs());
+        recordPresentation(0.0);
+        return m_running.load();
+    }
+
+    const double toleranceSec = lateToleranceSec(frameDurationMs);
+
+    while (m_running.load()) {
+        const int64_t now = MediaClock::nowUs();
+        const double clock = m_clock.time(now);
+        if (!std::isfinite(clock)) {
+            // 首帧且尚无音频：以该帧锚定系统时钟
+            m_clock.setVideoTime(pts, now);
+            recordPresentation(0.0);
+            return true;
+        }
+
+        const double delaySec = (pts - clock) / m_clock.rate();
+        if (delaySec > kMaxFrameDelaySec) {
+            // pts 跳变（重连、时间戳回绕）：立即呈现并重新锚定，音频主时钟下由音频自行追上
+            m_clock.setVideoTime(pts, now);
+            recordPresentation(0.0);
+            return true;
+        }
+
+        if (delaySec <= 0.0) {
+            const double lateSec = -delaySec;
+            if (lateSec > toleranceSec) {
+                if (newerFramePending || m_videoQueue.size() > 0) {
+                    // 等待期间变为迟到（例如同包后续帧），已有更新的数据在排队时丢弃
+                    m_lateDroppedFrames.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                // 没有更新的数据：呈现该帧，并在系统时钟模式下从这里重新开始计时，
+                // 使网络突发到达的后续帧按正常间隔平滑呈现
+                m_clock.setVideoTime(pts, now);
             }
+            recordPresentation(pts - clock);
+            return true;
         }
 
-        if (!frameImage.isNull()) {
-            emit frameReady(frameImage);
+        const auto sleepUs = std::min<int64_t>(static_cast<int64_t>(delaySec * 1e6), kPresentationPollUs);
+        std::this_thread::sleep_for(std::chrono::microseconds(sleepUs));
+    }
+    return false;
+}
+
+/**
+ * @brief 缓冲时长 = 已接收的最新视频时间 - 主时钟时间，覆盖队列、解码器与音频待写数据。
+ *        小幅超出上限时提速追赶，超出较多时跳到最新关键帧。
+ * @return true 表示刚刚执行了跳转，调用方应丢弃手中的旧包。
+ */
+bool LiveStreamPlayer::regulateLatency() {
+    const double bufferedSec = m_latestVideoPts.load(std::memory_order_relaxed) - m_clock.time(MediaClock::nowUs());
+    if (!std::isfinite(bufferedSec)) {
+        return false;
+    }
+    m_latencyMs.store(bufferedSec * 1000.0, std::memory_order_relaxed);
+
+    // 回放时不追赶：速率与跳转取决于实时时序，会使同一文件的回放结果不同
+    const int maxLatencyMs = m_maxLatencyMs.load(std::memory_order_acquire);
+    if (maxLatencyMs <= 0 || m_replaying.load(std::memory_order_acquire)) {
+        if (m_catchingUp) {
+            m_catchingUp = false;
+            m_clock.setRate(1.0);
         }
+        return false;
     }
 
-    av_frame_free(&frame);
+    const double targetSec = maxLatencyMs / 1000.0;
+    const double excessSec = bufferedSec - targetSec;
+    if (excessSec > std::max(kJumpExcessSec, targetSec) && jumpToLatestKeyframe()) {
+        return true;
+    }
+
+    if (!m_catchingUp && excessSec > 0.0) {
+        m_catchingUp = true;
+        m_clock.setRate(kCatchUpRate);
+    }
+    else if (m_catchingUp && bufferedSec < targetSec * kCatchUpStopRatio) {
+        m_catchingUp = false;
+        m_clock.setRate(1.0);
+    }
+    return false;
+}
+
+/**
+ * @brief 回放中且速度不为 1。
+ * @return true 表示不按时钟节拍。
+ */
+bool LiveStreamPlayer::replayUnpaced() const {
+    return m_replaying.load(std::memory_order_acquire) && m_replaySpeed.load(std::memory_order_relaxed) != 1.0;
+}
+
+/**
+ * @brief 设置开启且不在回放中。
+ * @return true 表示只解码关键帧。
+ */
+bool LiveStreamPlayer::keyframeOnlyActive() const {
+    return m_keyframeOnly.load(std::memory_order_relaxed) && !m_replaying.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief 丢弃最新关键帧之前的视频包及对应时间之前的音频包，清空解码器与待写音频并重建主时钟。
+ * @return 队列中没有可跳转的关键帧时返回 false，稍后重试。
+ */
+bool LiveStreamPlayer::jumpToLatestKeyframe() {
+    int64_t keyframeTimestamp = AV_NOPTS_VALUE;
+    if (m_videoQueue.dropToLastKeyframe(&keyframeTimestamp) == 0) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_contextMutex);
+        if (m_videoCodecCtx) {
+            avcodec_flush_buffers(m_videoCodecCtx);
+        }
+        if (m_audioCodecCtx && keyframeTimestamp != AV_NOPTS_VALUE && m_audioTimeBase.den != 0) {
+            m_audioQueue.dropBefore(av_rescale_q(keyframeTimestamp, m_videoTimeBase, m_audioTimeBase));
+        }
+    }
+    m_flushAudioDecoder.store(true, std::memory_order_release);
+    m_audioRing->discardQueued();
+
+    m_catchingUp = false;
+    m_clock.setRate(1.0);
+    m_clock.reset();
+    m_latencyJumps.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief 记录帧相对主时钟的偏差，并以 1/16 平滑系数更新呈现抖动。
+ * @param offsetSec 帧 pts 减去呈现时刻的主时钟时间（秒），负值表示视频落后。
+ */
+void LiveStreamPlayer::recordPresentation(double offsetSec) {
+    const double offsetMs = offsetSec * 1000.0;
+    const double previousMs = m_avOffsetMs.exchange(offsetMs, std::memory_order_relaxed);
+    const double jitterMs = m_presentationJitterMs.load(std::memory_order_relaxed);
+    m_presentationJitterMs.store(jitterMs + (std::abs(offsetMs - previousMs) - jitterMs) / 16.0, std::memory_order_relaxed);
 }
 
 /**
@@ -501,6 +1253,20 @@ void LiveStreamPlayer::audioDecodeLoop() {
         return;
     }
 
+    // 下一段输出样本的预计起始时间，帧缺少 pts 时按样本数外推
+    double nextAudioPts = std::numeric_limits<double>::quiet_NaN();
+    bool compensating = false;
+    bool resampling = false;            // 上一帧是否经过重采样器（其内部可能仍有延迟的样本）
+    // 漂移补偿：由缓冲水位估计两端时钟偏差，修正量通常远小于一个样本/帧，小数部分跨帧累积
+    DriftController driftController;
+    double correctionPpm = 0.0;
+    double sampleResidual = 0.0;
+    int64_t lastDriftUpdateUs = MediaClock::nowUs();
+    std::vector<char> convertBuffer;    // 环形缓冲回绕时的重采样暂存，按需增长后复用，稳态下不再分配
+    AudioLevels levels;                 // 当前电平统计窗口
+    int64_t levelWindowStartUs = MediaClock::nowUs();
+    FrameTrace::setThreadName("audio decode");
+
     while (m_running.load()) {
         AVPacket packet{};
         if (!m_audioQueue.pop(packet, m_running)) {
@@ -511,19 +1277,40 @@ void LiveStreamPlayer::audioDecodeLoop() {
             continue;
         }
 
-        std::vector<QByteArray> pendingSamples;
-
         {
+            // 写入环形缓冲不阻塞，放在锁内可保证重建音频输出（持锁重置缓冲）时没有并发写入
             std::lock_guard<std::mutex> lock(m_contextMutex);
             const int currentSampleRate = m_targetSampleRate.load(std::memory_order_acquire);
             const int currentChannels = m_targetChannels.load(std::memory_order_acquire);
+            const AVSampleFormat currentSampleFormat =
+                static_cast<AVSampleFormat>(m_targetSampleFormat.load(std::memory_order_acquire));
 
-            if (!m_audioCodecCtx || !m_swrCtx || currentSampleRate <= 0 || currentChannels <= 0) {
+            if (!m_audioCodecCtx || !m_swrCtx || currentSampleRate <= 0 || currentChannels <= 0 ||
+                currentSampleFormat == AV_SAMPLE_FMT_NONE) {
                 av_packet_unref(&packet);
                 continue;
             }
 
+            if (m_flushAudioDecoder.exchange(false, std::memory_order_acq_rel)) {
+                // 视频线程跳到了最新关键帧：丢弃解码器与重采样器中残留的旧样本
+                avcodec_flush_buffers(m_audioCodecCtx);
+                swr_init(m_swrCtx);
+                nextAudioPts = std::numeric_limits<double>::quiet_NaN();
+                compensating = false;
+                resampling = false;
+                driftController.reset();
+                correctionPpm = 0.0;
+                sampleResidual = 0.0;
+            }
+
+            // 音频解码器不重排，取出的帧沿用刚送入的包的追踪编号
+            const uint64_t traceId = FrameTrace::packetId(packet);
+            const int streamIndex = packet.stream_index;
+            const int64_t sendStartUs = traceId != 0 ? MediaClock::nowUs() : 0;
+            [[maybe_unused]] const int64_t decodeStartUs = LSP_PROBE_TIME_US(audio_decode_end);
+            LSP_PROBE3(audio_decode_start, streamIndex, packet.pts, packet.size);
             int ret = avcodec_send_packet(m_audioCodecCtx, &packet);
+            FrameTrace::span(FrameTrace::Point::SendPacket, traceId, sendStartUs, streamIndex);
             av_packet_unref(&packet);
             if (ret < 0) {
                 continue;
@@ -538,68 +1325,215 @@ void LiveStreamPlayer::audioDecodeLoop() {
                     emit errorOccurred(QStringLiteral("Error while decoding audio frame."));
                     break;
                 }
+                FrameTrace::instant(FrameTrace::Point::ReceiveFrame, traceId, streamIndex);
+                LSP_PROBE4(audio_decode_end, streamIndex, frame->pts, LSP_PROBE_TIME_US(audio_decode_end) - decodeStartUs, frame->nb_samples);
+
+                // 电平在解码帧上统计（增益前），静音时同样可用
+                const int64_t now = MediaClock::nowUs();
+                if (AudioProcessor::canMeasure(static_cast<AVSampleFormat>(frame->format))) {
+                    AudioProcessor::measure(frame->extended_data, static_cast<AVSampleFormat>(frame->format),
+                        frame->ch_layout.nb_channels, frame->nb_samples, levels);
+                }
+                if (now - levelWindowStartUs >= kLevelWindowUs) {
+                    m_audioPeakDb.store(levels.peakDb(), std::memory_order_relaxed);
+                    m_audioRmsDb.store(levels.rmsDb(), std::memory_order_relaxed);
+                    levels.reset();
+                    levelWindowStartUs = now;
+                }
+
+                // 静音或非原速回放时跳过重采样与输出
+                if (m_audioMuted.load(std::memory_order_relaxed) || replayUnpaced()) {
+                    nextAudioPts = std::numeric_limits<double>::quiet_NaN();
+                    av_frame_unref(frame);
+                    continue;
+                }
+
+                // 追赶期间水位被有意压低，暂停漂移估计，避免把追赶误判为时钟偏差
+                const double clockRate = m_clock.rate();
+                if (now - lastDriftUpdateUs >= kDriftUpdateIntervalUs) {
+                    const double bufferMs = m_audioBufferMs.load(std::memory_order_relaxed);
+                    if (clockRate == 1.0 && std::isfinite(bufferMs)) {
+                        correctionPpm = driftController.update(bufferMs, kTargetAudioBufferMs,
+                            static_cast<double>(now - lastDriftUpdateUs) * 1e-6);
+                        m_audioDriftPpm.store(driftController.driftPpm(), std::memory_order_relaxed);
+                    }
+                    lastDriftUpdateUs = now;
+                }
+
+                // 追赶速率与漂移修正合成一个播放速率，由重采样器的补偿功能增减输出样本完成拉伸（直通时见下）
+                const double playbackRate = clockRate * (1.0 + correctionPpm * 1e-6);
+                const int expectedSamples = static_cast<int>(av_rescale(frame->nb_samples, currentSampleRate,
+                    std::max(1, frame->sample_rate)));
+                const double exactDelta = expectedSamples / playbackRate - expectedSamples + sampleResidual;
+                const int sampleDelta = static_cast<int>(std::lround(exactDelta));
+                sampleResidual = exactDelta - sampleDelta;
+                // 采样率、通道数与样本格式都与设备一致且未在追赶时绕过重采样器，只做交错；
+                // 此时漂移修正量每帧至多一两个样本，以增删样本（sample slip）实现
+                const bool passthrough = clockRate == 1.0 &&
+                    frame->sample_rate == currentSampleRate &&
+                    frame->ch_layout.nb_channels == currentChannels &&
+                    AudioInterleaver::supports(static_cast<AVSampleFormat>(frame->format), currentSampleFormat);
+                m_audioPassthrough.store(passthrough, std::memory_order_relaxed);
+                if (passthrough) {
+                    if (resampling) {
+                        // 从重采样切到直通：先取出重采样器内部延迟的样本再写本帧，否则这段音频丢失、时间轴错开
+                        drainResampler(currentChannels, currentSampleFormat, currentSampleRate, playbackRate,
+                            convertBuffer, nextAudioPts);
+                        resampling = false;
+                        compensating = false;
+                    }
+                    else if (compensating) {
+                        swr_set_compensation(m_swrCtx, 0, 0);
+                        compensating = false;
+                    }
+                }
+                else if (sampleDelta != 0 || compensating) {
+                    swr_set_compensation(m_swrCtx, sampleDelta, sampleDelta != 0 ? expectedSamples : 0);
+                    compensating = sampleDelta != 0;
+                }
 
-                const int maxSamples = swr_get_out_samples(m_swrCtx, frame->nb_samples);
+                const int maxSamples = passthrough
+                    ? frame->nb_samples + std::max(0, sampleDelta)
+                    : swr_get_out_samples(m_swrCtx, frame->nb_samples);
                 const int bufferSize = av_samples_get_buffer_size(nullptr,
                     currentChannels,
                     maxSamples,
-                    AV_SAMPLE_FMT_S16,
+                    currentSampleFormat,
                     1);
                 if (bufferSize <= 0) {
                     av_frame_unref(frame);
                     continue;
                 }
 
-                QByteArray samples(bufferSize, 0);
-                uint8_t* destData[1] = { reinterpret_cast<uint8_t*>(samples.data()) };
+                // 输出起始时间 = 帧 pts 减去重采样器内部尚未输出的延迟（直通时无延迟）
+                double chunkPts = nextAudioPts;
+                if (frame->best_effort_timestamp != AV_NOPTS_VALUE) {
+                    chunkPts = static_cast<double>(frame->best_effort_timestamp) * av_q2d(m_audioTimeBase);
+                    if (!passthrough) {
+                        chunkPts -= static_cast<double>(swr_get_delay(m_swrCtx, currentSampleRate)) / currentSampleRate;
+                    }
+                }
 
-                int convertedSamples = swr_convert(m_swrCtx,
-                    destData,
-                    maxSamples,
-                    const_cast<const uint8_t**>(frame->extended_data),
-                    frame->nb_samples);
+                // 重采样器直接输出到环形缓冲的可写区域；区域在缓冲区尾部被截断时才借助暂存区拷贝
+                char* ringSpan = nullptr;
+                const bool direct = m_audioRing->reserve(&ringSpan) >= static_cast<size_t>(bufferSize);
+                if (!direct && convertBuffer.size() < static_cast<size_t>(bufferSize)) {
+                    convertBuffer.resize(bufferSize);
+                }
+                uint8_t* destData[1] = { reinterpret_cast<uint8_t*>(direct ? ringSpan : convertBuffer.data()) };
+
+                int convertedSamples = 0;
+                if (passthrough) {
+                    AudioInterleaver::interleave(frame->extended_data, static_cast<AVSampleFormat>(frame->format),
+                        currentChannels, frame->nb_samples, destData[0]);
+                    convertedSamples = applySampleSlip(destData[0], frame->nb_samples, sampleDelta,
+                        currentChannels * av_get_bytes_per_sample(currentSampleFormat));
+                }
+                else {
+                    convertedSamples = swr_convert(m_swrCtx,
+                        destData,
+                        maxSamples,
+                        const_cast<const uint8_t**>(frame->extended_data),
+                        frame->nb_samples);
+                    resampling = true;
+                }
                 if (convertedSamples <= 0) {
                     av_frame_unref(frame);
                     continue;
                 }
 
+                const float volume = m_audioVolume.load(std::memory_order_relaxed);
+                if (volume != 1.0f) {
+                    AudioProcessor::applyGain(destData[0], currentSampleFormat,
+                        static_cast<size_t>(convertedSamples) * currentChannels, volume);
+                }
+
                 const int convertedSize = av_samples_get_buffer_size(nullptr,
                     currentChannels,
                     convertedSamples,
-                    AV_SAMPLE_FMT_S16,
+                    currentSampleFormat,
                     1);
-                samples.resize(convertedSize);
-                pendingSamples.push_back(samples);
+                if (direct) {
+                    m_audioRing->commit(static_cast<size_t>(convertedSize), chunkPts, playbackRate);
+                }
+                else {
+                    m_audioRing->push(convertBuffer.data(), static_cast<size_t>(convertedSize), chunkPts, playbackRate);
+                }
+                nextAudioPts = chunkPts + static_cast<double>(convertedSamples) * playbackRate / currentSampleRate;
                 av_frame_unref(frame);
             }
         }
-
-        for (const QByteArray& samples : pendingSamples) {
-            emitAudioSamples(samples);
-        }
     }
 
     av_frame_free(&frame);
 }
 
 /**
- * @brief 打开拉流输入并初始化解码/重采样上下文。
- * @param url 需要连接的地址。
- * @return 成功返回 true。
+ * @brief 以空输入冲刷重采样器，把其内部延迟的样本按当前音量写入环形缓冲，随后重新初始化（同时清除补偿）。
+ *        只在从重采样切换到直通时调用，次数很少，经暂存区拷贝写入。调用方持有 m_contextMutex。
+ * @param channels 输出通道数。
+ * @param sampleFormat 输出样本格式。
+ * @param sampleRate 输出采样率。
+ * @param playbackRate 当前播放速率。
+ * @param buffer 暂存区，不足时增长。
+ * @param nextPts 输入为冲刷出的首样本时间，输出为其后一样本的时间（未知时保持 NaN）。
  */
-bool LiveStreamPlayer::openStream(const QString& url) {
-    closeStream();
+void LiveStreamPlayer::drainResampler(int channels, AVSampleFormat sampleFormat, int sampleRate, double playbackRate,
+    std::vector<char>& buffer, double& nextPts) {
+    const int pending = swr_get_out_samples(m_swrCtx, 0);
+    const int bufferSize = pending > 0
+        ? av_samples_get_buffer_size(nullptr, channels, pending, sampleFormat, 1) : 0;
+    if (bufferSize > 0) {
+        if (buffer.size() < static_cast<size_t>(bufferSize)) {
+            buffer.resize(bufferSize);
+        }
+        uint8_t* out[1] = { reinterpret_cast<uint8_t*>(buffer.data()) };
+        const int drained = swr_convert(m_swrCtx, out, pending, nullptr, 0);
+        if (drained > 0) {
+            const float volume = m_audioVolume.load(std::memory_order_relaxed);
+            if (volume != 1.0f) {
+                AudioProcessor::applyGain(out[0], sampleFormat, static_cast<size_t>(drained) * channels, volume);
+            }
+            const int drainedSize = av_samples_get_buffer_size(nullptr, channels, drained, sampleFormat, 1);
+            m_audioRing->push(buffer.data(), static_cast<size_t>(drainedSize), nextPts, playbackRate);
+            nextPts += static_cast<double>(drained) * playbackRate / sampleRate;
+        }
+    }
+    // 冲刷后的重采样器需重新初始化才能继续接收输入
+    swr_init(m_swrCtx);
+}
 
+/**
+ * @brief 打开网络或本地输入并探测流信息。
+ * @param url 输入地址。
+ * @return 格式上下文，失败时为空（已发出错误信号）。
+ */
+AVFormatContext* LiveStreamPlayer::openInput(const QString& url) {
     AVFormatContext* formatContext = avformat_alloc_context();
     if (!formatContext) {
         emit errorOccurred(QStringLiteral("Unable to allocate format context."));
-        return false;
+        return nullptr;
     }
 
     formatContext->flags |= AVFMT_FLAG_NOBUFFER;
     formatContext->interrupt_callback.callback = &LiveStreamPlayer::interruptCallback;
     formatContext->interrupt_callback.opaque = this;
 
+    const QString scheme = urlSchemeLower(url);
+    std::unique_ptr<ImpairedInput> impairedInput;
+    if (m_impairment && scheme != QLatin1String("rtsp")) {
+        // 经模拟链路读取：自定义 I/O 由 ImpairedInput 持有，关闭输入时不会被 FFmpeg 释放
+        impairedInput = std::make_unique<ImpairedInput>(m_impairment);
+        const int ret = impairedInput->open(url, formatContext->interrupt_callback);
+        if (ret < 0) {
+            emit errorOccurred(QStringLiteral("Failed to open stream: %1").arg(ffmpegErrorString(ret)));
+            avformat_free_context(formatContext);
+            return nullptr;
+        }
+        formatContext->pb = impairedInput->context();
+        formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
     AVDictionary* options = nullptr;
     // Common low-latency flags
     av_dict_set(&options, "buffer_size", "65536", 0);
@@ -608,7 +1542,6 @@ bool LiveStreamPlayer::openStream(const QString& url) {
     // Prefer protocol-agnostic I/O timeout (microseconds)
     av_dict_set(&options, "rw_timeout", QString::number(kDemuxTimeoutUs).toUtf8().constData(), 0);
 
-    const QString scheme = urlSchemeLower(url);
     if (scheme == QLatin1String("rtsp")) {
         // Force TCP for RTSP
         av_dict_set(&options, "rtsp_transport", "tcp", 0);
@@ -629,16 +1562,52 @@ bool LiveStreamPlayer::openStream(const QString& url) {
             emit errorOccurred(QStringLiteral("Failed to open stream: %1").arg(errorMsg));
         }
         avformat_free_context(formatContext);
-        return false;
+        return nullptr;
     }
 
     ret = avformat_find_stream_info(formatContext, nullptr);
     if (ret < 0) {
         emit errorOccurred(QStringLiteral("Failed to retrieve stream info: %1").arg(ffmpegErrorString(ret)));
         avformat_close_input(&formatContext);
-        return false;
+        return nullptr;
+    }
+
+    if (impairedInput) {
+        std::lock_guard<std::mutex> guard(m_contextMutex);
+        m_impairedInput = std::move(impairedInput);
+    }
+    return formatContext;
+}
+
+/**
+ * @brief 打开拉流输入并初始化解码/重采样上下文。
+ * @param url 需要连接的地址。
+ * @return 成功返回 true。
+ */
+bool LiveStreamPlayer::openStream(const QString& url) {
+    closeStream();
+
+    AVFormatContext* formatContext = nullptr;
+    if (m_replayReader) {
+        QString error;
+        formatContext = m_replayReader->openSegment(&error);
+        if (!formatContext) {
+            // 没有更多段或文件损坏，都不再重试
+            m_replayFinished.store(true, std::memory_order_release);
+            if (!error.isEmpty()) {
+                emit errorOccurred(QStringLiteral("Failed to read capture: %1").arg(error));
+            }
+            return false;
+        }
+    }
+    else {
+        formatContext = openInput(url);
+        if (!formatContext) {
+            return false;
+        }
     }
 
+    int ret = 0;
     int localVideoIndex = -1;
     int localAudioIndex = -1;
 
@@ -691,6 +1660,9 @@ bool LiveStreamPlayer::openStream(const QString& url) {
     videoCodecCtx->flags |= AV_CODEC_FLAG_LOW_DELAY;
     videoCodecCtx->thread_type = FF_THREAD_FRAME;
     videoCodecCtx->thread_count = 1;
+    if (keyframeOnlyActive()) {
+        videoCodecCtx->skip_frame = AVDISCARD_NONKEY;
+    }
 
     ret = avcodec_open2(videoCodecCtx, videoCodec, nullptr);
     if (ret < 0) {
@@ -707,7 +1679,8 @@ bool LiveStreamPlayer::openStream(const QString& url) {
             audioCodecCtx = avcodec_alloc_context3(audioCodec);
             if (audioCodecCtx) {
                 if (avcodec_parameters_to_context(audioCodecCtx, formatContext->streams[localAudioIndex]->codecpar) >= 0) {
-                    audioCodecCtx->request_sample_fmt = AV_SAMPLE_FMT_S16;
+                    // 与优先协商的浮点输出一致，支持该提示的解码器可直接走直通路径
+                    audioCodecCtx->request_sample_fmt = AV_SAMPLE_FMT_FLT;
                     ret = avcodec_open2(audioCodecCtx, audioCodec, nullptr);
                     if (ret < 0) {
                         emit errorOccurred(QStringLiteral("Unable to open audio codec."));
@@ -724,17 +1697,8 @@ bool LiveStreamPlayer::openStream(const QString& url) {
         }
     }
 
-    SwsContext* swsCtx = sws_getContext(videoCodecCtx->width,
-        videoCodecCtx->height,
-        videoCodecCtx->pix_fmt,
-        videoCodecCtx->width,
-        videoCodecCtx->height,
-        AV_PIX_FMT_BGRA,
-        SWS_BILINEAR,
-        nullptr,
-        nullptr,
-        nullptr);
-    if (!swsCtx) {
+    // 缩放上下文由转换阶段按帧属性与显示尺寸按需创建，这里只校验像素格式是否可转换
+    if (videoCodecCtx->pix_fmt != AV_PIX_FMT_NONE && !sws_isSupportedInput(videoCodecCtx->pix_fmt)) {
         emit errorOccurred(QStringLiteral("Failed to create scaler context."));
         avcodec_free_context(&videoCodecCtx);
         if (audioCodecCtx) {
@@ -762,10 +1726,11 @@ bool LiveStreamPlayer::openStream(const QString& url) {
             requestedChannels = 2;
         }
 
-        setupAudioOutput(requestedSampleRate, requestedChannels);
-
-        const int actualSampleRate = m_targetSampleRate.load(std::memory_order_acquire);
-        const int actualChannels = m_targetChannels.load(std::memory_order_acquire);
+        // 重采样按协商格式配置，格式不可用时音频线程跳过数据
+        const AudioOutputConfig outputConfig = setupAudioOutput(requestedSampleRate, requestedChannels);
+        const bool outputUsable = outputConfig.sampleFormat != AV_SAMPLE_FMT_NONE;
+        const int actualSampleRate = outputUsable ? outputConfig.format.sampleRate() : 0;
+        const int actualChannels = outputUsable ? outputConfig.format.channelCount() : 0;
 
         if (actualSampleRate > 0 && actualChannels > 0) {
             AVChannelLayout inputLayout{};
@@ -797,7 +1762,6 @@ bool LiveStreamPlayer::openStream(const QString& url) {
                 avcodec_free_context(&videoCodecCtx);
                 avcodec_free_context(&audioCodecCtx);
                 avformat_close_input(&formatContext);
-                teardownAudioOutput();
                 return false;
             }
 
@@ -808,7 +1772,6 @@ bool LiveStreamPlayer::openStream(const QString& url) {
                 avcodec_free_context(&videoCodecCtx);
                 avcodec_free_context(&audioCodecCtx);
                 avformat_close_input(&formatContext);
-                teardownAudioOutput();
                 return false;
             }
             else {
@@ -817,7 +1780,7 @@ bool LiveStreamPlayer::openStream(const QString& url) {
 
             if (swr_alloc_set_opts2(&swrCtx,
                 &outputLayout,
-                AV_SAMPLE_FMT_S16,
+                outputConfig.sampleFormat,
                 actualSampleRate,
                 &inputLayout,
                 audioCodecCtx->sample_fmt,
@@ -834,7 +1797,6 @@ bool LiveStreamPlayer::openStream(const QString& url) {
                 avcodec_free_context(&videoCodecCtx);
                 avcodec_free_context(&audioCodecCtx);
                 avformat_close_input(&formatContext);
-                teardownAudioOutput();
                 return false;
             }
 
@@ -847,24 +1809,26 @@ bool LiveStreamPlayer::openStream(const QString& url) {
             emit errorOccurred(QStringLiteral("Audio output initialisation failed."));
             avcodec_free_context(&audioCodecCtx);
             audioCodecCtx = nullptr;
-            teardownAudioOutput();
         }
     }
-    else {
-        teardownAudioOutput();
-    }
+    // 无音轨或音频初始化失败时保留音频输出（读空输出静音），下一次连接可直接复用
 
     {
         std::lock_guard<std::mutex> guard(m_contextMutex);
         m_formatCtx = formatContext;
         m_videoCodecCtx = videoCodecCtx;
         m_audioCodecCtx = audioCodecCtx;
-        m_swsCtx = swsCtx;
+        m_videoConverter.reset();
         m_swrCtx = swrCtx;
         m_videoStreamIndex = localVideoIndex;
         m_audioStreamIndex = localAudioIndex;
-        m_videoFrameDurationMs = 0.0;
-        m_audioFrameDurationMs = 0.0;
+        m_videoTimeBase = formatContext->streams[localVideoIndex]->time_base;
+        m_audioTimeBase = localAudioIndex >= 0 ? formatContext->streams[localAudioIndex]->time_base : AVRational{ 0, 1 };
+        m_videoFrameDurationMs.store(0.0, std::memory_order_relaxed);
+        m_audioFrameDurationMs.store(0.0, std::memory_order_relaxed);
+        // 新连接的时间轴与之前无关，重新建立主时钟
+        m_clock.reset();
+        m_latestVideoPts.store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
 
         if (m_videoCodecCtx) {
             double fps = av_q2d(m_formatCtx->streams[m_videoStreamIndex]->avg_frame_rate);
@@ -877,16 +1841,17 @@ bool LiveStreamPlayer::openStream(const QString& url) {
             if (fps < 1.0) {
                 fps = 30.0;
             }
-            m_videoFrameDurationMs = 1000.0 / fps;
+            m_videoFrameDurationMs.store(1000.0 / fps, std::memory_order_relaxed);
         }
 
         if (m_audioCodecCtx) {
             if (m_audioCodecCtx->frame_size > 0 && m_audioCodecCtx->sample_rate > 0) {
-                m_audioFrameDurationMs = 1000.0 * static_cast<double>(m_audioCodecCtx->frame_size) /
-                    static_cast<double>(m_audioCodecCtx->sample_rate);
+                m_audioFrameDurationMs.store(1000.0 * static_cast<double>(m_audioCodecCtx->frame_size) /
+                    static_cast<double>(m_audioCodecCtx->sample_rate), std::memory_order_relaxed);
             }
             else if (m_audioCodecCtx->sample_rate > 0) {
-                m_audioFrameDurationMs = 1000.0 * 1024.0 / static_cast<double>(m_audioCodecCtx->sample_rate);
+                m_audioFrameDurationMs.store(1000.0 * 1024.0 / static_cast<double>(m_audioCodecCtx->sample_rate),
+                    std::memory_order_relaxed);
             }
         }
     }
@@ -910,10 +1875,7 @@ void LiveStreamPlayer::closeStream() {
         m_audioCodecCtx = nullptr;
     }
 
-    if (m_swsCtx) {
-        sws_freeContext(m_swsCtx);
-        m_swsCtx = nullptr;
-    }
+    m_videoConverter.reset();
 
     if (m_swrCtx) {
         swr_free(&m_swrCtx);
@@ -924,11 +1886,12 @@ void LiveStreamPlayer::closeStream() {
         avformat_close_input(&m_formatCtx);
         m_formatCtx = nullptr;
     }
+    m_impairedInput.reset();
 
     m_videoStreamIndex = -1;
     m_audioStreamIndex = -1;
-    m_videoFrameDurationMs = 0.0;
-    m_audioFrameDurationMs = 0.0;
+    m_videoFrameDurationMs.store(0.0, std::memory_order_relaxed);
+    m_audioFrameDurationMs.store(0.0, std::memory_order_relaxed);
 }
 
 /**
@@ -948,141 +1911,285 @@ void LiveStreamPlayer::resetState() {
 }
 
 /**
- * @brief 根据采样率与通道数创建 QAudioOutput。
+ * @brief 确定本路写入环形缓冲的格式并接入共享音频输出，调用线程只等待注册表互斥量，不等待任何输出线程。
+ *        声卡输出的格式由共享输出决定（各路一致，便于混合）：没有其他播放器接入时按本路请求重新协商，
+ *        否则沿用当前格式；空输出直接使用源格式的 32 位浮点，结果按请求的采样率/通道数缓存。
+ *        写入格式与当前配置一致时直接复用，只丢弃上一连接残留的音频。
  * @param sampleRate 期望采样率。
  * @param channels 期望通道数。
+ * @return 协商后的配置，样本格式为 AV_SAMPLE_FMT_NONE 表示失败。
  */
-void LiveStreamPlayer::setupAudioOutput(int sampleRate, int channels) {
-    if (sampleRate <= 0 || channels <= 0) {
-        return;
+LiveStreamPlayer::AudioOutputConfig LiveStreamPlayer::setupAudioOutput(int sampleRate, int channels) {
+    if (sampleRate <= 0 || channels <= 0 || !m_audioMixer) {
+        return AudioOutputConfig();
     }
 
-    const bool sameThread = thread() == QThread::currentThread();
-    const Qt::ConnectionType connectionType = sameThread ? Qt::DirectConnection : Qt::BlockingQueuedConnection;
-
-    QMetaObject::invokeMethod(this, [this, sampleRate, channels]() {
-        if (m_audioOutput) {
-            m_audioOutput->stop();
-            delete m_audioOutput;
-            m_audioOutput = nullptr;
-            m_audioDevice = nullptr;
+    const int64_t startUs = MediaClock::nowUs();
+    const bool nullSink = m_audioMixer->isNullSink();
+    const bool allowReuse = m_audioOutputReuse.load(std::memory_order_acquire);
+    AudioOutputConfig config;
+    {
+        std::lock_guard<std::mutex> lock(m_audioFormatMutex);
+        if (!nullSink) {
+            // 关闭复用时按旧行为每次连接都查询一次设备，结果只用于计时，写入格式仍以共享输出为准
+            if (!allowReuse) {
+                AudioMixer::queryDeviceFormat(sampleRate, channels);
+            }
+            // 每次连接都接入：共享输出可能已被其他播放器按别的格式重新打开，不能沿用缓存
+            const AudioMixer::OutputFormat mixerFormat = m_audioMixer->attach(m_audioRing, sampleRate, channels);
+            m_cachedAudioConfig = AudioOutputConfig{ sampleRate, channels, mixerFormat.format, mixerFormat.sampleFormat, false };
+        }
+        else if (!allowReuse || !m_cachedAudioConfig.format.isValid() ||
+            m_cachedAudioConfig.requestedSampleRate != sampleRate ||
+            m_cachedAudioConfig.requestedChannels != channels ||
+            !m_cachedAudioConfig.nullSink) {
+            QAudioFormat outputFormat;
+            outputFormat.setCodec("audio/pcm");
+            outputFormat.setChannelCount(channels);
+            outputFormat.setSampleRate(sampleRate);
+            outputFormat.setSampleSize(32);
+            outputFormat.setSampleType(QAudioFormat::Float);
+            outputFormat.setByteOrder(QAudioFormat::LittleEndian);
+            m_cachedAudioConfig = AudioOutputConfig{ sampleRate, channels, outputFormat, AV_SAMPLE_FMT_FLT, true };
+        }
+        config = m_cachedAudioConfig;
+        if (config.sampleFormat == AV_SAMPLE_FMT_NONE) {
+            return config;
         }
 
-        QAudioFormat outputFormat;
-        outputFormat.setCodec("audio/pcm");
-        outputFormat.setChannelCount(channels);
-        outputFormat.setSampleRate(sampleRate);
-        outputFormat.setSampleSize(16);
-        outputFormat.setSampleType(QAudioFormat::SignedInt);
-        outputFormat.setByteOrder(QAudioFormat::LittleEndian);
-
-        QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
-        if (!device.isFormatSupported(outputFormat)) {
-            outputFormat = device.nearestFormat(outputFormat);
+        const bool reuse = allowReuse && m_audioOutputConfigured &&
+            m_outputAudioConfig.format == config.format &&
+            m_outputAudioConfig.nullSink == nullSink;
+        if (reuse) {
+            // 共享输出重新协商时会移除本路的注册，复用也要按静音状态重新注册
+            m_audioRing->discardQueued();
+            updateAudioSource();
+        }
+        else {
+            m_outputAudioConfig = config;
+            m_audioOutputConfigured = true;
+            configureAudioRing(config);
         }
+    }
+
+    const double setupMs = static_cast<double>(MediaClock::nowUs() - startUs) / 1000.0;
+    m_audioSetupMs.store(setupMs, std::memory_order_relaxed);
+    m_audioSetupMaxMs.store(std::max(m_audioSetupMaxMs.load(std::memory_order_relaxed), setupMs), std::memory_order_relaxed);
+    m_audioSetupCount.fetch_add(1, std::memory_order_relaxed);
+    return config;
+}
 
-        m_targetSampleRate.store(outputFormat.sampleRate(), std::memory_order_release);
-        m_targetChannels.store(outputFormat.channelCount(), std::memory_order_release);
+/**
+ * @brief 先从共享输出注销（输出线程不再读取），再持 m_contextMutex 重置环形缓冲（音频解码线程不在写入），
+ *        发布新的目标格式后按静音状态重新注册。调用方持有 m_audioFormatMutex。
+ * @param config 协商好的格式。
+ */
+void LiveStreamPlayer::configureAudioRing(const AudioOutputConfig& config) {
+    m_audioMixer->removeSource(m_audioRing);
 
-        m_audioOutput = new QAudioOutput(device, outputFormat, this);
-        m_audioOutput->setBufferSize(outputFormat.sampleRate() * outputFormat.channelCount() * 2 / 5);
-        m_audioDevice = m_audioOutput->start(); }, connectionType);
+    const QAudioFormat& outputFormat = config.format;
+    const int bytesPerFrame = outputFormat.channelCount() * av_get_bytes_per_sample(config.sampleFormat);
+    const int bytesPerSecond = outputFormat.sampleRate() * bytesPerFrame;
+    {
+        std::lock_guard<std::mutex> lock(m_contextMutex);
+        m_audioRing->configure(bytesPerSecond, bytesPerFrame);
+    }
+    m_targetSampleFormat.store(config.sampleFormat, std::memory_order_release);
+    m_targetBytesPerSecond.store(bytesPerSecond, std::memory_order_release);
+    m_targetSampleRate.store(outputFormat.sampleRate(), std::memory_order_release);
+    m_targetChannels.store(outputFormat.channelCount(), std::memory_order_release);
+    updateAudioSource();
 }
 
 /**
- * @brief 在线程安全上下文中销毁音频输出。
+ * @brief 已配置且未静音时注册到共享输出，否则注销。调用方持有 m_audioFormatMutex。
  */
-void LiveStreamPlayer::teardownAudioOutput() {
-    if (thread() != QThread::currentThread()) {
-        QMetaObject::invokeMethod(this, [this]() { teardownAudioOutput(); }, Qt::BlockingQueuedConnection);
+void LiveStreamPlayer::updateAudioSource() {
+    if (!m_audioMixer) {
         return;
     }
-
-    if (m_audioOutput) {
-        m_audioOutput->stop();
-        delete m_audioOutput;
-        m_audioOutput = nullptr;
-        m_audioDevice = nullptr;
+    const int bytesPerSecond = m_targetBytesPerSecond.load(std::memory_order_acquire);
+    const int channels = m_targetChannels.load(std::memory_order_acquire);
+    const AVSampleFormat sampleFormat = static_cast<AVSampleFormat>(m_targetSampleFormat.load(std::memory_order_acquire));
+    if (m_audioOutputConfigured && bytesPerSecond > 0 && sampleFormat != AV_SAMPLE_FMT_NONE &&
+        !m_audioMuted.load(std::memory_order_acquire)) {
+        m_audioMixer->addSource(m_audioRing, bytesPerSecond, channels * av_get_bytes_per_sample(sampleFormat));
+    }
+    else {
+        m_audioMixer->removeSource(m_audioRing);
     }
-
-    m_targetSampleRate.store(0, std::memory_order_release);
-    m_targetChannels.store(0, std::memory_order_release);
 }
 
 /**
- * @brief 将 PCM 数据加入待写队列，由定时器统一消费。
- * @param samples 可写音频数据。
+ * @brief 从共享输出注销并解除接入（其他播放器此后可以重新协商格式），清除目标格式，任意线程可调用，不等待输出线程。
  */
-void LiveStreamPlayer::emitAudioSamples(QByteArray samples) {
-    std::lock_guard<std::mutex> lock(m_audioPendingMutex);
-    m_audioPendingQueue.push_back(std::move(samples));
+void LiveStreamPlayer::teardownAudioOutput() {
+    std::lock_guard<std::mutex> lock(m_audioFormatMutex);
+    m_audioOutputConfigured = false;
+    if (m_audioMixer) {
+        m_audioMixer->detach(m_audioRing);
+    }
+
+    m_targetSampleRate.store(0, std::memory_order_release);
+    m_targetChannels.store(0, std::memory_order_release);
+    m_targetSampleFormat.store(AV_SAMPLE_FMT_NONE, std::memory_order_release);
+    m_targetBytesPerSecond.store(0, std::memory_order_release);
+    m_audioBufferMs.store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
 }
 
 /**
- * @brief 定时器槽，从待写队列消费并分批写入音频设备，避免递归调用链。
+ * @brief 设备拉取回调，在共享音频输出线程执行。
+ *        正在播放的时间 = 读位置时间 - 设备缓冲中尚未播放的时长，同时记录音频水位供漂移补偿使用。
+ * @param pts 环形缓冲读位置的媒体时间。
+ * @param queuedBytes 环形缓冲中排队的字节数。
  */
-void LiveStreamPlayer::processAudioQueue() {
-    if (!m_audioOutput || !m_audioDevice) {
+void LiveStreamPlayer::updateAudioClock(double pts, size_t queuedBytes) {
+    const int bytesPerSecond = m_targetBytesPerSecond.load(std::memory_order_acquire);
+    if (bytesPerSecond <= 0) {
         return;
     }
 
-    // 一次性取出所有待写数据
-    std::deque<QByteArray> localQueue;
-    {
-        std::lock_guard<std::mutex> lock(m_audioPendingMutex);
-        localQueue.swap(m_audioPendingQueue);
-    }
-
-    for (const QByteArray& samples : localQueue) {
-        int offset = 0;
-        const int totalSize = samples.size();
-
-        while (offset < totalSize) {
-            const int freeBytes = m_audioOutput->bytesFree();
-            if (freeBytes <= 0) {
-                // 缓冲区满，剩余数据重新入队
-                if (offset < totalSize) {
-                    std::lock_guard<std::mutex> lock(m_audioPendingMutex);
-                    m_audioPendingQueue.push_front(samples.mid(offset));
-                }
-                return;
-            }
-
-            const qint64 written = m_audioDevice->write(samples.constData() + offset, totalSize - offset);
-            if (written <= 0) {
-                return;
-            }
-
-            offset += static_cast<int>(written);
-        }
+    // 空输出没有设备缓冲，读出即视为已播放
+    const int bufferedBytes = m_audioMixer ? m_audioMixer->bufferedBytes() : 0;
+    if (std::isfinite(pts)) {
+        m_clock.setAudioTime(pts - static_cast<double>(bufferedBytes) * m_clock.rate() / bytesPerSecond,
+            MediaClock::nowUs());
     }
+    m_audioBufferMs.store(static_cast<double>(queuedBytes + bufferedBytes) * 1000.0 / bytesPerSecond,
+        std::memory_order_relaxed);
 }
 
 /**
- * @brief 汇总队列与码率信息后发射 statsUpdated。
+ * @brief 从各线程的原子计数与无锁副本汇总统计，不获取任何热路径上的锁；写入快照后发射 statsUpdated。
  */
 void LiveStreamPlayer::updateStats() {
+    // 先清除标记：汇总期间到达的请求会再投递一次，不会丢失
+    m_statsPending.store(false, std::memory_order_release);
     PlayerStats stats;
     stats.videoQueueSize = static_cast<int>(m_videoQueue.size());
     stats.audioQueueSize = static_cast<int>(m_audioQueue.size());
     stats.incomingBitrateKbps = m_bitrateKbps.load(std::memory_order_relaxed);
     stats.droppedVideoFrames = static_cast<int>(m_videoQueue.droppedCount());
+    stats.avOffsetMs = m_avOffsetMs.load(std::memory_order_relaxed);
+    stats.presentationJitterMs = m_presentationJitterMs.load(std::memory_order_relaxed);
+    stats.videoLatenessMs = m_videoLatenessMs.load(std::memory_order_relaxed);
+    stats.lateDroppedFrames = static_cast<int>(m_lateDroppedFrames.load(std::memory_order_relaxed));
+    stats.latencyMs = m_latencyMs.load(std::memory_order_relaxed);
+    stats.playbackRate = m_clock.rate();
+    stats.latencyJumps = static_cast<int>(m_latencyJumps.load(std::memory_order_relaxed));
+    stats.audioBufferMs = m_audioBufferMs.load(std::memory_order_relaxed);
+    stats.audioDriftPpm = m_audioDriftPpm.load(std::memory_order_relaxed);
+    stats.audioUnderruns = static_cast<int>(m_audioRing->underrunCount());
+    stats.audioTrimmedSamples = static_cast<qint64>(m_audioRing->trimmedFrames());
+    stats.audioSetupMs = m_audioSetupMs.load(std::memory_order_relaxed);
+    stats.audioSetupMaxMs = m_audioSetupMaxMs.load(std::memory_order_relaxed);
+    stats.audioSetupCount = m_audioSetupCount.load(std::memory_order_relaxed);
+    stats.audioPassthrough = m_audioPassthrough.load(std::memory_order_relaxed);
+    stats.audioPeakDb = m_audioPeakDb.load(std::memory_order_relaxed);
+    stats.audioRmsDb = m_audioRmsDb.load(std::memory_order_relaxed);
+    stats.audioMuted = m_audioMuted.load(std::memory_order_relaxed);
+    stats.decodedVideoFrames = static_cast<qint64>(m_decodedVideoFrames.load(std::memory_order_relaxed));
+    stats.presentedVideoFrames = static_cast<qint64>(m_presentedVideoFrames.load(std::memory_order_relaxed));
+    const quint64 inputPackets = m_inputVideoPackets.load(std::memory_order_relaxed);
+    stats.inputVideoPackets = static_cast<qint64>(inputPackets);
+    stats.reconnectCount = static_cast<int>(m_reconnectCount.load(std::memory_order_relaxed));
+    stats.timeToFirstFrameMs = m_timeToFirstFrameMs.load(std::memory_order_relaxed);
+    stats.framePoolHits = static_cast<qint64>(m_videoConverter.framePool().hitCount());
+    stats.framePoolMisses = static_cast<qint64>(m_videoConverter.framePool().allocationCount());
+
+    // 帧率：窗口满 1 秒后由计数增量得出，统计周期更短时沿用上一个窗口的结果
+    const int64_t nowUs = MediaClock::nowUs();
+    const int64_t rateElapsedUs = nowUs - m_rateBaseline.timeUs;
+    if (rateElapsedUs >= kRateWindowUs) {
+        const quint64 decodedFrames = static_cast<quint64>(stats.decodedVideoFrames);
+        const quint64 presentedFrames = static_cast<quint64>(stats.presentedVideoFrames);
+        m_rateBaseline.inputFps = ratePerSecond(inputPackets, m_rateBaseline.inputPackets, rateElapsedUs);
+        m_rateBaseline.decodedFps = ratePerSecond(decodedFrames, m_rateBaseline.decodedFrames, rateElapsedUs);
+        m_rateBaseline.presentedFps = ratePerSecond(presentedFrames, m_rateBaseline.presentedFrames, rateElapsedUs);
+        m_rateBaseline.timeUs = nowUs;
+        m_rateBaseline.inputPackets = inputPackets;
+        m_rateBaseline.decodedFrames = decodedFrames;
+        m_rateBaseline.presentedFrames = presentedFrames;
+    }
+    stats.inputFps = m_rateBaseline.inputFps;
+    stats.decodedFps = m_rateBaseline.decodedFps;
+    stats.presentedFps = m_rateBaseline.presentedFps;
+
+    // 分位数：相对较旧的基线汇总，覆盖最近 5~10 秒；每 5 秒用当前内容覆盖较旧的基线
+    const LatencyHistogram& decodeLatency = m_stageLatency[static_cast<int>(PipelineStage::VideoDecode)];
+    const LatencyHistogram& convertLatency = m_stageLatency[static_cast<int>(PipelineStage::VideoConvert)];
+    const LatencyHistogram::Summary decodeSummary = decodeLatency.summarizeSince(m_decodeBaseline[m_olderBaseline]);
+    const LatencyHistogram::Summary convertSummary = convertLatency.summarizeSince(m_convertBaseline[m_olderBaseline]);
+    stats.decodeP50Ms = decodeSummary.p50Us / 1000.0;
+    stats.decodeP99Ms = decodeSummary.p99Us / 1000.0;
+    stats.convertP50Ms = convertSummary.p50Us / 1000.0;
+    stats.convertP99Ms = convertSummary.p99Us / 1000.0;
+    if (nowUs - m_percentileWindowStartUs >= kPercentileWindowUs) {
+        m_decodeBaseline[m_olderBaseline].assign(decodeLatency);
+        m_convertBaseline[m_olderBaseline].assign(convertLatency);
+        m_olderBaseline ^= 1;
+        m_percentileWindowStartUs = nowUs;
+    }
+
+    // 卡顿：视频线程只在下一帧到达时结算，进行中的卡顿在这里补上
+    const int64_t lastPresentedUs = m_lastPresentedUs.load(std::memory_order_relaxed);
+    int64_t stallTotalUs = m_stallTotalUs.load(std::memory_order_relaxed);
+    stats.stallCount = static_cast<int>(m_stallCount.load(std::memory_order_relaxed));
+    if (lastPresentedUs != 0) {
+        const int64_t sinceLastUs = std::max<int64_t>(0, nowUs - lastPresentedUs);
+        stats.msSinceLastFrame = static_cast<double>(sinceLastUs) / 1000.0;
+        if (m_running.load(std::memory_order_relaxed) && !keyframeOnlyActive()
+            && sinceLastUs > m_stallThresholdUs.load(std::memory_order_relaxed)) {
+            ++stats.stallCount;
+            stallTotalUs += sinceLastUs;
+        }
+    }
+    stats.stallTotalMs = static_cast<double>(stallTotalUs) / 1000.0;
+
+    const int audioBytesPerSecond = m_targetBytesPerSecond.load(std::memory_order_acquire);
+    if (audioBytesPerSecond > 0) {
+        stats.audioRingMs = static_cast<double>(m_audioRing->queuedBytes()) * 1000.0 / audioBytesPerSecond;
+    }
+    // 信箱只在 UI 线程替换，同一线程读取无需加锁，不与视频线程争用 m_mailboxMutex
+    if (m_frameMailbox) {
+        stats.supersededFrames = static_cast<int>(m_frameMailbox->supersededCount());
+    }
 
     double jitterVideo = 0.0;
     double jitterAudio = 0.0;
+    const double videoFrameDurationMs = m_videoFrameDurationMs.load(std::memory_order_relaxed);
+    const double audioFrameDurationMs = m_audioFrameDurationMs.load(std::memory_order_relaxed);
 
-    if (m_videoFrameDurationMs > 0.0) {
-        jitterVideo = m_videoFrameDurationMs * stats.videoQueueSize;
+    if (videoFrameDurationMs > 0.0) {
+        jitterVideo = videoFrameDurationMs * stats.videoQueueSize;
     }
 
-    if (m_audioFrameDurationMs > 0.0) {
-        jitterAudio = m_audioFrameDurationMs * stats.audioQueueSize;
+    if (audioFrameDurationMs > 0.0) {
+        jitterAudio = audioFrameDurationMs * stats.audioQueueSize;
     }
 
     stats.jitterBufferMs = std::max(jitterVideo, jitterAudio);
+    m_statsSnapshot.store(stats);
     emit statsUpdated(stats);
 }
 
+/**
+ * @brief 未有待处理请求时向 UI 线程投递一次 updateStats；多个线程、多次请求合并为一次。
+ */
+void LiveStreamPlayer::requestStatsUpdate() {
+    if (!m_statsPending.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, [this]() { updateStats(); }, Qt::QueuedConnection);
+    }
+}
+
+/**
+ * @brief 读取顺序锁快照。
+ * @return 统计快照。
+ */
+PlayerStats LiveStreamPlayer::latestStats() const {
+    return m_statsSnapshot.load();
+}
+
 /**
  * @brief FFmpeg 访问回调，用于检测停止请求。
  * @param opaque 指向 LiveStreamPlayer。
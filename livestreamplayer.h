@@ -6,14 +6,42 @@
  *   - stop
  *   - setMaxReconnectAttempts
  *   - setReconnectDelayMs
+ *   - setKeyframeOnly
+ *   - setOutputSize
+ *   - setScalingQuality
+ *   - setFrameMailbox
+ *   - setMaxLatencyMs
+ *   - setMaxAudioQueueMs
+ *   - setVolume
+ *   - setMuted
+ *   - setNullAudioSink
+ *   - setAudioOutputReuse
+ *   - setVideoConversionEnabled
+ *   - setRealtimeInput
+ *   - setCaptureFile
+ *   - setReplaySpeed
+ *   - setNetworkImpairment
+ *   - stageLatency
+ *   - resetStageLatency
+ *   - latestStats
  *   - requestStop
  *   - demuxLoop
  *   - videoDecodeLoop
+ *   - waitForPresentation
+ *   - notePresented
+ *   - regulateLatency
+ *   - replayUnpaced
+ *   - keyframeOnlyActive
  *   - audioDecodeLoop
+ *   - drainResampler
+ *   - openInput
  *   - openStream
  *   - closeStream
  *   - setupAudioOutput
+ *   - configureAudioRing
+ *   - updateAudioSource
  *   - teardownAudioOutput
+ *   - updateAudioClock
  * @mainclasses
  *   - LiveStreamPlayer
  */
@@ -22,21 +50,34 @@
 #define LIVESTREAMPLAYER_H
 
 #include <QObject>
-#include <QAudioOutput>
-#include <QByteArray>
+#include <QAudioFormat>
 #include <QImage>
+#include <QSize>
 #include <QString>
 class QTimer;
 class QUrl;
 
 #include <atomic>
-#include <deque>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <thread>
-
+#include <vector>
+
+#include "audiointerleaver.h"
+#include "audiomixer.h"
+#include "audioprocessor.h"
+#include "audioringdevice.h"
+#include "driftcontroller.h"
+#include "framemailbox.h"
+#include "latencyhistogram.h"
+#include "mediaclock.h"
+#include "networkimpairment.h"
+#include "packetcapture.h"
 #include "packetqueue.h"
 #include "playerstats.h"
+#include "seqlock.h"
+#include "videoconverter.h"
 
 extern "C"
 {
@@ -63,6 +104,17 @@ public:
      */
     explicit LiveStreamPlayer(QObject* parent = nullptr);
 
+    /**
+     * @brief 视频处理阶段，用于按阶段统计耗时分布。
+     */
+    enum class PipelineStage {
+        VideoQueueWait,     // 视频包在队列中的等待时长
+        VideoDecode,        // 每个视频包的解码耗时（送包与取帧）
+        VideoConvert,       // 每帧的缩放与颜色转换耗时
+        PacketToPresent,    // 视频包入队到对应帧呈现，含按时钟等待的时长
+        Count
+    };
+
     /**
      * @brief 析构函数，确保线程与资源被释放。
      */
@@ -97,13 +149,131 @@ public:
      */
     void setReconnectDelayMs(int delayMs);
 
-signals:
     /**
-     * @brief 当有新的视频帧准备好时发射。
-     * @param frame 已转换的 QImage。
+     * @brief 切换仅关键帧的低功耗解码模式，适用于多路预览墙的缩略图。
+     * @param enabled true 表示只解码关键帧，false 在下一个关键帧处恢复完整解码。
+     */
+    void setKeyframeOnly(bool enabled);
+
+    /**
+     * @brief 查询是否处于仅关键帧模式。
+     * @return true 表示只解码关键帧。
+     */
+    bool isKeyframeOnly() const;
+
+    /**
+     * @brief 设置显示区域的设备像素尺寸，转换阶段直接缩放到该尺寸。
+     * @param devicePixelSize 显示区域尺寸，为空时输出源分辨率。
+     */
+    void setOutputSize(const QSize& devicePixelSize);
+
+    /**
+     * @brief 设置转换阶段的缩放质量。
+     * @param quality 缩放算法。
+     */
+    void setScalingQuality(VideoConverter::ScalingQuality quality);
+
+    /**
+     * @brief 设置视频帧的交付信箱，到达呈现时刻的帧写入其中，由显示端在绘制时取走。仅在 UI 线程调用。
+     * @param mailbox 信箱，传空表示不输出画面。
+     */
+    void setFrameMailbox(std::shared_ptr<FrameMailbox> mailbox);
+
+    /**
+     * @brief 设置端到端延迟上限。缓冲的媒体略超上限时以 1.05 倍速追赶（音频经重采样补偿拉伸），
+     *        超出较多时直接跳到最新关键帧。
+     * @param latencyMs 延迟上限（毫秒），0 表示关闭。
+     */
+    void setMaxLatencyMs(int latencyMs);
+
+    /**
+     * @brief 设置排队音频的时长上限，超出时丢弃最旧的音频，防止设备停滞时音频越积越多、落后于视频。
+     * @param queueMs 上限（毫秒），0 表示仅受环形缓冲容量限制。
+     */
+    void setMaxAudioQueueMs(int queueMs);
+
+    /**
+     * @brief 设置软件增益，在写入环形缓冲前作用于 PCM，多路播放时各路独立调节。
+     * @param volume 线性增益，1.0 为原始音量，范围 [0, 4]。
+     */
+    void setVolume(double volume);
+
+    /**
+     * @brief 静音时仍解码并统计电平，但不重采样、不写入环形缓冲，并从共享音频输出注销，时钟改由视频驱动；
+     *        取消静音时先丢弃切换期间残留的音频再重新注册。
+     * @param muted 是否静音。
+     */
+    void setMuted(bool muted);
+
+    /**
+     * @brief 使用空音频输出：不打开声卡，由共享输出线程的定时器按实时速率消费环形缓冲并驱动音频时钟，
+     *        供无显示、无声卡的环境（服务器、CI）运行完整的音频路径。下一次连接时生效。
+     * @param enabled 是否启用。
+     */
+    void setNullAudioSink(bool enabled);
+
+    /**
+     * @brief 关闭后每次连接都重新查询设备格式，并重新配置环形缓冲、重新注册到共享音频输出，
+     *        即引入格式缓存与输出复用之前的行为，只用于对比重连耗时（统计中的 audioSetupMs）。下一次连接时生效。
+     * @param enabled 是否复用，默认开启。
+     */
+    void setAudioOutputReuse(bool enabled);
+
+    /**
+     * @brief 关闭后视频只解码并按时钟节拍计时，不转换为 QImage、不投递到信箱，用于测量纯解码开销。
+     * @param enabled 是否转换视频帧。
+     */
+    void setVideoConversionEnabled(bool enabled);
+
+    /**
+     * @brief 按时间戳以实时速率读取输入（类似 ffmpeg -re），使本地文件与网络直播流的节奏一致。
+     *        时间戳回退或超前较多时重新对齐。下一次连接时生效。
+     * @param enabled 是否启用。
+     */
+    void setRealtimeInput(bool enabled);
+
+    /**
+     * @brief 将解复用得到的每个包连同到达时刻与流参数追加写入抓取文件（扩展名 .lspcap），每次连接写一段。
+     *        空字符串表示关闭。下一次 start() 时生效。
+     * @param path 文件路径。
+     */
+    void setCaptureFile(const QString& path);
+
+    /**
+     * @brief 回放抓取文件（start() 传入 .lspcap 路径）时的速度：1 为按原始到达节奏，大于 1 为倍速，
+     *        0 为不等待、只受队列反压限制的最快速度。速度不为 1 时视频不按主时钟等待、不丢弃迟到帧，
+     *        音视频队列都阻塞等待空位，音频只统计电平不输出，同一文件每次回放的呈现帧序列相同。
+     *        回放时（任意速度）不做延迟追赶，也不启用仅关键帧模式。
+     * @param speed 速度倍数，负值按 1 处理。
+     */
+    void setReplaySpeed(double speed);
+
+    /**
+     * @brief 在输入与解复用器之间插入网络损伤模拟（延迟、抖动、带宽、停顿、断线），
+     *        仅作用于字节流输入，RTSP 与抓取回放不受影响。空指针表示关闭。下一次 start() 时生效。
+     * @param profile 已解析的损伤脚本。
+     */
+    void setNetworkImpairment(std::shared_ptr<const ImpairmentProfile> profile);
+
+    /**
+     * @brief 查询某一阶段的耗时直方图，任意线程可读取快照。
+     * @param stage 阶段。
+     * @return 直方图。
      */
-    void frameReady(const QImage& frame);
+    const LatencyHistogram& stageLatency(PipelineStage stage) const;
 
+    /**
+     * @brief 清空各阶段直方图，用于跳过预热期或开始新的统计窗口；start() 时自动清空。
+     */
+    void resetStageLatency();
+
+    /**
+     * @brief 读取最近一次汇总的统计信息，不加锁，任意线程可调用；与最近一次 statsUpdated 的内容相同。
+     * @return 统计快照。
+     */
+    PlayerStats latestStats() const;
+
+signals:
     /**
      * @brief 播放状态变化时通知 UI。
      * @param statusText 状态描述。
@@ -140,11 +310,76 @@ private:
      */
     void videoDecodeLoop();
 
+    /**
+     * @brief 按帧 pts 与主时钟等待呈现时刻。
+     * @param pts 帧时间（秒），NaN 表示无时间戳。
+     * @param frameDurationMs 标称帧间隔（毫秒）。
+     * @param newerFramePending 是否已有更新的解码帧等待呈现。
+     * @return true 表示呈现，false 表示丢弃迟到帧。
+     */
+    bool waitForPresentation(double pts, double frameDurationMs, bool newerFramePending);
+
+    /**
+     * @brief 记录一帧到达呈现时刻，更新首帧耗时与卡顿计数，仅视频线程调用。
+     * @param presentedUs 呈现时刻（微秒）。
+     * @param frameDurationMs 标称帧间隔（毫秒）。
+     */
+    void notePresented(int64_t presentedUs, double frameDurationMs);
+
+    /**
+     * @brief 检查缓冲时长并在超出延迟上限时追赶。
+     * @return true 表示已跳到最新关键帧。
+     */
+    bool regulateLatency();
+
+    /**
+     * @brief 是否正以不为 1 的速度回放：此时解码结果不按时钟节拍呈现，队列不丢包。
+     * @return true 表示不按时钟节拍。
+     */
+    bool replayUnpaced() const;
+
+    /**
+     * @brief 仅关键帧模式是否实际生效：回放时忽略该设置，保证结果可重复。
+     * @return true 表示只解码关键帧。
+     */
+    bool keyframeOnlyActive() const;
+
+    /**
+     * @brief 丢弃旧数据并跳到队列中最新的关键帧。
+     * @return 成功跳转返回 true。
+     */
+    bool jumpToLatestKeyframe();
+
+    /**
+     * @brief 记录一帧呈现时的音视频偏差并更新呈现抖动。
+     * @param offsetSec 帧时间减去主时钟时间（秒）。
+     */
+    void recordPresentation(double offsetSec);
+
     /**
      * @brief 音频解码线程主循环。
      */
     void audioDecodeLoop();
 
+    /**
+     * @brief 冲刷重采样器中延迟的样本并写入环形缓冲，随后重新初始化重采样器（仅音频解码线程调用）。
+     * @param channels 输出通道数。
+     * @param sampleFormat 输出样本格式。
+     * @param sampleRate 输出采样率。
+     * @param playbackRate 当前播放速率。
+     * @param buffer 暂存区。
+     * @param nextPts 冲刷出的首样本时间，返回时为其后一样本的时间。
+     */
+    void drainResampler(int channels, AVSampleFormat sampleFormat, int sampleRate, double playbackRate,
+        std::vector<char>& buffer, double& nextPts);
+
+    /**
+     * @brief 打开网络或本地输入并探测流信息（回放抓取文件时不使用）。
+     * @param url 输入地址。
+     * @return 格式上下文，失败时为空。
+     */
+    AVFormatContext* openInput(const QString& url);
+
     /**
      * @brief 打开流并准备解码上下文。
      * @param url 拉流地址。
@@ -168,33 +403,57 @@ private:
     void resetState();
 
     /**
-     * @brief 初始化音频输出设备。
+     * @brief 协商好的音频写入格式，按请求的采样率/通道数缓存。
+     */
+    struct AudioOutputConfig {
+        int requestedSampleRate = 0;
+        int requestedChannels = 0;
+        QAudioFormat format;
+        AVSampleFormat sampleFormat = AV_SAMPLE_FMT_NONE;   // 与 format 对应的打包样本格式
+        bool nullSink = false;                              // 空输出不查询设备，直接使用源格式
+    };
+
+    /**
+     * @brief 确定写入格式并接入共享音频输出，不等待输出线程。
      * @param sampleRate 目标采样率。
      * @param channels 通道数。
+     * @return 协商后的配置，样本格式为 AV_SAMPLE_FMT_NONE 表示失败。
      */
-    void setupAudioOutput(int sampleRate, int channels);
+    AudioOutputConfig setupAudioOutput(int sampleRate, int channels);
 
     /**
-     * @brief 停止音频输出并释放设备。
+     * @brief 按新格式重置环形缓冲并重新注册到共享输出，调用方持有 m_audioFormatMutex。
+     * @param config 写入格式。
      */
-    void teardownAudioOutput();
+    void configureAudioRing(const AudioOutputConfig& config);
+
+    /**
+     * @brief 按配置与静音状态向共享输出注册或注销环形缓冲，调用方持有 m_audioFormatMutex。
+     */
+    void updateAudioSource();
 
     /**
-     * @brief 将解码后的音频数据加入待写队列。
-     * @param samples PCM 数据。
+     * @brief 从共享音频输出注销并清除目标格式，返回后输出线程不再读取环形缓冲。
      */
-    void emitAudioSamples(QByteArray samples);
+    void teardownAudioOutput();
 
     /**
-     * @brief 定时器槽，从待写队列中消费并写入音频设备。
+     * @brief 音频设备拉取数据前的回调，更新音频主时钟与水位。
+     * @param pts 环形缓冲读位置的媒体时间。
+     * @param queuedBytes 环形缓冲中排队的字节数。
      */
-    void processAudioQueue();
+    void updateAudioClock(double pts, size_t queuedBytes);
 
     /**
-     * @brief 刷新统计数据并发射信号。
+     * @brief 汇总统计数据、发布快照并发射信号，仅在 UI 线程调用。
      */
     void updateStats();
 
+    /**
+     * @brief 请求尽快刷新统计，任意线程可调用；已有待处理的请求时不再投递。
+     */
+    void requestStatsUpdate();
+
     /**
      * @brief 将 FFmpeg 错误码转换为可读字符串。
      * @param errorCode FFmpeg 返回值。
@@ -248,22 +507,109 @@ private:
     AVFormatContext* m_formatCtx = nullptr;
     AVCodecContext* m_videoCodecCtx = nullptr;
     AVCodecContext* m_audioCodecCtx = nullptr;
-    SwsContext* m_swsCtx = nullptr;
     SwrContext* m_swrCtx = nullptr;
+    VideoConverter m_videoConverter;        // 视频转换阶段，仅由视频解码线程使用
+    std::mutex m_mailboxMutex;              // 保护 m_frameMailbox 的替换
+    std::shared_ptr<FrameMailbox> m_frameMailbox;
     int m_videoStreamIndex = -1;
     int m_audioStreamIndex = -1;
-    double m_videoFrameDurationMs = 0.0;
-    double m_audioFrameDurationMs = 0.0;
+    AVRational m_videoTimeBase{ 0, 1 };
+    AVRational m_audioTimeBase{ 0, 1 };
+    std::atomic<double> m_videoFrameDurationMs{ 0.0 };    // 打开/关闭流时写入，统计时不加锁读取
+    std::atomic<double> m_audioFrameDurationMs{ 0.0 };
 
     std::atomic<int> m_targetSampleRate{ 0 };
     std::atomic<int> m_targetChannels{ 0 };
-
-    QAudioOutput* m_audioOutput = nullptr;
-    QIODevice* m_audioDevice = nullptr;
+    std::atomic<int> m_targetSampleFormat{ AV_SAMPLE_FMT_NONE };    // 输出设备的打包样本格式
+    std::atomic<int> m_targetBytesPerSecond{ 0 };
+    std::atomic_bool m_audioPassthrough{ false };                   // 最近一帧是否绕过了重采样器
+
+    // 所有播放器共用一个音频输出线程与一个 QAudioOutput，由 AudioMixer 混合各路环形缓冲，
+    // 注册与注销都不等待输出线程，不受 UI 线程卡顿影响
+    std::shared_ptr<AudioMixer> m_audioMixer;   // start 时按空输出开关获取，析构时释放
+    AudioRingDevice* m_audioRing = nullptr;     // 拉模式数据源，音频解码线程直接写入，共享输出线程读取
+    std::mutex m_audioFormatMutex;          // 保护下面的格式缓存、输出配置与注册状态
+    AudioOutputConfig m_cachedAudioConfig;  // 最近一次协商结果
+    AudioOutputConfig m_outputAudioConfig;  // 环形缓冲当前的写入配置
+    bool m_audioOutputConfigured = false;
+    std::atomic<double> m_audioSetupMs{ 0.0 };  // 最近一次打开流时音频输出准备耗时
+    std::atomic<double> m_audioSetupMaxMs{ 0.0 };   // 各次连接中的最大准备耗时（仅解复用线程写入）
+    std::atomic<int> m_audioSetupCount{ 0 };        // 准备音频输出的次数（仅解复用线程写入）
+    std::atomic_bool m_audioOutputReuse{ true };
     QTimer* m_statsTimer = nullptr;         // 统计信息刷新定时器
-    QTimer* m_audioWriteTimer = nullptr;    // 音频写入定时器，周期性消费待写队列
-    std::mutex m_audioPendingMutex;         // 保护音频待写队列的互斥锁
-    std::deque<QByteArray> m_audioPendingQueue;  // 音频待写队列，避免递归 invokeMethod
+
+    std::atomic_bool m_nullAudioSink{ false };  // start 时据此选择共享输出实例
+    std::atomic_bool m_convertVideo{ true };
+    std::atomic_bool m_realtimeInput{ false };
+
+    // 抓取、回放与损伤模拟（读写器与会话状态仅解复用线程访问）
+    std::mutex m_inputConfigMutex;                      // 保护抓取路径与损伤脚本
+    QString m_capturePath;
+    std::shared_ptr<const ImpairmentProfile> m_impairmentProfile;
+    std::shared_ptr<NetworkImpairment> m_impairment;
+    std::unique_ptr<ImpairedInput> m_impairedInput;     // 与 m_formatCtx 同生命周期，受 m_contextMutex 保护
+    std::unique_ptr<PacketCaptureWriter> m_captureWriter;
+    std::unique_ptr<PacketCaptureReader> m_replayReader;
+    std::atomic<double> m_replaySpeed{ 1.0 };
+    std::atomic_bool m_replaying{ false };              // 本次 start() 的输入是抓取文件
+    std::atomic_bool m_replayFinished{ false };         // 回放读完所有段，结束而不重连
+
+    // 各阶段耗时分布与视频帧计数
+    LatencyHistogram m_stageLatency[static_cast<int>(PipelineStage::Count)];
+    std::atomic<quint64> m_decodedVideoFrames{ 0 };
+    std::atomic<quint64> m_presentedVideoFrames{ 0 };
+    std::atomic<quint64> m_inputVideoPackets{ 0 };      // 解复用线程成功入队的视频包数
+
+    // 卡顿、重连与首帧：视频/解复用线程只做计数与时间戳存取，统计时再汇总
+    std::atomic<int64_t> m_startUs{ 0 };                // 最近一次 start() 的时刻
+    std::atomic<int64_t> m_lastPresentedUs{ 0 };        // 最近一帧到达呈现时刻，0 表示尚无帧
+    std::atomic<int64_t> m_stallThresholdUs{ 0 };       // 呈现间隔超过该值计为一次卡顿
+    std::atomic<quint64> m_stallCount{ 0 };
+    std::atomic<int64_t> m_stallTotalUs{ 0 };
+    std::atomic<quint64> m_reconnectCount{ 0 };
+    std::atomic<double> m_timeToFirstFrameMs{ -1.0 };
+
+    // 以下仅 UI 线程在 updateStats 中访问：帧率与分位数的窗口基线
+    struct RateBaseline {
+        int64_t timeUs = 0;
+        quint64 inputPackets = 0;
+        quint64 decodedFrames = 0;
+        quint64 presentedFrames = 0;
+        double inputFps = 0.0;                          // 上一个完整窗口的结果，窗口未满时沿用
+        double decodedFps = 0.0;
+        double presentedFps = 0.0;
+    };
+    RateBaseline m_rateBaseline;
+    LatencyHistogram m_decodeBaseline[2];               // 交替刷新，分位数覆盖最近 5~10 秒
+    LatencyHistogram m_convertBaseline[2];
+    int64_t m_percentileWindowStartUs = 0;
+    int m_olderBaseline = 0;
+    Seqlock<PlayerStats> m_statsSnapshot;               // 只由 updateStats 写入
+    std::atomic_bool m_statsPending{ false };           // 已投递、尚未执行的统计刷新
+
+    MediaClock m_clock;                     // 呈现主时钟：音频设备位置优先，否则为系统时钟
+    std::atomic<double> m_avOffsetMs{ 0.0 };
+    std::atomic<double> m_presentationJitterMs{ 0.0 };
+    std::atomic<double> m_videoLatenessMs{ 0.0 };       // 最近解码帧相对主时钟的迟到量
+    std::atomic<quint64> m_lateDroppedFrames{ 0 };      // 因迟到在呈现前丢弃的帧数
+
+    // 延迟上限：超出时追赶或跳到最新关键帧
+    std::atomic<int> m_maxLatencyMs{ 0 };
+    std::atomic<double> m_latestVideoPts{ 0.0 };        // 已接收的最新视频时间（秒）
+    std::atomic<double> m_latencyMs{ 0.0 };
+    std::atomic<quint64> m_latencyJumps{ 0 };
+    std::atomic_bool m_flushAudioDecoder{ false };      // 通知音频线程清空解码器
+    bool m_catchingUp = false;                          // 仅视频线程访问
+
+    // 音频时钟漂移补偿
+    std::atomic<double> m_audioBufferMs{ 0.0 };         // 环形缓冲 + 设备缓冲水位，由设备拉取回调测量
+    std::atomic<double> m_audioDriftPpm{ 0.0 };         // 估计的输入时钟相对声卡的偏差
+
+    // 音频后处理：软件增益、静音与电平
+    std::atomic<float> m_audioVolume{ 1.0f };
+    std::atomic_bool m_audioMuted{ false };
+    std::atomic<double> m_audioPeakDb{ -100.0 };        // 最近一个统计窗口的峰值电平
+    std::atomic<double> m_audioRmsDb{ -100.0 };
 
     std::atomic<double> m_bitrateKbps{ 0.0 };
     QString m_currentUrl;
@@ -272,6 +618,13 @@ private:
     std::atomic<int> m_maxReconnectAttempts{ 5 };
     std::atomic<int> m_reconnectDelayMs{ 2000 };
 
+    // 仅关键帧模式：解复用阶段丢弃非关键帧，解码器跳过非关键帧
+    std::atomic_bool m_keyframeOnly{ false };
+
+    // 转换目标尺寸（高 16 位宽、低 16 位高，0 表示源尺寸）与缩放质量
+    std::atomic<quint32> m_outputSize{ 0 };
+    std::atomic<int> m_scalingQuality{ static_cast<int>(VideoConverter::ScalingQuality::Bilinear) };
+
     // 异步停止相关：避免 UI 线程在 join 时卡顿
     std::shared_future<void> m_shutdownFuture;  // 异步停止任务的 future
     mutable std::mutex m_shutdownMutex;         // 保护 m_shutdownFuture 的互斥锁
@@ -7,18 +7,20 @@
  *   - MainWindow
  */
 
+#include "frametrace.h"
 #include "mainwindow.h"
 
 #include <QApplication>
 
  /**
-  * @brief Qt 应用程序入口，负责创建 QApplication 和 MainWindow。
+  * @brief Qt 应用程序入口，负责创建 QApplication 和 MainWindow，并把当前线程登记为帧追踪的 UI 线程。
   * @param argc 命令行参数数量。
   * @param argv 命令行参数数组。
   * @return Qt 事件循环退出码。
   */
 int main(int argc, char* argv[]) {
     QApplication a(argc, argv);
+    FrameTrace::setThreadName("ui");
     MainWindow w;
     w.show();
     return a.exec();
@@ -7,6 +7,7 @@
  *   - MainWindow::handleStatusChanged
  *   - MainWindow::handleStatsUpdated
  *   - MainWindow::handleError
+ *   - MainWindow::handleExportTrace
  *   - MainWindow::updateControlsForRunning
  * @mainclasses
  *   - MainWindow
@@ -14,9 +15,13 @@
 
 #include "mainwindow.h"
 
+#include "frametrace.h"
 #include "livestreamplayer.h"
 #include "videowidget.h"
 
+#include <QCheckBox>
+#include <QComboBox>
+#include <QFileDialog>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
@@ -27,6 +32,8 @@
 #include <QIcon>
 #include <QPixmap>
 
+#include <cmath>
+
  /**
   * @brief 构造主窗口并设置所有界面元素。
   * @param parent 父级 QWidget。
@@ -217,6 +224,43 @@ MainWindow::MainWindow(QWidget* parent)
     settingsLayout->addWidget(delayIconLabel);
     settingsLayout->addWidget(delayLabel);
     settingsLayout->addWidget(m_delaySpin);
+    settingsLayout->addSpacing(30);
+    auto* latencyLabel = new QLabel(QStringLiteral("最大延迟(ms):"), central);
+    latencyLabel->setObjectName("titleLabel");
+    m_maxLatencySpin = new QSpinBox(central);
+    m_maxLatencySpin->setRange(0, 10000);
+    m_maxLatencySpin->setSingleStep(100);
+    m_maxLatencySpin->setSpecialValueText(QStringLiteral("关闭"));
+    m_maxLatencySpin->setValue(0);
+    m_maxLatencySpin->setToolTip(QStringLiteral("缓冲超过该值时加速追赶，远超时跳到最新关键帧"));
+    settingsLayout->addWidget(latencyLabel);
+    settingsLayout->addWidget(m_maxLatencySpin);
+    settingsLayout->addSpacing(30);
+    m_keyframeOnlyCheck = new QCheckBox(QStringLiteral("仅关键帧(低功耗)"), central);
+    m_keyframeOnlyCheck->setToolTip(QStringLiteral("只解码关键帧，适用于多路预览；取消后在下一个关键帧恢复完整解码"));
+    settingsLayout->addWidget(m_keyframeOnlyCheck);
+    settingsLayout->addSpacing(30);
+    auto* volumeLabel = new QLabel(QStringLiteral("音量(%):"), central);
+    volumeLabel->setObjectName("titleLabel");
+    m_volumeSpin = new QSpinBox(central);
+    m_volumeSpin->setRange(0, 400);
+    m_volumeSpin->setSingleStep(10);
+    m_volumeSpin->setValue(100);
+    m_muteCheck = new QCheckBox(QStringLiteral("静音"), central);
+    m_muteCheck->setToolTip(QStringLiteral("静音时不输出音频，仍统计电平"));
+    settingsLayout->addWidget(volumeLabel);
+    settingsLayout->addWidget(m_volumeSpin);
+    settingsLayout->addWidget(m_muteCheck);
+    settingsLayout->addSpacing(30);
+    auto* scalingLabel = new QLabel(QStringLiteral("缩放质量:"), central);
+    scalingLabel->setObjectName("titleLabel");
+    m_scalingCombo = new QComboBox(central);
+    m_scalingCombo->addItem(QStringLiteral("最近邻"), static_cast<int>(VideoConverter::ScalingQuality::Point));
+    m_scalingCombo->addItem(QStringLiteral("快速双线性"), static_cast<int>(VideoConverter::ScalingQuality::FastBilinear));
+    m_scalingCombo->addItem(QStringLiteral("双线性"), static_cast<int>(VideoConverter::ScalingQuality::Bilinear));
+    m_scalingCombo->setCurrentIndex(2);
+    settingsLayout->addWidget(scalingLabel);
+    settingsLayout->addWidget(m_scalingCombo);
     settingsLayout->addStretch();
 
     auto* buttonLayout = new QHBoxLayout();
@@ -230,8 +274,15 @@ MainWindow::MainWindow(QWidget* parent)
     m_stopButton->setCursor(Qt::PointingHandCursor);
     m_stopButton->setIconSize(QSize(20, 20));
     m_stopButton->setEnabled(false);
+    m_traceCheck = new QCheckBox(QStringLiteral("帧追踪"), central);
+    m_traceCheck->setToolTip(QStringLiteral("记录每帧在读包、排队、解码、转换、呈现与绘制各阶段的时刻"));
+    m_traceExportButton = new QPushButton(QStringLiteral("导出追踪"), central);
+    m_traceExportButton->setToolTip(QStringLiteral("导出为 Chrome Trace JSON，可在 ui.perfetto.dev 或 chrome://tracing 中打开"));
     buttonLayout->addWidget(m_startButton);
     buttonLayout->addWidget(m_stopButton);
+    buttonLayout->addSpacing(30);
+    buttonLayout->addWidget(m_traceCheck);
+    buttonLayout->addWidget(m_traceExportButton);
     buttonLayout->addStretch();
 
     m_statusLabel = new QLabel(QStringLiteral("空闲中"), central);
@@ -252,8 +303,23 @@ MainWindow::MainWindow(QWidget* parent)
 
     connect(m_startButton, &QPushButton::clicked, this, &MainWindow::handleStart);
     connect(m_stopButton, &QPushButton::clicked, this, &MainWindow::handleStop);
-
-    connect(m_player, &LiveStreamPlayer::frameReady, m_videoWidget, &VideoWidget::updateFrame, Qt::QueuedConnection);
+    connect(m_keyframeOnlyCheck, &QCheckBox::toggled, m_player, &LiveStreamPlayer::setKeyframeOnly);
+    connect(m_maxLatencySpin, QOverload<int>::of(&QSpinBox::valueChanged), m_player, &LiveStreamPlayer::setMaxLatencyMs);
+    connect(m_volumeSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int percent) {
+        m_player->setVolume(percent / 100.0);
+    });
+    connect(m_muteCheck, &QCheckBox::toggled, m_player, &LiveStreamPlayer::setMuted);
+    connect(m_traceCheck, &QCheckBox::toggled, this, [](bool enabled) {
+        FrameTrace::setEnabled(enabled);
+    });
+    connect(m_traceExportButton, &QPushButton::clicked, this, &MainWindow::handleExportTrace);
+    connect(m_scalingCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int) {
+        m_player->setScalingQuality(static_cast<VideoConverter::ScalingQuality>(m_scalingCombo->currentData().toInt()));
+    });
+    // 显示区域尺寸变化时通知解码端，转换阶段直接输出显示尺寸
+    connect(m_videoWidget, &VideoWidget::displaySizeChanged, m_player, &LiveStreamPlayer::setOutputSize);
+
+    m_player->setFrameMailbox(m_videoWidget->frameMailbox());
     connect(m_player, &LiveStreamPlayer::statusChanged, this, &MainWindow::handleStatusChanged);
     connect(m_player, &LiveStreamPlayer::statsUpdated, this, &MainWindow::handleStatsUpdated);
     connect(m_player, &LiveStreamPlayer::errorOccurred, this, &MainWindow::handleError);
@@ -299,6 +365,10 @@ void MainWindow::handleStart() {
         m_player->setMaxReconnectAttempts(m_retrySpin->value());
     if (m_delaySpin)
         m_player->setReconnectDelayMs(m_delaySpin->value());
+    if (m_keyframeOnlyCheck)
+        m_player->setKeyframeOnly(m_keyframeOnlyCheck->isChecked());
+    if (m_maxLatencySpin)
+        m_player->setMaxLatencyMs(m_maxLatencySpin->value());
 
     updateControlsForRunning(true);
     m_player->start(url);
@@ -376,12 +446,41 @@ void MainWindow::handleStatsUpdated(const PlayerStats& stats) {
         return;
     }
 
-    m_statsLabel->setText(QStringLiteral("视频队列: %1 | 音频队列: %2 | 码率: %3 kbps | 抖动: %4 ms | 丢帧: %5")
+    const QString frameText = QStringLiteral("帧率: %1/%2/%3 fps (接收/解码/呈现) | 解码: %4/%5 ms | 转换: %6/%7 ms (p50/p99) | 卡顿: %8 次 %9 ms | 首帧: %10 | 重连: %11")
+        .arg(QString::number(stats.inputFps, 'f', 1))
+        .arg(QString::number(stats.decodedFps, 'f', 1))
+        .arg(QString::number(stats.presentedFps, 'f', 1))
+        .arg(QString::number(stats.decodeP50Ms, 'f', 1))
+        .arg(QString::number(stats.decodeP99Ms, 'f', 1))
+        .arg(QString::number(stats.convertP50Ms, 'f', 1))
+        .arg(QString::number(stats.convertP99Ms, 'f', 1))
+        .arg(stats.stallCount)
+        .arg(QString::number(stats.stallTotalMs, 'f', 0))
+        .arg(stats.timeToFirstFrameMs >= 0.0 ? QStringLiteral("%1 ms").arg(QString::number(stats.timeToFirstFrameMs, 'f', 0)) : QStringLiteral("-"))
+        .arg(stats.reconnectCount);
+
+    m_statsLabel->setText(frameText + QStringLiteral(" | ") + QStringLiteral("视频队列: %1 | 音频队列: %2 | 码率: %3 kbps | 抖动: %4 ms | 丢帧: %5 | 迟到丢弃: %9 | 覆盖: %8 | 音画偏差: %6 ms | 呈现抖动: %7 ms | 延迟: %10 ms (%11x, 跳转 %12) | 音频缓冲: %13 ms | 漂移: %14 ppm | 音频环形缓冲: %15 ms | 欠载: %16 | 裁剪: %17 | 直通: %18 | 电平: %19/%20 dBFS%21")
         .arg(stats.videoQueueSize)
         .arg(stats.audioQueueSize)
         .arg(QString::number(stats.incomingBitrateKbps, 'f', 1))
         .arg(QString::number(stats.jitterBufferMs, 'f', 1))
-        .arg(stats.droppedVideoFrames));
+        .arg(stats.droppedVideoFrames)
+        .arg(QString::number(stats.avOffsetMs, 'f', 1))
+        .arg(QString::number(stats.presentationJitterMs, 'f', 1))
+        .arg(stats.supersededFrames)
+        .arg(stats.lateDroppedFrames)
+        .arg(QString::number(stats.latencyMs, 'f', 0))
+        .arg(QString::number(stats.playbackRate, 'f', 2))
+        .arg(stats.latencyJumps)
+        .arg(QString::number(std::isfinite(stats.audioBufferMs) ? stats.audioBufferMs : 0.0, 'f', 0))
+        .arg(QString::number(stats.audioDriftPpm, 'f', 1))
+        .arg(QString::number(stats.audioRingMs, 'f', 0))
+        .arg(stats.audioUnderruns)
+        .arg(stats.audioTrimmedSamples)
+        .arg(stats.audioPassthrough ? QStringLiteral("是") : QStringLiteral("否"))
+        .arg(QString::number(stats.audioPeakDb, 'f', 1))
+        .arg(QString::number(stats.audioRmsDb, 'f', 1))
+        .arg(stats.audioMuted ? QStringLiteral(" (静音)") : QString()));
 }
 
 /**
@@ -399,6 +498,22 @@ void MainWindow::handleError(const QString& message) {
     m_statusLabel->setStyleSheet("background-color: white; border: 2px solid #ddd; border-radius: 6px; padding: 6px 12px; font-weight: bold; color: #F44336;");
 }
 
+/**
+ * @brief 导出当前保留的追踪记录，不影响正在进行的记录。
+ */
+void MainWindow::handleExportTrace() {
+    const QString path = QFileDialog::getSaveFileName(this, QStringLiteral("导出追踪"),
+        QStringLiteral("trace.json"), QStringLiteral("Chrome Trace (*.json)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QString error;
+    if (!FrameTrace::exportChromeTrace(path, &error)) {
+        QMessageBox::warning(this, QStringLiteral("导出失败"), error);
+    }
+}
+
 /**
  * @brief 根据运行状态切换开始/停止按钮可用性。
  * @param running 是否正在播放。
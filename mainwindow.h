@@ -7,6 +7,7 @@
  *   - handleStatusChanged
  *   - handleStatsUpdated
  *   - handleError
+ *   - handleExportTrace
  *   - updateControlsForRunning
  * @mainclasses
  *   - MainWindow
@@ -23,6 +24,8 @@ class QLineEdit;
 class QPushButton;
 class QLabel;
 class QSpinBox;
+class QCheckBox;
+class QComboBox;
 class VideoWidget;
 class LiveStreamPlayer;
 
@@ -73,6 +76,11 @@ private slots:
      */
     void handleError(const QString& message);
 
+    /**
+     * @brief 选择文件并导出逐帧追踪记录。
+     */
+    void handleExportTrace();
+
 private:
     /**
      * @brief 根据运行状态切换按钮可用性。
@@ -91,6 +99,13 @@ private:
     // Settings controls
     QSpinBox* m_retrySpin = nullptr; // 最大重试次数
     QSpinBox* m_delaySpin = nullptr; // 重试间隔(ms)
+    QSpinBox* m_maxLatencySpin = nullptr; // 延迟上限(ms)，0 为关闭
+    QCheckBox* m_keyframeOnlyCheck = nullptr; // 仅关键帧低功耗模式
+    QSpinBox* m_volumeSpin = nullptr; // 软件音量(%)
+    QCheckBox* m_muteCheck = nullptr; // 静音
+    QComboBox* m_scalingCombo = nullptr;      // 转换缩放质量
+    QCheckBox* m_traceCheck = nullptr;        // 逐帧追踪开关
+    QPushButton* m_traceExportButton = nullptr;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,134 @@
+/**
+ * @file mediaclock.cpp
+ * @brief 实现音频主时钟与系统时钟之间的锚定与外推。
+ * @mainfunctions
+ *   - MediaClock::setAudioTime
+ *   - MediaClock::setVideoTime
+ *   - MediaClock::time
+ * @mainclasses
+ *   - MediaClock
+ */
+
+#include "mediaclock.h"
+
+#include <cmath>
+#include <limits>
+
+extern "C"
+{
+#include <libavutil/time.h>
+}
+
+namespace {
+    constexpr int64_t kAudioMasterTimeoutUs = 1000 * 1000; // 音频超过 1 秒未更新则退回系统时钟
+}
+
+/**
+ * @brief 使用 FFmpeg 的单调时钟，与解复用超时等逻辑保持同一时间源。
+ * @return 微秒。
+ */
+int64_t MediaClock::nowUs() {
+    return av_gettime_relative();
+}
+
+/**
+ * @brief 清除锚点与音频状态，速率保持不变。
+ */
+void MediaClock::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_valid = false;
+    m_anchorPts = 0.0;
+    m_anchorUs = 0;
+    m_lastAudioUs = 0;
+}
+
+/**
+ * @brief 音频更新总是生效，并标记音频为主时钟。
+ * @param pts 播放位置。
+ * @param atUs 系统时间。
+ */
+void MediaClock::setAudioTime(double pts, int64_t atUs) {
+    if (!std::isfinite(pts)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_valid = true;
+    m_anchorPts = pts;
+    m_anchorUs = atUs;
+    m_lastAudioUs = atUs;
+}
+
+/**
+ * @brief 仅在没有有效音频主时钟时重新锚定。
+ * @param pts 视频帧时间。
+ * @param atUs 系统时间。
+ */
+void MediaClock::setVideoTime(double pts, int64_t atUs) {
+    if (!std::isfinite(pts)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_lastAudioUs != 0 && atUs - m_lastAudioUs < kAudioMasterTimeoutUs) {
+        return;
+    }
+    m_valid = true;
+    m_anchorPts = pts;
+    m_anchorUs = atUs;
+}
+
+/**
+ * @brief 按锚点与速率外推。
+ * @param atUs 系统时间。
+ * @return 媒体时间，未锚定时为 NaN。
+ */
+double MediaClock::time(int64_t atUs) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return timeLocked(atUs);
+}
+
+/**
+ * @brief 判断音频更新是否仍然新鲜。
+ * @param atUs 系统时间。
+ * @return true 表示音频为主时钟。
+ */
+bool MediaClock::isAudioMaster(int64_t atUs) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastAudioUs != 0 && atUs - m_lastAudioUs < kAudioMasterTimeoutUs;
+}
+
+/**
+ * @brief 调整速率前把锚点推进到当前时刻。
+ * @param rate 新速率。
+ */
+void MediaClock::setRate(double rate) {
+    if (!(rate > 0.0)) {
+        return;
+    }
+    const int64_t now = nowUs();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_valid) {
+        m_anchorPts = timeLocked(now);
+        m_anchorUs = now;
+    }
+    m_rate.store(rate, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 返回当前速率。
+ * @return 速率。
+ */
+double MediaClock::rate() const {
+    return m_rate.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 外推实现。
+ * @param atUs 系统时间。
+ * @return 媒体时间。
+ */
+double MediaClock::timeLocked(int64_t atUs) const {
+    if (!m_valid) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return m_anchorPts + static_cast<double>(atUs - m_anchorUs) * 1e-6 * m_rate.load(std::memory_order_relaxed);
+}
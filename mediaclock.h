@@ -0,0 +1,95 @@
+/**
+ * @file mediaclock.h
+ * @brief 定义播放主时钟，音频存在时以音频设备播放位置为准，否则以系统单调时钟推进。
+ * @mainfunctions
+ *   - setAudioTime
+ *   - setVideoTime
+ *   - time
+ *   - setRate
+ *   - reset
+ * @mainclasses
+ *   - MediaClock
+ */
+
+#ifndef MEDIACLOCK_H
+#define MEDIACLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief MediaClock 给出“当前应当呈现的媒体时间”（秒，与流 pts 同一时间轴）。
+ *
+ * 时钟由锚点 (pts, 系统时间) 加速率外推得到。音频输出每次写入后用设备实际播放位置更新锚点，
+ * 成为主时钟；音频长时间未更新（无音轨、设备停滞）时退回视频锚定的系统时钟，
+ * 两者共用同一锚点，因此切换时不会跳变。
+ */
+class MediaClock {
+public:
+    /**
+     * @brief 返回单调时钟的当前时间。
+     * @return 微秒。
+     */
+    static int64_t nowUs();
+
+    /**
+     * @brief 清除锚点，下一次更新重新建立时钟。
+     */
+    void reset();
+
+    /**
+     * @brief 以音频设备播放位置更新时钟。
+     * @param pts 设备此刻正在播放的样本时间（秒）。
+     * @param atUs 对应的系统时间（微秒）。
+     */
+    void setAudioTime(double pts, int64_t atUs);
+
+    /**
+     * @brief 以视频帧重新锚定时钟；音频主时钟有效时忽略。
+     * @param pts 视频帧时间（秒）。
+     * @param atUs 对应的系统时间（微秒）。
+     */
+    void setVideoTime(double pts, int64_t atUs);
+
+    /**
+     * @brief 查询指定时刻的媒体时间。
+     * @param atUs 系统时间（微秒）。
+     * @return 媒体时间（秒），尚未锚定时返回 NaN。
+     */
+    double time(int64_t atUs) const;
+
+    /**
+     * @brief 查询音频是否为当前主时钟。
+     * @param atUs 系统时间（微秒）。
+     * @return true 表示最近有音频更新。
+     */
+    bool isAudioMaster(int64_t atUs) const;
+
+    /**
+     * @brief 设置播放速率，锚点先移到当前时刻以保证时钟连续。
+     * @param rate 速率，1.0 为正常速度。
+     */
+    void setRate(double rate);
+
+    /**
+     * @brief 查询播放速率，不加锁，供统计读取。
+     * @return 当前速率。
+     */
+    double rate() const;
+
+private:
+    /**
+     * @brief 计算外推时间，调用方需持有锁。
+     */
+    double timeLocked(int64_t atUs) const;
+
+    mutable std::mutex m_mutex;
+    bool m_valid = false;
+    double m_anchorPts = 0.0;
+    int64_t m_anchorUs = 0;
+    int64_t m_lastAudioUs = 0;   // 最近一次音频更新的系统时间，0 表示从未更新
+    std::atomic<double> m_rate{ 1.0 };   // 只在持锁时写入，读取统计时不加锁
+};
+
+#endif // MEDIACLOCK_H
@@ -0,0 +1,478 @@
+/**
+ * @file networkimpairment.cpp
+ * @brief 实现损伤脚本解析、跨重连的断线状态与模拟链路的排期和读取。
+ * @mainfunctions
+ *   - ImpairmentProfile::parse
+ *   - ImpairedInput::open
+ *   - ImpairedInput::linkLoop
+ *   - ImpairedInput::readPacket
+ * @mainclasses
+ *   - ImpairmentProfile
+ *   - NetworkImpairment
+ *   - ImpairedInput
+ */
+
+#include "networkimpairment.h"
+
+#include <QByteArray>
+#include <QStringList>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+extern "C"
+{
+#include <libavutil/mem.h>
+#include <libavutil/time.h>
+}
+
+namespace {
+    constexpr int kChunkBytes = 16 * 1024;              // 链路线程单次读取上限
+    constexpr size_t kMaxQueuedBytes = 4 * 1024 * 1024; // 链路上在途数据上限（类似 TCP 窗口）
+    constexpr int kIoBufferBytes = 32 * 1024;           // 自定义 AVIOContext 的缓冲
+    constexpr int64_t kPollUs = 10000;                  // 等待时检查停止请求的间隔
+
+    // Qt 5.14 起 QString::SkipEmptyParts 已弃用
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    constexpr auto kSkipEmptyParts = Qt::SkipEmptyParts;
+#else
+    constexpr auto kSkipEmptyParts = QString::SkipEmptyParts;
+#endif
+
+    /**
+     * @brief 写入失败原因。
+     * @param error 输出参数，可为空。
+     * @param message 原因。
+     * @return 总是 false，便于直接 return。
+     */
+    bool fail(QString* error, const QString& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 解析非负数值。
+     * @param text 文本。
+     * @param value 输出参数。
+     * @return 有效时返回 true。
+     */
+    bool parseNonNegative(const QString& text, double* value) {
+        bool ok = false;
+        *value = text.toDouble(&ok);
+        return ok && *value >= 0.0 && std::isfinite(*value);
+    }
+}
+
+/**
+ * @brief 逐段解析，每段先复制上一段的参数再覆盖写出的键。
+ * @param spec 脚本。
+ * @param profile 输出参数。
+ * @param error 可选输出参数。
+ * @return 解析成功返回 true。
+ */
+bool ImpairmentProfile::parse(const QString& spec, ImpairmentProfile* profile, QString* error) {
+    ImpairmentProfile result;
+    result.m_phases.clear();
+    Phase previous;
+    const QStringList segments = spec.split(QLatin1Char(';'), kSkipEmptyParts);
+    for (const QString& rawSegment : segments) {
+        QString segment = rawSegment.trimmed();
+        Phase phase = previous;
+        phase.disconnect = false;
+        if (segment.startsWith(QLatin1Char('@'))) {
+            const int colon = segment.indexOf(QLatin1Char(':'));
+            if (colon < 0 || !parseNonNegative(segment.mid(1, colon - 1), &phase.startSec)) {
+                return fail(error, QStringLiteral("无效的段起点：%1").arg(segment));
+            }
+            segment = segment.mid(colon + 1);
+        }
+        else if (!result.m_phases.empty()) {
+            return fail(error, QStringLiteral("第二段起必须以 @秒: 开头：%1").arg(segment));
+        }
+        if (!result.m_phases.empty() && phase.startSec <= result.m_phases.back().startSec) {
+            return fail(error, QStringLiteral("段起点必须递增：%1").arg(segment));
+        }
+
+        const QStringList items = segment.split(QLatin1Char(','), kSkipEmptyParts);
+        for (const QString& rawItem : items) {
+            const QString item = rawItem.trimmed();
+            const int equals = item.indexOf(QLatin1Char('='));
+            const QString key = (equals < 0 ? item : item.left(equals)).trimmed().toLower();
+            const QString value = equals < 0 ? QString() : item.mid(equals + 1).trimmed();
+            bool ok = true;
+            if (key == QLatin1String("disconnect")) {
+                phase.disconnect = true;
+            }
+            else if (key == QLatin1String("latency")) {
+                ok = parseNonNegative(value, &phase.latencyMs);
+            }
+            else if (key == QLatin1String("jitter")) {
+                ok = parseNonNegative(value, &phase.jitterMs);
+            }
+            else if (key == QLatin1String("bandwidth")) {
+                ok = parseNonNegative(value, &phase.bandwidthKbps);
+            }
+            else if (key == QLatin1String("rate")) {
+                ok = parseNonNegative(value, &phase.sourceRateKbps);
+            }
+            else if (key == QLatin1String("outage")) {
+                ok = parseNonNegative(value, &phase.outageMs);
+            }
+            else if (key == QLatin1String("stall")) {
+                const int colon = value.indexOf(QLatin1Char(':'));
+                ok = colon > 0 && parseNonNegative(value.left(colon), &phase.stallPeriodSec)
+                    && parseNonNegative(value.mid(colon + 1), &phase.stallMs)
+                    && (phase.stallMs == 0.0 || phase.stallMs < phase.stallPeriodSec * 1000.0);
+            }
+            else if (key == QLatin1String("seed")) {
+                result.m_seed = value.toUInt(&ok);
+            }
+            else {
+                return fail(error, QStringLiteral("未知的参数：%1").arg(key));
+            }
+            if (!ok) {
+                return fail(error, QStringLiteral("无效的取值：%1").arg(item));
+            }
+        }
+
+        if (result.m_phases.empty() && phase.startSec > 0.0) {
+            result.m_phases.push_back(Phase{});  // 第一段之前不施加损伤
+        }
+        result.m_phases.push_back(phase);
+        previous = phase;
+    }
+    if (result.m_phases.empty()) {
+        result.m_phases.push_back(Phase{});
+    }
+    if (result.m_seed == 0) {
+        result.m_seed = 1;  // xorshift 的状态不能为 0
+    }
+    *profile = std::move(result);
+    return true;
+}
+
+/**
+ * @brief 段数很少，线性查找。
+ * @param seconds 相对模拟起点的秒数。
+ * @param index 可选输出参数。
+ * @return 段参数。
+ */
+const ImpairmentProfile::Phase& ImpairmentProfile::phaseAt(double seconds, int* index) const {
+    size_t found = 0;
+    for (size_t i = 1; i < m_phases.size() && m_phases[i].startSec <= seconds; ++i) {
+        found = i;
+    }
+    if (index) {
+        *index = static_cast<int>(found);
+    }
+    return m_phases[found];
+}
+
+/**
+ * @brief 返回种子。
+ * @return 种子。
+ */
+uint32_t ImpairmentProfile::seed() const {
+    return m_seed;
+}
+
+/**
+ * @brief 记录模拟起点。
+ * @param profile 损伤脚本。
+ */
+NetworkImpairment::NetworkImpairment(std::shared_ptr<const ImpairmentProfile> profile)
+    : m_profile(std::move(profile)), m_epochUs(av_gettime_relative()) {
+}
+
+/**
+ * @brief 返回脚本。
+ * @return 脚本。
+ */
+const ImpairmentProfile& NetworkImpairment::profile() const {
+    return *m_profile;
+}
+
+/**
+ * @brief 换算为秒。
+ * @param nowUs 单调时钟（微秒）。
+ * @return 秒。
+ */
+double NetworkImpairment::elapsedSec(int64_t nowUs) const {
+    return static_cast<double>(nowUs - m_epochUs) / 1e6;
+}
+
+/**
+ * @brief 记录不可达期限。
+ * @param nowUs 断线时刻。
+ * @param outageMs 不可达时长。
+ */
+void NetworkImpairment::disconnect(int64_t nowUs, double outageMs) {
+    m_unreachableUntilUs.store(nowUs + static_cast<int64_t>(outageMs * 1000.0), std::memory_order_relaxed);
+}
+
+/**
+ * @brief 与不可达期限比较。
+ * @param nowUs 单调时钟（微秒）。
+ * @return 可连接时返回 true。
+ */
+bool NetworkImpairment::isReachable(int64_t nowUs) const {
+    return nowUs >= m_unreachableUntilUs.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 保存会话状态，抖动序列以脚本种子初始化。
+ * @param impairment 会话共享状态。
+ */
+ImpairedInput::ImpairedInput(std::shared_ptr<NetworkImpairment> impairment)
+    : m_impairment(std::move(impairment)), m_randomState(m_impairment->profile().seed()) {
+}
+
+/**
+ * @brief 先停链路线程，再释放两端的 I/O。
+ */
+ImpairedInput::~ImpairedInput() {
+    m_stop.store(true, std::memory_order_release);
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (m_io) {
+        av_freep(&m_io->buffer);
+        avio_context_free(&m_io);
+    }
+    if (m_inner) {
+        avio_closep(&m_inner);
+    }
+}
+
+/**
+ * @brief 模拟断线期间直接拒绝连接；否则打开真实输入并创建读回调驱动的 AVIOContext。
+ * @param url 输入地址。
+ * @param interrupt 播放器的中断回调。
+ * @return 0 或 FFmpeg 错误码。
+ */
+int ImpairedInput::open(const QString& url, const AVIOInterruptCB& interrupt) {
+    m_interrupt = interrupt;
+    const int64_t nowUs = av_gettime_relative();
+    if (!m_impairment->isReachable(nowUs)) {
+        return AVERROR(ECONNREFUSED);
+    }
+
+    const AVIOInterruptCB innerInterrupt{ &ImpairedInput::innerInterruptCallback, this };
+    int ret = avio_open2(&m_inner, url.toUtf8().constData(), AVIO_FLAG_READ, &innerInterrupt, nullptr);
+    if (ret < 0) {
+        return ret;
+    }
+    auto* buffer = static_cast<unsigned char*>(av_malloc(kIoBufferBytes));
+    if (!buffer) {
+        return AVERROR(ENOMEM);
+    }
+    m_io = avio_alloc_context(buffer, kIoBufferBytes, 0, this, &ImpairedInput::readPacket, nullptr, nullptr);
+    if (!m_io) {
+        av_free(buffer);
+        return AVERROR(ENOMEM);
+    }
+    m_io->seekable = 0;
+
+    m_linkFreeUs = nowUs;
+    m_lastDeliverUs = nowUs;
+    m_thread = std::thread(&ImpairedInput::linkLoop, this);
+    return 0;
+}
+
+/**
+ * @brief 返回自定义 I/O。
+ * @return I/O 上下文。
+ */
+AVIOContext* ImpairedInput::context() const {
+    return m_io;
+}
+
+/**
+ * @brief 按源速率读取真实输入并交给 enqueue 排期；进入带 disconnect 的段时插入断线标记并结束，
+ *        打开时已处于的段不触发断线，避免重连后立即再次断开。真实输入结束或出错时同样以标记结束。
+ */
+void ImpairedInput::linkLoop() {
+    const ImpairmentProfile& profile = m_impairment->profile();
+    int64_t nowUs = av_gettime_relative();
+    int phaseIndex = 0;
+    profile.phaseAt(m_impairment->elapsedSec(nowUs), &phaseIndex);
+    double rateKbps = -1.0;
+    int64_t rateBaseUs = nowUs;
+    int64_t sentBytes = 0;
+
+    while (!interrupted()) {
+        nowUs = av_gettime_relative();
+        int index = 0;
+        const ImpairmentProfile::Phase& phase = profile.phaseAt(m_impairment->elapsedSec(nowUs), &index);
+        if (index != phaseIndex) {
+            phaseIndex = index;
+            if (phase.disconnect) {
+                m_impairment->disconnect(nowUs, phase.outageMs);
+                Chunk marker;
+                marker.error = AVERROR(ECONNRESET);
+                enqueue(std::move(marker), nowUs, phase);  // 断线标记排在已发出的数据之后
+                break;
+            }
+        }
+
+        if (phase.sourceRateKbps != rateKbps) {
+            rateKbps = phase.sourceRateKbps;
+            rateBaseUs = nowUs;
+            sentBytes = 0;
+        }
+        if (rateKbps > 0.0) {
+            const int64_t dueUs = rateBaseUs + static_cast<int64_t>(static_cast<double>(sentBytes) * 8000.0 / rateKbps);
+            if (nowUs < dueUs) {
+                std::this_thread::sleep_for(std::chrono::microseconds(std::min(dueUs - nowUs, kPollUs)));
+                continue;
+            }
+        }
+
+        Chunk chunk;
+        chunk.data.resize(kChunkBytes);
+        const int bytes = avio_read_partial(m_inner, chunk.data.data(), kChunkBytes);
+        if (bytes == 0) {
+            continue;
+        }
+        if (bytes < 0) {
+            Chunk marker;
+            marker.error = bytes;
+            enqueue(std::move(marker), av_gettime_relative(), phase);
+            break;
+        }
+        chunk.data.resize(static_cast<size_t>(bytes));
+        sentBytes += bytes;
+        if (!enqueue(std::move(chunk), av_gettime_relative(), phase)) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_linkFinished = true;
+    m_cv.notify_all();
+}
+
+/**
+ * @brief 到达时刻 = 带宽串行化后的发送完成时刻 + 延迟 + 抖动，且不早于前一块（按序交付，抖动表现为成簇到达）；
+ *        落在停顿窗口（每个周期的末尾）内的数据推迟到窗口结束，形成停顿后的突发。
+ * @param chunk 数据块。
+ * @param sendUs 发送时刻。
+ * @param phase 生效的段。
+ * @return 链路仍在运行时返回 true。
+ */
+bool ImpairedInput::enqueue(Chunk chunk, int64_t sendUs, const ImpairmentProfile::Phase& phase) {
+    const size_t bytes = chunk.data.size();
+    const int64_t transmitUs = phase.bandwidthKbps > 0.0
+        ? static_cast<int64_t>(static_cast<double>(bytes) * 8000.0 / phase.bandwidthKbps) : 0;
+    m_linkFreeUs = std::max(sendUs, m_linkFreeUs) + transmitUs;
+    int64_t deliverUs = m_linkFreeUs + static_cast<int64_t>(phase.latencyMs * 1000.0) + sampleJitterUs(phase.jitterMs);
+    deliverUs = std::max(deliverUs, m_lastDeliverUs);
+    if (phase.stallPeriodSec > 0.0 && phase.stallMs > 0.0) {
+        const double position = std::fmod(m_impairment->elapsedSec(deliverUs), phase.stallPeriodSec);
+        const double stallStart = phase.stallPeriodSec - phase.stallMs / 1000.0;
+        if (position >= stallStart) {
+            deliverUs += static_cast<int64_t>((phase.stallPeriodSec - position) * 1e6);
+        }
+    }
+    m_lastDeliverUs = deliverUs;
+    chunk.deliverUs = deliverUs;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_queuedBytes + bytes > kMaxQueuedBytes && !m_chunks.empty()) {
+        if (interrupted()) {
+            return false;
+        }
+        m_cv.wait_for(lock, std::chrono::microseconds(kPollUs));
+    }
+    m_queuedBytes += bytes;
+    m_chunks.push_back(std::move(chunk));
+    m_cv.notify_all();
+    return true;
+}
+
+/**
+ * @brief xorshift32 取均匀分布。
+ * @param jitterMs 抖动幅度。
+ * @return 微秒。
+ */
+int64_t ImpairedInput::sampleJitterUs(double jitterMs) {
+    if (jitterMs <= 0.0) {
+        return 0;
+    }
+    m_randomState ^= m_randomState << 13;
+    m_randomState ^= m_randomState >> 17;
+    m_randomState ^= m_randomState << 5;
+    const double unit = static_cast<double>(m_randomState) / 4294967295.0 * 2.0 - 1.0;
+    return static_cast<int64_t>(unit * jitterMs * 1000.0);
+}
+
+/**
+ * @brief 合并自身的停止标志与播放器的中断回调。
+ * @return 应中止时返回 true。
+ */
+bool ImpairedInput::interrupted() const {
+    if (m_stop.load(std::memory_order_acquire)) {
+        return true;
+    }
+    return m_interrupt.callback && m_interrupt.callback(m_interrupt.opaque) != 0;
+}
+
+/**
+ * @brief 拷贝已到达的数据（可跨多个数据块），没有到达的数据时等待；到达的断线或结束标记保留在队首，
+ *        之后的读取持续返回同一错误。
+ * @param opaque ImpairedInput 指针。
+ * @param buffer 目标缓冲。
+ * @param size 缓冲大小。
+ * @return 读取的字节数或 FFmpeg 错误码。
+ */
+int ImpairedInput::readPacket(void* opaque, uint8_t* buffer, int size) {
+    auto* self = static_cast<ImpairedInput*>(opaque);
+    std::unique_lock<std::mutex> lock(self->m_mutex);
+    for (;;) {
+        if (self->interrupted()) {
+            return AVERROR_EXIT;
+        }
+        const int64_t nowUs = av_gettime_relative();
+        if (!self->m_chunks.empty() && self->m_chunks.front().deliverUs <= nowUs) {
+            if (self->m_chunks.front().error != 0) {
+                return self->m_chunks.front().error;
+            }
+            int copied = 0;
+            while (copied < size && !self->m_chunks.empty()) {
+                Chunk& front = self->m_chunks.front();
+                if (front.error != 0 || front.deliverUs > nowUs) {
+                    break;
+                }
+                const size_t count = std::min(front.data.size() - front.offset, static_cast<size_t>(size - copied));
+                std::memcpy(buffer + copied, front.data.data() + front.offset, count);
+                copied += static_cast<int>(count);
+                front.offset += count;
+                if (front.offset == front.data.size()) {
+                    self->m_queuedBytes -= front.data.size();
+                    self->m_chunks.pop_front();
+                }
+            }
+            self->m_cv.notify_all();
+            return copied;
+        }
+        if (self->m_chunks.empty() && self->m_linkFinished) {
+            return AVERROR_EOF;
+        }
+        const int64_t waitUs = self->m_chunks.empty() ? kPollUs : std::min(self->m_chunks.front().deliverUs - nowUs, kPollUs);
+        self->m_cv.wait_for(lock, std::chrono::microseconds(waitUs));
+    }
+}
+
+/**
+ * @brief 真实输入阻塞读取时的中断判断。
+ * @param opaque ImpairedInput 指针。
+ * @return 非零表示中断。
+ */
+int ImpairedInput::innerInterruptCallback(void* opaque) {
+    return static_cast<const ImpairedInput*>(opaque)->interrupted() ? 1 : 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file networkimpairment.h
+ * @brief 定义网络损伤模拟：按脚本化的配置对送往解复用器的字节流施加延迟、抖动、带宽上限、
+ *        停顿后突发与断线，用于在本地调节抖动缓冲与验证重连逻辑，不依赖需要 root 权限的 netem。
+ * @mainfunctions
+ *   - ImpairmentProfile::parse
+ *   - ImpairmentProfile::phaseAt
+ *   - NetworkImpairment::isReachable
+ *   - ImpairedInput::open
+ *   - ImpairedInput::context
+ * @mainclasses
+ *   - ImpairmentProfile
+ *   - NetworkImpairment
+ *   - ImpairedInput
+ */
+
+#ifndef NETWORKIMPAIRMENT_H
+#define NETWORKIMPAIRMENT_H
+
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+/**
+ * @brief ImpairmentProfile 是按时间分段的损伤脚本。
+ *
+ * 文本格式：各段以分号分隔，段首可用 "@秒:" 指定开始时刻（首段默认从 0 开始），段内为逗号分隔的 key=value：
+ *   latency=毫秒  jitter=毫秒  bandwidth=kbps  rate=kbps（源端发送速率，0 为不限）
+ *   stall=周期秒:时长毫秒（周期性停顿，停顿结束时积压数据突发到达）
+ *   disconnect（进入该段时断开连接）  outage=毫秒（断开后源端不可达的时长）  seed=整数
+ * 例如 "latency=80,jitter=30,bandwidth=6000;@20:stall=5:800;@40:disconnect,outage=3000;@45:latency=80"。
+ * 未写出的参数沿用上一段的取值，disconnect 只作用于所在段。
+ */
+class ImpairmentProfile {
+public:
+    /**
+     * @brief 一段时间内生效的损伤参数。
+     */
+    struct Phase {
+        double startSec = 0.0;
+        double latencyMs = 0.0;
+        double jitterMs = 0.0;
+        double bandwidthKbps = 0.0;     // 0 表示不限
+        double sourceRateKbps = 0.0;    // 0 表示按源的速度读取
+        double stallPeriodSec = 0.0;    // 0 表示不停顿
+        double stallMs = 0.0;
+        bool disconnect = false;
+        double outageMs = 0.0;
+    };
+
+    /**
+     * @brief 解析脚本文本。
+     * @param spec 脚本。
+     * @param profile 输出参数。
+     * @param error 可选输出参数，格式错误时的说明。
+     * @return 解析成功返回 true。
+     */
+    static bool parse(const QString& spec, ImpairmentProfile* profile, QString* error = nullptr);
+
+    /**
+     * @brief 查找给定时刻生效的段。
+     * @param seconds 相对模拟起点的秒数。
+     * @param index 可选输出参数，段下标。
+     * @return 段参数。
+     */
+    const Phase& phaseAt(double seconds, int* index = nullptr) const;
+
+    /**
+     * @brief 抖动采样使用的随机种子，固定种子使每次运行的损伤序列相同。
+     * @return 种子。
+     */
+    uint32_t seed() const;
+
+private:
+    std::vector<Phase> m_phases{ Phase{} };
+    uint32_t m_seed = 1;
+};
+
+/**
+ * @brief NetworkImpairment 保存一次播放会话内跨重连共享的模拟状态：脚本、时间起点与断线后的不可达期限。
+ */
+class NetworkImpairment {
+public:
+    /**
+     * @brief 以当前时刻为模拟起点。
+     * @param profile 损伤脚本。
+     */
+    explicit NetworkImpairment(std::shared_ptr<const ImpairmentProfile> profile);
+
+    /**
+     * @brief 获取脚本。
+     * @return 脚本。
+     */
+    const ImpairmentProfile& profile() const;
+
+    /**
+     * @brief 当前时刻相对模拟起点的秒数。
+     * @param nowUs 单调时钟（微秒）。
+     * @return 秒。
+     */
+    double elapsedSec(int64_t nowUs) const;
+
+    /**
+     * @brief 模拟断线，源端在给定时长内拒绝连接。
+     * @param nowUs 断线时刻。
+     * @param outageMs 不可达时长。
+     */
+    void disconnect(int64_t nowUs, double outageMs);
+
+    /**
+     * @brief 源端当前是否可连接。
+     * @param nowUs 单调时钟（微秒）。
+     * @return 可连接时返回 true。
+     */
+    bool isReachable(int64_t nowUs) const;
+
+private:
+    std::shared_ptr<const ImpairmentProfile> m_profile;
+    int64_t m_epochUs = 0;
+    std::atomic<int64_t> m_unreachableUntilUs{ 0 };
+};
+
+/**
+ * @brief ImpairedInput 在真实输入与解复用器之间插入一条模拟链路。
+ *
+ * 链路线程从真实输入读取数据块，按源速率、带宽串行化、延迟与抖动（保持顺序）计算每块的到达时刻，
+ * 放入有界队列；解复用器通过自定义 AVIOContext 读取，数据块到达前阻塞等待。队列写满时链路线程停止读取，
+ * 相当于 TCP 窗口的反压。只适用于字节流输入（文件、tcp、http、rtmp、udp 上的 TS 等），RTSP 由其自身的
+ * 解复用器收发，不经过这一层。
+ */
+class ImpairedInput {
+public:
+    /**
+     * @brief 构造，尚未打开。
+     * @param impairment 会话共享状态。
+     */
+    explicit ImpairedInput(std::shared_ptr<NetworkImpairment> impairment);
+    ImpairedInput(const ImpairedInput&) = delete;
+    ImpairedInput& operator=(const ImpairedInput&) = delete;
+
+    /**
+     * @brief 停止链路线程并释放真实输入与自定义 I/O。
+     */
+    ~ImpairedInput();
+
+    /**
+     * @brief 打开真实输入并启动链路线程。
+     * @param url 输入地址。
+     * @param interrupt 播放器的中断回调，停止时打断阻塞的读取与等待。
+     * @return 0 表示成功，否则为 FFmpeg 错误码（模拟不可达时为 AVERROR(ECONNREFUSED)）。
+     */
+    int open(const QString& url, const AVIOInterruptCB& interrupt);
+
+    /**
+     * @brief 供 AVFormatContext::pb 使用的自定义 I/O，需同时设置 AVFMT_FLAG_CUSTOM_IO。
+     * @return I/O 上下文，未打开时为空。
+     */
+    AVIOContext* context() const;
+
+private:
+    /**
+     * @brief 链路上的一个数据块；data 为空且 error 非 0 表示在该时刻断开。
+     */
+    struct Chunk {
+        std::vector<uint8_t> data;
+        size_t offset = 0;
+        int64_t deliverUs = 0;
+        int error = 0;
+    };
+
+    /**
+     * @brief 链路线程主循环。
+     */
+    void linkLoop();
+
+    /**
+     * @brief 计算数据块的到达时刻并入队，队列满时等待。
+     * @param chunk 数据块。
+     * @param sendUs 发送时刻。
+     * @param phase 生效的段。
+     * @return 链路仍在运行时返回 true。
+     */
+    bool enqueue(Chunk chunk, int64_t sendUs, const ImpairmentProfile::Phase& phase);
+
+    /**
+     * @brief 均匀分布的抖动采样（xorshift，跨平台可复现）。
+     * @param jitterMs 抖动幅度。
+     * @return [-jitterMs, jitterMs] 内的微秒数。
+     */
+    int64_t sampleJitterUs(double jitterMs);
+
+    /**
+     * @brief 是否应中止等待：析构或播放器请求停止。
+     * @return 应中止时返回 true。
+     */
+    bool interrupted() const;
+
+    /**
+     * @brief 自定义 I/O 的读回调。
+     */
+    static int readPacket(void* opaque, uint8_t* buffer, int size);
+
+    /**
+     * @brief 真实输入的中断回调。
+     */
+    static int innerInterruptCallback(void* opaque);
+
+    std::shared_ptr<NetworkImpairment> m_impairment;
+    AVIOInterruptCB m_interrupt{};
+    AVIOContext* m_inner = nullptr;
+    AVIOContext* m_io = nullptr;
+    std::thread m_thread;
+    std::atomic_bool m_stop{ false };
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Chunk> m_chunks;
+    size_t m_queuedBytes = 0;
+    bool m_linkFinished = false;
+
+    // 仅链路线程访问
+    int64_t m_linkFreeUs = 0;       // 带宽串行化：链路空闲的时刻
+    int64_t m_lastDeliverUs = 0;    // 保持顺序：到达时刻不早于前一块
+    uint32_t m_randomState = 1;
+};
+
+#endif // NETWORKIMPAIRMENT_H
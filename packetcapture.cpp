@@ -0,0 +1,699 @@
+/**
+ * @file packetcapture.cpp
+ * @brief 实现抓取文件的序列化、后台写入与内存映射回放。
+ * @mainfunctions
+ *   - PacketCaptureWriter::beginSegment
+ *   - PacketCaptureWriter::writerLoop
+ *   - PacketCaptureReader::openSegment
+ *   - PacketCaptureReader::read
+ * @mainclasses
+ *   - PacketCaptureWriter
+ *   - PacketCaptureReader
+ */
+
+#include "packetcapture.h"
+
+#include <cstring>
+#include <utility>
+
+extern "C"
+{
+#include <libavutil/channel_layout.h>
+#include <libavutil/mem.h>
+#include <libavutil/time.h>
+}
+
+namespace {
+    constexpr char kMagic[8] = { 'L', 'S', 'P', 'C', 'A', 'P', '0', '1' };
+    constexpr uint32_t kVersion = 2;                    // 2：流记录覆盖全部编解码参数，并带记录长度
+    constexpr uint32_t kByteOrderMark = 0x01020304u;
+    constexpr uint32_t kRecordSegment = 1;
+    constexpr uint32_t kRecordPacket = 2;
+    constexpr size_t kMaxPendingBytes = 64 * 1024 * 1024;  // 写线程落后时允许排队的数据量
+    constexpr qint64 kRecordAlignment = 8;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+    };
+
+    struct RecordHeader {
+        uint32_t type;
+        uint32_t size;      // 负载字节数（已对齐）
+    };
+
+    // 逐项对应 AVCodecParameters 的标量字段与所属流的时间参数；新增字段只能追加在末尾
+    struct StreamRecord {
+        int32_t codecType;
+        int32_t codecId;
+        uint32_t codecTag;
+        int32_t format;
+        int64_t bitRate;
+        int32_t bitsPerCodedSample;
+        int32_t bitsPerRawSample;
+        int32_t profile;
+        int32_t level;
+        int32_t width;
+        int32_t height;
+        int32_t sampleAspectNum;
+        int32_t sampleAspectDen;
+        int32_t frameRateNum;       // 编解码参数中的帧率（FFmpeg 6.1 起），更早的版本为 0/0
+        int32_t frameRateDen;
+        int32_t fieldOrder;
+        int32_t colorRange;
+        int32_t colorPrimaries;
+        int32_t colorTrc;
+        int32_t colorSpace;
+        int32_t chromaLocation;
+        int32_t videoDelay;
+        int32_t channelOrder;
+        int32_t channels;
+        int32_t sampleRate;
+        int32_t blockAlign;
+        int32_t frameSize;
+        int32_t initialPadding;
+        int32_t trailingPadding;
+        int32_t seekPreroll;
+        int32_t timeBaseNum;
+        int32_t timeBaseDen;
+        int32_t avgFrameRateNum;
+        int32_t avgFrameRateDen;
+        int32_t realFrameRateNum;
+        int32_t realFrameRateDen;
+        int32_t reserved;
+        uint64_t channelMask;       // 原生与 Ambisonic 顺序的声道掩码
+        uint32_t extradataSize;
+        uint32_t customChannels;    // 自定义顺序时随后的声道编号个数（每个 int32，整体按记录对齐）
+    };
+
+    struct PacketRecord {
+        int64_t arrivalUs;
+        int64_t pts;
+        int64_t dts;
+        int64_t duration;
+        int32_t streamIndex;
+        int32_t flags;
+        uint32_t size;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(FileHeader) % kRecordAlignment == 0, "FileHeader must keep records aligned");
+    static_assert(sizeof(RecordHeader) % kRecordAlignment == 0, "RecordHeader must keep records aligned");
+    static_assert(sizeof(StreamRecord) % kRecordAlignment == 0, "StreamRecord must keep records aligned");
+    static_assert(sizeof(PacketRecord) % kRecordAlignment == 0, "PacketRecord must keep records aligned");
+
+    const char kZeroPadding[AV_INPUT_BUFFER_PADDING_SIZE + kRecordAlignment] = {};
+
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(60, 31, 102)
+#define LSP_CODECPAR_HAS_FRAMERATE 1
+#endif
+
+    /**
+     * @brief 向上对齐到记录边界。
+     * @param size 字节数。
+     * @return 对齐后的字节数。
+     */
+    qint64 alignRecord(qint64 size) {
+        return (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+    }
+
+    /**
+     * @brief 数据包记录的负载长度：包头、数据与解码器要求的零填充。
+     * @param size 包数据字节数。
+     * @return 负载字节数。
+     */
+    qint64 packetPayloadSize(int size) {
+        return static_cast<qint64>(sizeof(PacketRecord)) + alignRecord(static_cast<qint64>(size) + AV_INPUT_BUFFER_PADDING_SIZE);
+    }
+
+    /**
+     * @brief 以原始字节追加一个平凡结构体。
+     * @param buffer 目标缓冲。
+     * @param value 结构体。
+     */
+    template <typename T>
+    void appendStruct(QByteArray& buffer, const T& value) {
+        buffer.append(reinterpret_cast<const char*>(&value), static_cast<int>(sizeof(T)));
+    }
+
+    /**
+     * @brief 越界检查后从映射内存复制一个平凡结构体。
+     * @param data 映射起点。
+     * @param size 映射长度。
+     * @param offset 读取位置。
+     * @param value 输出参数。
+     * @return 未越界时返回 true。
+     */
+    template <typename T>
+    bool readStruct(const uchar* data, qint64 size, qint64 offset, T* value) {
+        if (offset < 0 || offset + static_cast<qint64>(sizeof(T)) > size) {
+            return false;
+        }
+        std::memcpy(value, data + offset, sizeof(T));
+        return true;
+    }
+
+    /**
+     * @brief 写入失败原因。
+     * @param error 输出参数，可为空。
+     * @param message 原因。
+     */
+    void setError(QString* error, const QString& message) {
+        if (error) {
+            *error = message;
+        }
+    }
+}
+
+/**
+ * @brief 关闭文件。
+ */
+PacketCaptureWriter::~PacketCaptureWriter() {
+    close();
+}
+
+/**
+ * @brief 写入文件头后启动写线程。
+ * @param path 文件路径。
+ * @param error 可选输出参数。
+ * @return 成功返回 true。
+ */
+bool PacketCaptureWriter::open(const QString& path, QString* error) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        setError(error, QStringLiteral("无法创建抓取文件 %1").arg(path));
+        return false;
+    }
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    if (m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header))) {
+        setError(error, QStringLiteral("无法写入抓取文件 %1：%2").arg(path, m_file.errorString()));
+        m_file.close();
+        return false;
+    }
+
+    m_closing = false;
+    m_pendingBytes = 0;
+    m_droppedPackets.store(0, std::memory_order_relaxed);
+    m_writeFailed.store(false, std::memory_order_relaxed);
+    m_errorString.clear();
+    m_startUs = av_gettime_relative();
+    m_thread = std::thread(&PacketCaptureWriter::writerLoop, this);
+    return true;
+}
+
+/**
+ * @brief 在调用线程上序列化流参数（输入上下文只在此刻有效），交给写线程落盘。
+ *        段头依次为流数量、流记录长度，然后是各流的记录、extradata 与自定义声道编号。
+ * @param format 已打开的输入。
+ */
+void PacketCaptureWriter::beginSegment(const AVFormatContext* format) {
+    QByteArray payload;
+    const uint32_t streamCount = format->nb_streams;
+    appendStruct(payload, streamCount);
+    appendStruct(payload, static_cast<uint32_t>(sizeof(StreamRecord)));
+    for (unsigned int i = 0; i < format->nb_streams; ++i) {
+        const AVStream* stream = format->streams[i];
+        const AVCodecParameters* par = stream->codecpar;
+        StreamRecord record{};
+        record.codecType = par->codec_type;
+        record.codecId = par->codec_id;
+        record.codecTag = par->codec_tag;
+        record.format = par->format;
+        record.bitRate = par->bit_rate;
+        record.bitsPerCodedSample = par->bits_per_coded_sample;
+        record.bitsPerRawSample = par->bits_per_raw_sample;
+        record.profile = par->profile;
+        record.level = par->level;
+        record.width = par->width;
+        record.height = par->height;
+        record.sampleAspectNum = par->sample_aspect_ratio.num;
+        record.sampleAspectDen = par->sample_aspect_ratio.den;
+#ifdef LSP_CODECPAR_HAS_FRAMERATE
+        record.frameRateNum = par->framerate.num;
+        record.frameRateDen = par->framerate.den;
+#endif
+        record.fieldOrder = par->field_order;
+        record.colorRange = par->color_range;
+        record.colorPrimaries = par->color_primaries;
+        record.colorTrc = par->color_trc;
+        record.colorSpace = par->color_space;
+        record.chromaLocation = par->chroma_location;
+        record.videoDelay = par->video_delay;
+        record.channelOrder = par->ch_layout.order;
+        record.channels = par->ch_layout.nb_channels;
+        record.sampleRate = par->sample_rate;
+        record.blockAlign = par->block_align;
+        record.frameSize = par->frame_size;
+        record.initialPadding = par->initial_padding;
+        record.trailingPadding = par->trailing_padding;
+        record.seekPreroll = par->seek_preroll;
+        record.timeBaseNum = stream->time_base.num;
+        record.timeBaseDen = stream->time_base.den;
+        record.avgFrameRateNum = stream->avg_frame_rate.num;
+        record.avgFrameRateDen = stream->avg_frame_rate.den;
+        record.realFrameRateNum = stream->r_frame_rate.num;
+        record.realFrameRateDen = stream->r_frame_rate.den;
+        const bool customOrder = par->ch_layout.order == AV_CHANNEL_ORDER_CUSTOM && par->ch_layout.u.map;
+        if (par->ch_layout.order == AV_CHANNEL_ORDER_NATIVE || par->ch_layout.order == AV_CHANNEL_ORDER_AMBISONIC) {
+            record.channelMask = par->ch_layout.u.mask;
+        }
+        record.customChannels = customOrder && par->ch_layout.nb_channels > 0 ? static_cast<uint32_t>(par->ch_layout.nb_channels) : 0;
+        record.extradataSize = par->extradata && par->extradata_size > 0 ? static_cast<uint32_t>(par->extradata_size) : 0;
+        appendStruct(payload, record);
+        if (record.extradataSize > 0) {
+            payload.append(reinterpret_cast<const char*>(par->extradata), par->extradata_size);
+            payload.append(kZeroPadding, static_cast<int>(alignRecord(par->extradata_size) - par->extradata_size));
+        }
+        if (record.customChannels > 0) {
+            for (uint32_t channel = 0; channel < record.customChannels; ++channel) {
+                appendStruct(payload, static_cast<int32_t>(par->ch_layout.u.map[channel].id));
+            }
+            const qint64 idsSize = static_cast<qint64>(record.customChannels) * static_cast<qint64>(sizeof(int32_t));
+            payload.append(kZeroPadding, static_cast<int>(alignRecord(idsSize) - idsSize));
+        }
+    }
+
+    Pending item;
+    const RecordHeader header{ kRecordSegment, static_cast<uint32_t>(payload.size()) };
+    appendStruct(item.segment, header);
+    item.segment.append(payload);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_thread.joinable() || m_closing) {
+        return;
+    }
+    // 段头总是入队（不受上限约束），否则之后的包无法回放
+    m_pendingBytes += static_cast<size_t>(item.segment.size());
+    m_pending.push_back(std::move(item));
+    m_cv.notify_one();
+}
+
+/**
+ * @brief 超出待写上限时丢弃该包并计数。
+ * @param packet 解复用得到的包。
+ */
+void PacketCaptureWriter::write(const AVPacket& packet) {
+    const int64_t arrivalUs = av_gettime_relative() - m_startUs;
+    const size_t bytes = sizeof(RecordHeader) + static_cast<size_t>(packetPayloadSize(packet.size));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable() || m_closing) {
+            return;
+        }
+        if (m_pendingBytes + bytes > kMaxPendingBytes) {
+            m_droppedPackets.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_pendingBytes += bytes;
+    }
+
+    AVPacket* reference = av_packet_alloc();
+    if (!reference || av_packet_ref(reference, &packet) < 0) {
+        av_packet_free(&reference);
+        m_droppedPackets.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingBytes -= bytes;
+        return;
+    }
+
+    Pending item;
+    item.packet = reference;
+    item.arrivalUs = arrivalUs;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.push_back(std::move(item));
+    m_cv.notify_one();
+}
+
+/**
+ * @brief 通知写线程写完剩余条目后退出。
+ */
+void PacketCaptureWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+/**
+ * @brief 读取丢弃计数。
+ * @return 包数。
+ */
+quint64 PacketCaptureWriter::droppedPackets() const {
+    return m_droppedPackets.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 读取写盘失败原因。
+ * @return 原因，未失败时为空。
+ */
+QString PacketCaptureWriter::errorString() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_errorString;
+}
+
+/**
+ * @brief 写入不完整即视为失败，记录第一次失败的原因；之后的写入直接返回 false。
+ * @param data 数据。
+ * @param size 字节数。
+ * @return 全部写入返回 true。
+ */
+bool PacketCaptureWriter::writeFully(const char* data, qint64 size) {
+    if (m_writeFailed.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (size <= 0 || m_file.write(data, size) == size) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_errorString = QStringLiteral("写入抓取文件 %1 失败：%2").arg(m_file.fileName(), m_file.errorString());
+    m_writeFailed.store(true, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief 逐条取出并写盘，文件写入在锁外进行；关闭时写完队列再退出。
+ *        写盘失败后不再写入，剩余条目只释放，文件在失败处截断（回放时按截断处理）。
+ */
+void PacketCaptureWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cv.wait(lock, [this]() { return m_closing || !m_pending.empty(); });
+        if (m_pending.empty()) {
+            break;
+        }
+        Pending item = std::move(m_pending.front());
+        m_pending.pop_front();
+        lock.unlock();
+
+        size_t bytes = 0;
+        if (item.packet) {
+            const AVPacket* packet = item.packet;
+            const qint64 payloadSize = packetPayloadSize(packet->size);
+            const RecordHeader header{ kRecordPacket, static_cast<uint32_t>(payloadSize) };
+            PacketRecord record{};
+            record.arrivalUs = item.arrivalUs;
+            record.pts = packet->pts;
+            record.dts = packet->dts;
+            record.duration = packet->duration;
+            record.streamIndex = packet->stream_index;
+            record.flags = packet->flags;
+            record.size = static_cast<uint32_t>(packet->size);
+            // 逐段写入，第一段失败后 writeFully 不再写
+            writeFully(reinterpret_cast<const char*>(&header), sizeof(header));
+            writeFully(reinterpret_cast<const char*>(&record), sizeof(record));
+            writeFully(reinterpret_cast<const char*>(packet->data), packet->size);
+            writeFully(kZeroPadding, payloadSize - static_cast<qint64>(sizeof(record)) - packet->size);
+            bytes = sizeof(header) + static_cast<size_t>(payloadSize);
+            av_packet_free(&item.packet);
+        }
+        else {
+            writeFully(item.segment.constData(), item.segment.size());
+            bytes = static_cast<size_t>(item.segment.size());
+        }
+
+        lock.lock();
+        m_pendingBytes -= bytes;
+    }
+    lock.unlock();
+    if (!m_writeFailed.load(std::memory_order_relaxed) && !m_file.flush()) {
+        std::lock_guard<std::mutex> errorLock(m_mutex);
+        m_errorString = QStringLiteral("写入抓取文件 %1 失败：%2").arg(m_file.fileName(), m_file.errorString());
+        m_writeFailed.store(true, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 解除映射。
+ */
+PacketCaptureReader::Mapping::~Mapping() {
+    if (data) {
+        file.unmap(data);
+    }
+}
+
+/**
+ * @brief 按扩展名判断，不读取文件。
+ * @param url 输入地址。
+ * @return 是抓取文件时返回 true。
+ */
+bool PacketCaptureReader::isCaptureFile(const QString& url) {
+    return url.endsWith(QStringLiteral(".lspcap"), Qt::CaseInsensitive);
+}
+
+/**
+ * @brief 映射整个文件，校验魔数、版本与字节序。
+ * @param path 文件路径。
+ * @param error 可选输出参数。
+ * @return 成功返回 true。
+ */
+bool PacketCaptureReader::open(const QString& path, QString* error) {
+    auto mapping = std::make_shared<Mapping>();
+    mapping->file.setFileName(path);
+    if (!mapping->file.open(QIODevice::ReadOnly)) {
+        setError(error, QStringLiteral("无法打开抓取文件 %1").arg(path));
+        return false;
+    }
+    mapping->size = mapping->file.size();
+    mapping->data = mapping->size > 0 ? mapping->file.map(0, mapping->size) : nullptr;
+    FileHeader header{};
+    if (!mapping->data || !readStruct(mapping->data, mapping->size, 0, &header)) {
+        setError(error, QStringLiteral("无法映射抓取文件 %1").arg(path));
+        return false;
+    }
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || header.byteOrder != kByteOrderMark) {
+        setError(error, QStringLiteral("不是受支持的抓取文件：%1").arg(path));
+        return false;
+    }
+    m_mapping = std::move(mapping);
+    m_offset = sizeof(FileHeader);
+    return true;
+}
+
+/**
+ * @brief 跳过上一段未读完的包，解析下一个段头并重建流参数。
+ * @param error 可选输出参数。
+ * @return 格式上下文，没有更多段或文件损坏时为空。
+ */
+AVFormatContext* PacketCaptureReader::openSegment(QString* error) {
+    if (!m_mapping) {
+        setError(error, QStringLiteral("抓取文件未打开"));
+        return nullptr;
+    }
+    const uchar* data = m_mapping->data;
+    const qint64 size = m_mapping->size;
+
+    RecordHeader header{};
+    for (;;) {
+        if (m_offset >= size) {
+            return nullptr;
+        }
+        if (!readStruct(data, size, m_offset, &header) || m_offset + static_cast<qint64>(sizeof(header)) + header.size > size) {
+            setError(error, QStringLiteral("抓取文件已截断"));
+            m_offset = size;
+            return nullptr;
+        }
+        if (header.type == kRecordSegment) {
+            break;
+        }
+        m_offset += static_cast<qint64>(sizeof(header)) + header.size;
+    }
+
+    qint64 offset = m_offset + static_cast<qint64>(sizeof(header));
+    const qint64 end = offset + header.size;
+    m_offset = end;
+
+    uint32_t streamCount = 0;
+    uint32_t recordSize = 0;
+    if (!readStruct(data, end, offset, &streamCount) || !readStruct(data, end, offset + sizeof(uint32_t), &recordSize)
+        || recordSize < sizeof(StreamRecord) || alignRecord(recordSize) != recordSize) {
+        setError(error, QStringLiteral("段头损坏"));
+        return nullptr;
+    }
+    offset += 2 * sizeof(uint32_t);
+
+    AVFormatContext* format = avformat_alloc_context();
+    if (!format) {
+        setError(error, QStringLiteral("无法分配格式上下文"));
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < streamCount; ++i) {
+        StreamRecord record{};
+        AVStream* stream = nullptr;
+        if (!readStruct(data, end, offset, &record)
+            || offset + static_cast<qint64>(recordSize) + alignRecord(record.extradataSize)
+                + alignRecord(static_cast<qint64>(record.customChannels) * static_cast<qint64>(sizeof(int32_t))) > end
+            || !(stream = avformat_new_stream(format, nullptr))) {
+            setError(error, QStringLiteral("段头损坏"));
+            avformat_free_context(format);
+            return nullptr;
+        }
+        // 跳过新版本追加的字段
+        offset += recordSize;
+
+        AVCodecParameters* par = stream->codecpar;
+        par->codec_type = static_cast<AVMediaType>(record.codecType);
+        par->codec_id = static_cast<AVCodecID>(record.codecId);
+        par->codec_tag = record.codecTag;
+        par->format = record.format;
+        par->bit_rate = record.bitRate;
+        par->bits_per_coded_sample = record.bitsPerCodedSample;
+        par->bits_per_raw_sample = record.bitsPerRawSample;
+        par->profile = record.profile;
+        par->level = record.level;
+        par->width = record.width;
+        par->height = record.height;
+        par->sample_aspect_ratio = AVRational{ record.sampleAspectNum, record.sampleAspectDen };
+#ifdef LSP_CODECPAR_HAS_FRAMERATE
+        par->framerate = AVRational{ record.frameRateNum, record.frameRateDen };
+#endif
+        par->field_order = static_cast<AVFieldOrder>(record.fieldOrder);
+        par->color_range = static_cast<AVColorRange>(record.colorRange);
+        par->color_primaries = static_cast<AVColorPrimaries>(record.colorPrimaries);
+        par->color_trc = static_cast<AVColorTransferCharacteristic>(record.colorTrc);
+        par->color_space = static_cast<AVColorSpace>(record.colorSpace);
+        par->chroma_location = static_cast<AVChromaLocation>(record.chromaLocation);
+        par->video_delay = record.videoDelay;
+        par->sample_rate = record.sampleRate;
+        par->block_align = record.blockAlign;
+        par->frame_size = record.frameSize;
+        par->initial_padding = record.initialPadding;
+        par->trailing_padding = record.trailingPadding;
+        par->seek_preroll = record.seekPreroll;
+        if (record.channels > 0) {
+            switch (record.channelOrder) {
+            case AV_CHANNEL_ORDER_NATIVE:
+            case AV_CHANNEL_ORDER_AMBISONIC:
+                par->ch_layout.order = static_cast<AVChannelOrder>(record.channelOrder);
+                par->ch_layout.nb_channels = record.channels;
+                par->ch_layout.u.mask = record.channelMask;
+                break;
+            case AV_CHANNEL_ORDER_CUSTOM:
+                // 声道编号在 extradata 之后读取
+                break;
+            default:
+                par->ch_layout.order = AV_CHANNEL_ORDER_UNSPEC;
+                par->ch_layout.nb_channels = record.channels;
+                break;
+            }
+        }
+        if (record.extradataSize > 0) {
+            par->extradata = static_cast<uint8_t*>(av_mallocz(record.extradataSize + AV_INPUT_BUFFER_PADDING_SIZE));
+            if (!par->extradata) {
+                setError(error, QStringLiteral("无法分配 extradata"));
+                avformat_free_context(format);
+                return nullptr;
+            }
+            std::memcpy(par->extradata, data + offset, record.extradataSize);
+            par->extradata_size = static_cast<int>(record.extradataSize);
+            offset += alignRecord(record.extradataSize);
+        }
+        if (record.customChannels > 0) {
+            AVChannelCustom* map = static_cast<AVChannelCustom*>(av_calloc(record.customChannels, sizeof(AVChannelCustom)));
+            if (!map) {
+                setError(error, QStringLiteral("无法分配声道映射"));
+                avformat_free_context(format);
+                return nullptr;
+            }
+            for (uint32_t channel = 0; channel < record.customChannels; ++channel) {
+                int32_t id = 0;
+                std::memcpy(&id, data + offset + channel * sizeof(int32_t), sizeof(id));
+                map[channel].id = static_cast<AVChannel>(id);
+            }
+            par->ch_layout.order = AV_CHANNEL_ORDER_CUSTOM;
+            par->ch_layout.nb_channels = static_cast<int>(record.customChannels);
+            par->ch_layout.u.map = map;
+            offset += alignRecord(static_cast<qint64>(record.customChannels) * static_cast<qint64>(sizeof(int32_t)));
+        }
+        stream->time_base = AVRational{ record.timeBaseNum, record.timeBaseDen };
+        stream->avg_frame_rate = AVRational{ record.avgFrameRateNum, record.avgFrameRateDen };
+        stream->r_frame_rate = AVRational{ record.realFrameRateNum, record.realFrameRateDen };
+    }
+    return format;
+}
+
+/**
+ * @brief 遇到段头时不消费它并返回段结束，由调用方决定是否继续下一段；未知类型的记录跳过。
+ * @param packet 输出参数。
+ * @param arrivalUs 输出参数。
+ * @return 0、AVERROR_EOF 或 AVERROR_INVALIDDATA。
+ */
+int PacketCaptureReader::read(AVPacket& packet, int64_t* arrivalUs) {
+    if (!m_mapping) {
+        return AVERROR_EOF;
+    }
+    const uchar* data = m_mapping->data;
+    const qint64 size = m_mapping->size;
+
+    for (;;) {
+        if (m_offset >= size) {
+            return AVERROR_EOF;
+        }
+        RecordHeader header{};
+        if (!readStruct(data, size, m_offset, &header) || m_offset + static_cast<qint64>(sizeof(header)) + header.size > size) {
+            m_offset = size;
+            return AVERROR_INVALIDDATA;
+        }
+        if (header.type == kRecordSegment) {
+            return AVERROR_EOF;
+        }
+        const qint64 payload = m_offset + static_cast<qint64>(sizeof(header));
+        m_offset = payload + header.size;
+        if (header.type != kRecordPacket) {
+            continue;
+        }
+
+        PacketRecord record{};
+        if (!readStruct(data, m_offset, payload, &record) || packetPayloadSize(static_cast<int>(record.size)) > header.size) {
+            m_offset = size;
+            return AVERROR_INVALIDDATA;
+        }
+        uint8_t* packetData = const_cast<uint8_t*>(data + payload + sizeof(PacketRecord));
+        auto* owner = new std::shared_ptr<Mapping>(m_mapping);
+        AVBufferRef* buffer = av_buffer_create(packetData, record.size + AV_INPUT_BUFFER_PADDING_SIZE,
+            &PacketCaptureReader::releaseMapping, owner, AV_BUFFER_FLAG_READONLY);
+        if (!buffer) {
+            delete owner;
+            return AVERROR(ENOMEM);
+        }
+        packet.buf = buffer;
+        packet.data = packetData;
+        packet.size = static_cast<int>(record.size);
+        packet.pts = record.pts;
+        packet.dts = record.dts;
+        packet.duration = record.duration;
+        packet.stream_index = record.streamIndex;
+        packet.flags = record.flags;
+        *arrivalUs = record.arrivalUs;
+        return 0;
+    }
+}
+
+/**
+ * @brief 判断读取位置是否已到文件末尾。
+ * @return 到达末尾时返回 true。
+ */
+bool PacketCaptureReader::atEnd() const {
+    return !m_mapping || m_offset >= m_mapping->size;
+}
+
+/**
+ * @brief 释放包持有的映射引用。
+ * @param opaque 堆上的 std::shared_ptr<Mapping>。
+ * @param data 未使用。
+ */
+void PacketCaptureReader::releaseMapping(void* opaque, uint8_t* data) {
+    delete static_cast<std::shared_ptr<Mapping>*>(opaque);
+}
@@ -0,0 +1,209 @@
+/**
+ * @file packetcapture.h
+ * @brief 定义数据包抓取文件的写入与回放：记录解复用得到的每个 AVPacket 及其到达时刻、流参数，
+ *        之后按原始节奏、倍速或最快速度重放，使性能测试与问题复现可重复。
+ * @mainfunctions
+ *   - PacketCaptureWriter::open
+ *   - PacketCaptureWriter::beginSegment
+ *   - PacketCaptureWriter::write
+ *   - PacketCaptureWriter::errorString
+ *   - PacketCaptureReader::open
+ *   - PacketCaptureReader::openSegment
+ *   - PacketCaptureReader::read
+ * @mainclasses
+ *   - PacketCaptureWriter
+ *   - PacketCaptureReader
+ */
+
+#ifndef PACKETCAPTURE_H
+#define PACKETCAPTURE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+/*
+ * 文件格式（本机字节序，文件头带字节序标记，全部记录按 8 字节对齐）：
+ *   文件头   FileHeader
+ *   记录     RecordHeader + 负载，类型为：
+ *     段头   每次连接成功时写入，负载为流数量、流记录长度与各流记录：完整的编解码参数（含声道映射）、
+ *            时间基、帧率，随后是 extradata 与自定义声道顺序的声道编号；流记录长度使新版本追加的字段
+ *            可被旧读取器跳过
+ *     数据包 PacketRecord + 包数据 + AV_INPUT_BUFFER_PADDING_SIZE 字节的零填充
+ * 零填充使回放时可以直接把映射内存交给解码器，无需复制；一个文件可包含多段，回放时段与段之间表现为一次重连。
+ */
+
+/**
+ * @brief PacketCaptureWriter 以追加方式写入抓取文件。
+ *
+ * 解复用线程只做引用计数与入队，由独立的写线程落盘，磁盘抖动不会阻塞拉流。
+ * 待写数据超过上限时丢弃新包并计数，避免磁盘过慢时内存无限增长。
+ */
+class PacketCaptureWriter {
+public:
+    PacketCaptureWriter() = default;
+    PacketCaptureWriter(const PacketCaptureWriter&) = delete;
+    PacketCaptureWriter& operator=(const PacketCaptureWriter&) = delete;
+
+    /**
+     * @brief 析构时写完已排队的数据并关闭文件。
+     */
+    ~PacketCaptureWriter();
+
+    /**
+     * @brief 创建（覆盖）抓取文件并启动写线程，到达时刻以此刻为零点。
+     * @param path 文件路径。
+     * @param error 可选输出参数，失败原因。
+     * @return 成功返回 true。
+     */
+    bool open(const QString& path, QString* error = nullptr);
+
+    /**
+     * @brief 写入新的段头，在每次连接成功、开始写数据包之前调用。
+     * @param format 已打开的输入，读取其流参数。
+     */
+    void beginSegment(const AVFormatContext* format);
+
+    /**
+     * @brief 记录一个数据包，到达时刻取调用时刻；只增加引用，不复制数据。
+     * @param packet 解复用得到的包。
+     */
+    void write(const AVPacket& packet);
+
+    /**
+     * @brief 写完已排队的数据后关闭文件，可重复调用。
+     */
+    void close();
+
+    /**
+     * @brief 因待写数据超限而未记录的包数量。
+     * @return 包数。
+     */
+    quint64 droppedPackets() const;
+
+    /**
+     * @brief 写盘失败（磁盘已满、设备错误）的原因，失败后不再写入后续数据，任意线程可调用。
+     * @return 原因，未失败时为空。
+     */
+    QString errorString() const;
+
+private:
+    /**
+     * @brief 待写条目：段头（已序列化）或数据包。
+     */
+    struct Pending {
+        QByteArray segment;
+        AVPacket* packet = nullptr;
+        int64_t arrivalUs = 0;
+    };
+
+    /**
+     * @brief 写线程主循环。
+     */
+    void writerLoop();
+
+    /**
+     * @brief 完整写入一段数据，失败时记录原因，仅写线程调用。
+     * @param data 数据。
+     * @param size 字节数。
+     * @return 全部写入返回 true。
+     */
+    bool writeFully(const char* data, qint64 size);
+
+    QFile m_file;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Pending> m_pending;
+    size_t m_pendingBytes = 0;
+    bool m_closing = false;
+    int64_t m_startUs = 0;
+    std::atomic<quint64> m_droppedPackets{ 0 };
+    std::atomic_bool m_writeFailed{ false };    // 写线程置位后只丢弃待写条目
+    QString m_errorString;                      // 受 m_mutex 保护
+};
+
+/**
+ * @brief PacketCaptureReader 以内存映射方式读取抓取文件。
+ *
+ * 回放的包直接引用映射内存（只读 AVBufferRef，持有映射的共享所有权），映射在最后一个包释放后才解除。
+ */
+class PacketCaptureReader {
+public:
+    PacketCaptureReader() = default;
+    PacketCaptureReader(const PacketCaptureReader&) = delete;
+    PacketCaptureReader& operator=(const PacketCaptureReader&) = delete;
+
+    /**
+     * @brief 判断地址是否指向抓取文件（按扩展名 .lspcap）。
+     * @param url 输入地址。
+     * @return 是抓取文件时返回 true。
+     */
+    static bool isCaptureFile(const QString& url);
+
+    /**
+     * @brief 映射文件并校验文件头。
+     * @param path 文件路径。
+     * @param error 可选输出参数，失败原因。
+     * @return 成功返回 true。
+     */
+    bool open(const QString& path, QString* error = nullptr);
+
+    /**
+     * @brief 读取下一个段头，并据此构造只含流信息的 AVFormatContext（可用 avformat_close_input 释放）。
+     * @param error 可选输出参数，文件损坏时的原因；已读到文件末尾时保持为空。
+     * @return 格式上下文，没有更多段或文件损坏时为空。
+     */
+    AVFormatContext* openSegment(QString* error = nullptr);
+
+    /**
+     * @brief 读取当前段的下一个包。
+     * @param packet 输出参数，数据引用映射内存。
+     * @param arrivalUs 输出参数，抓取时相对文件起点的到达时刻（微秒）。
+     * @return 0 表示成功；AVERROR_EOF 表示当前段结束（随后可 openSegment）；AVERROR_INVALIDDATA 表示文件损坏。
+     */
+    int read(AVPacket& packet, int64_t* arrivalUs);
+
+    /**
+     * @brief 是否已读完所有段。
+     * @return 读到文件末尾时返回 true。
+     */
+    bool atEnd() const;
+
+private:
+    /**
+     * @brief 映射的文件，由读取器与所有未释放的包共享。
+     */
+    struct Mapping {
+        QFile file;
+        uchar* data = nullptr;
+        qint64 size = 0;
+        ~Mapping();
+    };
+
+    /**
+     * @brief 包缓冲释放回调，释放对映射的一份引用。
+     * @param opaque 堆上的 std::shared_ptr<Mapping>。
+     * @param data 未使用。
+     */
+    static void releaseMapping(void* opaque, uint8_t* data);
+
+    std::shared_ptr<Mapping> m_mapping;
+    qint64 m_offset = 0;
+};
+
+#endif // PACKETCAPTURE_H
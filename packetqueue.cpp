@@ -8,18 +8,52 @@
  *   - PacketQueue::open
  *   - PacketQueue::close
  *   - PacketQueue::size
+ *   - PacketQueue::dropToLastKeyframe
  * @mainclasses
  *   - PacketQueue
  */
 
 #include "packetqueue.h"
 
+#include "frametrace.h"
+#include "probes.h"
+
+extern "C"
+{
+#include <libavutil/time.h>
+}
+
+namespace {
+    // queue_drop 探针的 reason 参数
+    constexpr int kDropOverflow = 0;
+    constexpr int kDropToKeyframe = 1;
+    constexpr int kDropBefore = 2;
+
+    /**
+     * @brief 返回包的展示时间戳，缺失时退回解码时间戳。
+     */
+    int64_t packetTimestamp(const AVPacket& packet) {
+        return packet.pts != AV_NOPTS_VALUE ? packet.pts : packet.dts;
+    }
+
+    /**
+     * @brief 记录包在队列中被丢弃（逐帧追踪与 USDT 探针），溢出与延迟追赶在追踪中使用不同的打点。
+     * @param packet 被丢弃的包。
+     * @param reason 丢弃原因。
+     */
+    void noteDrop(const AVPacket& packet, int reason) {
+        const FrameTrace::Point point = reason == kDropOverflow ? FrameTrace::Point::QueueDrop : FrameTrace::Point::QueueSkip;
+        FrameTrace::instant(point, FrameTrace::packetId(packet), packet.stream_index);
+        LSP_PROBE4(queue_drop, packet.stream_index, packet.pts, packet.size, reason);
+    }
+}
+
  /**
   * @brief 构造函数，初始化容量与关闭标志。
   * @param maxPackets 队列容量。
   */
 PacketQueue::PacketQueue(size_t maxPackets, OverflowPolicy policy)
-    : m_maxSize(maxPackets), m_closed(false), m_policy(policy), m_droppedCount(0) {
+    : m_maxSize(maxPackets), m_closed(false), m_policy(policy) {
 }
 
 /**
@@ -39,11 +73,12 @@ void PacketQueue::setMaxSize(size_t maxPackets) {
     m_maxSize = maxPackets;
     if (m_policy == OverflowPolicy::DropOldest) {
         while (m_queue.size() > m_maxSize) {
-            AVPacket dropped = m_queue.front();
+            noteDrop(m_queue.front().packet, kDropOverflow);
+            av_packet_unref(&m_queue.front().packet);
             m_queue.pop_front();
-            av_packet_unref(&dropped);
-            ++m_droppedCount;
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
         }
+        publishSize();
     }
     m_cvNotFull.notify_all();
 }
@@ -65,11 +100,12 @@ bool PacketQueue::push(const AVPacket* packet, std::atomic_bool& running) {
     else {
         while (!m_closed && running.load() && m_queue.size() >= m_maxSize) {
             // 丢弃最旧的包以控制延迟，避免生产者线程停顿
-            AVPacket dropped = m_queue.front();
+            noteDrop(m_queue.front().packet, kDropOverflow);
+            av_packet_unref(&m_queue.front().packet);
             m_queue.pop_front();
-            av_packet_unref(&dropped);
-            ++m_droppedCount;
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
         }
+        publishSize();
         if (m_closed || !running.load()) {
             return false;
         }
@@ -80,7 +116,10 @@ bool PacketQueue::push(const AVPacket* packet, std::atomic_bool& running) {
         return false;
     }
 
-    m_queue.push_back(copy);
+    m_queue.push_back(Entry{ copy, av_gettime_relative() });
+    publishSize();
+    FrameTrace::instant(FrameTrace::Point::QueuePush, FrameTrace::packetId(copy), copy.stream_index);
+    LSP_PROBE4(queue_push, copy.stream_index, copy.pts, copy.size, m_queue.size());
     m_cvNotEmpty.notify_one();
     return true;
 }
@@ -89,9 +128,10 @@ bool PacketQueue::push(const AVPacket* packet, std::atomic_bool& running) {
  * @brief 从队列取出一个包，必要时阻塞等待。
  * @param outPacket 输出引用。
  * @param running 播放器运行标志。
+ * @param enqueuedUs 可选输出入队时间。
  * @return true 表示成功取出。
  */
-bool PacketQueue::pop(AVPacket& outPacket, std::atomic_bool& running) {
+bool PacketQueue::pop(AVPacket& outPacket, std::atomic_bool& running, int64_t* enqueuedUs) {
     std::unique_lock<std::mutex> lock(m_mutex);
     m_cvNotEmpty.wait(lock, [this, &running]() { return m_closed || !m_queue.empty() || !running.load(); });
 
@@ -99,10 +139,15 @@ bool PacketQueue::pop(AVPacket& outPacket, std::atomic_bool& running) {
         return false;
     }
 
-    AVPacket packet = m_queue.front();
+    Entry entry = m_queue.front();
     m_queue.pop_front();
-    av_packet_move_ref(&outPacket, &packet);
-    av_packet_unref(&packet);
+    publishSize();
+    av_packet_move_ref(&outPacket, &entry.packet);
+    av_packet_unref(&entry.packet);
+    FrameTrace::instant(FrameTrace::Point::QueuePop, FrameTrace::packetId(outPacket), outPacket.stream_index);
+    if (enqueuedUs) {
+        *enqueuedUs = entry.enqueuedUs;
+    }
     m_cvNotFull.notify_one();
     return true;
 }
@@ -112,10 +157,11 @@ bool PacketQueue::pop(AVPacket& outPacket, std::atomic_bool& running) {
  */
 void PacketQueue::clear() {
     std::lock_guard<std::mutex> lock(m_mutex);
-    for (AVPacket& packet : m_queue) {
-        av_packet_unref(&packet);
+    for (Entry& entry : m_queue) {
+        av_packet_unref(&entry.packet);
     }
     m_queue.clear();
+    publishSize();
     m_cvNotFull.notify_all();
 }
 
@@ -156,16 +202,89 @@ bool PacketQueue::isOpen() const {
  * @return 队列长度。
  */
 size_t PacketQueue::size() const {
+    return m_size.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 从队尾向前查找最新关键帧，释放其之前的包。
+ * @param keyframeTimestamp 输出关键帧时间戳。
+ * @return 丢弃数量。
+ */
+size_t PacketQueue::dropToLastKeyframe(int64_t* keyframeTimestamp) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    return m_queue.size();
+    auto it = m_queue.end();
+    while (it != m_queue.begin()) {
+        --it;
+        if (it->packet.flags & AV_PKT_FLAG_KEY) {
+            break;
+        }
+    }
+    if (it == m_queue.end() || !(it->packet.flags & AV_PKT_FLAG_KEY) || it == m_queue.begin()) {
+        return 0;
+    }
+
+    const size_t dropped = static_cast<size_t>(it - m_queue.begin());
+    if (keyframeTimestamp) {
+        *keyframeTimestamp = packetTimestamp(it->packet);
+    }
+    for (auto drop = m_queue.begin(); drop != it; ++drop) {
+        noteDrop(drop->packet, kDropToKeyframe);
+        av_packet_unref(&drop->packet);
+    }
+    m_queue.erase(m_queue.begin(), it);
+    m_droppedCount.fetch_add(dropped, std::memory_order_relaxed);
+    publishSize();
+    m_cvNotFull.notify_all();
+    return dropped;
 }
 
-size_t PacketQueue::droppedCount() const {
+/**
+ * @brief 移除时间戳早于阈值的包。
+ * @param timestamp 阈值。
+ * @return 丢弃数量。
+ */
+size_t PacketQueue::dropBefore(int64_t timestamp) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    return m_droppedCount;
+    size_t dropped = 0;
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+        const int64_t packetTime = packetTimestamp(it->packet);
+        if (packetTime != AV_NOPTS_VALUE && packetTime < timestamp) {
+            noteDrop(it->packet, kDropBefore);
+            av_packet_unref(&it->packet);
+            it = m_queue.erase(it);
+            ++dropped;
+        }
+        else {
+            ++it;
+        }
+    }
+    if (dropped > 0) {
+        m_droppedCount.fetch_add(dropped, std::memory_order_relaxed);
+        publishSize();
+        m_cvNotFull.notify_all();
+    }
+    return dropped;
 }
 
+/**
+ * @brief 返回累计丢弃数。
+ * @return 丢弃数量。
+ */
+size_t PacketQueue::droppedCount() const {
+    return m_droppedCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 丢弃计数清零。
+ */
 void PacketQueue::resetDroppedCount() {
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_droppedCount = 0;
+    m_droppedCount.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 写入当前长度。
+ */
+void PacketQueue::publishSize() {
+    m_size.store(m_queue.size(), std::memory_order_relaxed);
 }
@@ -9,6 +9,8 @@
  *   - close
  *   - isOpen
  *   - size
+ *   - dropToLastKeyframe
+ *   - dropBefore
  * @mainclasses
  *   - PacketQueue
  */
@@ -18,6 +20,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <mutex>
 
@@ -66,9 +69,10 @@ public:
      * @brief 从队列取出一个包。
      * @param outPacket 输出参数。
      * @param running 播放器运行标志。
+     * @param enqueuedUs 可选输出参数，包入队时的单调时钟（微秒），用于统计排队时长。
      * @return true 表示成功取包。
      */
-    bool pop(AVPacket& outPacket, std::atomic_bool& running);
+    bool pop(AVPacket& outPacket, std::atomic_bool& running, int64_t* enqueuedUs = nullptr);
 
     /**
      * @brief 清空队列并释放内部 AVPacket。
@@ -92,14 +96,28 @@ public:
     bool isOpen() const;
 
     /**
-     * @brief 获取当前缓存的包数量。
+     * @brief 获取当前缓存的包数量，不加锁（结果为近似快照），统计可随时读取。
      * @return 队列长度。
      */
     size_t size() const;
 
     /**
-     * @brief 查询累计丢弃的包数量。
-     * @return 自上次重置以来丢弃的包数。
+     * @brief 丢弃队列中最新关键帧之前的所有包，用于延迟追赶时跳到最新关键帧。
+     * @param keyframeTimestamp 输出参数，保留下来的关键帧时间戳（pts，缺失时为 dts）。
+     * @return 丢弃的包数量；队列中没有可跳转的关键帧时返回 0 且不修改队列。
+     */
+    size_t dropToLastKeyframe(int64_t* keyframeTimestamp);
+
+    /**
+     * @brief 丢弃时间戳早于给定值的包，时间戳缺失的包保留。
+     * @param timestamp 时间戳阈值（与包同一时间基）。
+     * @return 丢弃的包数量。
+     */
+    size_t dropBefore(int64_t timestamp);
+
+    /**
+     * @brief 查询累计丢弃的包数量，不加锁。
+     * @return 自上次重置以来丢弃的包数，包括溢出丢弃与 dropToLastKeyframe / dropBefore 跳过的包。
      */
     size_t droppedCount() const;
 
@@ -109,14 +127,28 @@ public:
     void resetDroppedCount();
 
 private:
+    /**
+     * @brief 同步队列长度的无锁副本，调用方需持有锁。
+     */
+    void publishSize();
+
+    /**
+     * @brief 队列元素：包及其入队时间。
+     */
+    struct Entry {
+        AVPacket packet;
+        int64_t enqueuedUs;
+    };
+
     mutable std::mutex m_mutex;
     std::condition_variable m_cvNotEmpty;
     std::condition_variable m_cvNotFull;
-    std::deque<AVPacket> m_queue;
+    std::deque<Entry> m_queue;
     size_t m_maxSize;
     bool m_closed;
     OverflowPolicy m_policy;
-    size_t m_droppedCount;
+    std::atomic<size_t> m_size{ 0 };            // m_queue.size() 的副本，只在持锁修改队列后写入
+    std::atomic<size_t> m_droppedCount{ 0 };    // 只在持锁时递增
 };
 
 #endif // PACKETQUEUE_H
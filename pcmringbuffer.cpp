@@ -0,0 +1,181 @@
+/**
+ * @file pcmringbuffer.cpp
+ * @brief 实现无锁 PCM 环形缓冲的读写。
+ * @mainfunctions
+ *   - PcmRingBuffer::write
+ *   - PcmRingBuffer::writableSpan
+ *   - PcmRingBuffer::read
+ *   - PcmRingBuffer::discard
+ *   - PcmRingBuffer::discardOldest
+ * @mainclasses
+ *   - PcmRingBuffer
+ */
+
+#include "pcmringbuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief 容量向上取整到 2 的幂，最小 4 KiB。
+ * @param capacityBytes 期望容量。
+ */
+PcmRingBuffer::PcmRingBuffer(size_t capacityBytes) {
+    size_t capacity = 4096;
+    while (capacity < capacityBytes) {
+        capacity <<= 1;
+    }
+    m_buffer.resize(capacity);
+    m_mask = capacity - 1;
+}
+
+/**
+ * @brief 读写位置同时归零。
+ */
+void PcmRingBuffer::reset() {
+    m_writePos.store(0, std::memory_order_relaxed);
+    m_readPos.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 写入可分为缓冲区尾部与头部两段，写完后再发布写位置。
+ * @param data 源数据。
+ * @param bytes 字节数。
+ * @return 实际写入字节数。
+ */
+size_t PcmRingBuffer::write(const char* data, size_t bytes) {
+    const uint64_t writePos = m_writePos.load(std::memory_order_relaxed);
+    const uint64_t readPos = m_readPos.load(std::memory_order_acquire);
+    const size_t freeBytes = m_buffer.size() - static_cast<size_t>(writePos - readPos);
+    bytes = std::min(bytes, freeBytes);
+    if (bytes == 0) {
+        return 0;
+    }
+
+    const size_t offset = static_cast<size_t>(writePos) & m_mask;
+    const size_t first = std::min(bytes, m_buffer.size() - offset);
+    std::memcpy(m_buffer.data() + offset, data, first);
+    std::memcpy(m_buffer.data(), data + first, bytes - first);
+    m_writePos.store(writePos + bytes, std::memory_order_release);
+    return bytes;
+}
+
+/**
+ * @brief 可写区域不跨越缓冲区尾部，跨越时调用方只能使用尾部一段。
+ * @param data 输出参数。
+ * @return 字节数。
+ */
+size_t PcmRingBuffer::writableSpan(char** data) {
+    const uint64_t writePos = m_writePos.load(std::memory_order_relaxed);
+    const uint64_t readPos = m_readPos.load(std::memory_order_acquire);
+    const size_t freeBytes = m_buffer.size() - static_cast<size_t>(writePos - readPos);
+    const size_t offset = static_cast<size_t>(writePos) & m_mask;
+    *data = m_buffer.data() + offset;
+    return std::min(freeBytes, m_buffer.size() - offset);
+}
+
+/**
+ * @brief 数据已由调用方写入，只需以 release 语义发布写位置。
+ * @param bytes 字节数。
+ */
+void PcmRingBuffer::commitWrite(size_t bytes) {
+    const uint64_t writePos = m_writePos.load(std::memory_order_relaxed);
+    m_writePos.store(writePos + bytes, std::memory_order_release);
+}
+
+/**
+ * @brief 读取后再发布读位置，生产者随后才能覆盖这段空间。
+ * @param data 目标缓冲。
+ * @param bytes 最多读取字节数。
+ * @return 实际读取字节数。
+ */
+size_t PcmRingBuffer::read(char* data, size_t bytes) {
+    const uint64_t readPos = m_readPos.load(std::memory_order_relaxed);
+    const uint64_t writePos = m_writePos.load(std::memory_order_acquire);
+    bytes = std::min(bytes, static_cast<size_t>(writePos - readPos));
+    if (bytes == 0) {
+        return 0;
+    }
+
+    const size_t offset = static_cast<size_t>(readPos) & m_mask;
+    const size_t first = std::min(bytes, m_buffer.size() - offset);
+    std::memcpy(data, m_buffer.data() + offset, first);
+    std::memcpy(data + first, m_buffer.data(), bytes - first);
+    advanceReadPosition(readPos, readPos + bytes);
+    return bytes;
+}
+
+/**
+ * @brief 只移动读位置。
+ * @param bytes 最多丢弃字节数。
+ * @return 实际丢弃字节数。
+ */
+size_t PcmRingBuffer::discard(size_t bytes) {
+    const uint64_t readPos = m_readPos.load(std::memory_order_relaxed);
+    const uint64_t writePos = m_writePos.load(std::memory_order_acquire);
+    bytes = std::min(bytes, static_cast<size_t>(writePos - readPos));
+    advanceReadPosition(readPos, readPos + bytes);
+    return bytes;
+}
+
+/**
+ * @brief 以 CAS 把读位置推进到写位置之前 keepBytes 处；消费者同时推进时重新计算。
+ * @param keepBytes 保留字节数。
+ * @return 实际丢弃字节数。
+ */
+size_t PcmRingBuffer::discardOldest(size_t keepBytes) {
+    const uint64_t writePos = m_writePos.load(std::memory_order_relaxed);
+    uint64_t readPos = m_readPos.load(std::memory_order_acquire);
+    while (writePos - readPos > keepBytes) {
+        const uint64_t target = writePos - keepBytes;
+        if (m_readPos.compare_exchange_weak(readPos, target, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return static_cast<size_t>(target - readPos);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 通常一次 CAS 即成功；失败说明生产者刚丢弃过数据，只在其结果仍落后于 target 时继续推进。
+ * @param expected 推进前的读位置。
+ * @param target 目标读位置。
+ */
+void PcmRingBuffer::advanceReadPosition(uint64_t expected, uint64_t target) {
+    while (expected < target &&
+        !m_readPos.compare_exchange_weak(expected, target, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 先读读位置再读写位置，保证差值不为负。
+ * @return 字节数。
+ */
+size_t PcmRingBuffer::size() const {
+    const uint64_t readPos = m_readPos.load(std::memory_order_acquire);
+    const uint64_t writePos = m_writePos.load(std::memory_order_acquire);
+    return static_cast<size_t>(writePos - readPos);
+}
+
+/**
+ * @brief 返回容量。
+ * @return 字节数。
+ */
+size_t PcmRingBuffer::capacity() const {
+    return m_buffer.size();
+}
+
+/**
+ * @brief 返回写位置。
+ * @return 字节计数。
+ */
+uint64_t PcmRingBuffer::writePosition() const {
+    return m_writePos.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief 返回读位置。
+ * @return 字节计数。
+ */
+uint64_t PcmRingBuffer::readPosition() const {
+    return m_readPos.load(std::memory_order_acquire);
+}
@@ -0,0 +1,133 @@
+/**
+ * @file pcmringbuffer.h
+ * @brief 定义单生产者/单消费者的无锁 PCM 字节环形缓冲。
+ * @mainfunctions
+ *   - write
+ *   - writableSpan
+ *   - commitWrite
+ *   - read
+ *   - discard
+ *   - discardOldest
+ *   - size
+ * @mainclasses
+ *   - PcmRingBuffer
+ */
+
+#ifndef PCMRINGBUFFER_H
+#define PCMRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief PcmRingBuffer 在音频解码线程与音频设备回调之间传递 PCM 数据。
+ *
+ * 容量取 2 的幂，读写位置为单调递增的 64 位字节计数，按掩码映射到缓冲区，
+ * 因此写满与读空无需额外标志。生产者只修改写位置，读位置由消费者推进，
+ * 双方通过 acquire/release 交接数据，任何一方都不会阻塞对方。
+ * 唯一的例外是 discardOldest：消费者停滞时生产者也可以推进读位置丢弃最旧的数据，
+ * 因此读位置以 CAS 单调推进，两侧的推进取较大者。
+ */
+class PcmRingBuffer {
+public:
+    /**
+     * @brief 构造函数，预先分配缓冲区。
+     * @param capacityBytes 期望容量，向上取整到 2 的幂。
+     */
+    explicit PcmRingBuffer(size_t capacityBytes);
+
+    PcmRingBuffer(const PcmRingBuffer&) = delete;
+    PcmRingBuffer& operator=(const PcmRingBuffer&) = delete;
+
+    /**
+     * @brief 清空缓冲并将读写位置归零，调用时生产者与消费者都不得访问。
+     */
+    void reset();
+
+    /**
+     * @brief 写入数据（仅生产者调用），空间不足时只写入能容纳的部分。
+     * @param data 源数据。
+     * @param bytes 字节数。
+     * @return 实际写入的字节数。
+     */
+    size_t write(const char* data, size_t bytes);
+
+    /**
+     * @brief 获取写位置起始的连续可写区域（仅生产者调用），供调用方原地生成数据。
+     * @param data 输出参数，区域起始地址。
+     * @return 区域字节数，受剩余空间与缓冲区尾部限制。
+     */
+    size_t writableSpan(char** data);
+
+    /**
+     * @brief 发布已在可写区域中写好的数据（仅生产者调用）。
+     * @param bytes 字节数，不得超过 writableSpan 返回值。
+     */
+    void commitWrite(size_t bytes);
+
+    /**
+     * @brief 读出数据（仅消费者调用）。
+     * @param data 目标缓冲。
+     * @param bytes 最多读取的字节数。
+     * @return 实际读取的字节数。
+     */
+    size_t read(char* data, size_t bytes);
+
+    /**
+     * @brief 丢弃已缓存的数据（仅消费者调用）。
+     * @param bytes 最多丢弃的字节数。
+     * @return 实际丢弃的字节数。
+     */
+    size_t discard(size_t bytes);
+
+    /**
+     * @brief 丢弃最旧的数据直到只剩 keepBytes（仅生产者调用），用于消费者停滞时限制排队量。
+     *        与并发的 read 交错时，那一次读出的数据可能夹杂新写入的内容，调用方应只在本就要产生不连续时使用。
+     * @param keepBytes 保留的最新字节数。
+     * @return 实际丢弃的字节数。
+     */
+    size_t discardOldest(size_t keepBytes);
+
+    /**
+     * @brief 查询已缓存的字节数，任意线程可调用（结果为近似快照）。
+     * @return 字节数。
+     */
+    size_t size() const;
+
+    /**
+     * @brief 查询容量。
+     * @return 字节数。
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief 查询累计写入的字节数。
+     * @return 写位置。
+     */
+    uint64_t writePosition() const;
+
+    /**
+     * @brief 查询累计读出（含丢弃）的字节数。
+     * @return 读位置。
+     */
+    uint64_t readPosition() const;
+
+private:
+    /**
+     * @brief 把读位置单调推进到 target，生产者已推进得更远时保留其结果。
+     * @param expected 推进前读到的读位置。
+     * @param target 目标读位置。
+     */
+    void advanceReadPosition(uint64_t expected, uint64_t target);
+
+    std::vector<char> m_buffer;
+    size_t m_mask = 0;
+
+    // 读写位置分处不同缓存行，避免两个线程互相使对方的缓存行失效
+    alignas(64) std::atomic<uint64_t> m_writePos{ 0 };
+    alignas(64) std::atomic<uint64_t> m_readPos{ 0 };
+};
+
+#endif // PCMRINGBUFFER_H
@@ -0,0 +1,61 @@
+/**
+ * @file playerstats.cpp
+ * @brief 实现播放器统计信息的 JSON 序列化。
+ * @mainfunctions
+ *   - PlayerStats::toJson
+ * @mainclasses
+ *   - PlayerStats
+ */
+
+#include "playerstats.h"
+
+/**
+ * @brief 逐字段写入，64 位计数以 double 表示（JSON 数值精度足够覆盖实际取值）。
+ * @return JSON 对象。
+ */
+QJsonObject PlayerStats::toJson() const {
+  QJsonObject object;
+  object.insert(QStringLiteral("videoQueueSize"), videoQueueSize);
+  object.insert(QStringLiteral("audioQueueSize"), audioQueueSize);
+  object.insert(QStringLiteral("incomingBitrateKbps"), incomingBitrateKbps);
+  object.insert(QStringLiteral("jitterBufferMs"), jitterBufferMs);
+  object.insert(QStringLiteral("droppedVideoFrames"), droppedVideoFrames);
+  object.insert(QStringLiteral("avOffsetMs"), avOffsetMs);
+  object.insert(QStringLiteral("presentationJitterMs"), presentationJitterMs);
+  object.insert(QStringLiteral("supersededFrames"), supersededFrames);
+  object.insert(QStringLiteral("videoLatenessMs"), videoLatenessMs);
+  object.insert(QStringLiteral("lateDroppedFrames"), lateDroppedFrames);
+  object.insert(QStringLiteral("latencyMs"), latencyMs);
+  object.insert(QStringLiteral("playbackRate"), playbackRate);
+  object.insert(QStringLiteral("latencyJumps"), latencyJumps);
+  object.insert(QStringLiteral("audioBufferMs"), audioBufferMs);
+  object.insert(QStringLiteral("audioDriftPpm"), audioDriftPpm);
+  object.insert(QStringLiteral("audioRingMs"), audioRingMs);
+  object.insert(QStringLiteral("audioUnderruns"), audioUnderruns);
+  object.insert(QStringLiteral("audioTrimmedSamples"), static_cast<double>(audioTrimmedSamples));
+  object.insert(QStringLiteral("audioSetupMs"), audioSetupMs);
+  object.insert(QStringLiteral("audioSetupMaxMs"), audioSetupMaxMs);
+  object.insert(QStringLiteral("audioSetupCount"), audioSetupCount);
+  object.insert(QStringLiteral("audioPassthrough"), audioPassthrough);
+  object.insert(QStringLiteral("audioPeakDb"), audioPeakDb);
+  object.insert(QStringLiteral("audioRmsDb"), audioRmsDb);
+  object.insert(QStringLiteral("audioMuted"), audioMuted);
+  object.insert(QStringLiteral("decodedVideoFrames"), static_cast<double>(decodedVideoFrames));
+  object.insert(QStringLiteral("presentedVideoFrames"), static_cast<double>(presentedVideoFrames));
+  object.insert(QStringLiteral("inputVideoPackets"), static_cast<double>(inputVideoPackets));
+  object.insert(QStringLiteral("inputFps"), inputFps);
+  object.insert(QStringLiteral("decodedFps"), decodedFps);
+  object.insert(QStringLiteral("presentedFps"), presentedFps);
+  object.insert(QStringLiteral("decodeP50Ms"), decodeP50Ms);
+  object.insert(QStringLiteral("decodeP99Ms"), decodeP99Ms);
+  object.insert(QStringLiteral("convertP50Ms"), convertP50Ms);
+  object.insert(QStringLiteral("convertP99Ms"), convertP99Ms);
+  object.insert(QStringLiteral("msSinceLastFrame"), msSinceLastFrame);
+  object.insert(QStringLiteral("stallCount"), stallCount);
+  object.insert(QStringLiteral("stallTotalMs"), stallTotalMs);
+  object.insert(QStringLiteral("reconnectCount"), reconnectCount);
+  object.insert(QStringLiteral("timeToFirstFrameMs"), timeToFirstFrameMs);
+  object.insert(QStringLiteral("framePoolHits"), static_cast<double>(framePoolHits));
+  object.insert(QStringLiteral("framePoolMisses"), static_cast<double>(framePoolMisses));
+  return object;
+}
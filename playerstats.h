@@ -2,7 +2,7 @@
  * @file playerstats.h
  * @brief 定义播放器统计信息结构体。
  * @mainfunctions
- *   - 无
+ *   - PlayerStats::toJson
  * @mainclasses
  *   - PlayerStats
  */
@@ -10,6 +10,7 @@
 #ifndef PLAYERSTATS_H
 #define PLAYERSTATS_H
 
+#include <QJsonObject>
 #include <QMetaType>
 
  /**
@@ -20,7 +21,50 @@ struct PlayerStats {
   int audioQueueSize = 0;
   double incomingBitrateKbps = 0.0;
   double jitterBufferMs = 0.0;
-  int droppedVideoFrames = 0;  // 累计丢弃的视频包数
+  int droppedVideoFrames = 0;  // 累计丢弃的视频包数（队列溢出与延迟追赶跳过）
+  double avOffsetMs = 0.0;            // 最近呈现帧相对主时钟的偏差，负值表示视频落后
+  double presentationJitterMs = 0.0;  // 呈现偏差的平滑抖动
+  int supersededFrames = 0;           // 显示前即被新帧覆盖的帧数（UI 线程跟不上时增加）
+  double videoLatenessMs = 0.0;       // 最近解码帧相对主时钟的迟到量，负值表示提前
+  int lateDroppedFrames = 0;          // 因迟到而未转换即丢弃的帧数
+  double latencyMs = 0.0;             // 已接收的最新数据与当前播放位置之差
+  double playbackRate = 1.0;          // 当前播放速率，追赶时大于 1
+  int latencyJumps = 0;               // 为限制延迟而跳到最新关键帧的次数
+  double audioBufferMs = 0.0;         // 音频待写队列与设备缓冲的总水位
+  double audioDriftPpm = 0.0;         // 估计的发送端音频时钟相对声卡的偏差
+  double audioRingMs = 0.0;           // PCM 环形缓冲中排队的时长
+  int audioUnderruns = 0;             // 音频缓冲读空、以静音补齐的次数
+  qint64 audioTrimmedSamples = 0;     // 排队超出时长上限而丢弃的采样帧数
+  double audioSetupMs = 0.0;          // 最近一次连接时解复用线程准备音频输出的耗时
+  double audioSetupMaxMs = 0.0;       // 各次连接中准备音频输出的最大耗时
+  int audioSetupCount = 0;            // 准备音频输出的次数（首次连接加每次重连）
+  bool audioPassthrough = false;      // 音频是否绕过重采样器直接交错输出
+  double audioPeakDb = -100.0;        // 最近 100ms 解码音频的峰值电平 (dBFS，增益前)
+  double audioRmsDb = -100.0;         // 最近 100ms 解码音频的 RMS 电平 (dBFS，增益前)
+  bool audioMuted = false;            // 是否静音（仍统计电平）
+  qint64 decodedVideoFrames = 0;      // 累计解码的视频帧数
+  qint64 presentedVideoFrames = 0;    // 累计到达呈现时刻的视频帧数（含未转换的只解码模式）
+  qint64 inputVideoPackets = 0;       // 累计接收并入队的视频包数
+  double inputFps = 0.0;              // 最近约 1 秒接收的视频包速率
+  double decodedFps = 0.0;            // 最近约 1 秒解码的视频帧速率
+  double presentedFps = 0.0;          // 最近约 1 秒呈现的视频帧速率
+  double decodeP50Ms = 0.0;           // 最近 5~10 秒视频解码（送包+取帧）耗时分位数
+  double decodeP99Ms = 0.0;
+  double convertP50Ms = 0.0;          // 最近 5~10 秒视频转换耗时分位数
+  double convertP99Ms = 0.0;
+  double msSinceLastFrame = -1.0;     // 距最近一次呈现帧的时长，尚无帧时为 -1
+  int stallCount = 0;                 // 首帧后呈现间隔超过卡顿阈值的次数，含进行中的一次
+  double stallTotalMs = 0.0;          // 卡顿累计时长，含进行中的一次
+  int reconnectCount = 0;             // 首次连接成功后重新连接成功的次数
+  double timeToFirstFrameMs = -1.0;   // 自 start() 到首帧呈现的耗时，尚无帧时为 -1
+  qint64 framePoolHits = 0;           // 转换输出直接复用池中缓冲区的次数（播放器生命周期内累计）
+  qint64 framePoolMisses = 0;         // 转换输出需要新分配（池未满或池耗尽退化）的次数
+
+  /**
+   * @brief 转换为 JSON 对象，字段名与成员名一致，供无界面模式逐行输出。
+   * @return JSON 对象。
+   */
+  QJsonObject toJson() const;
 };
 
 Q_DECLARE_METATYPE(PlayerStats)
@@ -0,0 +1,23 @@
+/**
+ * @file probes.cpp
+ * @brief 定义 USDT 探针的信号量，挂载工具通过 ELF note 中记录的地址增减计数以开关探针。
+ * @mainfunctions
+ *   - 无
+ * @mainclasses
+ *   - 无
+ */
+
+#include "probes.h"
+
+#ifdef LSP_ENABLE_USDT
+
+// sys/sdt.h 约定的信号量：放在 .probes 节，名称为 <provider>_<name>_semaphore
+#define LSP_DEFINE_PROBE_SEMAPHORE(name) \
+    __attribute__((section(".probes"))) volatile unsigned short lsp_##name##_semaphore = 0;
+extern "C"
+{
+LSP_PROBE_LIST(LSP_DEFINE_PROBE_SEMAPHORE)
+}
+#undef LSP_DEFINE_PROBE_SEMAPHORE
+
+#endif // LSP_ENABLE_USDT
@@ -0,0 +1,96 @@
+/**
+ * @file probes.h
+ * @brief 定义 USDT 静态探针，供 perf / bpftrace 在生产环境挂载观测流水线边界。
+ *
+ * 以 CMake 选项 LSP_ENABLE_USDT 打开（需要 systemtap-sdt 提供的 sys/sdt.h）。打开后每个探针带一个信号量
+ * lsp_<name>_semaphore（定义在 probes.cpp），挂载工具附加时将其加一；探针先检查信号量，未挂载时只多一次
+ * 内存读取与一个预测为不跳转的分支，参数不求值，挂载后才执行 nop 指令并由内核读取参数。
+ * 关闭时宏展开为空语句，参数同样不求值。提供者名为 lsp，参数均为整数：
+ *
+ *   packet_read        (stream, pts, dts, size, flags)
+ *   queue_push         (stream, pts, size, queued)
+ *   queue_drop         (stream, pts, size, reason)          reason: 0 溢出 1 跳到关键帧 2 早于阈值
+ *   video_decode_start (stream, pts, size)
+ *   video_decode_end   (stream, pts, decode_us, frames)
+ *   audio_decode_start (stream, pts, size)
+ *   audio_decode_end   (stream, pts, decode_us, samples)
+ *   convert_start      (stream, pts, width, height)
+ *   convert_end        (stream, pts, convert_us, bytes)
+ *   reconnect          (attempt, max_attempts, delay_ms, reason)  reason: 0 连接失败 1 连接断开
+ *   audio_underrun     (count, missing_bytes, requested_bytes)
+ *
+ * pts 为所在流时间基下的原始值，缺失时为 AV_NOPTS_VALUE；耗时单位为微秒。video_decode_end 的 frames 为该包解出、
+ * 转换后进入呈现等待的帧数（解码时已判定迟到而丢弃的不计，之后在呈现等待中丢弃的仍计入）；audio_decode_end 每帧触发一次，decode_us 自送包起算；convert_end 的 bytes 为输出图像大小。例如：
+ *   bpftrace -e 'usdt:./LiveStreamPlayerHeadless:lsp:video_decode_end { @us = hist(arg2); }'
+ * @mainfunctions
+ *   - LSP_PROBE1 ... LSP_PROBE5
+ *   - LSP_PROBE_ENABLED
+ *   - LSP_PROBE_TIME_US
+ * @mainclasses
+ *   - 无
+ */
+
+#ifndef PROBES_H
+#define PROBES_H
+
+// 全部探针名，新增探针时在此登记，probes.cpp 据此定义信号量
+#define LSP_PROBE_LIST(X) \
+    X(packet_read) \
+    X(queue_push) \
+    X(queue_drop) \
+    X(video_decode_start) \
+    X(video_decode_end) \
+    X(audio_decode_start) \
+    X(audio_decode_end) \
+    X(convert_start) \
+    X(convert_end) \
+    X(reconnect) \
+    X(audio_underrun)
+
+#ifdef LSP_ENABLE_USDT
+
+// 让 sys/sdt.h 在 ELF note 中记录各探针信号量的地址，挂载工具据此开关探针
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+extern "C"
+{
+#include <libavutil/time.h>
+}
+
+#define LSP_DECLARE_PROBE_SEMAPHORE(name) extern "C" volatile unsigned short lsp_##name##_semaphore;
+LSP_PROBE_LIST(LSP_DECLARE_PROBE_SEMAPHORE)
+#undef LSP_DECLARE_PROBE_SEMAPHORE
+
+// 探针是否已被挂载
+#define LSP_PROBE_ENABLED(name) __builtin_expect(lsp_##name##_semaphore != 0, 0)
+
+#define LSP_PROBE1(name, a1) \
+    do { if (LSP_PROBE_ENABLED(name)) { STAP_PROBE1(lsp, name, a1); } } while (0)
+#define LSP_PROBE2(name, a1, a2) \
+    do { if (LSP_PROBE_ENABLED(name)) { STAP_PROBE2(lsp, name, a1, a2); } } while (0)
+#define LSP_PROBE3(name, a1, a2, a3) \
+    do { if (LSP_PROBE_ENABLED(name)) { STAP_PROBE3(lsp, name, a1, a2, a3); } } while (0)
+#define LSP_PROBE4(name, a1, a2, a3, a4) \
+    do { if (LSP_PROBE_ENABLED(name)) { STAP_PROBE4(lsp, name, a1, a2, a3, a4); } } while (0)
+#define LSP_PROBE5(name, a1, a2, a3, a4, a5) \
+    do { if (LSP_PROBE_ENABLED(name)) { STAP_PROBE5(lsp, name, a1, a2, a3, a4, a5); } } while (0)
+
+// 仅为探针参数计时的时钟读数：给定探针未挂载时为 0，不读取时钟
+#define LSP_PROBE_TIME_US(name) (LSP_PROBE_ENABLED(name) ? av_gettime_relative() : static_cast<int64_t>(0))
+
+#else
+
+#define LSP_PROBE_ENABLED(name) false
+
+#define LSP_PROBE1(name, a1) do { } while (0)
+#define LSP_PROBE2(name, a1, a2) do { } while (0)
+#define LSP_PROBE3(name, a1, a2, a3) do { } while (0)
+#define LSP_PROBE4(name, a1, a2, a3, a4) do { } while (0)
+#define LSP_PROBE5(name, a1, a2, a3, a4, a5) do { } while (0)
+
+#define LSP_PROBE_TIME_US(name) (static_cast<int64_t>(0))
+
+#endif // LSP_ENABLE_USDT
+
+#endif // PROBES_H
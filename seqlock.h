@@ -0,0 +1,90 @@
+/**
+ * @file seqlock.h
+ * @brief 定义单写者多读者的顺序锁快照，用于在线程间发布小型平凡可复制结构体（如统计信息）。
+ * @mainfunctions
+ *   - Seqlock::store
+ *   - Seqlock::load
+ * @mainclasses
+ *   - Seqlock
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+/**
+ * @brief Seqlock 保存一个值的最新快照：写者不等待读者，读者不阻塞写者。
+ *
+ * 写入前后各递增一次序号，奇数表示写入进行中；读者复制内容后序号不变才算读到一致的快照，
+ * 否则重试。内容按 64 位字存成 relaxed 原子，使并发复制也没有数据竞争。
+ * 只允许一个线程写入，值类型须平凡可复制。
+ */
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock requires a trivially copyable type");
+
+public:
+    /**
+     * @brief 以值类型的默认值初始化。
+     */
+    Seqlock() {
+        store(T());
+    }
+
+    Seqlock(const Seqlock&) = delete;
+    Seqlock& operator=(const Seqlock&) = delete;
+
+    /**
+     * @brief 发布新值，只能由唯一的写者线程调用。
+     * @param value 新值。
+     */
+    void store(const T& value) {
+        uint64_t words[kWordCount] = {};
+        std::memcpy(words, &value, sizeof(T));
+        const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int i = 0; i < kWordCount; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief 读取最近一次发布的值，任意线程可调用。
+     * @return 一致的快照。
+     */
+    T load() const {
+        uint64_t words[kWordCount];
+        for (;;) {
+            const uint64_t before = m_sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (int i = 0; i < kWordCount; ++i) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr int kWordCount = static_cast<int>((sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+
+    std::atomic<uint64_t> m_sequence{ 0 };
+    std::atomic<uint64_t> m_words[kWordCount] = {};
+};
+
+#endif // SEQLOCK_H
@@ -0,0 +1,439 @@
+/**
+ * @file syntheticstream.cpp
+ * @brief 实现合成测试流的编码与环回 TCP 服务端的匀速发送。
+ * @mainfunctions
+ *   - SyntheticStream::generate
+ *   - LoopbackStreamServer::serve
+ * @mainclasses
+ *   - SyntheticStream
+ *   - LoopbackStreamServer
+ */
+
+#include "syntheticstream.h"
+
+#include <QByteArray>
+#include <QFile>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+}
+
+namespace {
+    constexpr int kAudioSampleRate = 48000;
+    constexpr int kAudioChannels = 2;
+    constexpr int64_t kAudioBitrate = 128000;
+    constexpr double kToneHz = 440.0;
+    constexpr double kToneAmplitude = 0.25;     // -12 dBFS
+    constexpr int kServerChunkBytes = 64 * 1024;
+    constexpr int kServerPollMs = 5;            // 发送节奏等待时检查停止标志的间隔
+    constexpr double kPi = 3.14159265358979323846;
+
+    /**
+     * @brief 将 FFmpeg 错误码转化为 QString。
+     * @param errorCode libav 错误码。
+     * @return 可读错误信息。
+     */
+    QString ffmpegErrorString(int errorCode) {
+        char buffer[AV_ERROR_MAX_STRING_SIZE] = { 0 };
+        av_strerror(errorCode, buffer, sizeof(buffer));
+        return QString::fromUtf8(buffer);
+    }
+
+    /**
+     * @brief 写入失败原因。
+     * @param error 输出参数，可为空。
+     * @param message 原因。
+     * @return 总是 false，便于直接 return。
+     */
+    bool fail(QString* error, const QString& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 生成过程持有的 FFmpeg 对象，析构时统一释放。
+     */
+    struct EncodeSession {
+        AVFormatContext* format = nullptr;
+        AVCodecContext* video = nullptr;
+        AVCodecContext* audio = nullptr;
+        AVStream* videoStream = nullptr;
+        AVStream* audioStream = nullptr;
+        AVFrame* frame = nullptr;
+        AVPacket* packet = nullptr;
+
+        ~EncodeSession() {
+            av_packet_free(&packet);
+            av_frame_free(&frame);
+            avcodec_free_context(&audio);
+            avcodec_free_context(&video);
+            if (format) {
+                if (format->pb && !(format->oformat->flags & AVFMT_NOFILE)) {
+                    avio_closep(&format->pb);
+                }
+                avformat_free_context(format);
+            }
+        }
+    };
+
+    /**
+     * @brief 查找视频编码器：优先 x264/x265（可设置直播预设），否则使用任意可用的同类编码器。
+     * @param codec 编码类型。
+     * @param tunable 输出参数，是否为支持 preset/tune 选项的 x26x。
+     * @return 编码器，找不到时为空。
+     */
+    const AVCodec* findVideoEncoder(SyntheticStream::VideoCodec codec, bool* tunable) {
+        const bool hevc = codec == SyntheticStream::VideoCodec::Hevc;
+        const AVCodec* encoder = avcodec_find_encoder_by_name(hevc ? "libx265" : "libx264");
+        *tunable = encoder != nullptr;
+        if (!encoder) {
+            encoder = avcodec_find_encoder(hevc ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264);
+        }
+        return encoder;
+    }
+
+    /**
+     * @brief 画面：对角移动的亮度渐变，叠加低幅度伪随机噪声，使每帧都有真实的残差需要编码；色度缓慢变化。
+     * @param frame 目标帧（YUV420P，已可写）。
+     * @param index 帧序号。
+     * @param noiseState xorshift 状态，跨帧延续。
+     */
+    void fillVideoFrame(AVFrame* frame, int64_t index, uint32_t* noiseState) {
+        const int shift = static_cast<int>(index * 4);
+        for (int y = 0; y < frame->height; ++y) {
+            uint8_t* row = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+            uint32_t state = *noiseState;
+            for (int x = 0; x < frame->width; ++x) {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                row[x] = static_cast<uint8_t>(((x + y + shift) & 0xFF) ^ (state & 0x0F));
+            }
+            *noiseState = state;
+        }
+        const uint8_t u = static_cast<uint8_t>(128 + 48 * std::sin(static_cast<double>(index) * 0.05));
+        const uint8_t v = static_cast<uint8_t>(128 + 48 * std::cos(static_cast<double>(index) * 0.03));
+        const int chromaHeight = (frame->height + 1) / 2;
+        const int chromaWidth = (frame->width + 1) / 2;
+        for (int y = 0; y < chromaHeight; ++y) {
+            std::fill_n(frame->data[1] + static_cast<ptrdiff_t>(y) * frame->linesize[1], chromaWidth, u);
+            std::fill_n(frame->data[2] + static_cast<ptrdiff_t>(y) * frame->linesize[2], chromaWidth, v);
+        }
+    }
+
+    /**
+     * @brief 音频：各声道相同的 440 Hz 正弦（平面浮点）。
+     * @param frame 目标帧（FLTP，已可写）。
+     * @param firstSample 本帧首个采样的全局序号。
+     */
+    void fillAudioFrame(AVFrame* frame, int64_t firstSample) {
+        for (int i = 0; i < frame->nb_samples; ++i) {
+            const double phase = 2.0 * kPi * kToneHz * static_cast<double>(firstSample + i) / kAudioSampleRate;
+            const float sample = static_cast<float>(kToneAmplitude * std::sin(phase));
+            for (int ch = 0; ch < kAudioChannels; ++ch) {
+                reinterpret_cast<float*>(frame->data[ch])[i] = sample;
+            }
+        }
+    }
+
+    /**
+     * @brief 送入一帧（为空时冲刷编码器），把产出的包换算时间基后交错写入。
+     * @param session 生成会话。
+     * @param encoder 编码器上下文。
+     * @param stream 对应输出流。
+     * @param frame 待编码帧，空表示冲刷。
+     * @param error 输出参数。
+     * @return 成功返回 true。
+     */
+    bool encodeAndWrite(EncodeSession& session, AVCodecContext* encoder, AVStream* stream, const AVFrame* frame, QString* error) {
+        int ret = avcodec_send_frame(encoder, frame);
+        if (ret < 0) {
+            return fail(error, QStringLiteral("编码失败：%1").arg(ffmpegErrorString(ret)));
+        }
+        while ((ret = avcodec_receive_packet(encoder, session.packet)) >= 0) {
+            av_packet_rescale_ts(session.packet, encoder->time_base, stream->time_base);
+            session.packet->stream_index = stream->index;
+            ret = av_interleaved_write_frame(session.format, session.packet);
+            if (ret < 0) {
+                return fail(error, QStringLiteral("写入失败：%1").arg(ffmpegErrorString(ret)));
+            }
+        }
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+            return fail(error, QStringLiteral("编码失败：%1").arg(ffmpegErrorString(ret)));
+        }
+        return true;
+    }
+}
+
+/**
+ * @brief 按时间交错编码视频帧与音频帧，最后冲刷两个编码器并写出文件尾。
+ * @param config 生成参数。
+ * @param path 输出路径。
+ * @param error 可选输出参数。
+ * @return 成功返回 true。
+ */
+bool SyntheticStream::generate(const Config& config, const QString& path, QString* error) {
+    if (config.width <= 0 || config.height <= 0 || config.fps <= 0 || config.gopSize <= 0 || config.durationSec <= 0) {
+        return fail(error, QStringLiteral("无效的生成参数"));
+    }
+
+    EncodeSession session;
+    const QByteArray pathUtf8 = path.toUtf8();
+    int ret = avformat_alloc_output_context2(&session.format, nullptr, "mpegts", pathUtf8.constData());
+    if (ret < 0 || !session.format) {
+        return fail(error, QStringLiteral("无法创建输出：%1").arg(ffmpegErrorString(ret)));
+    }
+    const bool globalHeader = (session.format->oformat->flags & AVFMT_GLOBALHEADER) != 0;
+
+    bool tunable = false;
+    const AVCodec* videoCodec = findVideoEncoder(config.codec, &tunable);
+    if (!videoCodec) {
+        return fail(error, QStringLiteral("找不到视频编码器"));
+    }
+    session.video = avcodec_alloc_context3(videoCodec);
+    session.video->width = config.width;
+    session.video->height = config.height;
+    session.video->pix_fmt = AV_PIX_FMT_YUV420P;
+    session.video->time_base = AVRational{ 1, config.fps };
+    session.video->framerate = AVRational{ config.fps, 1 };
+    session.video->gop_size = config.gopSize;
+    session.video->max_b_frames = 0;
+    const int bitrateKbps = config.bitrateKbps > 0 ? config.bitrateKbps : defaultBitrateKbps(config.width, config.height);
+    session.video->bit_rate = static_cast<int64_t>(bitrateKbps) * 1000;
+    if (tunable && session.video->priv_data) {
+        av_opt_set(session.video->priv_data, "preset", config.codec == VideoCodec::Hevc ? "ultrafast" : "veryfast", 0);
+        av_opt_set(session.video->priv_data, "tune", "zerolatency", 0);
+    }
+    if (globalHeader) {
+        session.video->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    ret = avcodec_open2(session.video, videoCodec, nullptr);
+    if (ret < 0) {
+        return fail(error, QStringLiteral("无法打开视频编码器 %1：%2")
+            .arg(QString::fromUtf8(videoCodec->name), ffmpegErrorString(ret)));
+    }
+    session.videoStream = avformat_new_stream(session.format, nullptr);
+    avcodec_parameters_from_context(session.videoStream->codecpar, session.video);
+    session.videoStream->time_base = session.video->time_base;
+
+    if (config.withAudio) {
+        const AVCodec* audioCodec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+        if (!audioCodec) {
+            return fail(error, QStringLiteral("找不到 AAC 编码器"));
+        }
+        session.audio = avcodec_alloc_context3(audioCodec);
+        session.audio->sample_fmt = AV_SAMPLE_FMT_FLTP;
+        session.audio->sample_rate = kAudioSampleRate;
+        av_channel_layout_default(&session.audio->ch_layout, kAudioChannels);
+        session.audio->bit_rate = kAudioBitrate;
+        session.audio->time_base = AVRational{ 1, kAudioSampleRate };
+        if (globalHeader) {
+            session.audio->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        }
+        ret = avcodec_open2(session.audio, audioCodec, nullptr);
+        if (ret < 0) {
+            return fail(error, QStringLiteral("无法打开音频编码器：%1").arg(ffmpegErrorString(ret)));
+        }
+        session.audioStream = avformat_new_stream(session.format, nullptr);
+        avcodec_parameters_from_context(session.audioStream->codecpar, session.audio);
+        session.audioStream->time_base = session.audio->time_base;
+    }
+
+    if (!(session.format->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&session.format->pb, pathUtf8.constData(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            return fail(error, QStringLiteral("无法写入 %1：%2").arg(path, ffmpegErrorString(ret)));
+        }
+    }
+    ret = avformat_write_header(session.format, nullptr);
+    if (ret < 0) {
+        return fail(error, QStringLiteral("写入文件头失败：%1").arg(ffmpegErrorString(ret)));
+    }
+
+    session.frame = av_frame_alloc();
+    session.packet = av_packet_alloc();
+    AVFrame* videoFrame = av_frame_alloc();
+    AVFrame* audioFrame = av_frame_alloc();
+    const auto freeFrames = [&videoFrame, &audioFrame]() {
+        av_frame_free(&videoFrame);
+        av_frame_free(&audioFrame);
+    };
+    videoFrame->format = AV_PIX_FMT_YUV420P;
+    videoFrame->width = config.width;
+    videoFrame->height = config.height;
+    if (av_frame_get_buffer(videoFrame, 0) < 0) {
+        freeFrames();
+        return fail(error, QStringLiteral("无法分配视频帧"));
+    }
+    const int audioFrameSamples = session.audio && session.audio->frame_size > 0 ? session.audio->frame_size : 1024;
+    if (session.audio) {
+        audioFrame->format = AV_SAMPLE_FMT_FLTP;
+        audioFrame->sample_rate = kAudioSampleRate;
+        audioFrame->nb_samples = audioFrameSamples;
+        av_channel_layout_copy(&audioFrame->ch_layout, &session.audio->ch_layout);
+        if (av_frame_get_buffer(audioFrame, 0) < 0) {
+            freeFrames();
+            return fail(error, QStringLiteral("无法分配音频帧"));
+        }
+    }
+
+    const int64_t totalVideoFrames = static_cast<int64_t>(config.durationSec) * config.fps;
+    const int64_t totalAudioSamples = session.audio ? static_cast<int64_t>(config.durationSec) * kAudioSampleRate : 0;
+    int64_t videoIndex = 0;
+    int64_t audioSamples = 0;
+    uint32_t noiseState = 0x9E3779B9u;
+    while (videoIndex < totalVideoFrames || audioSamples < totalAudioSamples) {
+        // 总是先编码时间戳更早的一路，使复用器缓存的包尽量少
+        const double videoTime = static_cast<double>(videoIndex) / config.fps;
+        const double audioTime = static_cast<double>(audioSamples) / kAudioSampleRate;
+        const bool videoNext = videoIndex < totalVideoFrames && (audioSamples >= totalAudioSamples || videoTime <= audioTime);
+        bool ok = true;
+        if (videoNext) {
+            av_frame_make_writable(videoFrame);
+            fillVideoFrame(videoFrame, videoIndex, &noiseState);
+            videoFrame->pts = videoIndex++;
+            ok = encodeAndWrite(session, session.video, session.videoStream, videoFrame, error);
+        }
+        else {
+            av_frame_make_writable(audioFrame);
+            fillAudioFrame(audioFrame, audioSamples);
+            audioFrame->pts = audioSamples;
+            audioSamples += audioFrameSamples;
+            ok = encodeAndWrite(session, session.audio, session.audioStream, audioFrame, error);
+        }
+        if (!ok) {
+            freeFrames();
+            return false;
+        }
+    }
+    freeFrames();
+
+    if (!encodeAndWrite(session, session.video, session.videoStream, nullptr, error)) {
+        return false;
+    }
+    if (session.audio && !encodeAndWrite(session, session.audio, session.audioStream, nullptr, error)) {
+        return false;
+    }
+    ret = av_write_trailer(session.format);
+    if (ret < 0) {
+        return fail(error, QStringLiteral("写入文件尾失败：%1").arg(ffmpegErrorString(ret)));
+    }
+    return true;
+}
+
+/**
+ * @brief 以像素数分档。
+ * @param width 宽度。
+ * @param height 高度。
+ * @return kbps。
+ */
+int SyntheticStream::defaultBitrateKbps(int width, int height) {
+    const int64_t pixels = static_cast<int64_t>(width) * height;
+    if (pixels > 1920 * 1080) {
+        return 20000;
+    }
+    if (pixels > 1280 * 720) {
+        return 6000;
+    }
+    return 3000;
+}
+
+/**
+ * @brief 停止线程。
+ */
+LoopbackStreamServer::~LoopbackStreamServer() {
+    stop();
+}
+
+/**
+ * @brief 重复调用时先停止上一次的服务。
+ * @param path 文件路径。
+ * @param port 监听端口。
+ * @param durationSec 文件时长。
+ */
+void LoopbackStreamServer::start(const QString& path, int port, int durationSec) {
+    stop();
+    m_stop.store(false, std::memory_order_release);
+    m_port = port;
+    m_thread = std::thread(&LoopbackStreamServer::serve, this, path, durationSec);
+}
+
+/**
+ * @brief 置停止标志后等待线程结束。
+ */
+void LoopbackStreamServer::stop() {
+    m_stop.store(true, std::memory_order_release);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+/**
+ * @brief 生成客户端地址。
+ * @return 地址。
+ */
+QString LoopbackStreamServer::url() const {
+    return QStringLiteral("tcp://127.0.0.1:%1").arg(m_port);
+}
+
+/**
+ * @brief 等待一个客户端连接，随后每发送一块就按平均码率睡眠到该块应到达的时刻。
+ * @param path 文件路径。
+ * @param durationSec 文件时长。
+ */
+void LoopbackStreamServer::serve(QString path, int durationSec) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const double bytesPerSecond = static_cast<double>(file.size()) / std::max(1, durationSec);
+
+    const AVIOInterruptCB interrupt{ &LoopbackStreamServer::interruptCallback, this };
+    const QByteArray listenUrl = QStringLiteral("tcp://127.0.0.1:%1?listen=1").arg(m_port).toUtf8();
+    AVIOContext* io = nullptr;
+    if (avio_open2(&io, listenUrl.constData(), AVIO_FLAG_WRITE, &interrupt, nullptr) < 0) {
+        return;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    qint64 sentBytes = 0;
+    while (!m_stop.load(std::memory_order_acquire)) {
+        const QByteArray chunk = file.read(kServerChunkBytes);
+        if (chunk.isEmpty()) {
+            break;
+        }
+        avio_write(io, reinterpret_cast<const unsigned char*>(chunk.constData()), chunk.size());
+        avio_flush(io);
+        if (io->error < 0) {
+            break; // 客户端已断开
+        }
+        sentBytes += chunk.size();
+
+        const auto due = startTime + std::chrono::microseconds(static_cast<int64_t>(sentBytes / bytesPerSecond * 1e6));
+        while (!m_stop.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < due) {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                due - std::chrono::steady_clock::now(), std::chrono::milliseconds(kServerPollMs)));
+        }
+    }
+    avio_closep(&io);
+}
+
+/**
+ * @brief 停止标志置位后中断监听或阻塞写。
+ * @param opaque LoopbackStreamServer 指针。
+ * @return 非零表示中断。
+ */
+int LoopbackStreamServer::interruptCallback(void* opaque) {
+    const auto* server = static_cast<const LoopbackStreamServer*>(opaque);
+    return server->m_stop.load(std::memory_order_acquire) ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file syntheticstream.h
+ * @brief 定义基准测试使用的合成流：本地编码 H.264/HEVC + AAC 的 MPEG-TS 文件，以及以实时速率回放它的环回 TCP 服务端。
+ * @mainfunctions
+ *   - SyntheticStream::generate
+ *   - SyntheticStream::defaultBitrateKbps
+ *   - LoopbackStreamServer::start
+ *   - LoopbackStreamServer::stop
+ * @mainclasses
+ *   - SyntheticStream
+ *   - LoopbackStreamServer
+ */
+
+#ifndef SYNTHETICSTREAM_H
+#define SYNTHETICSTREAM_H
+
+#include <QString>
+
+#include <atomic>
+#include <thread>
+
+/**
+ * @brief SyntheticStream 生成内容确定的测试流：移动渐变叠加伪随机噪声的画面（避免编码器把画面压得过小）
+ *        与 440 Hz 正弦音频。编码参数模拟直播源：无 B 帧、固定 GOP、目标码率。
+ */
+class SyntheticStream {
+public:
+    enum class VideoCodec {
+        H264,
+        Hevc
+    };
+
+    /**
+     * @brief 生成参数。
+     */
+    struct Config {
+        VideoCodec codec = VideoCodec::H264;
+        int width = 1280;
+        int height = 720;
+        int fps = 30;
+        int gopSize = 60;           // 关键帧间隔（帧）
+        int bitrateKbps = 0;        // 0 表示按分辨率取默认值
+        int durationSec = 30;
+        bool withAudio = true;      // 48 kHz 立体声 AAC
+    };
+
+    /**
+     * @brief 编码并写出 MPEG-TS 文件，优先使用 libx264/libx265，缺失时退回 FFmpeg 内置的同类编码器。
+     * @param config 生成参数。
+     * @param path 输出路径。
+     * @param error 可选输出参数，失败原因。
+     * @return 成功返回 true。
+     */
+    static bool generate(const Config& config, const QString& path, QString* error = nullptr);
+
+    /**
+     * @brief 按像素数给出常见的直播码率（720p 3 Mbps、1080p 6 Mbps、4K 20 Mbps）。
+     * @param width 宽度。
+     * @param height 高度。
+     * @return kbps。
+     */
+    static int defaultBitrateKbps(int width, int height);
+};
+
+/**
+ * @brief LoopbackStreamServer 在 127.0.0.1 上监听 TCP 端口，客户端连接后按文件平均码率匀速发送文件内容，
+ *        模拟网络直播源的到达节奏（含 TCP 协议栈开销），发送完毕后关闭连接。
+ */
+class LoopbackStreamServer {
+public:
+    LoopbackStreamServer() = default;
+    LoopbackStreamServer(const LoopbackStreamServer&) = delete;
+    LoopbackStreamServer& operator=(const LoopbackStreamServer&) = delete;
+
+    /**
+     * @brief 析构时停止服务线程。
+     */
+    ~LoopbackStreamServer();
+
+    /**
+     * @brief 启动服务线程，立即返回；线程在客户端连接前阻塞于监听。
+     * @param path 要发送的文件。
+     * @param port 监听端口。
+     * @param durationSec 文件时长，用于计算发送速率。
+     */
+    void start(const QString& path, int port, int durationSec);
+
+    /**
+     * @brief 请求停止并等待线程退出（监听与发送均可被打断）。
+     */
+    void stop();
+
+    /**
+     * @brief 获取供播放器使用的地址。
+     * @return tcp://127.0.0.1:port 形式的地址。
+     */
+    QString url() const;
+
+private:
+    /**
+     * @brief 服务线程主体。
+     * @param path 文件路径。
+     * @param durationSec 文件时长。
+     */
+    void serve(QString path, int durationSec);
+
+    /**
+     * @brief FFmpeg 阻塞操作的中断回调。
+     * @param opaque LoopbackStreamServer 指针。
+     * @return 非零表示中断。
+     */
+    static int interruptCallback(void* opaque);
+
+    std::thread m_thread;
+    std::atomic_bool m_stop{ false };
+    int m_port = 0;
+};
+
+#endif // SYNTHETICSTREAM_H
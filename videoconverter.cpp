@@ -0,0 +1,396 @@
+/**
+ * @file videoconverter.cpp
+ * @brief 实现解码帧到显示尺寸 QImage 的缩放与颜色转换。
+ * @mainfunctions
+ *   - VideoConverter::convert
+ *   - VideoConverter::convertSliced
+ *   - VideoConverter::convertDirect
+ *   - VideoConverter::acquireScalers
+ *   - VideoConverter::reset
+ *   - VideoConverter::fitSize
+ * @mainclasses
+ *   - VideoConverter
+ */
+
+#include "videoconverter.h"
+
+#include "workerpool.h"
+#include "yuvtobgra.h"
+
+#include <algorithm>
+#include <atomic>
+
+extern "C"
+{
+#include <libavutil/buffer.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/version.h>
+}
+
+// sws_frame_start/sws_send_slice/sws_receive_slice 自 libswscale 6.1.100 (FFmpeg 5.0) 起提供
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+#define LSP_HAVE_SWS_SLICE_API 1
+#else
+#define LSP_HAVE_SWS_SLICE_API 0
+#endif
+
+namespace {
+    constexpr int kMinSlicePixels = 256 * 1024; // 每个条带至少约 0.25 MPix，避免小图的调度开销超过收益
+    constexpr size_t kMaxCachedScalers = 4;     // 覆盖日/夜配置切换、窗口缩放等常见的几组参数
+
+    /**
+     * @brief 输出缓冲由 FramePool 管理，AVBufferRef 释放时无需任何操作。
+     */
+    void noopBufferFree(void* opaque, uint8_t* data) {
+        Q_UNUSED(opaque);
+        Q_UNUSED(data);
+    }
+}
+
+/**
+ * @brief 构造函数。
+ */
+VideoConverter::VideoConverter() = default;
+
+/**
+ * @brief 析构函数，释放 swscale 上下文。
+ */
+VideoConverter::~VideoConverter() {
+    reset();
+}
+
+/**
+ * @brief 将解码帧转换为适配显示尺寸的 BGRA 图像。
+ * @param frame 解码帧。
+ * @param boundingSize 显示区域设备像素尺寸。
+ * @param quality 缩放质量。
+ * @return 转换结果。
+ */
+QImage VideoConverter::convert(const AVFrame* frame, const QSize& boundingSize, ScalingQuality quality) {
+    if (!frame || frame->width <= 0 || frame->height <= 0) {
+        return QImage();
+    }
+
+    const QSize sourceSize(frame->width, frame->height);
+    const QSize outputSize = fitSize(sourceSize, boundingSize);
+
+    if (outputSize == sourceSize && FramePool::canWrap(frame)) {
+        // 解码输出已是 BGRA 且无需缩放，直接引用解码器缓冲
+        return FramePool::wrapFrame(frame);
+    }
+
+    QImage image = m_framePool.acquire(outputSize.width(), outputSize.height());
+    if (image.isNull()) {
+        return QImage();
+    }
+
+    const int slices = sliceCount(outputSize);
+    if (outputSize == sourceSize && m_directYuvEnabled && YuvToBgra::supports(frame)) {
+        // 无缩放的常见 4:2:0 格式走专用 SIMD 内核，绕过 swscale 的通用管线
+        convertDirect(frame, image, slices);
+        return image;
+    }
+
+    // 每帧按解码帧自身的尺寸、格式与色彩属性选择上下文，流中途变化时自动切换
+    const ScalerKey key = scalerKey(frame, outputSize, swsFlags(quality));
+    if (slices > 1 && convertSliced(frame, image, key, slices)) {
+        return image;
+    }
+
+    ScalerEntry* entry = acquireScalers(key, 1);
+    if (!entry) {
+        return QImage();
+    }
+
+    uint8_t* destData[4] = { image.bits(), nullptr, nullptr, nullptr };
+    int destLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+
+    sws_scale(entry->contexts.front(),
+        frame->data,
+        frame->linesize,
+        0,
+        frame->height,
+        destData,
+        destLinesize);
+
+    return image;
+}
+
+/**
+ * @brief 释放缩放上下文与空闲输出缓冲。
+ */
+void VideoConverter::reset() {
+    freeScalers();
+    if (m_sliceDst) {
+        av_frame_free(&m_sliceDst);
+    }
+    m_framePool.clear();
+}
+
+/**
+ * @brief 设置条带数上限。
+ * @param slices 条带数，0 为自动。
+ */
+void VideoConverter::setMaxSlices(int slices) {
+    m_maxSlices = std::max(0, slices);
+}
+
+/**
+ * @brief 启用或禁用无缩放 YUV 专用路径。
+ * @param enabled 是否启用。
+ */
+void VideoConverter::setDirectYuvEnabled(bool enabled) {
+    m_directYuvEnabled = enabled;
+}
+
+/**
+ * @brief 返回缩放上下文创建次数。
+ * @return 创建次数。
+ */
+quint64 VideoConverter::scalerBuildCount() const {
+    return m_scalerBuilds;
+}
+
+/**
+ * @brief 返回输出缓冲池。
+ * @return 缓冲池。
+ */
+const FramePool& VideoConverter::framePool() const {
+    return m_framePool;
+}
+
+/**
+ * @brief 按纵横比将源尺寸适配到显示区域。
+ * @param sourceSize 源尺寸。
+ * @param boundingSize 显示区域尺寸。
+ * @return 输出尺寸。
+ */
+QSize VideoConverter::fitSize(const QSize& sourceSize, const QSize& boundingSize) {
+    if (boundingSize.isEmpty() || sourceSize.isEmpty()) {
+        return sourceSize;
+    }
+
+    QSize fitted = sourceSize.scaled(boundingSize, Qt::KeepAspectRatio);
+    fitted.setWidth(std::max(1, fitted.width()));
+    fitted.setHeight(std::max(1, fitted.height()));
+    return fitted;
+}
+
+/**
+ * @brief 缩放质量到 swscale 标志的映射。
+ * @param quality 缩放质量。
+ * @return SWS_* 标志。
+ */
+int VideoConverter::swsFlags(ScalingQuality quality) {
+    switch (quality) {
+    case ScalingQuality::Point:
+        return SWS_POINT;
+    case ScalingQuality::FastBilinear:
+        return SWS_FAST_BILINEAR;
+    case ScalingQuality::Bilinear:
+    default:
+        return SWS_BILINEAR;
+    }
+}
+
+/**
+ * @brief 按输出像素数拆分条带，上限为共享线程池线程数加调用线程。
+ * @param outputSize 输出尺寸。
+ * @return 条带数。
+ */
+int VideoConverter::sliceCount(const QSize& outputSize) const {
+    const int limit = m_maxSlices > 0 ? m_maxSlices : WorkerPool::instance().threadCount() + 1;
+    const qint64 pixels = static_cast<qint64>(outputSize.width()) * outputSize.height();
+    const int bySize = static_cast<int>(std::max<qint64>(1, pixels / kMinSlicePixels));
+    return std::max(1, std::min(limit, bySize));
+}
+
+/**
+ * @brief 按偶数行边界拆分条带，使相邻条带不共享色度行。
+ * @param frame 解码帧。
+ * @param image 与源同尺寸的输出图像。
+ * @param slices 条带数。
+ */
+void VideoConverter::convertDirect(const AVFrame* frame, QImage& image, int slices) {
+    const int height = frame->height;
+    const int rowsPerSlice = ((height + slices - 1) / slices + 1) & ~1;
+
+    WorkerPool::instance().parallelFor(slices, [&](int index) {
+        const int rowBegin = index * rowsPerSlice;
+        if (rowBegin < height) {
+            YuvToBgra::convert(frame, image.bits(), image.bytesPerLine(), rowBegin, std::min(height, rowBegin + rowsPerSlice));
+        }
+    });
+}
+
+/**
+ * @brief 各条带上下文读取完整源帧，只输出各自负责的目标行区间。
+ * @param frame 解码帧。
+ * @param image 输出图像。
+ * @param key 缩放参数。
+ * @param slices 条带数。
+ * @return 全部条带成功返回 true。
+ */
+bool VideoConverter::convertSliced(const AVFrame* frame, QImage& image, const ScalerKey& key, int slices) {
+#if LSP_HAVE_SWS_SLICE_API
+    ScalerEntry* entry = acquireScalers(key, slices);
+    if (!entry) {
+        return false;
+    }
+
+    if (!m_sliceDst) {
+        m_sliceDst = av_frame_alloc();
+        if (!m_sliceDst) {
+            return false;
+        }
+    }
+
+    // 以不释放内存的 AVBufferRef 包装池化输出缓冲，满足 sws_frame_start 对目标帧引用计数的要求
+    const int height = image.height();
+    m_sliceDst->buf[0] = av_buffer_create(image.bits(), static_cast<size_t>(image.bytesPerLine()) * height,
+        &noopBufferFree, nullptr, 0);
+    if (!m_sliceDst->buf[0]) {
+        return false;
+    }
+    m_sliceDst->data[0] = image.bits();
+    m_sliceDst->linesize[0] = image.bytesPerLine();
+    m_sliceDst->width = image.width();
+    m_sliceDst->height = height;
+    m_sliceDst->format = AV_PIX_FMT_BGRA;
+
+    const int alignment = std::max(1, static_cast<int>(sws_receive_slice_alignment(entry->contexts.front())));
+    const int rowsPerSlice = ((height + slices - 1) / slices + alignment - 1) / alignment * alignment;
+    std::atomic_bool failed{ false };
+
+    WorkerPool::instance().parallelFor(slices, [&](int index) {
+        const int sliceStart = index * rowsPerSlice;
+        if (sliceStart >= height) {
+            return;
+        }
+        const int sliceHeight = std::min(rowsPerSlice, height - sliceStart);
+
+        SwsContext* ctx = entry->contexts[static_cast<size_t>(index)];
+        int ret = sws_frame_start(ctx, m_sliceDst, frame);
+        if (ret >= 0) {
+            ret = sws_send_slice(ctx, 0, static_cast<unsigned int>(frame->height));
+            if (ret >= 0) {
+                ret = sws_receive_slice(ctx, static_cast<unsigned int>(sliceStart), static_cast<unsigned int>(sliceHeight));
+            }
+            sws_frame_end(ctx);
+        }
+        if (ret < 0) {
+            failed.store(true, std::memory_order_relaxed);
+        }
+    });
+
+    av_frame_unref(m_sliceDst);
+    return !failed.load(std::memory_order_relaxed);
+#else
+    Q_UNUSED(frame);
+    Q_UNUSED(image);
+    Q_UNUSED(key);
+    Q_UNUSED(slices);
+    return false;
+#endif
+}
+
+/**
+ * @brief 帧标注为 JPEG 范围或使用 YUVJ 格式时按全范围处理。
+ * @param frame 解码帧。
+ * @param outputSize 输出尺寸。
+ * @param flags swscale 标志。
+ * @return 缓存键。
+ */
+VideoConverter::ScalerKey VideoConverter::scalerKey(const AVFrame* frame, const QSize& outputSize, int flags) {
+    ScalerKey key;
+    key.srcWidth = frame->width;
+    key.srcHeight = frame->height;
+    key.srcFormat = frame->format;
+    key.srcColorspace = frame->colorspace;
+    key.srcFullRange = frame->color_range == AVCOL_RANGE_JPEG || frame->format == AV_PIX_FMT_YUVJ420P ||
+        frame->format == AV_PIX_FMT_YUVJ422P || frame->format == AV_PIX_FMT_YUVJ444P;
+    key.dstWidth = outputSize.width();
+    key.dstHeight = outputSize.height();
+    key.flags = flags;
+    return key;
+}
+
+/**
+ * @brief 创建上下文；YUV 源按帧标注的矩阵与范围设置系数，未标注时 swscale 使用 BT.601。
+ * @param key 构建参数。
+ * @return 新上下文。
+ */
+SwsContext* VideoConverter::createScaler(const ScalerKey& key) {
+    const AVPixelFormat srcFormat = static_cast<AVPixelFormat>(key.srcFormat);
+    if (!sws_isSupportedInput(srcFormat)) {
+        return nullptr;
+    }
+
+    SwsContext* ctx = sws_getContext(key.srcWidth, key.srcHeight, srcFormat,
+        key.dstWidth, key.dstHeight, AV_PIX_FMT_BGRA, key.flags, nullptr, nullptr, nullptr);
+    if (!ctx) {
+        return nullptr;
+    }
+
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(srcFormat);
+    if (desc && !(desc->flags & AV_PIX_FMT_FLAG_RGB)) {
+        sws_setColorspaceDetails(ctx, sws_getCoefficients(key.srcColorspace), key.srcFullRange ? 1 : 0,
+            sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+    }
+    return ctx;
+}
+
+/**
+ * @brief 命中时移到队首并按需补足条带上下文；未命中时新建，超出容量淘汰最久未用的一项。
+ * @param key 构建参数。
+ * @param count 需要的上下文数量。
+ * @return 缓存项。
+ */
+VideoConverter::ScalerEntry* VideoConverter::acquireScalers(const ScalerKey& key, int count) {
+    auto it = std::find_if(m_scalers.begin(), m_scalers.end(),
+        [&key](const ScalerEntry& entry) { return entry.key == key; });
+    if (it == m_scalers.end()) {
+        if (m_scalers.size() >= kMaxCachedScalers) {
+            for (SwsContext* ctx : m_scalers.back().contexts) {
+                sws_freeContext(ctx);
+            }
+            m_scalers.pop_back();
+        }
+        ScalerEntry entry;
+        entry.key = key;
+        m_scalers.insert(m_scalers.begin(), std::move(entry));
+    }
+    else if (it != m_scalers.begin()) {
+        std::rotate(m_scalers.begin(), it, it + 1);
+    }
+
+    ScalerEntry& entry = m_scalers.front();
+    while (static_cast<int>(entry.contexts.size()) < count) {
+        SwsContext* ctx = createScaler(key);
+        if (!ctx) {
+            break;
+        }
+        entry.contexts.push_back(ctx);
+        ++m_scalerBuilds;
+    }
+
+    if (static_cast<int>(entry.contexts.size()) < count) {
+        if (entry.contexts.empty()) {
+            m_scalers.erase(m_scalers.begin());
+        }
+        return nullptr;
+    }
+    return &entry;
+}
+
+/**
+ * @brief 释放所有缓存的缩放上下文。
+ */
+void VideoConverter::freeScalers() {
+    for (ScalerEntry& entry : m_scalers) {
+        for (SwsContext* ctx : entry.contexts) {
+            sws_freeContext(ctx);
+        }
+    }
+    m_scalers.clear();
+}
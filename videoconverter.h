@@ -0,0 +1,211 @@
+/**
+ * @file videoconverter.h
+ * @brief 定义视频转换阶段，将解码帧缩放并转换为可直接显示的 QImage。
+ * @mainfunctions
+ *   - convert
+ *   - reset
+ *   - setMaxSlices
+ *   - setDirectYuvEnabled
+ *   - scalerBuildCount
+ *   - framePool
+ *   - fitSize
+ * @mainclasses
+ *   - VideoConverter
+ */
+
+#ifndef VIDEOCONVERTER_H
+#define VIDEOCONVERTER_H
+
+#include <QImage>
+#include <QSize>
+
+#include <vector>
+
+#include "framepool.h"
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+/**
+ * @brief VideoConverter 负责 YUV 到 BGRA 的转换，并在转换时直接缩放到显示尺寸。
+ *
+ * 缩放上下文按源尺寸、像素格式、色彩矩阵/范围与输出参数缓存最近几组，每帧按解码帧自身的属性选择，
+ * 流中途切换分辨率或格式时无需重开流，来回切换也不会重复构建。
+ *
+ * 大尺寸输出按水平条带拆分，在共享 WorkerPool 上并行转换；每个条带使用独立的
+ * SwsContext，通过 sws_send_slice/sws_receive_slice 输出指定行区间，结果与单线程逐位一致。
+ * 无需缩放的 YUV420P/NV12 帧交给 YuvToBgra 的 SIMD 内核处理，同样按条带并行。
+ * 仅由视频解码线程使用，不做内部加锁。
+ */
+class VideoConverter {
+public:
+    /**
+     * @brief 缩放质量，对应 swscale 的插值算法。
+     */
+    enum class ScalingQuality {
+        Point,        // 最近邻，开销最低
+        FastBilinear, // 快速双线性
+        Bilinear      // 双线性（默认）
+    };
+
+    /**
+     * @brief 构造函数，缩放上下文在首帧时按需创建。
+     */
+    VideoConverter();
+
+    /**
+     * @brief 析构函数，释放缩放上下文。
+     */
+    ~VideoConverter();
+
+    VideoConverter(const VideoConverter&) = delete;
+    VideoConverter& operator=(const VideoConverter&) = delete;
+
+    /**
+     * @brief 转换一帧，输出尺寸为源尺寸按比例适配到 boundingSize 后的大小。
+     * @param frame 解码帧。
+     * @param boundingSize 显示区域的设备像素尺寸，为空时保持源尺寸。
+     * @param quality 缩放质量。
+     * @return 转换后的图像，失败时返回空图像。
+     */
+    QImage convert(const AVFrame* frame, const QSize& boundingSize, ScalingQuality quality);
+
+    /**
+     * @brief 释放缩放上下文与空闲缓冲区，切换流时调用。
+     */
+    void reset();
+
+    /**
+     * @brief 设置单帧最多拆分的条带数。
+     * @param slices 条带数，0 表示按共享线程池大小自动选择，1 表示禁用并行。
+     */
+    void setMaxSlices(int slices);
+
+    /**
+     * @brief 启用或禁用无缩放 YUV420P/NV12 的 SIMD 专用路径，禁用时统一走 swscale（用于对比测试）。
+     * @param enabled 是否启用，默认启用。
+     */
+    void setDirectYuvEnabled(bool enabled);
+
+    /**
+     * @brief 查询累计创建的缩放上下文数量，用于观察分辨率切换的开销。
+     * @return 创建次数。
+     */
+    quint64 scalerBuildCount() const;
+
+    /**
+     * @brief 访问输出缓冲池，用于读取命中与分配计数（计数为原子量，任意线程可读取）。
+     * @return 缓冲池。
+     */
+    const FramePool& framePool() const;
+
+    /**
+     * @brief 计算保持纵横比时源尺寸适配到显示区域的输出尺寸。
+     * @param sourceSize 源图像尺寸。
+     * @param boundingSize 显示区域尺寸，为空时返回源尺寸。
+     * @return 输出尺寸，至少为 1x1。
+     */
+    static QSize fitSize(const QSize& sourceSize, const QSize& boundingSize);
+
+private:
+    /**
+     * @brief 将缩放质量映射为 swscale 标志。
+     * @param quality 缩放质量。
+     * @return SWS_* 标志。
+     */
+    static int swsFlags(ScalingQuality quality);
+
+    /**
+     * @brief 根据输出像素数与线程池大小决定条带数。
+     * @param outputSize 输出尺寸。
+     * @return 条带数，1 表示单线程转换。
+     */
+    int sliceCount(const QSize& outputSize) const;
+
+    /**
+     * @brief 缩放上下文的构建参数，任一项变化都需要不同的 SwsContext。
+     */
+    struct ScalerKey {
+        int srcWidth = 0;
+        int srcHeight = 0;
+        int srcFormat = -1;
+        int srcColorspace = -1;
+        bool srcFullRange = false;
+        int dstWidth = 0;
+        int dstHeight = 0;
+        int flags = 0;
+
+        bool operator==(const ScalerKey& other) const {
+            return srcWidth == other.srcWidth && srcHeight == other.srcHeight && srcFormat == other.srcFormat &&
+                srcColorspace == other.srcColorspace && srcFullRange == other.srcFullRange &&
+                dstWidth == other.dstWidth && dstHeight == other.dstHeight && flags == other.flags;
+        }
+    };
+
+    /**
+     * @brief 缓存项：同一组参数下的一个或多个（按条带）缩放上下文。
+     */
+    struct ScalerEntry {
+        ScalerKey key;
+        std::vector<SwsContext*> contexts;
+    };
+
+    /**
+     * @brief 由帧属性与输出参数生成缓存键。
+     * @param frame 解码帧。
+     * @param outputSize 输出尺寸。
+     * @param flags swscale 标志。
+     * @return 缓存键。
+     */
+    static ScalerKey scalerKey(const AVFrame* frame, const QSize& outputSize, int flags);
+
+    /**
+     * @brief 创建缩放上下文并按源色彩矩阵与范围设置转换系数。
+     * @param key 构建参数。
+     * @return 新上下文，失败返回 nullptr。
+     */
+    static SwsContext* createScaler(const ScalerKey& key);
+
+    /**
+     * @brief 查找或创建至少包含 count 个上下文的缓存项，并将其移到最近使用位置。
+     * @param key 构建参数。
+     * @param count 需要的上下文数量。
+     * @return 缓存项，创建失败返回 nullptr。
+     */
+    ScalerEntry* acquireScalers(const ScalerKey& key, int count);
+
+    /**
+     * @brief 使用多个条带上下文并行转换整帧。
+     * @param frame 解码帧。
+     * @param image 输出图像。
+     * @param key 缩放参数。
+     * @param slices 条带数。
+     * @return 成功返回 true，失败时由调用方回退到单线程转换。
+     */
+    bool convertSliced(const AVFrame* frame, QImage& image, const ScalerKey& key, int slices);
+
+    /**
+     * @brief 使用 YuvToBgra 内核按行区间并行转换同尺寸帧。
+     * @param frame 解码帧。
+     * @param image 输出图像。
+     * @param slices 条带数。
+     */
+    void convertDirect(const AVFrame* frame, QImage& image, int slices);
+
+    /**
+     * @brief 释放所有缓存的缩放上下文。
+     */
+    void freeScalers();
+
+    std::vector<ScalerEntry> m_scalers;     // 按最近使用排序，首项最新
+    AVFrame* m_sliceDst = nullptr;          // 包装输出图像的目标帧，逐帧复用
+    int m_maxSlices = 0;
+    bool m_directYuvEnabled = true;
+    quint64 m_scalerBuilds = 0;
+    FramePool m_framePool;
+};
+
+#endif // VIDEOCONVERTER_H
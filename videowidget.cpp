@@ -2,18 +2,21 @@
  * @file videowidget.cpp
  * @brief 实现视频显示控件的绘制与帧更新逻辑。
  * @mainfunctions
- *   - VideoWidget::updateFrame
+ *   - VideoWidget::frameMailbox
  *   - VideoWidget::paintEvent
  *   - VideoWidget::resizeEvent
+ *   - VideoWidget::devicePixelSize
  * @mainclasses
  *   - VideoWidget
  */
 
 #include "videowidget.h"
 
+#include "frametrace.h"
+
+#include <QMetaObject>
 #include <QPainter>
 #include <QPainterPath>
-#include <QMutexLocker>
 #include <QFont>
 
  /**
@@ -21,7 +24,8 @@
   * @param parent 父级 QWidget。
   */
 VideoWidget::VideoWidget(QWidget* parent)
-    : QWidget(parent) {
+    : QWidget(parent),
+    m_mailbox(std::make_shared<FrameMailbox>()) {
     setAutoFillBackground(true);
     setMinimumSize(320, 240);
 
@@ -33,28 +37,34 @@ VideoWidget::VideoWidget(QWidget* parent)
         "   border-radius: 10px;"
         "}"
     );
+
+    // 信箱在生产者线程回调，只向 UI 线程投递一次重绘，由 paintEvent 取最新帧
+    m_mailbox->setNotifier([this]() {
+        QMetaObject::invokeMethod(this, [this]() { update(); }, Qt::QueuedConnection);
+    });
 }
 
 /**
- * @brief 更新当前帧并触发重绘。
- * @param frame 最新图像。
+ * @brief 析构时撤销通知回调，此后生产者发布的帧不再投递重绘。
  */
-void VideoWidget::updateFrame(const QImage& frame) {
-    {
-        QMutexLocker locker(&m_mutex);
-        m_frame = frame;
-    }
-    update();
+VideoWidget::~VideoWidget() {
+    m_mailbox->setNotifier(nullptr);
 }
 
 /**
- * @brief 清除当前帧并触发重绘。
+ * @brief 返回最新帧信箱。
+ * @return 信箱。
+ */
+std::shared_ptr<FrameMailbox> VideoWidget::frameMailbox() const {
+    return m_mailbox;
+}
+
+/**
+ * @brief 清除当前帧及信箱中待取的帧并触发重绘。
  */
 void VideoWidget::clearFrame() {
-    {
-        QMutexLocker locker(&m_mutex);
-        m_frame = QImage(); // 清空图像
-    }
+    m_mailbox->clear();
+    m_frame = QImage(); // 清空图像
     update();
 }
 
@@ -64,6 +74,7 @@ void VideoWidget::clearFrame() {
  */
 void VideoWidget::paintEvent(QPaintEvent* event) {
     Q_UNUSED(event);
+    const int64_t paintStartUs = FrameTrace::enabled() ? av_gettime_relative() : 0;
     QPainter painter(this);
 
     // 启用抗锯齿以获得更平滑的渲染效果
@@ -77,11 +88,10 @@ void VideoWidget::paintEvent(QPaintEvent* event) {
 
     painter.fillRect(rect(), Qt::black);
 
-    QImage frameCopy;
-    {
-        QMutexLocker locker(&m_mutex);
-        frameCopy = m_frame;
-    }
+    // 只有新取到的帧记录绘制，重复绘制同一帧（如窗口遮挡后恢复）不计
+    quint64 traceId = 0;
+    m_mailbox->take(m_frame, &traceId);
+    const QImage frameCopy = m_frame;
 
     if (frameCopy.isNull()) {
         // 如果没有视频帧，显示提示文字
@@ -95,6 +105,23 @@ void VideoWidget::paintEvent(QPaintEvent* event) {
 
     const QSize imageSize = frameCopy.size();
     const QSize widgetSize = size();
+    const QSize targetSize = devicePixelSize();
+    const qreal ratio = devicePixelRatioF();
+
+    // 解码端已按显示尺寸完成缩放时，图像在某一维上恰好铺满控件，直接 1:1 绘制
+    if (imageSize.width() <= targetSize.width() && imageSize.height() <= targetSize.height() &&
+        (imageSize.width() == targetSize.width() || imageSize.height() == targetSize.height())) {
+        const qreal drawWidth = imageSize.width() / ratio;
+        const qreal drawHeight = imageSize.height() / ratio;
+        const qreal x = (widgetSize.width() - drawWidth) / 2.0;
+        const qreal y = (widgetSize.height() - drawHeight) / 2.0;
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+        painter.drawImage(QRectF(x, y, drawWidth, drawHeight), frameCopy);
+        FrameTrace::span(FrameTrace::Point::Paint, traceId, paintStartUs);
+        return;
+    }
+
+    // 尺寸尚未同步（如刚调整窗口大小）时回退为按比例缩放绘制
     QSize drawSize = imageSize;
     drawSize.scale(widgetSize, Qt::KeepAspectRatio);
 
@@ -102,6 +129,7 @@ void VideoWidget::paintEvent(QPaintEvent* event) {
     const int y = (widgetSize.height() - drawSize.height()) / 2;
 
     painter.drawImage(QRect(QPoint(x, y), drawSize), frameCopy);
+    FrameTrace::span(FrameTrace::Point::Paint, traceId, paintStartUs);
 }
 
 /**
@@ -110,5 +138,15 @@ void VideoWidget::paintEvent(QPaintEvent* event) {
  */
 void VideoWidget::resizeEvent(QResizeEvent* event) {
     QWidget::resizeEvent(event);
+    emit displaySizeChanged(devicePixelSize());
     update();
 }
+
+/**
+ * @brief 将逻辑尺寸换算为设备像素尺寸，兼顾高 DPI 屏幕。
+ * @return 设备像素尺寸。
+ */
+QSize VideoWidget::devicePixelSize() const {
+    const qreal ratio = devicePixelRatioF();
+    return QSize(qRound(width() * ratio), qRound(height() * ratio));
+}
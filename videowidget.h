@@ -2,7 +2,8 @@
  * @file videowidget.h
  * @brief 声明用于显示视频帧的 QWidget 子类。
  * @mainfunctions
- *   - updateFrame
+ *   - frameMailbox
+ *   - displaySizeChanged
  *   - paintEvent
  *   - resizeEvent
  * @mainclasses
@@ -13,11 +14,16 @@
 #define VIDEOWIDGET_H
 
 #include <QImage>
-#include <QMutex>
 #include <QWidget>
 
+#include <memory>
+
+#include "framemailbox.h"
+
  /**
   * @brief VideoWidget 负责接收图像并在界面中绘制。
+  *
+  * 视频管线通过 frameMailbox() 返回的信箱交付帧，控件在绘制时取最新帧。
   */
 class VideoWidget : public QWidget {
     Q_OBJECT
@@ -28,21 +34,33 @@ public:
      */
     explicit VideoWidget(QWidget* parent = nullptr);
 
-public slots:
     /**
-     * @brief 更新最新帧并触发重绘。
-     * @param frame 输入图像。
+     * @brief 析构函数，撤销信箱的重绘通知。
      */
-    void updateFrame(const QImage& frame);
+    ~VideoWidget() override;
 
+    /**
+     * @brief 获取该控件的最新帧信箱，交给视频管线作为生产者端。
+     * @return 信箱。
+     */
+    std::shared_ptr<FrameMailbox> frameMailbox() const;
+
+public slots:
     /**
      * @brief 清除当前帧并重绘为空白画面。
      */
     void clearFrame();
 
+signals:
+    /**
+     * @brief 控件尺寸变化时发射，供解码端直接转换到显示尺寸。
+     * @param devicePixelSize 控件的设备像素尺寸。
+     */
+    void displaySizeChanged(const QSize& devicePixelSize);
+
 protected:
     /**
-     * @brief 绘制当前帧，保持纵横比。
+     * @brief 绘制当前帧，保持纵横比；帧尺寸已匹配显示区域时按 1:1 直接绘制。
      * @param event Qt 绘制事件。
      */
     void paintEvent(QPaintEvent* event) override;
@@ -54,8 +72,14 @@ protected:
     void resizeEvent(QResizeEvent* event) override;
 
 private:
-    QImage m_frame;
-    QMutex m_mutex;
+    /**
+     * @brief 计算当前控件的设备像素尺寸。
+     * @return 设备像素尺寸。
+     */
+    QSize devicePixelSize() const;
+
+    QImage m_frame;                          // 当前显示的帧，仅在 UI 线程访问
+    std::shared_ptr<FrameMailbox> m_mailbox;
 };
 
 #endif // VIDEOWIDGET_H
@@ -0,0 +1,142 @@
+/**
+ * @file workerpool.cpp
+ * @brief 实现共享工作线程池的任务分发与等待。
+ * @mainfunctions
+ *   - WorkerPool::instance
+ *   - WorkerPool::run
+ *   - WorkerPool::workerLoop
+ * @mainclasses
+ *   - WorkerPool
+ */
+
+#include "workerpool.h"
+
+#include <algorithm>
+
+/**
+ * @brief 返回进程共享实例，首次调用时创建。
+ * @return 共享线程池。
+ */
+WorkerPool& WorkerPool::instance() {
+    static WorkerPool pool(std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+    return pool;
+}
+
+/**
+ * @brief 启动工作线程。
+ * @param threadCount 线程数量。
+ */
+WorkerPool::WorkerPool(int threadCount) {
+    const int count = std::max(0, threadCount);
+    m_threads.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        m_threads.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+/**
+ * @brief 停止并回收所有工作线程。
+ */
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+    for (std::thread& thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+/**
+ * @brief 返回工作线程数量。
+ * @return 线程数。
+ */
+int WorkerPool::threadCount() const {
+    return static_cast<int>(m_threads.size());
+}
+
+/**
+ * @brief 发布任务，调用线程参与执行并等待所有工作线程离开该任务。
+ * @param count 任务数量。
+ * @param fn 任务函数。
+ * @param context 任务上下文。
+ */
+void WorkerPool::run(int count, TaskFn fn, void* context) {
+    if (count <= 0) {
+        return;
+    }
+    if (count == 1 || m_threads.empty()) {
+        for (int i = 0; i < count; ++i) {
+            fn(context, i);
+        }
+        return;
+    }
+
+    Job job;
+    job.fn = fn;
+    job.context = context;
+    job.count = count;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobs.push_back(&job);
+    if (count - 1 >= static_cast<int>(m_threads.size())) {
+        m_workAvailable.notify_all();
+    }
+    else {
+        for (int i = 0; i < count - 1; ++i) {
+            m_workAvailable.notify_one();
+        }
+    }
+
+    drain(job, lock);
+
+    // 任务序号已领完，必须等待工作线程执行完毕且不再引用栈上的 job
+    m_jobFinished.wait(lock, [&job]() { return job.completed == job.count && job.workers == 0; });
+}
+
+/**
+ * @brief 循环领取任务序号并执行，领完后将任务移出队列。
+ * @param job 当前任务。
+ * @param lock 池互斥锁。
+ */
+void WorkerPool::drain(Job& job, std::unique_lock<std::mutex>& lock) {
+    while (job.next < job.count) {
+        const int index = job.next++;
+        if (job.next >= job.count) {
+            auto it = std::find(m_jobs.begin(), m_jobs.end(), &job);
+            if (it != m_jobs.end()) {
+                m_jobs.erase(it);
+            }
+        }
+
+        lock.unlock();
+        job.fn(job.context, index);
+        lock.lock();
+
+        ++job.completed;
+    }
+}
+
+/**
+ * @brief 工作线程主循环，等待并协助执行队首任务。
+ */
+void WorkerPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_workAvailable.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+        if (m_stopping) {
+            return;
+        }
+
+        Job* job = m_jobs.front();
+        ++job->workers;
+        drain(*job, lock);
+        --job->workers;
+        if (job->completed == job->count && job->workers == 0) {
+            m_jobFinished.notify_all();
+        }
+    }
+}
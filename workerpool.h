@@ -0,0 +1,109 @@
+/**
+ * @file workerpool.h
+ * @brief 定义进程共享的工作线程池，用于将转换等计算切片并行执行。
+ * @mainfunctions
+ *   - instance
+ *   - parallelFor
+ *   - threadCount
+ * @mainclasses
+ *   - WorkerPool
+ */
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief WorkerPool 为所有播放器共享一组工作线程，避免每路流各自创建线程。
+ *
+ * parallelFor 的调用线程同样参与执行，因此即使池中线程全部繁忙也能保证进度。
+ */
+class WorkerPool {
+public:
+    /**
+     * @brief 获取进程共享的线程池，线程数为硬件并发数减一。
+     * @return 共享实例。
+     */
+    static WorkerPool& instance();
+
+    /**
+     * @brief 构造函数，启动指定数量的工作线程。
+     * @param threadCount 工作线程数量，可为 0（仅调用线程执行）。
+     */
+    explicit WorkerPool(int threadCount);
+
+    /**
+     * @brief 析构函数，通知并等待所有工作线程退出。
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief 查询工作线程数量（不含调用线程）。
+     * @return 线程数。
+     */
+    int threadCount() const;
+
+    /**
+     * @brief 并行执行 fn(0) ... fn(count - 1)，全部完成后返回。
+     * @param count 任务数量。
+     * @param fn 可调用对象，参数为任务序号。
+     */
+    template <typename Fn>
+    void parallelFor(int count, Fn&& fn) {
+        using Callable = std::remove_reference_t<Fn>;
+        run(count, [](void* context, int index) { (*static_cast<Callable*>(context))(index); }, &fn);
+    }
+
+private:
+    using TaskFn = void (*)(void* context, int index);
+
+    /**
+     * @brief 一次 parallelFor 调用，驻留在调用线程栈上。
+     */
+    struct Job {
+        TaskFn fn = nullptr;
+        void* context = nullptr;
+        int count = 0;
+        int next = 0;      // 下一个待领取的任务序号
+        int completed = 0; // 已完成的任务数
+        int workers = 0;   // 正在执行该任务的工作线程数
+    };
+
+    /**
+     * @brief 发布任务并在调用线程参与执行，直到全部完成。
+     * @param count 任务数量。
+     * @param fn 任务函数。
+     * @param context 任务上下文。
+     */
+    void run(int count, TaskFn fn, void* context);
+
+    /**
+     * @brief 领取并执行任务，直到没有剩余序号。
+     * @param job 当前任务。
+     * @param lock 已持有的池互斥锁，执行任务期间释放。
+     */
+    void drain(Job& job, std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @brief 工作线程主循环。
+     */
+    void workerLoop();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_jobFinished;
+    std::deque<Job*> m_jobs;
+    bool m_stopping = false;
+};
+
+#endif // WORKERPOOL_H
@@ -0,0 +1,404 @@
+/**
+ * @file yuvtobgra.cpp
+ * @brief 实现 YUV420P/NV12 到 BGRA 的标量、SSE4.1 与 AVX2 内核及运行时分发。
+ * @mainfunctions
+ *   - YuvToBgra::supports
+ *   - YuvToBgra::convert
+ *   - YuvToBgra::detectedIsa
+ * @mainclasses
+ *   - YuvToBgra
+ */
+
+#include "yuvtobgra.h"
+
+#include <algorithm>
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+}
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define LSP_YUV_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define LSP_YUV_X86 0
+#endif
+
+// GCC/Clang 需要为单个函数启用指令集；MSVC 无需额外标志即可使用内建函数
+#if LSP_YUV_X86 && (defined(__GNUC__) || defined(__clang__))
+#define LSP_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define LSP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LSP_TARGET_SSE41
+#define LSP_TARGET_AVX2
+#endif
+
+namespace {
+    enum class Layout {
+        Planar,     // YUV420P / YUVJ420P：U、V 各自一个平面
+        SemiPlanar  // NV12：UV 交错平面
+    };
+
+    enum class Matrix {
+        Bt601,
+        Bt709
+    };
+
+    /**
+     * @brief 将浮点系数转换为 Q13 定点数。
+     */
+    constexpr int q13(double value) {
+        return static_cast<int>(value * 8192.0 + 0.5);
+    }
+
+    /**
+     * @brief 定点转换系数。输入样本左移 6 位后与 Q13 系数做 mulhi，结果为 Q3，最后 (x + 4) >> 3 取整。
+     */
+    template <Matrix M, bool FullRange>
+    struct Coefficients {
+        static constexpr double kr = M == Matrix::Bt709 ? 0.2126 : 0.299;
+        static constexpr double kb = M == Matrix::Bt709 ? 0.0722 : 0.114;
+        static constexpr double kg = 1.0 - kr - kb;
+        static constexpr double yScale = FullRange ? 1.0 : 255.0 / 219.0;
+        static constexpr double cScale = FullRange ? 1.0 : 255.0 / 224.0;
+
+        static constexpr int yOffset = FullRange ? 0 : 16;
+        static constexpr int y = q13(yScale);
+        static constexpr int rv = q13(2.0 * (1.0 - kr) * cScale);
+        static constexpr int bu = q13(2.0 * (1.0 - kb) * cScale);
+        static constexpr int gu = q13(2.0 * (1.0 - kb) * kb / kg * cScale);
+        static constexpr int gv = q13(2.0 * (1.0 - kr) * kr / kg * cScale);
+    };
+
+    /**
+     * @brief 与 _mm_mulhi_epi16 等价的标量乘法（取 32 位乘积高 16 位）。
+     */
+    inline int mulhi(int a, int b) {
+        return (a * b) >> 16;
+    }
+
+    inline uint8_t clampByte(int value) {
+        return static_cast<uint8_t>(std::min(255, std::max(0, value)));
+    }
+
+    /**
+     * @brief 标量转换 [x, width) 区间，既是无 SIMD 时的实现也用于处理 SIMD 尾部像素。
+     */
+    template <Layout L, Matrix M, bool FullRange>
+    void convertRowScalar(const uint8_t* yRow, const uint8_t* uRow, const uint8_t* vRow, uint8_t* dst, int x, int width) {
+        using C = Coefficients<M, FullRange>;
+        for (; x < width; ++x) {
+            const int c = x >> 1;
+            const int uSample = L == Layout::Planar ? uRow[c] : uRow[c * 2];
+            const int vSample = L == Layout::Planar ? vRow[c] : uRow[c * 2 + 1];
+
+            const int luma = mulhi((yRow[x] - C::yOffset) * 64, C::y);
+            const int u = (uSample - 128) * 64;
+            const int v = (vSample - 128) * 64;
+
+            uint8_t* out = dst + x * 4;
+            out[0] = clampByte((luma + mulhi(u, C::bu) + 4) >> 3);
+            out[1] = clampByte((luma - mulhi(u, C::gu) - mulhi(v, C::gv) + 4) >> 3);
+            out[2] = clampByte((luma + mulhi(v, C::rv) + 4) >> 3);
+            out[3] = 255;
+        }
+    }
+
+#if LSP_YUV_X86
+    /**
+     * @brief SSE4.1 内核：每次处理 16 像素（8 个色度样本）。
+     */
+    template <Layout L, Matrix M, bool FullRange>
+    LSP_TARGET_SSE41 void convertRowSse41(const uint8_t* yRow, const uint8_t* uRow, const uint8_t* vRow, uint8_t* dst, int width) {
+        using C = Coefficients<M, FullRange>;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i yOffset = _mm_set1_epi16(static_cast<short>(C::yOffset));
+        const __m128i chromaBias = _mm_set1_epi16(128);
+        const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+        const __m128i round = _mm_set1_epi16(4);
+        const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+        const __m128i cy = _mm_set1_epi16(static_cast<short>(C::y));
+        const __m128i crv = _mm_set1_epi16(static_cast<short>(C::rv));
+        const __m128i cbu = _mm_set1_epi16(static_cast<short>(C::bu));
+        const __m128i cgu = _mm_set1_epi16(static_cast<short>(C::gu));
+        const __m128i cgv = _mm_set1_epi16(static_cast<short>(C::gv));
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(yRow + x));
+            __m128i u16;
+            __m128i v16;
+            if (L == Layout::Planar) {
+                u16 = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(uRow + x / 2)));
+                v16 = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(vRow + x / 2)));
+            }
+            else {
+                const __m128i uv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uRow + x));
+                u16 = _mm_and_si128(uv, lowBytes);
+                v16 = _mm_srli_epi16(uv, 8);
+            }
+            u16 = _mm_slli_epi16(_mm_sub_epi16(u16, chromaBias), 6);
+            v16 = _mm_slli_epi16(_mm_sub_epi16(v16, chromaBias), 6);
+
+            // 色度按 2:1 水平复制，与亮度低/高 8 像素对齐
+            const __m128i uLo = _mm_unpacklo_epi16(u16, u16);
+            const __m128i uHi = _mm_unpackhi_epi16(u16, u16);
+            const __m128i vLo = _mm_unpacklo_epi16(v16, v16);
+            const __m128i vHi = _mm_unpackhi_epi16(v16, v16);
+
+            const __m128i yLo = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), yOffset), 6), cy);
+            const __m128i yHi = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y8, zero), yOffset), 6), cy);
+
+            const __m128i bLo = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(yLo, _mm_mulhi_epi16(uLo, cbu)), round), 3);
+            const __m128i bHi = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(yHi, _mm_mulhi_epi16(uHi, cbu)), round), 3);
+            const __m128i gLo = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_sub_epi16(yLo, _mm_mulhi_epi16(uLo, cgu)),
+                _mm_mulhi_epi16(vLo, cgv)), round), 3);
+            const __m128i gHi = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_sub_epi16(yHi, _mm_mulhi_epi16(uHi, cgu)),
+                _mm_mulhi_epi16(vHi, cgv)), round), 3);
+            const __m128i rLo = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(yLo, _mm_mulhi_epi16(vLo, crv)), round), 3);
+            const __m128i rHi = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(yHi, _mm_mulhi_epi16(vHi, crv)), round), 3);
+
+            const __m128i b = _mm_packus_epi16(bLo, bHi);
+            const __m128i g = _mm_packus_epi16(gLo, gHi);
+            const __m128i r = _mm_packus_epi16(rLo, rHi);
+
+            const __m128i bgLo = _mm_unpacklo_epi8(b, g);
+            const __m128i bgHi = _mm_unpackhi_epi8(b, g);
+            const __m128i raLo = _mm_unpacklo_epi8(r, alpha);
+            const __m128i raHi = _mm_unpackhi_epi8(r, alpha);
+
+            __m128i* out = reinterpret_cast<__m128i*>(dst + x * 4);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(bgLo, raLo));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgLo, raLo));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgHi, raHi));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgHi, raHi));
+        }
+        convertRowScalar<L, M, FullRange>(yRow, uRow, vRow, dst, x, width);
+    }
+
+    /**
+     * @brief AVX2 内核：每次处理 32 像素。unpack 在 128 位通道内进行，
+     *        写出前用 permute2x128 恢复像素顺序。
+     */
+    template <Layout L, Matrix M, bool FullRange>
+    LSP_TARGET_AVX2 void convertRowAvx2(const uint8_t* yRow, const uint8_t* uRow, const uint8_t* vRow, uint8_t* dst, int width) {
+        using C = Coefficients<M, FullRange>;
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i yOffset = _mm256_set1_epi16(static_cast<short>(C::yOffset));
+        const __m256i chromaBias = _mm256_set1_epi16(128);
+        const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+        const __m256i round = _mm256_set1_epi16(4);
+        const __m256i alpha = _mm256_set1_epi8(static_cast<char>(0xFF));
+        const __m256i cy = _mm256_set1_epi16(static_cast<short>(C::y));
+        const __m256i crv = _mm256_set1_epi16(static_cast<short>(C::rv));
+        const __m256i cbu = _mm256_set1_epi16(static_cast<short>(C::bu));
+        const __m256i cgu = _mm256_set1_epi16(static_cast<short>(C::gu));
+        const __m256i cgv = _mm256_set1_epi16(static_cast<short>(C::gv));
+
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            // 通道内解包后：lo = 像素 0-7 | 16-23，hi = 像素 8-15 | 24-31
+            const __m256i y8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(yRow + x));
+            __m256i u16;
+            __m256i v16;
+            if (L == Layout::Planar) {
+                u16 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uRow + x / 2)));
+                v16 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(vRow + x / 2)));
+            }
+            else {
+                const __m256i uv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uRow + x));
+                u16 = _mm256_and_si256(uv, lowBytes);
+                v16 = _mm256_srli_epi16(uv, 8);
+            }
+            u16 = _mm256_slli_epi16(_mm256_sub_epi16(u16, chromaBias), 6);
+            v16 = _mm256_slli_epi16(_mm256_sub_epi16(v16, chromaBias), 6);
+
+            const __m256i uLo = _mm256_unpacklo_epi16(u16, u16);
+            const __m256i uHi = _mm256_unpackhi_epi16(u16, u16);
+            const __m256i vLo = _mm256_unpacklo_epi16(v16, v16);
+            const __m256i vHi = _mm256_unpackhi_epi16(v16, v16);
+
+            const __m256i yLo = _mm256_mulhi_epi16(_mm256_slli_epi16(_mm256_sub_epi16(_mm256_unpacklo_epi8(y8, zero), yOffset), 6), cy);
+            const __m256i yHi = _mm256_mulhi_epi16(_mm256_slli_epi16(_mm256_sub_epi16(_mm256_unpackhi_epi8(y8, zero), yOffset), 6), cy);
+
+            const __m256i bLo = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(yLo, _mm256_mulhi_epi16(uLo, cbu)), round), 3);
+            const __m256i bHi = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(yHi, _mm256_mulhi_epi16(uHi, cbu)), round), 3);
+            const __m256i gLo = _mm256_srai_epi16(_mm256_add_epi16(_mm256_sub_epi16(_mm256_sub_epi16(yLo, _mm256_mulhi_epi16(uLo, cgu)),
+                _mm256_mulhi_epi16(vLo, cgv)), round), 3);
+            const __m256i gHi = _mm256_srai_epi16(_mm256_add_epi16(_mm256_sub_epi16(_mm256_sub_epi16(yHi, _mm256_mulhi_epi16(uHi, cgu)),
+                _mm256_mulhi_epi16(vHi, cgv)), round), 3);
+            const __m256i rLo = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(yLo, _mm256_mulhi_epi16(vLo, crv)), round), 3);
+            const __m256i rHi = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(yHi, _mm256_mulhi_epi16(vHi, crv)), round), 3);
+
+            // packus 同样按通道进行，结果恰好回到 0-15 | 16-31 的顺序
+            const __m256i b = _mm256_packus_epi16(bLo, bHi);
+            const __m256i g = _mm256_packus_epi16(gLo, gHi);
+            const __m256i r = _mm256_packus_epi16(rLo, rHi);
+
+            const __m256i bgLo = _mm256_unpacklo_epi8(b, g);
+            const __m256i bgHi = _mm256_unpackhi_epi8(b, g);
+            const __m256i raLo = _mm256_unpacklo_epi8(r, alpha);
+            const __m256i raHi = _mm256_unpackhi_epi8(r, alpha);
+
+            const __m256i p0 = _mm256_unpacklo_epi16(bgLo, raLo); // 0-3   | 16-19
+            const __m256i p1 = _mm256_unpackhi_epi16(bgLo, raLo); // 4-7   | 20-23
+            const __m256i p2 = _mm256_unpacklo_epi16(bgHi, raHi); // 8-11  | 24-27
+            const __m256i p3 = _mm256_unpackhi_epi16(bgHi, raHi); // 12-15 | 28-31
+
+            __m256i* out = reinterpret_cast<__m256i*>(dst + x * 4);
+            _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(p0, p1, 0x20));
+            _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(p2, p3, 0x20));
+            _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(p0, p1, 0x31));
+            _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+        }
+        convertRowScalar<L, M, FullRange>(yRow, uRow, vRow, dst, x, width);
+    }
+#endif
+
+    using RowFn = void (*)(const uint8_t* yRow, const uint8_t* uRow, const uint8_t* vRow, uint8_t* dst, int width);
+
+    template <Layout L, Matrix M, bool FullRange>
+    void scalarRow(const uint8_t* yRow, const uint8_t* uRow, const uint8_t* vRow, uint8_t* dst, int width) {
+        convertRowScalar<L, M, FullRange>(yRow, uRow, vRow, dst, 0, width);
+    }
+
+    /**
+     * @brief 按指令集选择某一格式特化的行函数。
+     */
+    template <Layout L, Matrix M, bool FullRange>
+    RowFn selectRow(YuvToBgra::Isa isa) {
+#if LSP_YUV_X86
+        if (isa == YuvToBgra::Isa::Avx2) {
+            return &convertRowAvx2<L, M, FullRange>;
+        }
+        if (isa == YuvToBgra::Isa::Sse41) {
+            return &convertRowSse41<L, M, FullRange>;
+        }
+#else
+        (void)isa;
+#endif
+        return &scalarRow<L, M, FullRange>;
+    }
+
+    template <Layout L, Matrix M>
+    RowFn selectRow(YuvToBgra::Isa isa, bool fullRange) {
+        return fullRange ? selectRow<L, M, true>(isa) : selectRow<L, M, false>(isa);
+    }
+
+    template <Layout L>
+    RowFn selectRow(YuvToBgra::Isa isa, Matrix matrix, bool fullRange) {
+        return matrix == Matrix::Bt709 ? selectRow<L, Matrix::Bt709>(isa, fullRange)
+                                       : selectRow<L, Matrix::Bt601>(isa, fullRange);
+    }
+
+    /**
+     * @brief 运行时检测 CPU 能力。
+     */
+    YuvToBgra::Isa probeIsa() {
+#if LSP_YUV_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4] = {};
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool sse41 = (info[2] & (1 << 19)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        const bool sse41 = __builtin_cpu_supports("sse4.1") != 0;
+        const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+        if (avx2) {
+            return YuvToBgra::Isa::Avx2;
+        }
+        if (sse41) {
+            return YuvToBgra::Isa::Sse41;
+        }
+#endif
+        return YuvToBgra::Isa::Scalar;
+    }
+}
+
+/**
+ * @brief 检测结果只计算一次。
+ * @return 最优指令集。
+ */
+YuvToBgra::Isa YuvToBgra::detectedIsa() {
+    static const Isa isa = probeIsa();
+    return isa;
+}
+
+/**
+ * @brief 仅接受 8 位 4:2:0 且为 BT.601/709（或未标注）的帧。
+ * @param frame 解码帧。
+ * @return true 表示支持。
+ */
+bool YuvToBgra::supports(const AVFrame* frame) {
+    if (!frame || frame->width < 2 || frame->height < 2) {
+        return false;
+    }
+    if (frame->format != AV_PIX_FMT_YUV420P && frame->format != AV_PIX_FMT_YUVJ420P &&
+        frame->format != AV_PIX_FMT_NV12) {
+        return false;
+    }
+    switch (frame->colorspace) {
+    case AVCOL_SPC_UNSPECIFIED:
+    case AVCOL_SPC_BT470BG:
+    case AVCOL_SPC_SMPTE170M:
+    case AVCOL_SPC_BT709:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 逐行调用选定的内核；色度行为亮度行的一半。
+ * @param frame 解码帧。
+ * @param dst 输出首行地址。
+ * @param dstStride 输出行跨度。
+ * @param rowBegin 起始行。
+ * @param rowEnd 结束行。
+ * @param isa 请求的指令集。
+ * @return 成功返回 true。
+ */
+bool YuvToBgra::convert(const AVFrame* frame, uint8_t* dst, int dstStride, int rowBegin, int rowEnd, Isa isa) {
+    if (!supports(frame) || !dst || rowBegin < 0) {
+        return false;
+    }
+    rowEnd = std::min(rowEnd, frame->height);
+    if (rowBegin >= rowEnd) {
+        return true;
+    }
+
+    // 请求的指令集不能超过 CPU 实际能力（枚举按能力递增排列）
+    const Isa detected = detectedIsa();
+    if (isa == Isa::Auto || static_cast<int>(isa) > static_cast<int>(detected)) {
+        isa = detected;
+    }
+
+    const Matrix matrix = frame->colorspace == AVCOL_SPC_BT709 ? Matrix::Bt709 : Matrix::Bt601;
+    const bool fullRange = frame->format == AV_PIX_FMT_YUVJ420P || frame->color_range == AVCOL_RANGE_JPEG;
+    const bool semiPlanar = frame->format == AV_PIX_FMT_NV12;
+    const RowFn row = semiPlanar ? selectRow<Layout::SemiPlanar>(isa, matrix, fullRange)
+                                 : selectRow<Layout::Planar>(isa, matrix, fullRange);
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        const int c = y >> 1;
+        const uint8_t* yRow = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+        const uint8_t* uRow = frame->data[1] + static_cast<ptrdiff_t>(c) * frame->linesize[1];
+        const uint8_t* vRow = semiPlanar ? nullptr : frame->data[2] + static_cast<ptrdiff_t>(c) * frame->linesize[2];
+        row(yRow, uRow, vRow, dst + static_cast<ptrdiff_t>(y) * dstStride, frame->width);
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file yuvtobgra.h
+ * @brief 定义 8 位 YUV420P/NV12 到同尺寸 BGRA 的专用 SIMD 转换引擎。
+ * @mainfunctions
+ *   - supports
+ *   - convert
+ *   - detectedIsa
+ * @mainclasses
+ *   - YuvToBgra
+ */
+
+#ifndef YUVTOBGRA_H
+#define YUVTOBGRA_H
+
+#include <cstdint>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+/**
+ * @brief YuvToBgra 覆盖摄像头最常见的无缩放转换场景，其余情况仍由 swscale 处理。
+ *
+ * 内核按像素布局、色彩矩阵与取值范围做模板特化，运行时根据 CPU 选择 AVX2 / SSE4.1 / 标量实现。
+ * 所有实现使用相同的定点运算，彼此输出逐位一致，与浮点参考值误差不超过 ±1。
+ */
+class YuvToBgra {
+public:
+    /**
+     * @brief 指令集选择，Auto 表示使用检测到的最优实现。
+     */
+    enum class Isa {
+        Auto,
+        Scalar,
+        Sse41,
+        Avx2
+    };
+
+    /**
+     * @brief 判断帧是否可走专用路径（YUV420P/YUVJ420P/NV12，BT.601/709）。
+     * @param frame 解码帧。
+     * @return true 表示支持。
+     */
+    static bool supports(const AVFrame* frame);
+
+    /**
+     * @brief 转换指定行区间，便于按条带并行。
+     * @param frame 解码帧，需满足 supports()。
+     * @param dst 输出图像首行地址（BGRA）。
+     * @param dstStride 输出行跨度（字节）。
+     * @param rowBegin 起始行。
+     * @param rowEnd 结束行（不含）。
+     * @param isa 指令集，超出 CPU 能力时自动降级。
+     * @return 成功返回 true。
+     */
+    static bool convert(const AVFrame* frame, uint8_t* dst, int dstStride, int rowBegin, int rowEnd, Isa isa = Isa::Auto);
+
+    /**
+     * @brief 查询当前 CPU 支持的最优指令集。
+     * @return 检测结果。
+     */
+    static Isa detectedIsa();
+};
+
+#endif // YUVTOBGRA_H